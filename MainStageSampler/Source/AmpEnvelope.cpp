@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+    AmpEnvelope.cpp
+    Created: SFZ amplitude envelope rendered a block at a time
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "AmpEnvelope.h"
+
+namespace
+{
+    // How far an exponential stage has gone by the end of its time, as a ratio
+    // of the distance it started from (-60 dB)
+    constexpr double exponentialFloor = 0.001;
+}
+
+//==============================================================================
+AmpEnvelope::AmpEnvelope()
+{
+}
+
+AmpEnvelope::~AmpEnvelope()
+{
+}
+
+void AmpEnvelope::noteOn() noexcept
+{
+    level = 0.0f;
+    enterStage(Stage::delay);
+}
+
+void AmpEnvelope::noteOff() noexcept
+{
+    if (stage != Stage::idle && stage != Stage::release)
+        enterStage(Stage::release);
+}
+
+void AmpEnvelope::reset() noexcept
+{
+    level = 0.0f;
+    stage = Stage::idle;
+}
+
+//==============================================================================
+void AmpEnvelope::enterStage(Stage newStage) noexcept
+{
+    stage = newStage;
+
+    switch (stage)
+    {
+        case Stage::delay:
+            samplesLeft = toSamples(parameters.delay);
+
+            if (samplesLeft == 0)
+                enterStage(Stage::attack);
+            break;
+
+        case Stage::attack:
+            samplesLeft = toSamples(parameters.attack);
+
+            if (samplesLeft == 0)
+            {
+                level = 1.0f;
+                enterStage(Stage::hold);
+            }
+            else
+            {
+                increment = (1.0f - level) / (float)samplesLeft;
+            }
+            break;
+
+        case Stage::hold:
+            samplesLeft = toSamples(parameters.hold);
+
+            if (samplesLeft == 0)
+                enterStage(Stage::decay);
+            break;
+
+        case Stage::decay:
+            target = juce::jlimit(0.0f, 1.0f, parameters.sustain);
+            samplesLeft = level > target ? toSamples(parameters.decay) : 0;
+
+            if (samplesLeft == 0)
+            {
+                level = target;
+                enterStage(Stage::sustain);
+            }
+            else
+            {
+                multiplier = (float)std::pow(exponentialFloor, 1.0 / samplesLeft);
+            }
+            break;
+
+        case Stage::sustain:
+            // Nothing more can be heard until the next note
+            if (level == 0.0f)
+                stage = Stage::idle;
+            break;
+
+        case Stage::release:
+            target = 0.0f;
+            samplesLeft = level > 0.0f ? toSamples(parameters.release) : 0;
+
+            if (samplesLeft == 0)
+            {
+                level = 0.0f;
+                stage = Stage::idle;
+            }
+            else
+            {
+                multiplier = (float)std::pow(exponentialFloor, 1.0 / samplesLeft);
+            }
+            break;
+
+        case Stage::idle:
+        default:
+            break;
+    }
+}
+
+void AmpEnvelope::finishStage() noexcept
+{
+    // Land exactly where the stage was heading, whatever rounding did on the way
+    if (stage == Stage::attack)
+        level = 1.0f;
+    else if (stage == Stage::decay || stage == Stage::release)
+        level = target;
+
+    // The stages run in the order they're declared, and the release is the last
+    enterStage(stage == Stage::release ? Stage::idle : (Stage)((int)stage + 1));
+}
+
+void AmpEnvelope::getNextBlock(float* gains, int numSamples) noexcept
+{
+    while (numSamples > 0)
+    {
+        if (stage == Stage::idle || stage == Stage::sustain)
+        {
+            juce::FloatVectorOperations::fill(gains, level, numSamples);
+            return;
+        }
+
+        const int numThisTime = juce::jmin(numSamples, samplesLeft);
+
+        switch (stage)
+        {
+            case Stage::delay:
+            case Stage::hold:
+                juce::FloatVectorOperations::fill(gains, level, numThisTime);
+                break;
+
+            case Stage::attack:
+                for (int i = 0; i < numThisTime; ++i)
+                    gains[i] = level + increment * (float)i;
+
+                level += increment * (float)numThisTime;
+                break;
+
+            case Stage::decay:
+            case Stage::release:
+            {
+                auto distance = level - target;
+
+                for (int i = 0; i < numThisTime; ++i)
+                {
+                    gains[i] = target + distance;
+                    distance *= multiplier;
+                }
+
+                level = target + distance;
+                break;
+            }
+
+            case Stage::idle:
+            case Stage::sustain:
+            default:
+                break;
+        }
+
+        gains += numThisTime;
+        numSamples -= numThisTime;
+        samplesLeft -= numThisTime;
+
+        if (samplesLeft == 0)
+            finishStage();
+    }
+}
\ No newline at end of file
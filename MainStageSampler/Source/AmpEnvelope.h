@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    AmpEnvelope.h
+    Created: SFZ amplitude envelope rendered a block at a time
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    The SFZ amp envelope: delay, attack, hold, decay, sustain and release.
+
+    The attack is a straight line up to full level. Decay and release are
+    exponential, as a struck or plucked string dies away, and each reaches its
+    target 60 dB down from where it started at the end of its time, then lands
+    on it exactly.
+
+    Gains are produced a block at a time. Each stage is filled in one run,
+    either directly or with a single multiply per sample, so there's no
+    per-sample check of where the envelope is.
+*/
+class AmpEnvelope
+{
+public:
+    //==============================================================================
+    /** The shape of the envelope, following the SFZ ampeg_ opcodes. */
+    struct Parameters
+    {
+        float delay = 0.0f;     // seconds of silence before the attack
+        float attack = 0.0f;    // seconds to rise to full level
+        float hold = 0.0f;      // seconds held at full level
+        float decay = 0.0f;     // seconds to fall to the sustain level
+        float sustain = 1.0f;   // 0 to 1, where ampeg_sustain is a percentage
+        float release = 0.1f;   // seconds to die away after note-off
+    };
+
+    AmpEnvelope();
+    ~AmpEnvelope();
+
+    /** Sets the rate the gains are produced at. */
+    void setSampleRate(double newSampleRate) noexcept { sampleRate = newSampleRate; }
+
+    /** Sets the shape. A stage already under way carries on as it started; the change applies from the next one. */
+    void setParameters(const Parameters& newParameters) noexcept { parameters = newParameters; }
+
+    /** Returns the shape. */
+    const Parameters& getParameters() const noexcept { return parameters; }
+
+    //==============================================================================
+    /** Starts the envelope from silence. */
+    void noteOn() noexcept;
+
+    /** Starts the release from wherever the envelope is, at the next sample produced. */
+    void noteOff() noexcept;
+
+    /** Stops the envelope at once. */
+    void reset() noexcept;
+
+    /** Returns true until the release has finished. A sustain of zero also ends
+        the envelope once the decay has finished.
+    */
+    bool isActive() const noexcept { return stage != Stage::idle; }
+
+    /** Returns true once the release has started. */
+    bool isReleasing() const noexcept { return stage == Stage::release; }
+
+    //==============================================================================
+    /** Writes the gains for the next numSamples samples. Those after the end of the envelope are 0. */
+    void getNextBlock(float* gains, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    enum class Stage
+    {
+        idle,
+        delay,
+        attack,
+        hold,
+        decay,
+        sustain,
+        release
+    };
+
+    /** Moves on to a stage, skipping any that take no time. */
+    void enterStage(Stage newStage) noexcept;
+
+    /** Moves on from a timed stage that has run its course. */
+    void finishStage() noexcept;
+
+    /** Returns a length in seconds as a number of samples. */
+    int toSamples(float seconds) const noexcept { return juce::roundToInt(juce::jmax(0.0f, seconds) * sampleRate); }
+
+    Parameters parameters;
+    double sampleRate = 44100.0;
+
+    Stage stage = Stage::idle;
+    int samplesLeft = 0;       // in the current stage, when it's timed
+
+    float level = 0.0f;        // the gain the next sample gets
+    float target = 0.0f;       // where an exponential stage is heading
+    float increment = 0.0f;    // per sample, in the attack
+    float multiplier = 1.0f;   // on the distance to the target per sample, in the decay and release
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AmpEnvelope)
+};
\ No newline at end of file
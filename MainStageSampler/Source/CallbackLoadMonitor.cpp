@@ -0,0 +1,180 @@
+/*
+  ==============================================================================
+
+    CallbackLoadMonitor.cpp
+    Created: Times every audio callback against its deadline
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "CallbackLoadMonitor.h"
+
+namespace
+{
+    constexpr double loadSmoothingSeconds = 0.25;
+}
+
+//==============================================================================
+float CallbackLoadMonitor::Snapshot::getPercentile(double fraction) const noexcept
+{
+    if (numCallbacks == 0)
+        return 0.0f;
+
+    const auto target = (juce::int64)std::ceil(juce::jlimit(0.0, 1.0, fraction) * (double)numCallbacks);
+    juce::int64 count = 0;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        count += histogram[bin];
+
+        if (count >= target)
+            return (float)(bin + 1) * binWidth;
+    }
+
+    return maxLoad;
+}
+
+juce::String CallbackLoadMonitor::Snapshot::toJSON() const
+{
+    juce::Array<juce::var> bins;
+    for (auto count : histogram)
+        bins.add(count);
+
+    juce::Array<juce::var> overrunList;
+
+    for (auto& overrun : recentOverruns)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("time_seconds", overrun.time);
+        object->setProperty("load", overrun.load);
+        object->setProperty("samples", overrun.numSamples);
+        object->setProperty("active_voices", overrun.activeVoices);
+        overrunList.add(juce::var(object));
+    }
+
+    auto* percentiles = new juce::DynamicObject();
+    for (auto fraction : { 0.5, 0.9, 0.99, 0.999 })
+        percentiles->setProperty("p" + juce::String(fraction * 100.0), getPercentile(fraction));
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("sample_rate", sampleRate);
+    root->setProperty("callbacks", numCallbacks);
+    root->setProperty("overruns", numOverruns);
+    root->setProperty("max_load", maxLoad);
+    root->setProperty("load_percentiles", juce::var(percentiles));
+    root->setProperty("histogram_bin_width", binWidth);
+    root->setProperty("histogram", bins);
+    root->setProperty("recent_overruns", overrunList);
+
+    return juce::JSON::toString(juce::var(root));
+}
+
+//==============================================================================
+CallbackLoadMonitor::CallbackLoadMonitor()
+{
+    prepare(sampleRate);
+}
+
+CallbackLoadMonitor::~CallbackLoadMonitor()
+{
+}
+
+void CallbackLoadMonitor::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    resetRequested.store(false);
+    clear();
+}
+
+void CallbackLoadMonitor::clear() noexcept
+{
+    for (auto& bin : histogram)
+        bin.store(0, std::memory_order_relaxed);
+
+    numCallbacks.store(0);
+    numOverruns.store(0);
+    maxLoad.store(0.0f);
+    smoothedLoad.store(0.0f);
+    peakLoad.store(0.0f);
+
+    startTicks = juce::Time::getHighResolutionTicks();
+}
+
+float CallbackLoadMonitor::endCallback(juce::int64 callbackStartTicks, int numSamples, int activeVoices) noexcept
+{
+    const auto endTicks = juce::Time::getHighResolutionTicks();
+
+    if (resetRequested.exchange(false))
+        clear();
+
+    if (numSamples <= 0)
+        return 0.0f;
+
+    const auto period = numSamples / sampleRate;
+    const auto load = (float)(juce::Time::highResolutionTicksToSeconds(endTicks - callbackStartTicks) / period);
+
+    // Only this thread writes, so plain load-and-store is enough
+    auto& bin = histogram[juce::jlimit(0, numBins - 1, (int)(load / binWidth))];
+    bin.store(bin.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    numCallbacks.store(numCallbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (load > maxLoad.load(std::memory_order_relaxed))
+        maxLoad.store(load, std::memory_order_relaxed);
+
+    // The peak is also reset by readers, so it needs a compare-and-swap
+    auto peak = peakLoad.load(std::memory_order_relaxed);
+    while (load > peak && !peakLoad.compare_exchange_weak(peak, load, std::memory_order_relaxed))
+    {
+    }
+
+    const auto smoothing = (float)(1.0 - std::exp(-period / loadSmoothingSeconds));
+    const auto smoothed = smoothedLoad.load(std::memory_order_relaxed);
+    smoothedLoad.store(smoothed + (load - smoothed) * smoothing, std::memory_order_relaxed);
+
+    if (load > 1.0f)
+    {
+        const auto index = numOverruns.load(std::memory_order_relaxed);
+        auto& slot = overruns[index % maxOverrunsKept];
+
+        slot.time.store(juce::Time::highResolutionTicksToSeconds(callbackStartTicks - startTicks), std::memory_order_relaxed);
+        slot.load.store(load, std::memory_order_relaxed);
+        slot.numSamples.store(numSamples, std::memory_order_relaxed);
+        slot.activeVoices.store(activeVoices, std::memory_order_relaxed);
+
+        // Published after the slot is filled in
+        numOverruns.store(index + 1, std::memory_order_release);
+    }
+
+    return load;
+}
+
+//==============================================================================
+CallbackLoadMonitor::Snapshot CallbackLoadMonitor::getSnapshot() const
+{
+    Snapshot snapshot;
+    snapshot.sampleRate = sampleRate;
+    snapshot.numCallbacks = numCallbacks.load(std::memory_order_relaxed);
+    snapshot.numOverruns = numOverruns.load(std::memory_order_acquire);
+    snapshot.maxLoad = maxLoad.load(std::memory_order_relaxed);
+
+    for (int bin = 0; bin < numBins; ++bin)
+        snapshot.histogram[bin] = histogram[bin].load(std::memory_order_relaxed);
+
+    const auto numKept = (int)juce::jmin(snapshot.numOverruns, (juce::int64)maxOverrunsKept);
+
+    for (auto index = snapshot.numOverruns - numKept; index < snapshot.numOverruns; ++index)
+    {
+        auto& slot = overruns[index % maxOverrunsKept];
+
+        Overrun overrun;
+        overrun.time = slot.time.load(std::memory_order_relaxed);
+        overrun.load = slot.load.load(std::memory_order_relaxed);
+        overrun.numSamples = slot.numSamples.load(std::memory_order_relaxed);
+        overrun.activeVoices = slot.activeVoices.load(std::memory_order_relaxed);
+        snapshot.recentOverruns.add(overrun);
+    }
+
+    return snapshot;
+}
\ No newline at end of file
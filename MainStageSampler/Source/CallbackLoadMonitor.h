@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    CallbackLoadMonitor.h
+    Created: Times every audio callback against its deadline
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Keeps track of how much of each buffer period the audio callback uses.
+
+    The audio thread times every callback with the high resolution (monotonic)
+    clock and adds it to a histogram of load, the time taken as a fraction of
+    the time the buffer lasts. A callback over 100% is an overrun: the device
+    was left waiting, and unless it had spare buffering, that's an audible
+    dropout. The last few overruns are kept with the number of voices that were
+    playing.
+
+    Recording only does relaxed atomic stores, so it's safe on the audio thread,
+    and the statistics can be read from any other thread while it runs.
+*/
+class CallbackLoadMonitor
+{
+public:
+    //==============================================================================
+    static constexpr int numBins = 100;
+    static constexpr float binWidth = 0.02f;     // of the period, so the bins cover 0 to 200%. The last one also takes anything longer.
+    static constexpr int maxOverrunsKept = 64;
+
+    /** A callback that took longer than its buffer lasts */
+    struct Overrun
+    {
+        double time = 0.0;         // seconds since prepare()
+        float load = 0.0f;         // time taken as a fraction of the period
+        int numSamples = 0;
+        int activeVoices = 0;
+    };
+
+    /** A copy of the statistics at one moment */
+    struct Snapshot
+    {
+        double sampleRate = 0.0;
+        juce::int64 numCallbacks = 0;
+        juce::int64 numOverruns = 0;
+        float maxLoad = 0.0f;
+        juce::int64 histogram[numBins] = {};
+        juce::Array<Overrun> recentOverruns;    // oldest first
+
+        /** Returns the load that the given fraction (0 to 1) of callbacks came in under, to the nearest bin */
+        float getPercentile(double fraction) const noexcept;
+
+        /** Returns the statistics as JSON, for saving */
+        juce::String toJSON() const;
+    };
+
+    //==============================================================================
+    CallbackLoadMonitor();
+    ~CallbackLoadMonitor();
+
+    /** Clears the statistics and sets the rate used to turn buffer sizes into deadlines.
+        Call this when the device starts, before its first callback.
+    */
+    void prepare(double sampleRate);
+
+    /** Clears the statistics at the start of the next callback. Safe to call from any thread. */
+    void requestReset() noexcept { resetRequested.store(true); }
+
+    //==============================================================================
+    /** Call at the very start of the audio callback, and pass the result to endCallback(). */
+    static juce::int64 beginCallback() noexcept { return juce::Time::getHighResolutionTicks(); }
+
+    /** Call at the very end of the audio callback. Returns the callback's load. */
+    float endCallback(juce::int64 startTicks, int numSamples, int activeVoices) noexcept;
+
+    //==============================================================================
+    /** Returns the load averaged over the last quarter of a second or so. Safe to call from any thread. */
+    float getCurrentLoad() const noexcept { return smoothedLoad.load(std::memory_order_relaxed); }
+
+    /** Returns the highest load since the last call, and starts again from zero. Safe to call from any thread. */
+    float getAndResetPeakLoad() noexcept { return peakLoad.exchange(0.0f); }
+
+    /** Returns the number of overruns since prepare(). Safe to call from any thread. */
+    juce::int64 getNumOverruns() const noexcept { return numOverruns.load(std::memory_order_relaxed); }
+
+    /** Copies the statistics. Safe to call from any thread; an overrun recorded while
+        this runs may be missed or, if many arrive at once, read half written.
+    */
+    Snapshot getSnapshot() const;
+
+private:
+    //==============================================================================
+    void clear() noexcept;
+
+    double sampleRate = 44100.0;
+    juce::int64 startTicks = 0;
+
+    std::atomic<juce::int64> histogram[numBins] = {};
+    std::atomic<juce::int64> numCallbacks { 0 }, numOverruns { 0 };
+    std::atomic<float> maxLoad { 0.0f }, smoothedLoad { 0.0f }, peakLoad { 0.0f };
+    std::atomic<bool> resetRequested { false };
+
+    // Ring of the latest overruns, written by the audio thread only. numOverruns says how far it has got.
+    struct OverrunSlot
+    {
+        std::atomic<double> time { 0.0 };
+        std::atomic<float> load { 0.0f };
+        std::atomic<int> numSamples { 0 }, activeVoices { 0 };
+    };
+
+    OverrunSlot overruns[maxOverrunsKept];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CallbackLoadMonitor)
+};
\ No newline at end of file
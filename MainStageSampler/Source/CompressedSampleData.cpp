@@ -0,0 +1,569 @@
+/*
+  ==============================================================================
+
+    CompressedSampleData.cpp
+    Created: Lossless in-RAM sample compression
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "CompressedSampleData.h"
+
+namespace
+{
+    // Residuals are coded in partitions that each get their own Rice parameter
+    constexpr int partitionSize = 256;
+
+    // Quotients at or above this are written as an escape followed by the raw value
+    constexpr int escapeUnaryLength = 24;
+
+    constexpr int maxPredictorOrder = 3;
+
+    inline juce::uint32 zigzagEncode(juce::int32 v) noexcept
+    {
+        return ((juce::uint32)v << 1) ^ (juce::uint32)(v >> 31);
+    }
+
+    inline juce::int32 zigzagDecode(juce::uint32 u) noexcept
+    {
+        return (juce::int32)(u >> 1) ^ -(juce::int32)(u & 1);
+    }
+
+    inline int countLeadingZeros(juce::uint64 x) noexcept
+    {
+       #if JUCE_MSVC
+        unsigned long index;
+        _BitScanReverse64(&index, x);
+        return 63 - (int)index;
+       #else
+        return __builtin_clzll(x);
+       #endif
+    }
+
+    inline juce::int32 predict(const juce::int32* x, int i, int order) noexcept
+    {
+        switch (order)
+        {
+        case 1:  return x[i - 1];
+        case 2:  return 2 * x[i - 1] - x[i - 2];
+        case 3:  return 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3];
+        default: return 0;
+        }
+    }
+
+    //==============================================================================
+    struct BitWriter
+    {
+        std::vector<juce::uint8> bytes;
+        juce::uint64 accumulator = 0;
+        int numPendingBits = 0;
+
+        void write(juce::uint32 value, int numBits)
+        {
+            if (numBits == 0)
+                return;
+
+            auto mask = numBits == 32 ? 0xffffffffu : ((1u << numBits) - 1);
+            accumulator = (accumulator << numBits) | (value & mask);
+            numPendingBits += numBits;
+
+            while (numPendingBits >= 8)
+            {
+                numPendingBits -= 8;
+                bytes.push_back((juce::uint8)(accumulator >> numPendingBits));
+            }
+        }
+
+        void writeRice(juce::uint32 value, int k)
+        {
+            auto quotient = value >> k;
+
+            if (quotient < (juce::uint32)escapeUnaryLength)
+            {
+                write(0, (int)quotient);
+                write(1, 1);
+                write(value, k);
+            }
+            else
+            {
+                write(0, escapeUnaryLength);
+                write(value, 32);
+            }
+        }
+
+        void alignToByte()
+        {
+            if (numPendingBits > 0)
+                write(0, 8 - numPendingBits);
+        }
+    };
+
+    struct BitReader
+    {
+        explicit BitReader(const juce::uint8* data) noexcept : ptr(data) {}
+
+        void refill() noexcept
+        {
+            while (numBits <= 56)
+            {
+                cache |= (juce::uint64)*ptr++ << (56 - numBits);
+                numBits += 8;
+            }
+        }
+
+        juce::uint32 read(int n) noexcept
+        {
+            if (n == 0)
+                return 0;
+
+            refill();
+            auto value = (juce::uint32)(cache >> (64 - n));
+            cache <<= n;
+            numBits -= n;
+            return value;
+        }
+
+        juce::uint32 readRice(int k) noexcept
+        {
+            refill();
+            auto zeros = cache == 0 ? 64 : countLeadingZeros(cache);
+
+            if (zeros >= escapeUnaryLength)
+            {
+                cache <<= escapeUnaryLength;
+                numBits -= escapeUnaryLength;
+                return read(32);
+            }
+
+            cache <<= (zeros + 1);
+            numBits -= (zeros + 1);
+            return ((juce::uint32)zeros << k) | read(k);
+        }
+
+        const juce::uint8* ptr;
+        juce::uint64 cache = 0;
+        int numBits = 0;
+    };
+
+    //==============================================================================
+    juce::int64 residualCost(const juce::int32* x, int n, int order) noexcept
+    {
+        juce::int64 cost = 0;
+
+        for (int i = order; i < n; ++i)
+            cost += std::abs((juce::int64)x[i] - predict(x, i, order));
+
+        return cost;
+    }
+
+    int chooseOrder(const juce::int32* x, int n, juce::int64& bestCost) noexcept
+    {
+        int bestOrder = 0;
+        bestCost = residualCost(x, n, 0);
+
+        for (int order = 1; order <= juce::jmin(maxPredictorOrder, n); ++order)
+        {
+            auto cost = residualCost(x, n, order);
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestOrder = order;
+            }
+        }
+
+        return bestOrder;
+    }
+
+    int chooseRiceParameter(const juce::uint32* values, int n) noexcept
+    {
+        juce::uint64 sum = 0;
+        for (int i = 0; i < n; ++i)
+            sum += values[i];
+
+        auto mean = (juce::uint32)juce::jmin<juce::uint64>(sum / (juce::uint64)juce::jmax(1, n), 0xffffffffu);
+        auto estimate = mean == 0 ? 0 : juce::findHighestSetBit(mean);
+
+        int bestK = 0;
+        auto bestBits = std::numeric_limits<juce::uint64>::max();
+
+        for (int k = juce::jmax(0, estimate - 2); k <= juce::jmin(30, estimate + 1); ++k)
+        {
+            juce::uint64 bits = 0;
+            for (int i = 0; i < n; ++i)
+            {
+                auto quotient = values[i] >> k;
+                bits += quotient < (juce::uint32)escapeUnaryLength ? quotient + 1 + (juce::uint32)k
+                    : (juce::uint32)(escapeUnaryLength + 32);
+            }
+
+            if (bits < bestBits)
+            {
+                bestBits = bits;
+                bestK = k;
+            }
+        }
+
+        return bestK;
+    }
+
+    void encodeChannel(BitWriter& writer, const juce::int32* x, int n)
+    {
+        juce::int64 cost;
+        auto order = chooseOrder(x, n, cost);
+        writer.write((juce::uint32)order, 2);
+
+        for (int i = 0; i < order; ++i)
+            writer.write(zigzagEncode(x[i]), 32);
+
+        juce::uint32 residuals[partitionSize];
+
+        for (int start = order; start < n; start += partitionSize)
+        {
+            auto count = juce::jmin(partitionSize, n - start);
+
+            for (int i = 0; i < count; ++i)
+                residuals[i] = zigzagEncode(x[start + i] - predict(x, start + i, order));
+
+            auto k = chooseRiceParameter(residuals, count);
+            writer.write((juce::uint32)k, 5);
+
+            for (int i = 0; i < count; ++i)
+                writer.writeRice(residuals[i], k);
+        }
+    }
+
+    void decodeChannel(BitReader& reader, juce::int32* x, int n) noexcept
+    {
+        auto order = juce::jmin((int)reader.read(2), n);
+
+        for (int i = 0; i < order; ++i)
+            x[i] = zigzagDecode(reader.read(32));
+
+        for (int start = order; start < n; start += partitionSize)
+        {
+            auto end = juce::jmin(n, start + partitionSize);
+            auto k = (int)reader.read(5);
+
+            // Keep the order switch outside the per-sample loop
+            switch (order)
+            {
+            case 0:
+                for (int i = start; i < end; ++i)
+                    x[i] = zigzagDecode(reader.readRice(k));
+                break;
+            case 1:
+                for (int i = start; i < end; ++i)
+                    x[i] = zigzagDecode(reader.readRice(k)) + x[i - 1];
+                break;
+            case 2:
+                for (int i = start; i < end; ++i)
+                    x[i] = zigzagDecode(reader.readRice(k)) + 2 * x[i - 1] - x[i - 2];
+                break;
+            default:
+                for (int i = start; i < end; ++i)
+                    x[i] = zigzagDecode(reader.readRice(k)) + 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3];
+                break;
+            }
+        }
+    }
+}
+
+//==============================================================================
+std::unique_ptr<CompressedSampleData> CompressedSampleData::encode(const juce::AudioBuffer<float>& source,
+    int bitsPerSample)
+{
+    const int channels = source.getNumChannels();
+    const int frames = source.getNumSamples();
+
+    if (channels < 1 || channels > 2 || frames == 0 || bitsPerSample < 8 || bitsPerSample > 24)
+        return nullptr;
+
+    std::unique_ptr<CompressedSampleData> result(new CompressedSampleData());
+    result->numChannels = channels;
+    result->numFrames = frames;
+    result->numBlocks = (frames + blockSize - 1) / blockSize;
+    result->bitsPerSample = bitsPerSample;
+    result->blockOffsets.malloc((size_t)result->numBlocks);
+
+    const auto fullScale = (float)(1 << (bitsPerSample - 1));
+    const auto scale = 1.0f / fullScale;
+    const auto maxValue = (1 << (bitsPerSample - 1)) - 1;
+    const auto minValue = -(1 << (bitsPerSample - 1));
+
+    BitWriter writer;
+    writer.bytes.reserve((size_t)frames * (size_t)channels * (size_t)bitsPerSample / 16);
+
+    std::vector<juce::int32> samples[2] = { std::vector<juce::int32>(blockSize), std::vector<juce::int32>(blockSize) };
+    std::vector<juce::int32> side(blockSize);
+
+    for (int block = 0; block < result->numBlocks; ++block)
+    {
+        result->blockOffsets[block] = (juce::uint32)writer.bytes.size();
+
+        const int start = block * blockSize;
+        const int n = juce::jmin(blockSize, frames - start);
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            auto* in = source.getReadPointer(ch, start);
+            auto* out = samples[ch].data();
+
+            for (int i = 0; i < n; ++i)
+            {
+                auto value = juce::roundToInt(in[i] * fullScale);
+
+                // Only store what we can give back bit-for-bit
+                if (value < minValue || value > maxValue || (float)value * scale != in[i])
+                    return nullptr;
+
+                out[i] = value;
+            }
+        }
+
+        const juce::int32* coded[2] = { samples[0].data(), samples[1].data() };
+
+        if (channels == 2)
+        {
+            for (int i = 0; i < n; ++i)
+                side[(size_t)i] = samples[0][(size_t)i] - samples[1][(size_t)i];
+
+            juce::int64 rightCost, sideCost;
+            chooseOrder(samples[1].data(), n, rightCost);
+            chooseOrder(side.data(), n, sideCost);
+
+            const bool useSide = sideCost < rightCost;
+            writer.write(useSide ? 1 : 0, 1);
+
+            if (useSide)
+                coded[1] = side.data();
+        }
+
+        for (int ch = 0; ch < channels; ++ch)
+            encodeChannel(writer, coded[ch], n);
+
+        writer.alignToByte();
+    }
+
+    // Padding so the reader can always refill a full word
+    for (int i = 0; i < 8; ++i)
+        writer.bytes.push_back(0);
+
+    result->stream.replaceAll(writer.bytes.data(), writer.bytes.size());
+    return result;
+}
+
+CompressedSampleData::~CompressedSampleData()
+{
+}
+
+size_t CompressedSampleData::getCompressedSizeBytes() const noexcept
+{
+    return stream.getSize() + (size_t)numBlocks * sizeof(juce::uint32);
+}
+
+size_t CompressedSampleData::getUncompressedSizeBytes() const noexcept
+{
+    return (size_t)numFrames * (size_t)numChannels * sizeof(float);
+}
+
+void CompressedSampleData::visitMemory(const std::function<void(const void*, size_t)>& visitor) const
+{
+    visitor(stream.getData(), stream.getSize());
+    visitor(blockOffsets.get(), (size_t)numBlocks * sizeof(juce::uint32));
+}
+
+int CompressedSampleData::decodeBlock(int blockIndex, float* const* destChannels) const noexcept
+{
+    if (!juce::isPositiveAndBelow(blockIndex, numBlocks))
+        return 0;
+
+    const int n = juce::jmin(blockSize, numFrames - blockIndex * blockSize);
+    BitReader reader(static_cast<const juce::uint8*>(stream.getData()) + blockOffsets[blockIndex]);
+
+    const bool useSide = numChannels == 2 && reader.read(1) != 0;
+
+    juce::int32 samples[2][blockSize];
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        decodeChannel(reader, samples[ch], n);
+
+    if (useSide)
+        for (int i = 0; i < n; ++i)
+            samples[1][i] = samples[0][i] - samples[1][i];
+
+    const auto scale = 1.0f / (float)(1 << (bitsPerSample - 1));
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* dest = destChannels[ch];
+        for (int i = 0; i < n; ++i)
+            dest[i] = (float)samples[ch][i] * scale;
+    }
+
+    return n;
+}
+
+//==============================================================================
+CompressedSampleData::DecodeWindow::DecodeWindow()
+{
+}
+
+void CompressedSampleData::DecodeWindow::allocate()
+{
+    if (isAllocated())
+        return;
+
+    storage.setSize(2, capacityBlocks * blockSize);
+    loopHead.setSize(2, loopHeadBlocks * blockSize);
+    allocated.store(true, std::memory_order_release);
+}
+
+void CompressedSampleData::DecodeWindow::setSource(const CompressedSampleData* newSource, int loopStartFrame) noexcept
+{
+    // Nowhere to decode into: better silence than writing past the end
+    const auto canDecode = isAllocated();
+    jassert(newSource == nullptr || canDecode);
+    source = canDecode ? newSource : nullptr;
+
+    firstBlock = 0;
+    numResidentBlocks = 0;
+
+    loopHeadFirstBlock = (source != nullptr && juce::isPositiveAndBelow(loopStartFrame, source->numFrames))
+                       ? loopStartFrame / blockSize : -1;
+    numLoopHeadBlocks = 0;
+}
+
+juce::Range<int> CompressedSampleData::DecodeWindow::ensureResident(int firstFrame, int lastFrame) noexcept
+{
+    if (source == nullptr || !juce::isPositiveAndBelow(firstFrame, source->numFrames))
+        return {};
+
+    const int currentBlock = firstFrame / blockSize;
+
+    // Jumped outside the window (new note or a loop back) - start again
+    if (currentBlock < firstBlock || currentBlock >= firstBlock + numResidentBlocks)
+    {
+        firstBlock = currentBlock;
+        numResidentBlocks = 0;
+
+        // Back to the loop start, whose blocks are already decoded
+        if (currentBlock >= loopHeadFirstBlock && currentBlock < loopHeadFirstBlock + numLoopHeadBlocks)
+        {
+            firstBlock = loopHeadFirstBlock;
+            numResidentBlocks = numLoopHeadBlocks;
+
+            for (int ch = 0; ch < source->numChannels; ++ch)
+                storage.copyFrom(ch, 0, loopHead, ch, 0, numLoopHeadBlocks * blockSize);
+        }
+    }
+
+    const int lastBlock = juce::jmin(lastFrame / blockSize, source->numBlocks - 1);
+
+    while (firstBlock + numResidentBlocks <= lastBlock && appendBlock(currentBlock))
+    {
+    }
+
+    return getResidentRange();
+}
+
+void CompressedSampleData::DecodeWindow::decodeAhead(int currentFrame) noexcept
+{
+    if (source == nullptr)
+        return;
+
+    const int currentBlock = currentFrame / blockSize;
+    const int lastResident = firstBlock + numResidentBlocks - 1;
+
+    if (currentBlock >= firstBlock && currentBlock <= lastResident
+        && lastResident - currentBlock < lookaheadBlocks && appendBlock(currentBlock))
+    {
+        return;
+    }
+
+    appendLoopHeadBlock();
+}
+
+const float* CompressedSampleData::DecodeWindow::getReadPointer(int channel) const noexcept
+{
+    if (!isAllocated())
+        return nullptr;
+
+    const int numSourceChannels = source != nullptr ? source->numChannels : 1;
+    return storage.getReadPointer(juce::jmin(channel, numSourceChannels - 1));
+}
+
+juce::Range<int> CompressedSampleData::DecodeWindow::getResidentRange() const noexcept
+{
+    if (source == nullptr)
+        return {};
+
+    return { firstBlock * blockSize,
+             juce::jmin(source->numFrames, (firstBlock + numResidentBlocks) * blockSize) };
+}
+
+bool CompressedSampleData::DecodeWindow::appendBlock(int currentBlock) noexcept
+{
+    const int nextBlock = firstBlock + numResidentBlocks;
+
+    if (nextBlock >= source->numBlocks)
+        return false;
+
+    if (numResidentBlocks == capacityBlocks)
+    {
+        // Drop the blocks the voice has already played past
+        const int blocksToDrop = currentBlock - firstBlock;
+        if (blocksToDrop <= 0)
+            return false;
+
+        const int framesToKeep = (numResidentBlocks - blocksToDrop) * blockSize;
+        for (int ch = 0; ch < storage.getNumChannels(); ++ch)
+        {
+            auto* data = storage.getWritePointer(ch);
+            std::memmove(data, data + blocksToDrop * blockSize, (size_t)framesToKeep * sizeof(float));
+        }
+
+        firstBlock += blocksToDrop;
+        numResidentBlocks -= blocksToDrop;
+    }
+
+    const int offset = numResidentBlocks * blockSize;
+    float* dest[2] = { storage.getWritePointer(0, offset), storage.getWritePointer(1, offset) };
+    decode(firstBlock + numResidentBlocks, dest);
+
+    ++numResidentBlocks;
+    return true;
+}
+
+bool CompressedSampleData::DecodeWindow::appendLoopHeadBlock() noexcept
+{
+    if (loopHeadFirstBlock < 0 || numLoopHeadBlocks == loopHeadBlocks
+        || loopHeadFirstBlock + numLoopHeadBlocks >= source->numBlocks)
+        return false;
+
+    const int block = loopHeadFirstBlock + numLoopHeadBlocks;
+    const int offset = numLoopHeadBlocks * blockSize;
+
+    // On the first pass the window has usually decoded it already
+    if (block >= firstBlock && block < firstBlock + numResidentBlocks)
+    {
+        for (int ch = 0; ch < source->numChannels; ++ch)
+            loopHead.copyFrom(ch, offset, storage, ch, (block - firstBlock) * blockSize, blockSize);
+    }
+    else
+    {
+        float* dest[2] = { loopHead.getWritePointer(0, offset), loopHead.getWritePointer(1, offset) };
+        decode(block, dest);
+    }
+
+    ++numLoopHeadBlocks;
+    return true;
+}
+
+void CompressedSampleData::DecodeWindow::decode(int blockIndex, float* const* dest) noexcept
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    source->decodeBlock(blockIndex, dest);
+    decodeTicks.fetch_add(juce::Time::getHighResolutionTicks() - startTicks, std::memory_order_relaxed);
+    blocksDecoded.fetch_add(1, std::memory_order_relaxed);
+}
\ No newline at end of file
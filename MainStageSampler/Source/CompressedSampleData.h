@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+    CompressedSampleData.h
+    Created: Lossless in-RAM sample compression
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Holds a sample body as a sequence of independently decodable, losslessly
+    compressed blocks.
+
+    Each block stores a fixed polynomial predictor per channel (optionally on a
+    left/side pair) followed by Rice-coded residuals, so any block can be
+    decoded on the audio thread without touching its neighbours.
+*/
+class CompressedSampleData
+{
+public:
+    //==============================================================================
+    /** Number of frames in every block except possibly the last one. */
+    static constexpr int blockSize = 1024;
+
+    /** Compresses the given audio.
+
+        The samples are expected to be integer PCM of the given bit depth that was
+        converted to float (as the audio format readers do). If any sample can't be
+        reproduced exactly, or the layout isn't mono/stereo, this returns nullptr
+        and the caller should keep the uncompressed data.
+    */
+    static std::unique_ptr<CompressedSampleData> encode(const juce::AudioBuffer<float>& source,
+        int bitsPerSample);
+
+    ~CompressedSampleData();
+
+    //==============================================================================
+    int getNumChannels() const noexcept { return numChannels; }
+    int getNumFrames() const noexcept { return numFrames; }
+    int getNumBlocks() const noexcept { return numBlocks; }
+
+    /** Returns the number of bytes held in RAM for this sample. */
+    size_t getCompressedSizeBytes() const noexcept;
+
+    /** Returns the number of bytes the sample would take as float audio. */
+    size_t getUncompressedSizeBytes() const noexcept;
+
+    /** Calls the visitor with each block of memory holding the compressed data. */
+    void visitMemory(const std::function<void(const void* data, size_t numBytes)>& visitor) const;
+
+    /** Decodes one block into the destination channels, each of which must have
+        room for blockSize floats. Returns the number of frames written.
+
+        This doesn't allocate or lock, so it can be called from the audio thread.
+    */
+    int decodeBlock(int blockIndex, float* const* destChannels) const noexcept;
+
+    //==============================================================================
+    /**
+        A per-voice window of decoded blocks.
+
+        The voice asks for the frames it's about to read and the window makes sure
+        they're resident, then keeps decoding a few blocks ahead of the play
+        position so the work is spread across callbacks instead of arriving in
+        bursts at block boundaries.
+    */
+    class DecodeWindow
+    {
+    public:
+        /** Maximum number of decoded blocks held at once. */
+        static constexpr int capacityBlocks = 8;
+
+        /** Number of blocks to keep decoded beyond the one being played. */
+        static constexpr int lookaheadBlocks = 3;
+
+        /** Number of blocks from the loop start kept decoded for the jump back. */
+        static constexpr int loopHeadBlocks = 2;
+
+        DecodeWindow();
+
+        /** Makes room for the decoded blocks. Windows start empty, so voices that
+            never play a compressed sample don't carry the memory; call this before
+            giving the window a source. It allocates, so not on the audio thread, but
+            it may run while the audio thread is calling setSource(): the storage is
+            only published once it's complete, and never changes after that.
+        */
+        void allocate();
+
+        /** Returns true once allocate() has finished. */
+        bool isAllocated() const noexcept { return allocated.load(std::memory_order_acquire); }
+
+        /** Points the window at a new sample and discards anything decoded.
+
+            If the sample loops, pass the first frame of the loop. The blocks from
+            there are decoded ahead of time along with the others and kept, so the
+            jump back doesn't have to decode them all at once.
+        */
+        void setSource(const CompressedSampleData* newSource, int loopStartFrame = -1) noexcept;
+
+        /** Makes sure the given frames are decoded, as far as the window capacity
+            allows, and returns the range of frames that are now resident. The
+            returned range always contains firstFrame if it's inside the sample.
+        */
+        juce::Range<int> ensureResident(int firstFrame, int lastFrame) noexcept;
+
+        /** Decodes at most one more block: the next one if the window holds fewer
+            than lookaheadBlocks beyond the block containing currentFrame, or else
+            the next of the loop start's blocks.
+        */
+        void decodeAhead(int currentFrame) noexcept;
+
+        /** Returns the decoded data for a channel. Index 0 is the first frame of
+            getResidentRange().
+        */
+        const float* getReadPointer(int channel) const noexcept;
+
+        /** Returns the frames currently decoded. */
+        juce::Range<int> getResidentRange() const noexcept;
+
+        /** Returns the time spent decoding, in high resolution ticks. */
+        juce::int64 getDecodeTicks() const noexcept { return decodeTicks.load(std::memory_order_relaxed); }
+
+        /** Returns the number of blocks decoded so far. */
+        juce::int64 getBlocksDecoded() const noexcept { return blocksDecoded.load(std::memory_order_relaxed); }
+
+    private:
+        bool appendBlock(int currentBlock) noexcept;
+        bool appendLoopHeadBlock() noexcept;
+        void decode(int blockIndex, float* const* dest) noexcept;
+
+        const CompressedSampleData* source = nullptr;
+        juce::AudioBuffer<float> storage;
+        int firstBlock = 0;
+        int numResidentBlocks = 0;
+
+        // Decoded blocks from the loop start, copied in when playback jumps back there
+        juce::AudioBuffer<float> loopHead;
+        int loopHeadFirstBlock = -1;
+        int numLoopHeadBlocks = 0;
+
+        // Set last by allocate(), so a reader that sees it also sees the storage
+        std::atomic<bool> allocated { false };
+
+        std::atomic<juce::int64> decodeTicks { 0 };
+        std::atomic<juce::int64> blocksDecoded { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodeWindow)
+    };
+
+private:
+    //==============================================================================
+    CompressedSampleData() = default;
+
+    int numChannels = 0;
+    int numFrames = 0;
+    int numBlocks = 0;
+    int bitsPerSample = 16;
+
+    juce::MemoryBlock stream;
+    juce::HeapBlock<juce::uint32> blockOffsets;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CompressedSampleData)
+};
\ No newline at end of file
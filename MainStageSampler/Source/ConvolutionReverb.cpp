@@ -0,0 +1,636 @@
+/*
+  ==============================================================================
+
+    ConvolutionReverb.cpp
+    Created: Zero latency master bus convolution reverb
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "ConvolutionReverb.h"
+#include "RealtimeSupport.h"
+#include "RealtimeSafety.h"
+
+namespace
+{
+    constexpr int headLength = 64;          // taps applied directly
+    constexpr int earlyPartition = 64;      // audio thread partitions, covering the taps up to tailStart
+    constexpr int tailStart = 2048;
+    constexpr int tailPartition = 1024;     // background thread partitions
+    constexpr int tailSlots = 4;            // blocks of tail input/output in flight
+    constexpr double maxImpulseSeconds = 10.0;
+
+    // acc += a * b for spectra packed the way juce::dsp::FFT produces them
+    void multiplyAccumulate(float* acc, const float* a, const float* b, int numBins) noexcept
+    {
+        for (int i = 0; i < numBins; ++i)
+        {
+            const auto ar = a[2 * i], ai = a[2 * i + 1];
+            const auto br = b[2 * i], bi = b[2 * i + 1];
+            acc[2 * i] += ar * br - ai * bi;
+            acc[2 * i + 1] += ar * bi + ai * br;
+        }
+    }
+
+    void normaliseEnergy(juce::AudioBuffer<float>& impulse)
+    {
+        double energy = 0.0;
+
+        for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+        {
+            const auto* samples = impulse.getReadPointer(ch);
+            for (int i = 0; i < impulse.getNumSamples(); ++i)
+                energy += (double)samples[i] * samples[i];
+        }
+
+        energy /= juce::jmax(1, impulse.getNumChannels());
+
+        if (energy > 0.0)
+            impulse.applyGain((float)(1.0 / std::sqrt(energy)));
+    }
+
+    // Decaying noise whose high end dies away faster than its low end, with a few
+    // early reflections, standing in for a measured room
+    juce::AudioBuffer<float> generateRoom(ConvolutionReverb::RoomType type, float size, double sampleRate)
+    {
+        struct Character
+        {
+            double rt60;          // seconds, at mid size
+            double predelay;      // seconds
+            double brightness;    // lowpass cutoff at the start of the tail, Hz
+            double damping;       // how fast that cutoff falls, per second
+            int numReflections;
+        };
+
+        static const Character characters[] =
+        {
+            { 2.4, 0.025, 9000.0, 1.2, 12 },    // hall
+            { 0.7, 0.004, 7000.0, 3.0, 8 },     // room
+            { 1.3, 0.012, 8000.0, 2.0, 10 },    // chamber
+            { 1.8, 0.0, 14000.0, 0.8, 0 }       // plate
+        };
+
+        const auto& character = characters[(int)type];
+        const auto rt60 = character.rt60 * (0.4 + 1.2 * (double)size);
+        const auto numFrames = (int)(juce::jmin(maxImpulseSeconds, character.predelay + 1.2 * rt60) * sampleRate);
+        const auto predelayFrames = (int)(character.predelay * sampleRate);
+
+        juce::AudioBuffer<float> impulse(2, juce::jmax(1, numFrames));
+        impulse.clear();
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            // Fixed seeds, so the same settings always give the same room
+            juce::Random random(0x5eed + 2 * (int)type + ch);
+            auto* samples = impulse.getWritePointer(ch);
+            double lowpass = 0.0;
+
+            for (int i = predelayFrames; i < numFrames; ++i)
+            {
+                const auto t = (double)(i - predelayFrames) / sampleRate;
+                const auto cutoff = 200.0 + character.brightness * std::exp(-t * character.damping);
+                const auto coefficient = std::exp(-juce::MathConstants<double>::twoPi * juce::jmin(cutoff, 0.45 * sampleRate) / sampleRate);
+
+                lowpass += (1.0 - coefficient) * ((double)random.nextFloat() * 2.0 - 1.0 - lowpass);
+                samples[i] = (float)(lowpass * std::exp(-6.9078 * t / rt60));
+            }
+
+            for (int r = 0; r < character.numReflections; ++r)
+            {
+                auto frame = predelayFrames + (int)(random.nextDouble() * 0.08 * (0.5 + size) * sampleRate);
+                if (frame < numFrames)
+                    samples[frame] += (random.nextBool() ? 1.0f : -1.0f) * (0.3f + 0.4f * random.nextFloat()) / (float)(1 + r / 4);
+            }
+        }
+
+        return impulse;
+    }
+}
+
+//==============================================================================
+/** A uniformly partitioned overlap-save convolver for one section of the impulse response. */
+class ConvolutionReverb::Stage
+{
+public:
+    Stage(const juce::AudioBuffer<float>& impulse, int firstTap, int endTap, int partitionLength)
+        : partitionSize(partitionLength),
+        fftSize(2 * partitionLength),
+        numBins(partitionLength + 1),
+        numPartitions((endTap - firstTap + partitionLength - 1) / partitionLength),
+        fft(juce::findHighestSetBit((juce::uint32)(2 * partitionLength)))
+    {
+        const size_t spectrumSize = (size_t)(2 * numBins);
+
+        filters.calloc((size_t)(numChannels * numPartitions) * spectrumSize);
+        delayLine.calloc((size_t)(numChannels * numPartitions) * spectrumSize);
+        history.calloc((size_t)(numChannels * fftSize));
+        work.calloc((size_t)(2 * fftSize));
+        accumulator.calloc(spectrumSize);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto* taps = impulse.getReadPointer(juce::jmin(ch, impulse.getNumChannels() - 1));
+
+            for (int p = 0; p < numPartitions; ++p)
+            {
+                const int first = firstTap + p * partitionSize;
+                const int num = juce::jmin(partitionSize, endTap - first);
+
+                juce::FloatVectorOperations::clear(work.get(), 2 * fftSize);
+                juce::FloatVectorOperations::copy(work.get(), taps + first, num);
+                fft.performRealOnlyForwardTransform(work.get(), true);
+                juce::FloatVectorOperations::copy(getFilter(ch, p), work.get(), (int)spectrumSize);
+            }
+        }
+    }
+
+    void reset() noexcept
+    {
+        juce::FloatVectorOperations::clear(delayLine.get(), numChannels * numPartitions * 2 * numBins);
+        juce::FloatVectorOperations::clear(history.get(), numChannels * fftSize);
+        position = 0;
+    }
+
+    /** Convolves the next partitionSize samples of each input channel, writing
+        partitionSize samples to each output channel.
+    */
+    void process(const float* const* input, float* const* output, int numChannelsToProcess) noexcept
+    {
+        const int spectrumSize = 2 * numBins;
+
+        for (int ch = 0; ch < numChannelsToProcess; ++ch)
+        {
+            // Overlap-save: transform the previous and current partitions together
+            auto* previous = history.get() + ch * fftSize;
+            std::memmove(previous, previous + partitionSize, (size_t)partitionSize * sizeof(float));
+            juce::FloatVectorOperations::copy(previous + partitionSize, input[ch], partitionSize);
+
+            juce::FloatVectorOperations::copy(work.get(), previous, fftSize);
+            juce::FloatVectorOperations::clear(work.get() + fftSize, fftSize);
+            fft.performRealOnlyForwardTransform(work.get(), true);
+            juce::FloatVectorOperations::copy(getDelayLine(ch, position), work.get(), spectrumSize);
+
+            juce::FloatVectorOperations::clear(accumulator.get(), spectrumSize);
+
+            for (int p = 0; p < numPartitions; ++p)
+            {
+                const int slot = (position - p + numPartitions) % numPartitions;
+                multiplyAccumulate(accumulator.get(), getDelayLine(ch, slot), getFilter(ch, p), numBins);
+            }
+
+            juce::FloatVectorOperations::copy(work.get(), accumulator.get(), spectrumSize);
+            fft.performRealOnlyInverseTransform(work.get());
+
+            // The first half wrapped around, the second half is the output
+            juce::FloatVectorOperations::copy(output[ch], work.get() + partitionSize, partitionSize);
+        }
+
+        position = (position + 1) % numPartitions;
+    }
+
+private:
+    float* getFilter(int ch, int partition) const noexcept      { return filters.get() + (size_t)((ch * numPartitions + partition) * 2 * numBins); }
+    float* getDelayLine(int ch, int partition) const noexcept   { return delayLine.get() + (size_t)((ch * numPartitions + partition) * 2 * numBins); }
+
+    static constexpr int numChannels = 2;
+
+    const int partitionSize, fftSize, numBins, numPartitions;
+    juce::dsp::FFT fft;
+
+    juce::HeapBlock<float> filters;      // spectrum of each partition of the impulse
+    juce::HeapBlock<float> delayLine;    // spectra of the most recent input partitions
+    juce::HeapBlock<float> history;      // previous and current input partition, per channel
+    juce::HeapBlock<float> work;
+    juce::HeapBlock<float> accumulator;
+    int position = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(Stage)
+};
+
+//==============================================================================
+/** Everything built from one impulse response, plus the state of its convolution. */
+struct ConvolutionReverb::Kernel
+{
+    explicit Kernel(const juce::AudioBuffer<float>& impulse)
+        : length(impulse.getNumSamples()),
+        headInput(2, headLength - 1 + earlyPartition),
+        earlyInput(2, earlyPartition),
+        earlyOutput(2, earlyPartition),
+        tailInput(2, tailSlots * tailPartition),
+        tailOutput(2, tailSlots * tailPartition)
+    {
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            const auto* taps = impulse.getReadPointer(juce::jmin(ch, impulse.getNumChannels() - 1));
+            for (int i = 0; i < juce::jmin(headLength, length); ++i)
+                headTaps[ch][i] = taps[i];
+        }
+
+        if (length > headLength)
+            early = std::make_unique<Stage>(impulse, headLength, juce::jmin(length, tailStart), earlyPartition);
+
+        if (length > tailStart)
+            tail = std::make_unique<Stage>(impulse, tailStart, length, tailPartition);
+
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        headInput.clear();
+        earlyInput.clear();
+        earlyOutput.clear();
+        tailInput.clear();
+        tailOutput.clear();
+
+        if (early != nullptr)   early->reset();
+        if (tail != nullptr)    tail->reset();
+
+        framePosition = 0;
+        tailPosition = 0;
+        tailBlock = 0;
+        tailReady = true;
+        tailBlocksDone.store(0);
+    }
+
+    const int length;
+    float headTaps[2][headLength] = {};
+    std::unique_ptr<Stage> early, tail;
+
+    // Audio thread state
+    juce::AudioBuffer<float> headInput;      // the last headLength - 1 inputs, then the current chunk
+    juce::AudioBuffer<float> earlyInput, earlyOutput;
+    int framePosition = 0;                   // within the current early partition
+    int tailPosition = 0;                    // within the current tail block
+    juce::int64 tailBlock = 0;               // index of the tail block being played
+    bool tailReady = true;                   // false if the background thread missed this block
+
+    // Shared with the background thread. Input block k sits in slot k % tailSlots, and
+    // its result is played as block k + 2, from slot (k + 2) % tailSlots.
+    juce::AudioBuffer<float> tailInput, tailOutput;
+    std::atomic<juce::int64> tailBlocksDone { 0 };
+    std::atomic<int> jobsPending { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(Kernel)
+};
+
+//==============================================================================
+class ConvolutionReverb::TailThread : public juce::Thread
+{
+public:
+    explicit TailThread(ConvolutionReverb& reverb)
+        : juce::Thread("Reverb tail"), owner(reverb)
+    {
+    }
+
+    void run() override
+    {
+        int appliedPriority = 0;
+
+        while (!threadShouldExit())
+        {
+            auto priority = owner.workerPriority.load();
+            if (priority != appliedPriority)
+            {
+                appliedPriority = priority;
+
+                juce::String error;
+                if (priority > 0 && !RealtimeThread::requestRealtimeScheduling(priority, error))
+                    DBG("Reverb tail thread: " + error);
+            }
+
+            {
+                // The jobs have deadlines as real as the audio thread's. The wait below doesn't.
+                RealtimeSafety::ScopedRealtimeContext realtimeContext("reverb tail");
+
+                while (owner.processNextTailJob())
+                {
+                }
+            }
+
+            // Polled rather than signalled, so the audio thread never touches a lock.
+            // Each job has a whole block (over 20ms) of slack.
+            wait(1);
+        }
+    }
+
+private:
+    ConvolutionReverb& owner;
+};
+
+//==============================================================================
+ConvolutionReverb::ConvolutionReverb()
+{
+    tailThread = std::make_unique<TailThread>(*this);
+    tailThread->startThread();
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+    tailThread->stopThread(2000);
+
+    delete currentKernel;
+    delete pendingKernel.exchange(nullptr);
+    delete retiredKernel.exchange(nullptr);
+}
+
+void ConvolutionReverb::prepare(double newSampleRate, int /*maximumBlockSize*/)
+{
+    sampleRate = newSampleRate;
+    smoothedWet.setCurrentAndTargetValue(wetLevel);
+
+    rebuildKernel();
+
+    // Nothing is playing, so take the new kernel straight away
+    waitForTailJobs();
+
+    if (auto* newKernel = pendingKernel.exchange(nullptr))
+    {
+        delete currentKernel;
+        currentKernel = newKernel;
+    }
+
+    collectGarbage();
+    reset();
+}
+
+void ConvolutionReverb::reset()
+{
+    waitForTailJobs();
+
+    if (currentKernel != nullptr)
+        currentKernel->reset();
+}
+
+void ConvolutionReverb::setRoom(RoomType type, float size)
+{
+    {
+        const juce::ScopedLock sl(sourceLock);
+        roomType = type;
+        roomSize = juce::jlimit(0.0f, 1.0f, size);
+        useRoom = true;
+    }
+
+    rebuildKernel();
+}
+
+bool ConvolutionReverb::loadImpulseResponse(const juce::File& file)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+
+    if (reader == nullptr)
+    {
+        DBG("ConvolutionReverb: Cannot read impulse response " + file.getFullPathName());
+        return false;
+    }
+
+    const auto numFrames = (int)juce::jmin(reader->lengthInSamples, (juce::int64)(maxImpulseSeconds * reader->sampleRate));
+    juce::AudioBuffer<float> impulse(juce::jlimit(1, 2, (int)reader->numChannels), numFrames);
+    reader->read(&impulse, 0, numFrames, 0, true, true);
+
+    DBG("ConvolutionReverb: Loaded impulse response " + file.getFileName() + ", " +
+        juce::String((double)numFrames / reader->sampleRate, 2) + "s");
+
+    setImpulseResponse(impulse, reader->sampleRate);
+    return true;
+}
+
+void ConvolutionReverb::setImpulseResponse(const juce::AudioBuffer<float>& impulse, double impulseSampleRate)
+{
+    {
+        const juce::ScopedLock sl(sourceLock);
+        sourceImpulse.makeCopyOf(impulse);
+        sourceSampleRate = impulseSampleRate;
+        useRoom = false;
+    }
+
+    rebuildKernel();
+}
+
+void ConvolutionReverb::rebuildKernel()
+{
+    const juce::ScopedLock sl(sourceLock);
+
+    juce::AudioBuffer<float> impulse;
+
+    if (useRoom)
+    {
+        impulse = generateRoom(roomType, roomSize, sampleRate);
+    }
+    else if (sourceSampleRate == sampleRate || sourceSampleRate <= 0.0)
+    {
+        impulse.makeCopyOf(sourceImpulse);
+    }
+    else
+    {
+        const auto ratio = sourceSampleRate / sampleRate;
+        impulse.setSize(sourceImpulse.getNumChannels(), juce::jmax(1, (int)(sourceImpulse.getNumSamples() / ratio)));
+
+        for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+        {
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process(ratio, sourceImpulse.getReadPointer(ch), impulse.getWritePointer(ch), impulse.getNumSamples());
+        }
+    }
+
+    normaliseEnergy(impulse);
+    impulseLengthSeconds.store((double)impulse.getNumSamples() / sampleRate);
+
+    installKernel(std::make_unique<Kernel>(impulse));
+}
+
+void ConvolutionReverb::installKernel(std::unique_ptr<Kernel> newKernel)
+{
+    collectGarbage();
+
+    // A kernel that was still waiting has never been seen by the audio thread
+    delete pendingKernel.exchange(newKernel.release());
+}
+
+void ConvolutionReverb::collectGarbage()
+{
+    auto* retired = retiredKernel.load();
+
+    if (retired != nullptr && retired->jobsPending.load() == 0)
+    {
+        retiredKernel.store(nullptr);
+        delete retired;
+    }
+}
+
+void ConvolutionReverb::waitForTailJobs()
+{
+    for (int i = 0; i < 2000; ++i)
+    {
+        if ((currentKernel == nullptr || currentKernel->jobsPending.load() == 0) && tailFifo.getNumReady() == 0)
+            return;
+
+        juce::Thread::sleep(1);
+    }
+
+    jassertfalse; // the tail thread seems to be stuck
+}
+
+double ConvolutionReverb::getImpulseLengthSeconds() const noexcept
+{
+    return impulseLengthSeconds.load();
+}
+
+//==============================================================================
+void ConvolutionReverb::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    // Swap in a new impulse response once the previous old one has been cleared away
+    if (retiredKernel.load() == nullptr)
+    {
+        if (auto* newKernel = pendingKernel.exchange(nullptr))
+        {
+            retiredKernel.store(currentKernel);
+            currentKernel = newKernel;
+        }
+    }
+
+    auto* kernel = currentKernel;
+    // The level moves from the last block's setting to this one's across the block
+    smoothedWet.reset(numSamples);
+    smoothedWet.setTargetValue(wetLevel);
+
+    if (kernel == nullptr || (smoothedWet.getTargetValue() == 0.0f && !smoothedWet.isSmoothing()))
+        return;
+
+    const int numChannels = juce::jmin(2, buffer.getNumChannels());
+    float gains[earlyPartition];
+
+    for (int done = 0; done < numSamples;)
+    {
+        // Work up to the end of the current early partition
+        const int num = juce::jmin(numSamples - done, earlyPartition - kernel->framePosition);
+        const int tailOffset = (int)(kernel->tailBlock % tailSlots) * tailPartition + kernel->tailPosition;
+        const bool useTail = kernel->tail != nullptr && kernel->tailReady;
+
+        for (int i = 0; i < num; ++i)
+            gains[i] = smoothedWet.getNextValue();
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* io = buffer.getWritePointer(ch, startSample + done);
+            auto* recent = kernel->headInput.getWritePointer(ch);
+            const auto* taps = kernel->headTaps[ch];
+            const auto* early = kernel->earlyOutput.getReadPointer(ch, kernel->framePosition);
+            const auto* tail = useTail ? kernel->tailOutput.getReadPointer(ch, tailOffset) : nullptr;
+
+            juce::FloatVectorOperations::copy(recent + headLength - 1, io, num);
+            juce::FloatVectorOperations::copy(kernel->earlyInput.getWritePointer(ch, kernel->framePosition), io, num);
+            juce::FloatVectorOperations::copy(kernel->tailInput.getWritePointer(ch, tailOffset), io, num);
+
+            for (int i = 0; i < num; ++i)
+            {
+                const auto* x = recent + headLength - 1 + i;
+                float wet = early[i];
+
+                for (int t = 0; t < headLength; ++t)
+                    wet += taps[t] * x[-t];
+
+                if (tail != nullptr)
+                    wet += tail[i];
+
+                io[i] += gains[i] * wet;
+            }
+
+            std::memmove(recent, recent + num, (size_t)(headLength - 1) * sizeof(float));
+        }
+
+        kernel->framePosition += num;
+        kernel->tailPosition += num;
+        done += num;
+
+        if (kernel->framePosition == earlyPartition)
+        {
+            kernel->framePosition = 0;
+
+            if (kernel->early != nullptr)
+            {
+                const float* in[2] = { kernel->earlyInput.getReadPointer(0), kernel->earlyInput.getReadPointer(1) };
+                float* out[2] = { kernel->earlyOutput.getWritePointer(0), kernel->earlyOutput.getWritePointer(1) };
+                kernel->early->process(in, out, numChannels);
+            }
+        }
+
+        if (kernel->tailPosition == tailPartition)
+        {
+            kernel->tailPosition = 0;
+
+            if (kernel->tail != nullptr)
+            {
+                submitTailJob(*kernel);
+                ++kernel->tailBlock;
+
+                // Block m plays the result of job m - 2
+                kernel->tailReady = kernel->tailBlock < 2 || kernel->tailBlocksDone.load(std::memory_order_acquire) >= kernel->tailBlock - 1;
+
+                if (!kernel->tailReady)
+                    tailUnderruns.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void ConvolutionReverb::submitTailJob(Kernel& kernel) noexcept
+{
+    const TailJob job { &kernel, kernel.tailBlock };
+    kernel.jobsPending.fetch_add(1);
+
+    if (nonRealtime.load())
+    {
+        processTailJob(job);
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    tailFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 > 0)
+    {
+        tailJobs[(size_t)start1] = job;
+        tailFifo.finishedWrite(1);
+    }
+    else
+    {
+        // The background thread is hopelessly behind, drop this block
+        kernel.jobsPending.fetch_sub(1);
+        tailUnderruns.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool ConvolutionReverb::processNextTailJob() noexcept
+{
+    int start1, size1, start2, size2;
+    tailFifo.prepareToRead(1, start1, size1, start2, size2);
+
+    if (size1 == 0)
+        return false;
+
+    const auto job = tailJobs[(size_t)start1];
+    tailFifo.finishedRead(1);
+
+    processTailJob(job);
+    return true;
+}
+
+void ConvolutionReverb::processTailJob(const TailJob& job) noexcept
+{
+    auto& kernel = *job.kernel;
+    const int inputOffset = (int)(job.block % tailSlots) * tailPartition;
+    const int outputOffset = (int)((job.block + 2) % tailSlots) * tailPartition;
+
+    const float* in[2] = { kernel.tailInput.getReadPointer(0, inputOffset), kernel.tailInput.getReadPointer(1, inputOffset) };
+    float* out[2] = { kernel.tailOutput.getWritePointer(0, outputOffset), kernel.tailOutput.getWritePointer(1, outputOffset) };
+
+    kernel.tail->process(in, out, 2);
+
+    kernel.tailBlocksDone.store(job.block + 1, std::memory_order_release);
+    kernel.jobsPending.fetch_sub(1, std::memory_order_release);
+}
\ No newline at end of file
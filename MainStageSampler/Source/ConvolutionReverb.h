@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    ConvolutionReverb.h
+    Created: Zero latency master bus convolution reverb
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A master bus reverb that convolves the mix with an impulse response using
+    non-uniform partitioned convolution.
+
+    The impulse response is split into three parts so that nothing is added to
+    the latency and the expensive work is done in big, efficient chunks:
+
+    - the first 64 taps are applied directly in the time domain,
+    - taps 64 to 2048 use 64-sample FFT partitions on the audio thread,
+    - everything after that uses 1024-sample FFT partitions, computed on a
+      background thread with a full block of slack before it's needed.
+
+    Impulse responses can be loaded from audio files or generated for one of the
+    built-in room types.
+*/
+class ConvolutionReverb
+{
+public:
+    //==============================================================================
+    /** The generated rooms offered when no impulse response file is loaded. */
+    enum class RoomType
+    {
+        hall = 0,
+        room,
+        chamber,
+        plate
+    };
+
+    ConvolutionReverb();
+    ~ConvolutionReverb();
+
+    //==============================================================================
+    /** Prepares for playback. Call this while the audio callback isn't running. */
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    /** Clears the reverb tail. Call this while the audio callback isn't running. */
+    void reset();
+
+    /** Adds the reverb of the first two channels of the buffer to themselves. */
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    //==============================================================================
+    /** Sets the wet level, from 0 to 1. The next process() ramps to it across its
+        block. Call from the audio thread, or while it isn't running.
+    */
+    void setWetLevel(float newLevel) noexcept { wetLevel = newLevel; }
+
+    /** Switches to a generated room. Size goes from 0 (small, short) to 1 (large, long).
+        This builds the new impulse response on the calling thread, so don't call it
+        from the audio thread.
+    */
+    void setRoom(RoomType type, float size);
+
+    /** Loads an impulse response from an audio file, resampling it to the playback
+        rate if needed. Returns false if the file couldn't be read.
+    */
+    bool loadImpulseResponse(const juce::File& file);
+
+    /** Uses the given impulse response (mono or stereo) recorded at the given rate. */
+    void setImpulseResponse(const juce::AudioBuffer<float>& impulse, double impulseSampleRate);
+
+    /** Returns the length of the impulse response in use, in seconds. */
+    double getImpulseLengthSeconds() const noexcept;
+
+    //==============================================================================
+    /** When true, the background partitions are computed in line on the calling
+        thread, so offline renders are exact and repeatable whatever the CPU load.
+    */
+    void setNonRealtime(bool shouldBeNonRealtime) noexcept { nonRealtime.store(shouldBeNonRealtime); }
+
+    /** Asks for real-time scheduling on the background thread (see RealtimeThread). 0 leaves it alone. */
+    void setWorkerRealtimePriority(int priority) noexcept { workerPriority.store(priority); }
+
+    /** Returns the number of 1024-sample blocks where the background thread was late
+        and the far tail had to be dropped.
+    */
+    juce::int64 getTailUnderruns() const noexcept { return tailUnderruns.load(std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    class Stage;
+    struct Kernel;
+    class TailThread;
+
+    struct TailJob
+    {
+        Kernel* kernel;
+        juce::int64 block;
+    };
+
+    void rebuildKernel();
+    void installKernel(std::unique_ptr<Kernel> newKernel);
+    void collectGarbage();
+    void waitForTailJobs();
+    void submitTailJob(Kernel& kernel) noexcept;
+    void processTailJob(const TailJob& job) noexcept;
+    bool processNextTailJob() noexcept;
+
+    //==============================================================================
+    double sampleRate = 44100.0;
+
+    // What the current kernel was built from, so it can be rebuilt at a new rate
+    juce::AudioBuffer<float> sourceImpulse;
+    double sourceSampleRate = 0.0;
+    RoomType roomType = RoomType::hall;
+    float roomSize = 0.6f;
+    bool useRoom = true;
+    juce::CriticalSection sourceLock;
+    std::atomic<double> impulseLengthSeconds { 0.0 };
+
+    // The audio thread adopts the pending kernel and hands the old one back to be deleted
+    Kernel* currentKernel = nullptr;
+    std::atomic<Kernel*> pendingKernel { nullptr };
+    std::atomic<Kernel*> retiredKernel { nullptr };
+
+    juce::AbstractFifo tailFifo { 32 };
+    std::array<TailJob, 32> tailJobs {};
+    std::unique_ptr<TailThread> tailThread;
+
+    float wetLevel = 0.0f;
+    juce::SmoothedValue<float> smoothedWet;
+    std::atomic<bool> nonRealtime { false };
+    std::atomic<int> workerPriority { 0 };
+    std::atomic<juce::int64> tailUnderruns { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConvolutionReverb)
+};
\ No newline at end of file
@@ -20,11 +20,8 @@ EnhancedSFZLoader::~EnhancedSFZLoader()
 {
 }
 
-juce::Array<SampleSound::Ptr> EnhancedSFZLoader::loadSFZ(const juce::File& sfzFile)
+int EnhancedSFZLoader::parseSFZ(const juce::File& sfzFile)
 {
-    DBG("=== SALAMANDER SFZ LOADER ===");
-    DBG("Loading: " + sfzFile.getFullPathName());
-
     // Clear previous state
     variables.clear();
     masters.clear();
@@ -39,37 +36,79 @@ juce::Array<SampleSound::Ptr> EnhancedSFZLoader::loadSFZ(const juce::File& sfzFi
     if (!sfzFile.exists())
     {
         DBG("ERROR: SFZ file does not exist!");
-        return {};
+        return 0;
     }
 
-    try
+    // Parse the main file and all includes
+    parseFile(sfzFile);
+
+    DBG("=== PARSING RESULTS ===");
+    DBG("Variables: " + juce::String(variables.size()));
+    DBG("Masters: " + juce::String(masters.size()));
+    DBG("Groups: " + juce::String(groups.size()));
+    DBG("Regions: " + juce::String(regions.size()) + " *** KEY NUMBER ***");
+    DBG("Default path: '" + defaultPath + "'");
+
+    if (regions.size() == 0)
     {
-        // Parse the main file and all includes
-        parseFile(sfzFile);
+        DBG("*** CRITICAL ERROR: NO REGIONS FOUND! ***");
+        DBG("This means the include files aren't being processed correctly.");
+        return 0;
+    }
+
+    // Apply inheritance hierarchy
+    {
+        LoadPhaseTimer::Scope inheritance(phaseTimer, LoadProfile::Phase::inheritance);
+        applyInheritance();
+    }
+
+    return regions.size();
+}
+
+juce::Array<SampleSound::Ptr> EnhancedSFZLoader::loadSFZ(const juce::File& sfzFile)
+{
+    DBG("=== SALAMANDER SFZ LOADER ===");
+    DBG("Loading: " + sfzFile.getFullPathName());
 
-        DBG("=== PARSING RESULTS ===");
-        DBG("Variables: " + juce::String(variables.size()));
-        DBG("Masters: " + juce::String(masters.size()));
-        DBG("Groups: " + juce::String(groups.size()));
-        DBG("Regions: " + juce::String(regions.size()) + " *** KEY NUMBER ***");
-        DBG("Default path: '" + defaultPath + "'");
+    profile = {};
+    profile.sfzFile = sfzFile;
+    heldSampleBytes = 0;
+    phaseTimer.start(LoadProfile::Phase::parsing);
 
-        if (regions.size() == 0)
+    try
+    {
+        profile.numRegions = parseSFZ(sfzFile);
+
+        if (profile.numRegions == 0)
         {
-            DBG("*** CRITICAL ERROR: NO REGIONS FOUND! ***");
-            DBG("This means the include files aren't being processed correctly.");
+            phaseTimer.stop();
             return {};
         }
 
-        // Apply inheritance hierarchy
-        applyInheritance();
-
         // Create sample sounds
         auto sounds = createSampleSounds();
 
+        profile.numSounds = sounds.size();
+        phaseTimer.stop();
+        juce::Logger::writeToLog(profile.toString());
+
         DBG("=== FINAL RESULT ===");
         DBG("Created " + juce::String(sounds.size()) + " sample sounds");
 
+        if (options.compressSamples)
+        {
+            size_t storedBytes = 0, uncompressedBytes = 0;
+            for (auto& sound : sounds)
+            {
+                storedBytes += sound->getMemoryUsageBytes();
+                uncompressedBytes += sound->getUncompressedSizeBytes();
+            }
+
+            juce::Logger::writeToLog("Sample memory: " + juce::String((double)storedBytes / (1024.0 * 1024.0), 1) + " MB compressed from " +
+                juce::String((double)uncompressedBytes / (1024.0 * 1024.0), 1) + " MB (ratio " +
+                juce::String((double)uncompressedBytes / (double)juce::jmax<size_t>(1, storedBytes), 2) + ":1)");
+        }
+
         if (sounds.size() == 0)
         {
             DBG("*** ERROR: No sounds created from " + juce::String(regions.size()) + " regions! ***");
@@ -80,6 +119,7 @@ juce::Array<SampleSound::Ptr> EnhancedSFZLoader::loadSFZ(const juce::File& sfzFi
     catch (const std::exception& e)
     {
         DBG("Exception in SFZ loading: " + juce::String(e.what()));
+        phaseTimer.stop();
         return {};
     }
 }
@@ -94,7 +134,16 @@ void EnhancedSFZLoader::parseFile(const juce::File& file)
         return;
     }
 
-    juce::String content = file.loadFileAsString();
+    juce::String content;
+
+    {
+        // Reading the top file is part of parsing, reading the ones it includes isn't
+        LoadPhaseTimer::Scope reading(phaseTimer, file == currentSFZFile ? LoadProfile::Phase::parsing
+                                                                         : LoadProfile::Phase::includes);
+        content = file.loadFileAsString();
+        profile.bytesRead += file.getSize();
+    }
+
     if (content.isEmpty())
     {
         DBG("ERROR: File is empty: " + file.getFileName());
@@ -285,13 +334,20 @@ void EnhancedSFZLoader::handleInclude(const juce::String& line)
     if (startQuote >= 0 && endQuote > startQuote)
     {
         auto filename = line.substring(startQuote + 1, endQuote);
-        auto includeFile = currentSFZFile.getParentDirectory().getChildFile(filename);
+        juce::File includeFile;
+        bool found = false;
+
+        {
+            LoadPhaseTimer::Scope lookup(phaseTimer, LoadProfile::Phase::includes);
+            includeFile = currentSFZFile.getParentDirectory().getChildFile(filename);
+            found = includeFile.exists();
+        }
 
         DBG("Including: " + filename);
         DBG("Full path: " + includeFile.getFullPathName());
-        DBG("File exists: " + juce::String(includeFile.exists() ? "YES" : "NO"));
+        DBG("File exists: " + juce::String(found ? "YES" : "NO"));
 
-        if (includeFile.exists())
+        if (found)
         {
             // Recursively parse the included file
             parseFile(includeFile);
@@ -404,6 +460,16 @@ void EnhancedSFZLoader::applyOpcodeToRegion(const juce::String& key, const juce:
         region.sample = value;
         DBG("  sample: " + value);
     }
+    else if (key == "sample_overhead")
+    {
+        region.sample_overhead = value;
+        DBG("  sample_overhead: " + value);
+    }
+    else if (key == "sample_room")
+    {
+        region.sample_room = value;
+        DBG("  sample_room: " + value);
+    }
     else if (key == "lokey")
     {
         region.lokey = parseNoteValue(value);
@@ -449,14 +515,68 @@ void EnhancedSFZLoader::applyOpcodeToRegion(const juce::String& key, const juce:
     {
         region.transpose = juce::jlimit(-127, 127, value.getIntValue());
     }
+    else if (key == "ampeg_delay")
+    {
+        region.ampeg_delay = juce::jmax(0.0, value.getDoubleValue());
+    }
     else if (key == "ampeg_attack")
     {
         region.ampeg_attack = juce::jmax(0.0, value.getDoubleValue());
     }
+    else if (key == "ampeg_hold")
+    {
+        region.ampeg_hold = juce::jmax(0.0, value.getDoubleValue());
+    }
+    else if (key == "ampeg_decay")
+    {
+        region.ampeg_decay = juce::jmax(0.0, value.getDoubleValue());
+    }
+    else if (key == "ampeg_sustain")
+    {
+        region.ampeg_sustain = juce::jlimit(0.0, 100.0, value.getDoubleValue());
+    }
     else if (key == "ampeg_release")
     {
         region.ampeg_release = juce::jmax(0.0, value.getDoubleValue());
     }
+    else if (key == "loop_mode" || key == "loopmode")
+    {
+        region.loop_mode = value.trim();
+        DBG("  loop_mode: " + region.loop_mode);
+    }
+    else if (key == "loop_start" || key == "loopstart")
+    {
+        region.loop_start = juce::jmax(0, value.getIntValue());
+    }
+    else if (key == "loop_end" || key == "loopend")
+    {
+        region.loop_end = juce::jmax(0, value.getIntValue());
+    }
+    else if (key == "loop_crossfade")
+    {
+        region.loop_crossfade = juce::jmax(0.0, value.getDoubleValue());
+    }
+    else if (key == "cutoff")
+    {
+        region.cutoff = juce::jmax(0.0, value.getDoubleValue());
+        DBG("  cutoff: " + juce::String(region.cutoff));
+    }
+    else if (key == "resonance")
+    {
+        region.resonance = juce::jlimit(0.0, 40.0, value.getDoubleValue());
+    }
+    else if (key == "fil_type" || key == "filtype")
+    {
+        region.fil_type = parseFilterType(value);
+    }
+    else if (key == "fil_veltrack")
+    {
+        region.fil_veltrack = juce::jlimit(-9600, 9600, value.getIntValue());
+    }
+    else if (key == "trigger")
+    {
+        region.trigger = value.trim();
+    }
     // Add other opcodes as needed...
 }
 
@@ -476,6 +596,21 @@ int EnhancedSFZLoader::parseNoteValue(const juce::String& value)
     return juce::jlimit(0, 127, value.getIntValue());
 }
 
+int EnhancedSFZLoader::parseFilterType(const juce::String& value)
+{
+    // The voices run a 2-pole state variable filter, so the 1, 4 and 6 pole
+    // variants all get its slope
+    auto type = value.trim().toLowerCase();
+
+    if (type.startsWith("lpf")) return 0;
+    if (type.startsWith("hpf")) return 1;
+    if (type.startsWith("bpf")) return 2;
+    if (type.startsWith("brf")) return 3;
+
+    DBG("  fil_type " + value + " not supported, using lpf_2p");
+    return 0;
+}
+
 juce::String EnhancedSFZLoader::substituteVariables(const juce::String& input)
 {
     juce::String result = input;
@@ -539,6 +674,10 @@ void EnhancedSFZLoader::applyOpcodeToRegionDirect(SFZRegion& region, const juce:
     // Apply opcode without adding to opcodes list (to avoid duplicates)
     if (key == "sample" && region.sample.isEmpty())
         region.sample = value;
+    else if (key == "sample_overhead" && region.sample_overhead.isEmpty())
+        region.sample_overhead = value;
+    else if (key == "sample_room" && region.sample_room.isEmpty())
+        region.sample_room = value;
     else if (key == "lokey")
         region.lokey = parseNoteValue(value);
     else if (key == "hikey")
@@ -549,6 +688,36 @@ void EnhancedSFZLoader::applyOpcodeToRegionDirect(SFZRegion& region, const juce:
         region.hivel = juce::jlimit(0, 127, value.getIntValue());
     else if (key == "pitch_keycenter")
         region.pitch_keycenter = parseNoteValue(value);
+    else if (key == "loop_mode" || key == "loopmode")
+        region.loop_mode = value.trim();
+    else if (key == "loop_start" || key == "loopstart")
+        region.loop_start = juce::jmax(0, value.getIntValue());
+    else if (key == "loop_end" || key == "loopend")
+        region.loop_end = juce::jmax(0, value.getIntValue());
+    else if (key == "loop_crossfade")
+        region.loop_crossfade = juce::jmax(0.0, value.getDoubleValue());
+    else if (key == "cutoff")
+        region.cutoff = juce::jmax(0.0, value.getDoubleValue());
+    else if (key == "resonance")
+        region.resonance = juce::jlimit(0.0, 40.0, value.getDoubleValue());
+    else if (key == "fil_type" || key == "filtype")
+        region.fil_type = parseFilterType(value);
+    else if (key == "fil_veltrack")
+        region.fil_veltrack = juce::jlimit(-9600, 9600, value.getIntValue());
+    else if (key == "ampeg_delay")
+        region.ampeg_delay = juce::jmax(0.0, value.getDoubleValue());
+    else if (key == "ampeg_attack")
+        region.ampeg_attack = juce::jmax(0.0, value.getDoubleValue());
+    else if (key == "ampeg_hold")
+        region.ampeg_hold = juce::jmax(0.0, value.getDoubleValue());
+    else if (key == "ampeg_decay")
+        region.ampeg_decay = juce::jmax(0.0, value.getDoubleValue());
+    else if (key == "ampeg_sustain")
+        region.ampeg_sustain = juce::jlimit(0.0, 100.0, value.getDoubleValue());
+    else if (key == "ampeg_release")
+        region.ampeg_release = juce::jmax(0.0, value.getDoubleValue());
+    else if (key == "trigger")
+        region.trigger = value.trim();
     // Add other opcodes as needed...
 }
 
@@ -557,17 +726,30 @@ juce::Array<SampleSound::Ptr> EnhancedSFZLoader::createSampleSounds()
     DBG("=== CREATING SAMPLE SOUNDS ===");
     juce::Array<SampleSound::Ptr> sounds;
 
+    // Anything not timed as file lookup or decoding below is building the sounds
+    phaseTimer.switchTo(LoadProfile::Phase::soundConstruction);
+
     for (int i = 0; i < regions.size(); ++i)
     {
         const auto& region = regions.getReference(i);
 
+        if (options.skipReleaseTriggers && region.trigger == "release")
+        {
+            DBG("Region " + juce::String(i) + ": Skipping release trigger " + region.sample);
+            continue;
+        }
+
         if (region.sample.isNotEmpty())
         {
             DBG("Processing region " + juce::String(i) + ": " + region.sample);
-            auto sound = createSampleSound(region);
+            auto sound = createSampleSound(region, region.sample);
             if (sound != nullptr)
             {
+                addMicStreams(*sound, region);
                 sounds.add(sound);
+
+                heldSampleBytes += (juce::int64)sound->getMemoryUsageBytes();
+                profile.peakSampleBytes = juce::jmax(profile.peakSampleBytes, heldSampleBytes);
                 DBG("  SUCCESS: Created sound");
             }
             else
@@ -584,47 +766,121 @@ juce::Array<SampleSound::Ptr> EnhancedSFZLoader::createSampleSounds()
     return sounds;
 }
 
-SampleSound::Ptr EnhancedSFZLoader::createSampleSound(const SFZRegion& region)
+void EnhancedSFZLoader::addMicStreams(SampleSound& sound, const SFZRegion& region)
+{
+    const struct { SampleSound::Mic mic; const juce::String& sample; bool load; } mics[] =
+    {
+        { SampleSound::overheadMic, region.sample_overhead, options.loadOverheadMic },
+        { SampleSound::roomMic, region.sample_room, options.loadRoomMic }
+    };
+
+    for (const auto& m : mics)
+    {
+        if (m.sample.isEmpty() || !m.load)
+            continue;
+
+        // Built exactly as the close mic is, so the voice can read them side by side
+        auto stream = createSampleSound(region, m.sample);
+
+        if (stream == nullptr)
+            DBG("  ERROR: Could not load mic stream " + m.sample);
+        else if (!sound.setMicStream(m.mic, stream.get()))
+            DBG("  ERROR: Mic stream " + m.sample + " is " + juce::String(stream->getNumFrames()) +
+                " frames, the close mic is " + juce::String(sound.getNumFrames()));
+        else
+            DBG("  Added mic stream: " + m.sample);
+    }
+}
+
+SampleSound::Ptr EnhancedSFZLoader::createSampleSound(const SFZRegion& region, const juce::String& samplePath)
 {
     // Resolve sample file path using default_path
     juce::File sampleFile;
+    LoadPhaseTimer::Scope lookup(phaseTimer, LoadProfile::Phase::fileLookup);
 
     if (defaultPath.isNotEmpty())
     {
-        sampleFile = currentSFZFile.getParentDirectory().getChildFile(defaultPath + region.sample);
+        sampleFile = currentSFZFile.getParentDirectory().getChildFile(defaultPath + samplePath);
         DBG("  Trying with default_path: " + sampleFile.getFullPathName());
     }
 
     if (!sampleFile.existsAsFile())
     {
-        sampleFile = currentSFZFile.getParentDirectory().getChildFile(region.sample);
+        sampleFile = currentSFZFile.getParentDirectory().getChildFile(samplePath);
         DBG("  Trying direct path: " + sampleFile.getFullPathName());
     }
 
     if (!sampleFile.existsAsFile())
     {
-        sampleFile = currentSFZFile.getParentDirectory().getChildFile("Samples").getChildFile(region.sample);
+        sampleFile = currentSFZFile.getParentDirectory().getChildFile("Samples").getChildFile(samplePath);
         DBG("  Trying Samples folder: " + sampleFile.getFullPathName());
     }
 
     if (!sampleFile.existsAsFile())
     {
-        DBG("  ERROR: Sample file not found: " + region.sample);
+        DBG("  ERROR: Sample file not found: " + samplePath);
         return nullptr;
     }
 
     DBG("  Found sample: " + sampleFile.getFullPathName());
+    phaseTimer.switchTo(LoadProfile::Phase::decoding);
 
-    auto audioBuffer = loadAudioFile(sampleFile);
+    int bitsPerSample = 0;
+    double fileSampleRate = 0.0;
+    juce::Range<int> fileLoop;
+    auto audioBuffer = loadAudioFile(sampleFile, bitsPerSample, fileSampleRate, fileLoop);
     if (audioBuffer == nullptr)
     {
         DBG("  ERROR: Failed to load audio file");
         return nullptr;
     }
 
+    phaseTimer.switchTo(LoadProfile::Phase::soundConstruction);
+
     DBG("  Audio loaded: " + juce::String(audioBuffer->getNumChannels()) + " channels, " +
         juce::String(audioBuffer->getNumSamples()) + " samples");
 
+    // Loop mode defaults to looping when the file has a loop of its own, as the spec says
+    auto loopMode = SampleSound::LoopMode::none;
+
+    if (region.loop_mode == "one_shot")
+        loopMode = SampleSound::LoopMode::oneShot;
+    else if (region.loop_mode == "loop_continuous")
+        loopMode = SampleSound::LoopMode::continuous;
+    else if (region.loop_mode == "loop_sustain")
+        loopMode = SampleSound::LoopMode::sustain;
+    else if (region.loop_mode.isEmpty() && !fileLoop.isEmpty())
+        loopMode = SampleSound::LoopMode::continuous;
+
+    const bool looping = loopMode == SampleSound::LoopMode::continuous || loopMode == SampleSound::LoopMode::sustain;
+    juce::Range<int> loopFrames;
+
+    if (looping)
+    {
+        auto loopStart = region.loop_start >= 0 ? region.loop_start : (fileLoop.isEmpty() ? 0 : fileLoop.getStart());
+        auto loopEnd = region.loop_end >= 0 ? region.loop_end + 1 : (fileLoop.isEmpty() ? audioBuffer->getNumSamples() : fileLoop.getEnd());
+        loopFrames = { loopStart, juce::jmin(loopEnd, audioBuffer->getNumSamples()) };
+
+        DBG("  Loop: " + juce::String(loopFrames.getStart()) + "-" + juce::String(loopFrames.getEnd()) +
+            ", crossfade " + juce::String(region.loop_crossfade) + "s");
+
+        // Past the loop end a continuous loop is never heard. The jump back is interpolated
+        // from the sound's loop guard, so nothing past the end is needed. A sustain loop plays
+        // on past the end after release, so it keeps that audio.
+        if (options.trimAfterLoopEnd && loopFrames.getLength() > 0 && loopFrames.getEnd() < audioBuffer->getNumSamples())
+        {
+            if (loopMode == SampleSound::LoopMode::continuous)
+            {
+                audioBuffer->setSize(audioBuffer->getNumChannels(), loopFrames.getEnd(), true);
+                DBG("  Trimmed to " + juce::String(audioBuffer->getNumSamples()) + " samples");
+            }
+            else
+            {
+                DBG("  Not trimming: the sustain loop's release plays past the loop end");
+            }
+        }
+    }
+
     // Create MIDI note range
     juce::BigInteger midiNotes;
     for (int note = region.lokey; note <= region.hikey; ++note)
@@ -648,11 +904,68 @@ SampleSound::Ptr EnhancedSFZLoader::createSampleSound(const SFZRegion& region)
         velocityRange
     );
 
+    if (loopMode != SampleSound::LoopMode::none)
+        sound->setLoop(loopMode, loopFrames, juce::roundToInt(region.loop_crossfade * fileSampleRate), bitsPerSample);
+
+    AmpEnvelope::Parameters envelope;
+    envelope.delay = (float)region.ampeg_delay;
+    envelope.attack = (float)region.ampeg_attack;
+    envelope.hold = (float)region.ampeg_hold;
+    envelope.decay = (float)region.ampeg_decay;
+    envelope.sustain = (float)(region.ampeg_sustain / 100.0);
+    envelope.release = (float)region.ampeg_release;
+    sound->setEnvelope(envelope);
+
+    if (region.cutoff >= 0.0)
+    {
+        static const SampleSound::FilterType filterTypes[] = { SampleSound::FilterType::lowpass, SampleSound::FilterType::highpass,
+                                                               SampleSound::FilterType::bandpass, SampleSound::FilterType::notch };
+        SampleSound::FilterSettings filter;
+        filter.type = filterTypes[juce::jlimit(0, 3, region.fil_type)];
+        filter.cutoff = (float)region.cutoff;
+        filter.resonance = (float)region.resonance;
+        filter.velocityTrack = (float)region.fil_veltrack;
+        sound->setFilter(filter);
+
+        DBG("  Filter: type " + juce::String(region.fil_type) + ", cutoff " + juce::String(region.cutoff) +
+            " Hz, resonance " + juce::String(region.resonance) + " dB");
+    }
+
+    if (options.buildMipLevels)
+    {
+        // One octave-down copy for every octave the region plays above its root
+        auto numLevels = juce::jlimit(0, options.maxMipLevels, (region.hikey - region.pitch_keycenter) / 12);
+        if (numLevels > 0)
+        {
+            sound->buildMipLevels(numLevels);
+            DBG("  Built " + juce::String(numLevels) + " mip levels");
+        }
+    }
+
+    if (options.compressSamples)
+    {
+        if (bitsPerSample > 0 && sound->compressAudioData(bitsPerSample))
+        {
+            DBG("  Compressed: " + juce::String((int)sound->getUncompressedSizeBytes()) + " -> " +
+                juce::String((int)sound->getMemoryUsageBytes()) + " bytes");
+        }
+        else
+        {
+            DBG("  Keeping uncompressed: not integer PCM");
+        }
+    }
+
+    // Anything still held as stereo floats gets stored as L/R frame pairs
+    if (options.interleaveSamples)
+        sound->interleaveAudioData();
+
     return sound;
 }
 
-std::unique_ptr<juce::AudioBuffer<float>> EnhancedSFZLoader::loadAudioFile(const juce::File& audioFile)
+std::unique_ptr<juce::AudioBuffer<float>> EnhancedSFZLoader::loadAudioFile(const juce::File& audioFile, int& bitsPerSample,
+    double& sampleRate, juce::Range<int>& fileLoop)
 {
+    const auto startTicks = juce::Time::getHighResolutionTicks();
     std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(audioFile));
 
     if (reader == nullptr)
@@ -668,5 +981,30 @@ std::unique_ptr<juce::AudioBuffer<float>> EnhancedSFZLoader::loadAudioFile(const
 
     reader->read(buffer.get(), 0, (int)reader->lengthInSamples, 0, true, true);
 
+    LoadProfile::FileDecode decode;
+    decode.file = audioFile.getRelativePathFrom(currentSFZFile.getParentDirectory());
+    decode.seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    decode.bytesRead = audioFile.getSize();
+    decode.bytesDecoded = (juce::int64)buffer->getNumChannels() * buffer->getNumSamples() * (juce::int64)sizeof(float);
+    profile.files.add(decode);
+
+    profile.bytesRead += decode.bytesRead;
+    profile.bytesDecoded += decode.bytesDecoded;
+    profile.peakSampleBytes = juce::jmax(profile.peakSampleBytes, heldSampleBytes + decode.bytesDecoded);
+
+    bitsPerSample = reader->usesFloatingPointData ? 0 : (int)reader->bitsPerSample;
+    sampleRate = reader->sampleRate;
+
+    // WAV files carry their loops in the smpl chunk, where the end is the last frame played
+    fileLoop = {};
+    if (reader->metadataValues.getValue("NumSampleLoops", "0").getIntValue() > 0)
+    {
+        auto loopStart = reader->metadataValues.getValue("Loop0Start", "0").getIntValue();
+        auto loopEnd = reader->metadataValues.getValue("Loop0End", "0").getIntValue() + 1;
+
+        if (loopStart >= 0 && loopEnd > loopStart && loopEnd <= buffer->getNumSamples())
+            fileLoop = { loopStart, loopEnd };
+    }
+
     return buffer;
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 
 #include <JuceHeader.h>
 #include "SampleSound.h"
+#include "LoadProfile.h"
 
 //==============================================================================
 /**
@@ -26,9 +27,49 @@ public:
     ~EnhancedSFZLoader();
 
     //==============================================================================
+    /** Options that control how sample data is held in memory */
+    struct LoadOptions
+    {
+        /** Keep sample bodies as losslessly compressed blocks that voices decode as they play */
+        bool compressSamples = false;
+
+        /** Build octave-down band-limited copies for regions that transpose up by an octave or more */
+        bool buildMipLevels = true;
+
+        /** Upper limit on the number of octave-down copies per sample */
+        int maxMipLevels = 4;
+
+        /** Store stereo samples that aren't compressed as interleaved frames, so each voice reads a single stream */
+        bool interleaveSamples = false;
+
+        /** Drop the audio after the loop end of continuous loops, which is never heard. Sustain loops keep it for the release */
+        bool trimAfterLoopEnd = false;
+
+        /** Leave out regions with trigger=release. Voices only start on note-on, so these would
+            otherwise sound at the wrong time; SympatheticResonance stands in for the string
+            resonance samples some libraries trigger this way */
+        bool skipReleaseTriggers = false;
+
+        /** Load the overhead and room mic streams of multi-mic regions. Mics left out
+            here cost no memory; the close mic (the region's sample) is always loaded */
+        bool loadOverheadMic = true;
+        bool loadRoomMic = true;
+    };
+
+    /** Sets the options used by subsequent calls to loadSFZ */
+    void setLoadOptions(const LoadOptions& newOptions) { options = newOptions; }
+
     /** Loads an SFZ file with full support for advanced features */
     juce::Array<SampleSound::Ptr> loadSFZ(const juce::File& sfzFile);
 
+    /** Parses an SFZ file and its includes and resolves the region hierarchy, without
+        reading any audio. Returns the number of regions found. loadSFZ() starts with this.
+    */
+    int parseSFZ(const juce::File& sfzFile);
+
+    /** Returns where the time and memory of the last loadSFZ() call went */
+    const LoadProfile& getLoadProfile() const noexcept { return profile; }
+
 private:
     //==============================================================================
     struct SFZVariable
@@ -54,6 +95,8 @@ private:
 
         // Basic sample info
         juce::String sample;
+        juce::String sample_overhead;   // other mics' recordings of the same region, time-aligned with sample
+        juce::String sample_room;
         int lokey = 0;
         int hikey = 127;
         int lovel = 0;
@@ -61,16 +104,19 @@ private:
         int pitch_keycenter = 60;
         int key = -1;
 
-        // ADSR
+        // Amp envelope, in seconds but for the sustain level
+        double ampeg_delay = 0.0;
         double ampeg_attack = 0.0;
+        double ampeg_hold = 0.0;
         double ampeg_decay = 0.0;
-        double ampeg_sustain = 1.0;
+        double ampeg_sustain = 100.0;   // percent
         double ampeg_release = 0.1;
 
-        // Filters
-        double cutoff = 20000.0;
-        double resonance = 0.0;
-        int fil_type = 0; // 0=lpf, 1=hpf, 2=bpf
+        // Filters - as in the spec, there's no filter unless a cutoff is given
+        double cutoff = -1.0;   // Hz
+        double resonance = 0.0; // dB
+        int fil_type = 0; // 0=lpf, 1=hpf, 2=bpf, 3=brf
+        int fil_veltrack = 0;   // cents
 
         // Volume and pan
         double volume = 0.0; // dB
@@ -107,6 +153,12 @@ private:
         double offset = 0.0;
         double delay = 0.0;
 
+        // Looping - empty mode and negative points mean "use the sample file's loop"
+        juce::String loop_mode; // no_loop, one_shot, loop_continuous, loop_sustain
+        int loop_start = -1;
+        int loop_end = -1;      // inclusive, as in the SFZ spec
+        double loop_crossfade = 0.0;
+
         // All opcodes for advanced processing
         juce::Array<SFZOpcode> opcodes;
     };
@@ -132,6 +184,12 @@ private:
     juce::File currentSFZFile;
     juce::AudioFormatManager formatManager;
     juce::String defaultPath; // Store default_path from <control> section
+    LoadOptions options;
+
+    // Profile of the load in progress, or the last one
+    LoadProfile profile;
+    LoadPhaseTimer phaseTimer { profile };
+    juce::int64 heldSampleBytes = 0;
 
     //==============================================================================
     /** Process the main SFZ file and all includes */
@@ -164,6 +222,9 @@ private:
     /** Parse note values (handles note names like C4, A0) */
     int parseNoteValue(const juce::String& value);
 
+    /** Parse fil_type values like lpf_2p into the fil_type codes of SFZRegion */
+    int parseFilterType(const juce::String& value);
+
     /** Substitute variables in a string */
     juce::String substituteVariables(const juce::String& input);
 
@@ -176,11 +237,16 @@ private:
     /** Convert parsed regions to SampleSound objects */
     juce::Array<SampleSound::Ptr> createSampleSounds();
 
-    /** Create a single SampleSound from a region */
-    SampleSound::Ptr createSampleSound(const SFZRegion& region);
+    /** Create a single SampleSound from a region, playing the given sample file */
+    SampleSound::Ptr createSampleSound(const SFZRegion& region, const juce::String& samplePath);
+
+    /** Loads the region's other mics and attaches them to the close mic's sound */
+    void addMicStreams(SampleSound& sound, const SFZRegion& region);
 
-    /** Load audio file with proper error handling */
-    std::unique_ptr<juce::AudioBuffer<float>> loadAudioFile(const juce::File& audioFile);
+    /** Load audio file with proper error handling. bitsPerSample is set to 0 for floating point files,
+        and fileLoop to the first loop stored in the file (end exclusive), or an empty range if there isn't one */
+    std::unique_ptr<juce::AudioBuffer<float>> loadAudioFile(const juce::File& audioFile, int& bitsPerSample,
+        double& sampleRate, juce::Range<int>& fileLoop);
 
     /** Current parsing context */
     enum class ParseContext
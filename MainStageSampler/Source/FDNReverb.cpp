@@ -0,0 +1,334 @@
+/*
+  ==============================================================================
+
+    FDNReverb.cpp
+    Created: Light algorithmic reverb for low powered machines
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "FDNReverb.h"
+
+namespace
+{
+    // Mutually prime-ish line lengths at size 1, in milliseconds
+    const double baseDelaysMs[] = { 31.3, 37.1, 41.9, 47.3, 53.1, 59.9, 67.7, 73.9 };
+
+    // Input diffuser lengths from Dattorro's plate, in samples at 29761 Hz
+    const int baseDiffuserLengths[] = { 142, 107, 379, 277 };
+    constexpr double diffuserBaseRate = 29761.0;
+
+    constexpr double maxSizeScale = 1.5;
+    constexpr double maxPredelaySeconds = 0.05;
+    constexpr double maxModulationSeconds = 0.001;
+    constexpr double glideSeconds = 0.15;
+
+    struct Character
+    {
+        double rt60;          // seconds, at mid size
+        double predelay;      // seconds, at mid size
+        double sizeScale;     // line lengths relative to baseDelaysMs
+        double dampingHz;     // cutoff of the lowpass in each feedback path
+        float diffusion;      // allpass gain of the input diffusers
+        double modulation;    // peak delay modulation, seconds
+    };
+
+    const Character characters[] =
+    {
+        { 2.4, 0.025, 1.0, 6500.0, 0.6f, 0.00025 },     // hall
+        { 0.7, 0.004, 0.45, 5000.0, 0.5f, 0.00012 },    // room
+        { 1.8, 0.0, 0.6, 9500.0, 0.75f, 0.00018 }       // plate
+    };
+
+    // Orthogonal sign patterns for feeding and tapping the lines
+    const float inputSigns[]  = { 1, -1, 1, 1, -1, 1, -1, -1 };
+    const float leftSigns[]   = { 1, 1, -1, 1, -1, -1, 1, -1 };
+    const float rightSigns[]  = { 1, -1, -1, -1, 1, -1, 1, 1 };
+}
+
+//==============================================================================
+FDNReverb::FDNReverb()
+{
+    static_assert(numLines == (int)(sizeof(baseDelaysMs) / sizeof(baseDelaysMs[0])), "One base delay per line");
+
+    const auto scale = 1.0f / std::sqrt((float)numLines);
+    alignas(Vector::SIMDRegisterSize) float column[numLines];
+    alignas(Vector::SIMDRegisterSize) float input[numLines], left[numLines], right[numLines];
+
+    // Sylvester's Hadamard matrix, scaled to be orthogonal
+    for (int j = 0; j < numLines; ++j)
+    {
+        for (int i = 0; i < numLines; ++i)
+        {
+            int bits = i & j, parity = 0;
+            for (; bits != 0; bits &= bits - 1)
+                parity ^= 1;
+
+            column[i] = parity != 0 ? -scale : scale;
+        }
+
+        for (int v = 0; v < numVectors; ++v)
+            mixColumns[j][v] = Vector::fromRawArray(column + v * (int)Vector::SIMDNumElements);
+    }
+
+    for (int i = 0; i < numLines; ++i)
+    {
+        input[i] = inputSigns[i] * scale;
+        left[i] = leftSigns[i] * scale;
+        right[i] = rightSigns[i] * scale;
+    }
+
+    for (int v = 0; v < numVectors; ++v)
+    {
+        const auto offset = v * (int)Vector::SIMDNumElements;
+        inputGains[v] = Vector::fromRawArray(input + offset);
+        leftGains[v] = Vector::fromRawArray(left + offset);
+        rightGains[v] = Vector::fromRawArray(right + offset);
+    }
+
+    prepare(sampleRate, 512);
+}
+
+FDNReverb::~FDNReverb()
+{
+}
+
+//==============================================================================
+void FDNReverb::prepare(double newSampleRate, int /*maximumBlockSize*/)
+{
+    sampleRate = newSampleRate;
+
+    const auto maxDelay = baseDelaysMs[numLines - 1] * 0.001 * maxSizeScale + maxModulationSeconds;
+    lineSize = juce::nextPowerOfTwo((int)(maxDelay * sampleRate) + 4);
+    predelaySize = juce::nextPowerOfTwo((int)(maxPredelaySeconds * sampleRate) + 1);
+
+    for (int d = 0; d < numDiffusers; ++d)
+        diffuserLengths[d] = juce::jmax(1, juce::roundToInt(baseDiffuserLengths[d] * sampleRate / diffuserBaseRate));
+
+    diffuserSize = juce::nextPowerOfTwo(*std::max_element(diffuserLengths, diffuserLengths + numDiffusers) + 1);
+
+    lineBuffer.allocate((size_t)(numLines * lineSize), true);
+    predelayBuffer.allocate((size_t)predelaySize, true);
+    diffuserBuffer.allocate((size_t)(numDiffusers * diffuserSize), true);
+
+    // Each line wobbles at its own slow rate, so the modes don't ring
+    alignas(Vector::SIMDRegisterSize) float stepSin[numLines], stepCos[numLines];
+
+    for (int i = 0; i < numLines; ++i)
+    {
+        const auto w = juce::MathConstants<double>::twoPi * (0.29 + 0.13 * i) / sampleRate;
+        stepSin[i] = (float)std::sin(w);
+        stepCos[i] = (float)std::cos(w);
+    }
+
+    for (int v = 0; v < numVectors; ++v)
+    {
+        lfoStepSin[v] = Vector::fromRawArray(stepSin + v * (int)Vector::SIMDNumElements);
+        lfoStepCos[v] = Vector::fromRawArray(stepCos + v * (int)Vector::SIMDNumElements);
+    }
+
+    delayGlide = (float)(1.0 - std::exp(-1.0 / (glideSeconds * sampleRate)));
+
+    smoothedWet.setCurrentAndTargetValue(wetLevel);
+
+    reset();
+}
+
+void FDNReverb::reset() noexcept
+{
+    juce::FloatVectorOperations::clear(lineBuffer.get(), numLines * lineSize);
+    juce::FloatVectorOperations::clear(predelayBuffer.get(), predelaySize);
+    juce::FloatVectorOperations::clear(diffuserBuffer.get(), numDiffusers * diffuserSize);
+
+    alignas(Vector::SIMDRegisterSize) float phaseSin[numLines], phaseCos[numLines];
+
+    for (int i = 0; i < numLines; ++i)
+    {
+        const auto phase = juce::MathConstants<float>::twoPi * (float)i / (float)numLines;
+        phaseSin[i] = std::sin(phase);
+        phaseCos[i] = std::cos(phase);
+    }
+
+    for (int v = 0; v < numVectors; ++v)
+    {
+        dampingState[v] = Vector::expand(0.0f);
+        lfoSin[v] = Vector::fromRawArray(phaseSin + v * (int)Vector::SIMDNumElements);
+        lfoCos[v] = Vector::fromRawArray(phaseCos + v * (int)Vector::SIMDNumElements);
+    }
+
+    // Start the lines at the right lengths rather than gliding there
+    snapDelays = true;
+    appliedType = -1;
+}
+
+void FDNReverb::setRoom(RoomType type, float size) noexcept
+{
+    roomType.store((int)type);
+    roomSize.store(juce::jlimit(0.0f, 1.0f, size));
+}
+
+void FDNReverb::updateCoefficients(int type, float size) noexcept
+{
+    appliedType = type;
+    appliedSize = size;
+
+    const auto& character = characters[juce::jlimit(0, (int)juce::numElementsInArray(characters) - 1, type)];
+    const auto scale = character.sizeScale * (0.5 + (double)size);
+    const auto rt60 = character.rt60 * (0.4 + 1.2 * (double)size);
+
+    alignas(Vector::SIMDRegisterSize) float delays[numLines], gains[numLines];
+    double totalDelay = 0.0;
+
+    for (int i = 0; i < numLines; ++i)
+    {
+        const auto delay = baseDelaysMs[i] * 0.001 * scale * sampleRate;
+        delays[i] = (float)delay;
+        gains[i] = (float)std::exp(-6.9078 * delay / (rt60 * sampleRate));
+        totalDelay += delay;
+    }
+
+    for (int v = 0; v < numVectors; ++v)
+    {
+        targetDelay[v] = Vector::fromRawArray(delays + v * (int)Vector::SIMDNumElements);
+        feedbackGain[v] = Vector::fromRawArray(gains + v * (int)Vector::SIMDNumElements);
+
+        if (snapDelays)
+            currentDelay[v] = targetDelay[v];
+    }
+
+    snapDelays = false;
+
+    damping = (float)(1.0 - std::exp(-juce::MathConstants<double>::twoPi * juce::jmin(character.dampingHz, 0.45 * sampleRate) / sampleRate));
+    diffusion = character.diffusion;
+    modulationDepth = (float)(character.modulation * sampleRate);
+    predelayFrames = juce::jmin(predelaySize - 1, (int)(character.predelay * (0.5 + (double)size) * sampleRate));
+
+    // An undamped network holds its energy for about rt60 / 13.8 seconds, spread over all
+    // of the delay memory. The damping takes about two thirds of that away, which leaves
+    // the tail with roughly the energy of the normalised impulse responses of ConvolutionReverb
+    outputGain = (float)std::sqrt(3.0 * 13.8155 * totalDelay / (rt60 * sampleRate));
+}
+
+//==============================================================================
+void FDNReverb::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    const auto type = roomType.load();
+    const auto size = roomSize.load();
+
+    if (type != appliedType || size != appliedSize)
+        updateCoefficients(type, size);
+
+    // The level moves from the last block's setting to this one's across the block
+    smoothedWet.reset(numSamples);
+    smoothedWet.setTargetValue(wetLevel);
+
+    if (smoothedWet.getTargetValue() == 0.0f && !smoothedWet.isSmoothing())
+        return;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    constexpr int vectorSize = (int)Vector::SIMDNumElements;
+    const int numChannels = juce::jmin(2, buffer.getNumChannels());
+    auto* left = buffer.getWritePointer(0, startSample);
+    auto* right = numChannels > 1 ? buffer.getWritePointer(1, startSample) : nullptr;
+
+    const auto lineMask = (juce::uint32)(lineSize - 1);
+    const auto predelayMask = (juce::uint32)(predelaySize - 1);
+    const auto diffuserMask = (juce::uint32)(diffuserSize - 1);
+
+    alignas(Vector::SIMDRegisterSize) float readDelays[numLines], taps[numLines], feedback[numLines], lineInputs[numLines];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // Predelay and diffuse a mono sum of the input
+        float x = right != nullptr ? 0.5f * (left[i] + right[i]) : left[i];
+
+        predelayBuffer[writePosition & predelayMask] = x;
+        x = predelayBuffer[(writePosition - (juce::uint32)predelayFrames) & predelayMask];
+
+        for (int d = 0; d < numDiffusers; ++d)
+        {
+            auto* ring = diffuserBuffer + d * diffuserSize;
+            const auto g = d < 2 ? diffusion : diffusion * 0.83f;
+            const auto delayed = ring[(writePosition - (juce::uint32)diffuserLengths[d]) & diffuserMask];
+            const auto w = x + g * delayed;
+
+            ring[writePosition & diffuserMask] = w;
+            x = delayed - g * w;
+        }
+
+        // Modulated read positions, with the lengths gliding towards their targets
+        for (int v = 0; v < numVectors; ++v)
+        {
+            (currentDelay[v] + lfoSin[v] * modulationDepth).copyToRawArray(readDelays + v * vectorSize);
+            currentDelay[v] += (targetDelay[v] - currentDelay[v]) * delayGlide;
+
+            const auto s = lfoSin[v];
+            lfoSin[v] = s * lfoStepCos[v] + lfoCos[v] * lfoStepSin[v];
+            lfoCos[v] = lfoCos[v] * lfoStepCos[v] - s * lfoStepSin[v];
+        }
+
+        // The only per-line scalar work: fractional reads from each ring
+        for (int l = 0; l < numLines; ++l)
+        {
+            const auto* ring = lineBuffer + l * lineSize;
+            const auto whole = (juce::uint32)readDelays[l];
+            const auto alpha = readDelays[l] - (float)whole;
+
+            taps[l] = ring[(writePosition - whole) & lineMask] * (1.0f - alpha)
+                    + ring[(writePosition - whole - 1) & lineMask] * alpha;
+        }
+
+        auto outL = Vector::expand(0.0f);
+        auto outR = Vector::expand(0.0f);
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            const auto tap = Vector::fromRawArray(taps + v * vectorSize);
+
+            outL += tap * leftGains[v];
+            outR += tap * rightGains[v];
+
+            dampingState[v] += (tap - dampingState[v]) * damping;
+            (dampingState[v] * feedbackGain[v]).copyToRawArray(feedback + v * vectorSize);
+        }
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            auto mixed = inputGains[v] * x;
+
+            for (int j = 0; j < numLines; ++j)
+                mixed += mixColumns[j][v] * feedback[j];
+
+            mixed.copyToRawArray(lineInputs + v * vectorSize);
+        }
+
+        for (int l = 0; l < numLines; ++l)
+            lineBuffer[l * lineSize + (int)(writePosition & lineMask)] = lineInputs[l];
+
+        ++writePosition;
+
+        const auto gain = smoothedWet.getNextValue() * outputGain;
+        const auto wetL = outL.sum() * gain;
+        const auto wetR = outR.sum() * gain;
+
+        if (right != nullptr)
+        {
+            left[i] += wetL;
+            right[i] += wetR;
+        }
+        else
+        {
+            left[i] += 0.5f * (wetL + wetR);
+        }
+    }
+
+    // Keep the oscillators on the unit circle
+    for (int v = 0; v < numVectors; ++v)
+    {
+        const auto correction = Vector::expand(1.5f) - (lfoSin[v] * lfoSin[v] + lfoCos[v] * lfoCos[v]) * 0.5f;
+        lfoSin[v] *= correction;
+        lfoCos[v] *= correction;
+    }
+}
\ No newline at end of file
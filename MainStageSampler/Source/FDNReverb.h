@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    FDNReverb.h
+    Created: Light algorithmic reverb for low powered machines
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    An eight line feedback delay network reverb, for machines that can't afford
+    ConvolutionReverb.
+
+    The input is predelayed and smeared by a chain of allpass diffusers, then fed
+    into eight slowly modulated delay lines whose outputs are damped, attenuated
+    to give the decay time and mixed back into their inputs through a Hadamard
+    matrix. The per-line maths runs on juce::dsp::SIMDRegister vectors, so the
+    cost is a small fixed amount per sample however many voices are playing.
+*/
+class FDNReverb
+{
+public:
+    //==============================================================================
+    /** The algorithm presets on offer. */
+    enum class RoomType
+    {
+        hall = 0,
+        room,
+        plate
+    };
+
+    FDNReverb();
+    ~FDNReverb();
+
+    //==============================================================================
+    /** Prepares for playback. Call this while the audio callback isn't running. */
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    /** Clears the reverb tail. This only clears memory, so it's safe on the audio thread. */
+    void reset() noexcept;
+
+    /** Adds the reverb of the first two channels of the buffer to themselves. */
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    //==============================================================================
+    /** Sets the wet level, from 0 to 1. The next process() ramps to it across its
+        block. Call from the audio thread, or while it isn't running.
+    */
+    void setWetLevel(float newLevel) noexcept { wetLevel = newLevel; }
+
+    /** Changes the preset and size, from 0 (small, short) to 1 (large, long). Safe to call
+        from any thread; the delay lines glide to their new lengths.
+    */
+    void setRoom(RoomType type, float size) noexcept;
+
+private:
+    //==============================================================================
+    using Vector = juce::dsp::SIMDRegister<float>;
+
+    static constexpr int numLines = 8;
+    static constexpr int numVectors = numLines / (int)Vector::SIMDNumElements;
+    static constexpr int numDiffusers = 4;
+
+    static_assert(numLines % (int)Vector::SIMDNumElements == 0, "The lines must fill whole SIMD registers");
+
+    /** Works out the delay lengths, gains and filters for a preset. */
+    void updateCoefficients(int type, float size) noexcept;
+
+    //==============================================================================
+    double sampleRate = 44100.0;
+
+    std::atomic<int> roomType { (int)RoomType::hall };
+    std::atomic<float> roomSize { 0.6f };
+    int appliedType = -1;
+    float appliedSize = -1.0f;
+    bool snapDelays = true;
+
+    // One power-of-two ring per delay line, laid end to end
+    juce::HeapBlock<float> lineBuffer;
+    int lineSize = 0;
+    juce::uint32 writePosition = 0;    // free running, each ring masks it
+
+    juce::HeapBlock<float> predelayBuffer;
+    int predelaySize = 0;
+    int predelayFrames = 0;
+
+    juce::HeapBlock<float> diffuserBuffer;
+    int diffuserSize = 0;
+    int diffuserLengths[numDiffusers] = {};
+    float diffusion = 0.0f;
+
+    // Per-line state and coefficients, numVectors registers each
+    Vector currentDelay[numVectors], targetDelay[numVectors];
+    Vector feedbackGain[numVectors];
+    Vector dampingState[numVectors];
+    Vector lfoSin[numVectors], lfoCos[numVectors];
+    Vector lfoStepSin[numVectors], lfoStepCos[numVectors];
+    Vector inputGains[numVectors], leftGains[numVectors], rightGains[numVectors];
+
+    // The orthogonal mixing matrix, stored as columns
+    Vector mixColumns[numLines][numVectors];
+
+    float damping = 0.0f;
+    float modulationDepth = 0.0f;
+    float delayGlide = 0.0f;
+    float outputGain = 0.0f;
+
+    float wetLevel = 0.0f;
+    juce::SmoothedValue<float> smoothedWet;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FDNReverb)
+};
\ No newline at end of file
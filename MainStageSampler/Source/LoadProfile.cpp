@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+    LoadProfile.cpp
+    Created: Where the time and memory of an SFZ load went
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "LoadProfile.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+ #include <psapi.h>
+#else
+ #include <sys/resource.h>
+ #include <time.h>
+#endif
+
+namespace
+{
+    juce::String megabytes(juce::int64 bytes)
+    {
+        return juce::String((double)bytes / (1024.0 * 1024.0), 1) + " MB";
+    }
+}
+
+//==============================================================================
+juce::String LoadProfile::getPhaseName(Phase phase)
+{
+    static const char* const names[numPhases] = { "parsing", "includes", "inheritance", "file_lookup", "decoding", "sound_construction" };
+    return names[(int)phase];
+}
+
+juce::Array<LoadProfile::FileDecode> LoadProfile::getSlowestFiles(int maxFiles) const
+{
+    auto sorted = files;
+    std::sort(sorted.begin(), sorted.end(), [](const FileDecode& a, const FileDecode& b) { return a.seconds > b.seconds; });
+
+    if (sorted.size() > maxFiles)
+        sorted.removeRange(maxFiles, sorted.size() - maxFiles);
+
+    return sorted;
+}
+
+juce::String LoadProfile::toString(int maxFiles) const
+{
+    juce::String text;
+    text << "Loaded " << sfzFile.getFileName() << ": " << numSounds << " sounds from " << numRegions << " regions in "
+         << juce::String(total.wallSeconds, 2) << " s (" << juce::String(total.cpuSeconds, 2) << " s CPU)\n";
+
+    for (int i = 0; i < numPhases; ++i)
+    {
+        const auto share = total.wallSeconds > 0.0 ? 100.0 * phases[i].wallSeconds / total.wallSeconds : 0.0;
+
+        text << "  " << getPhaseName((Phase)i).paddedRight(' ', 20)
+             << juce::String(phases[i].wallSeconds, 3) << " s  " << juce::String(phases[i].cpuSeconds, 3) << " s CPU  "
+             << juce::String(share, 1) << "%\n";
+    }
+
+    text << "  read " << megabytes(bytesRead) << ", decoded " << megabytes(bytesDecoded)
+         << " from " << files.size() << " files, peak sample memory " << megabytes(peakSampleBytes);
+
+    if (peakResidentBytes >= 0)
+        text << ", process peak " << megabytes(peakResidentBytes);
+
+    text << "\n";
+
+    auto slowest = getSlowestFiles(maxFiles);
+    if (slowest.size() > 0)
+    {
+        text << "  slowest files:\n";
+        for (auto& file : slowest)
+            text << "    " << juce::String(file.seconds * 1000.0, 1) << " ms  " << file.file << "\n";
+    }
+
+    return text;
+}
+
+juce::String LoadProfile::toJSON() const
+{
+    auto phaseToVar = [](const PhaseTime& time)
+        {
+            auto* object = new juce::DynamicObject();
+            object->setProperty("wall_seconds", time.wallSeconds);
+            object->setProperty("cpu_seconds", time.cpuSeconds);
+            return juce::var(object);
+        };
+
+    auto* phaseObject = new juce::DynamicObject();
+    for (int i = 0; i < numPhases; ++i)
+        phaseObject->setProperty(getPhaseName((Phase)i), phaseToVar(phases[i]));
+
+    juce::Array<juce::var> fileList;
+    for (auto& file : files)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("file", file.file);
+        object->setProperty("seconds", file.seconds);
+        object->setProperty("bytes_read", file.bytesRead);
+        object->setProperty("bytes_decoded", file.bytesDecoded);
+        fileList.add(juce::var(object));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("sfz", sfzFile.getFullPathName());
+    root->setProperty("regions", numRegions);
+    root->setProperty("sounds", numSounds);
+    root->setProperty("total", phaseToVar(total));
+    root->setProperty("phases", juce::var(phaseObject));
+    root->setProperty("bytes_read", bytesRead);
+    root->setProperty("bytes_decoded", bytesDecoded);
+    root->setProperty("peak_sample_bytes", peakSampleBytes);
+    root->setProperty("peak_resident_bytes", peakResidentBytes);
+    root->setProperty("files", fileList);
+
+    return juce::JSON::toString(juce::var(root));
+}
+
+//==============================================================================
+LoadPhaseTimer::LoadPhaseTimer(LoadProfile& profileToFill)
+    : profile(profileToFill)
+{
+}
+
+void LoadPhaseTimer::start(LoadProfile::Phase firstPhase)
+{
+    startTicks = phaseStartTicks = juce::Time::getHighResolutionTicks();
+    startCpu = phaseStartCpu = getThreadCpuSeconds();
+    current = firstPhase;
+    running = true;
+}
+
+LoadProfile::Phase LoadPhaseTimer::switchTo(LoadProfile::Phase phase)
+{
+    const auto previous = current;
+
+    if (running && phase != current)
+    {
+        addElapsed();
+        current = phase;
+    }
+
+    return previous;
+}
+
+void LoadPhaseTimer::stop()
+{
+    if (!running)
+        return;
+
+    addElapsed();
+    running = false;
+
+    profile.total.wallSeconds = juce::Time::highResolutionTicksToSeconds(phaseStartTicks - startTicks);
+    profile.total.cpuSeconds = phaseStartCpu - startCpu;
+    profile.peakResidentBytes = getPeakResidentBytes();
+}
+
+void LoadPhaseTimer::addElapsed()
+{
+    const auto ticks = juce::Time::getHighResolutionTicks();
+    const auto cpu = getThreadCpuSeconds();
+
+    auto& time = profile.phases[(int)current];
+    time.wallSeconds += juce::Time::highResolutionTicksToSeconds(ticks - phaseStartTicks);
+    time.cpuSeconds += cpu - phaseStartCpu;
+
+    phaseStartTicks = ticks;
+    phaseStartCpu = cpu;
+}
+
+//==============================================================================
+double LoadPhaseTimer::getThreadCpuSeconds()
+{
+   #if JUCE_WINDOWS
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0.0;
+
+    auto toSeconds = [](const FILETIME& time) { return (double)(((juce::uint64)time.dwHighDateTime << 32) | time.dwLowDateTime) * 1.0e-7; };
+    return toSeconds(kernel) + toSeconds(user);
+   #else
+    timespec time {};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+        return 0.0;
+
+    return (double)time.tv_sec + (double)time.tv_nsec * 1.0e-9;
+   #endif
+}
+
+juce::int64 LoadPhaseTimer::getPeakResidentBytes()
+{
+   #if JUCE_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return (juce::int64)counters.PeakWorkingSetSize;
+    return -1;
+   #else
+    rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+
+    // Linux reports kilobytes, macOS bytes
+   #if JUCE_MAC || JUCE_IOS
+    return (juce::int64)usage.ru_maxrss;
+   #else
+    return (juce::int64)usage.ru_maxrss * 1024;
+   #endif
+   #endif
+}
\ No newline at end of file
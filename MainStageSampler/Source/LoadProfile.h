@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    LoadProfile.h
+    Created: Where the time and memory of an SFZ load went
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    What one EnhancedSFZLoader::loadSFZ() call spent, phase by phase.
+
+    The phases don't overlap: time spent reading an include file counts towards
+    includes, not towards the parsing of the file that included it, so the
+    phase times add up to the whole load.
+*/
+struct LoadProfile
+{
+    enum class Phase
+    {
+        parsing,            // reading the SFZ text into masters, groups and regions
+        includes,           // finding and reading #include files
+        inheritance,        // applying master and group opcodes to the regions
+        fileLookup,         // finding each region's sample on disk
+        decoding,           // reading and decoding sample files
+        soundConstruction   // building SampleSounds: loops, mip levels, compression
+    };
+
+    static constexpr int numPhases = 6;
+
+    /** Returns the name used for a phase in reports and JSON */
+    static juce::String getPhaseName(Phase phase);
+
+    struct PhaseTime
+    {
+        double wallSeconds = 0.0;
+        double cpuSeconds = 0.0;    // of the loading thread
+    };
+
+    /** One sample file read by the load */
+    struct FileDecode
+    {
+        juce::String file;          // relative to the SFZ file's folder
+        double seconds = 0.0;
+        juce::int64 bytesRead = 0;
+        juce::int64 bytesDecoded = 0;
+    };
+
+    //==============================================================================
+    juce::File sfzFile;
+    PhaseTime phases[numPhases];
+    PhaseTime total;
+
+    int numRegions = 0;
+    int numSounds = 0;
+
+    juce::int64 bytesRead = 0;       // SFZ text and sample files, as stored on disk
+    juce::int64 bytesDecoded = 0;    // sample audio as float, before compression or trimming
+
+    /** The most sample data the loader held at once: the finished sounds plus the file being decoded */
+    juce::int64 peakSampleBytes = 0;
+
+    /** The process's peak resident memory when the load finished, or -1 if the platform can't say.
+        This is the peak since the process started, so it only tells you about this load if it grew.
+    */
+    juce::int64 peakResidentBytes = -1;
+
+    juce::Array<FileDecode> files;
+
+    //==============================================================================
+    const PhaseTime& getPhase(Phase phase) const noexcept { return phases[(int)phase]; }
+
+    /** Returns the files that took longest to decode, slowest first */
+    juce::Array<FileDecode> getSlowestFiles(int maxFiles) const;
+
+    /** Returns a few lines for the log or a tooltip */
+    juce::String toString(int maxFiles = 5) const;
+
+    /** Returns the whole profile, every file included, as JSON */
+    juce::String toJSON() const;
+};
+
+//==============================================================================
+/**
+    Fills in the phase times of a LoadProfile as the loader moves between phases.
+    Only use it from the loading thread, as the CPU times are that thread's.
+*/
+class LoadPhaseTimer
+{
+public:
+    explicit LoadPhaseTimer(LoadProfile& profileToFill);
+
+    /** Starts timing the load, in the given phase */
+    void start(LoadProfile::Phase firstPhase);
+
+    /** Moves to a new phase and returns the one that was running */
+    LoadProfile::Phase switchTo(LoadProfile::Phase phase);
+
+    /** Ends the load, adding up the total and noting the peak resident memory */
+    void stop();
+
+    /** Switches to a phase for the lifetime of the object, then back */
+    class Scope
+    {
+    public:
+        Scope(LoadPhaseTimer& t, LoadProfile::Phase phase) : timer(t), previous(t.switchTo(phase)) {}
+        ~Scope() { timer.switchTo(previous); }
+
+    private:
+        LoadPhaseTimer& timer;
+        LoadProfile::Phase previous;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+    /** Returns the CPU time used by the calling thread so far, in seconds */
+    static double getThreadCpuSeconds();
+
+    /** Returns the process's peak resident memory in bytes, or -1 if it isn't available */
+    static juce::int64 getPeakResidentBytes();
+
+private:
+    void addElapsed();
+
+    LoadProfile& profile;
+    LoadProfile::Phase current = LoadProfile::Phase::parsing;
+    bool running = false;
+
+    juce::int64 startTicks = 0, phaseStartTicks = 0;
+    double startCpu = 0.0, phaseStartCpu = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE(LoadPhaseTimer)
+};
\ No newline at end of file
@@ -5,7 +5,7 @@ MainComponent::MainComponent()
     : interfaceTabs(juce::TabbedButtonBar::TabsAtTop)
 {
     // Create the Pro piano interface
-    pianoInterface = std::make_unique<ProPianoInterface>(samplerEngine, keyboardState);
+    pianoInterface = std::make_unique<ProPianoInterface>(samplerEngine, noteInput.getKeyboardState());
 
     // Add it to a tabbed component (ready for future instruments)
     interfaceTabs.addTab("Piano", juce::Colour(0xff2a2a2a), pianoInterface.get(), false);
@@ -37,6 +37,17 @@ MainComponent::MainComponent()
     modeLabel.setJustificationType(juce::Justification::right);
     addAndMakeVisible(modeLabel);
 
+    // DSP load of the audio callback, with a button to save its statistics
+    loadLabel.setText("DSP --", juce::dontSendNotification);
+    loadLabel.setJustificationType(juce::Justification::right);
+    loadLabel.setColour(juce::Label::textColourId, juce::Colour(0xffcccccc));
+    addAndMakeVisible(loadLabel);
+
+    loadStatsButton.setButtonText("Load Stats");
+    loadStatsButton.setTooltip("Save the audio callback's load histogram and recent overruns");
+    loadStatsButton.addListener(this);
+    addAndMakeVisible(loadStatsButton);
+
     // Enable keyboard focus
     setWantsKeyboardFocus(true);
     addKeyListener(this);
@@ -44,14 +55,26 @@ MainComponent::MainComponent()
     // Set window size - larger for UVI interface
     setSize(1400, 800);
 
+    // Load progress arrives on the loading thread
+    samplerEngine.onLoadStatus = [this](const juce::String& status)
+        {
+            juce::MessageManager::callAsync([this, status]() { updateStatusLabel(status); });
+        };
+
+    audioCallback.onDeviceStateChanged = [this]() { updateAudioStatus(); };
+
     // Initialize audio
     initializeAudio();
     updateAudioStatus();
+
+    startTimerHz(4);
 }
 
 MainComponent::~MainComponent()
 {
-    audioDeviceManager.removeAudioCallback(this);
+    stopTimer();
+    audioDeviceManager.removeMidiInputDeviceCallback({}, &noteInput);
+    audioDeviceManager.removeAudioCallback(&audioCallback);
     audioDeviceManager.closeAudioDevice();
 }
 
@@ -59,7 +82,13 @@ MainComponent::~MainComponent()
 void MainComponent::initializeAudio()
 {
     audioDeviceManager.initialiseWithDefaultDevices(0, 2);
-    audioDeviceManager.addAudioCallback(this);
+    audioDeviceManager.addAudioCallback(&audioCallback);
+
+    // Play from every MIDI input there is
+    for (auto& midiInput : juce::MidiInput::getAvailableDevices())
+        audioDeviceManager.setMidiInputDeviceEnabled(midiInput.identifier, true);
+
+    audioDeviceManager.addMidiInputDeviceCallback({}, &noteInput);
 
     DBG("Audio device manager initialized");
 
@@ -75,50 +104,6 @@ void MainComponent::initializeAudio()
     }
 }
 
-void MainComponent::audioDeviceIOCallbackWithContext(const float* const* /*inputChannelData*/,
-    int /*numInputChannels*/,
-    float* const* outputChannelData,
-    int numOutputChannels,
-    int numSamples,
-    const juce::AudioIODeviceCallbackContext& /*context*/)
-{
-    // Clear output buffers
-    for (int channel = 0; channel < numOutputChannels; ++channel)
-    {
-        if (outputChannelData[channel] != nullptr)
-            juce::FloatVectorOperations::clear(outputChannelData[channel], numSamples);
-    }
-
-    // Create audio buffer
-    juce::AudioBuffer<float> buffer(outputChannelData, numOutputChannels, numSamples);
-
-    // Create MIDI buffer
-    juce::MidiBuffer midiBuffer;
-    keyboardState.processNextMidiBuffer(midiBuffer, 0, numSamples, true);
-
-    // Process through sampler
-    samplerEngine.renderNextBlock(buffer, midiBuffer, 0, numSamples);
-
-    // Apply master volume
-    buffer.applyGain(0, numSamples, masterVolume);
-}
-
-void MainComponent::audioDeviceAboutToStart(juce::AudioIODevice* device)
-{
-    auto sampleRate = device->getCurrentSampleRate();
-    auto bufferSize = device->getCurrentBufferSizeSamples();
-
-    samplerEngine.prepareToPlay(sampleRate, bufferSize);
-    keyboardState.reset();
-    updateAudioStatus();
-}
-
-void MainComponent::audioDeviceStopped()
-{
-    keyboardState.reset();
-    updateAudioStatus();
-}
-
 void MainComponent::updateAudioStatus()
 {
     auto* currentDevice = audioDeviceManager.getCurrentAudioDevice();
@@ -190,6 +175,12 @@ void MainComponent::resized()
     utilityContent.removeFromRight(10); // spacing
     modeLabel.setBounds(utilityContent.removeFromRight(50));
 
+    // DSP load to the left of it
+    utilityContent.removeFromRight(20); // spacing
+    loadStatsButton.setBounds(utilityContent.removeFromRight(90));
+    utilityContent.removeFromRight(10); // spacing
+    loadLabel.setBounds(utilityContent.removeFromRight(300));
+
     // Tabbed interface takes the rest
     interfaceTabs.setBounds(bounds);
 }
@@ -241,42 +232,20 @@ void MainComponent::buttonClicked(juce::Button* button)
     {
         showAudioSettings();
     }
+    else if (button == &loadStatsButton)
+    {
+        saveLoadStatistics();
+    }
 }
 
 bool MainComponent::keyPressed(const juce::KeyPress& key, juce::Component* /*originatingComponent*/)
 {
-    int midiNote = -1;
-    int baseNote = 60;
-
-    // White keys
-    if (key.getKeyCode() == 'A') midiNote = baseNote;
-    else if (key.getKeyCode() == 'S') midiNote = baseNote + 2;
-    else if (key.getKeyCode() == 'D') midiNote = baseNote + 4;
-    else if (key.getKeyCode() == 'F') midiNote = baseNote + 5;
-    else if (key.getKeyCode() == 'G') midiNote = baseNote + 7;
-    else if (key.getKeyCode() == 'H') midiNote = baseNote + 9;
-    else if (key.getKeyCode() == 'J') midiNote = baseNote + 11;
-    else if (key.getKeyCode() == 'K') midiNote = baseNote + 12;
-
-    // Black keys
-    else if (key.getKeyCode() == 'W') midiNote = baseNote + 1;
-    else if (key.getKeyCode() == 'E') midiNote = baseNote + 3;
-    else if (key.getKeyCode() == 'T') midiNote = baseNote + 6;
-    else if (key.getKeyCode() == 'Y') midiNote = baseNote + 8;
-    else if (key.getKeyCode() == 'U') midiNote = baseNote + 10;
-
-    if (midiNote >= 0 && midiNote <= 127)
-    {
-        keyboardState.noteOn(1, midiNote, 0.8f);
-        return true;
-    }
-
-    return false;
+    return noteInput.computerKeyPressed(key.getKeyCode());
 }
 
 bool MainComponent::keyStateChanged(bool /*isKeyDown*/, juce::Component* /*originatingComponent*/)
 {
-    keyboardState.allNotesOff(1);
+    noteInput.computerKeysReleased();
     return true;
 }
 
@@ -295,7 +264,14 @@ void MainComponent::loadSFZFile(const juce::File& file)
                         currentSFZFile = file;
                         auto libraryName = file.getParentDirectory().getFileName();
                         pianoInterface->setCurrentLibrary(libraryName);
-                        updateStatusLabel("Loaded: " + libraryName);
+
+                        auto residency = samplerEngine.getResidencyReport();
+                        auto profile = samplerEngine.getLoadProfile();
+                        updateStatusLabel("Loaded: " + libraryName + " in " + juce::String(profile.total.wallSeconds, 1) + " s"
+                            + (residency.numLockFailures > 0 ? " (sample memory not locked)" : ""));
+
+                        // The breakdown of the load is there for anyone wondering why it took so long
+                        statusLabel.setTooltip(profile.toString());
                     });
             });
     }
@@ -305,6 +281,61 @@ void MainComponent::loadSFZFile(const juce::File& file)
     }
 }
 
+//==============================================================================
+void MainComponent::timerCallback()
+{
+    samplerEngine.updateAudioThreadPriority();
+
+    const auto load = loadMonitor.getCurrentLoad();
+    const auto peak = loadMonitor.getAndResetPeakLoad();
+    const auto overruns = loadMonitor.getNumOverruns();
+
+    juce::String text = "DSP " + juce::String(juce::roundToInt(load * 100.0f)) + "%"
+        + "  peak " + juce::String(juce::roundToInt(peak * 100.0f)) + "%"
+        + "  overruns " + juce::String(overruns);
+
+    // The driver's own count also catches dropouts that happened outside our callback
+    if (auto* device = audioDeviceManager.getCurrentAudioDevice())
+    {
+        const auto xruns = device->getXRunCount();
+        if (xruns > 0)
+            text << "  xruns " << xruns;
+    }
+
+    loadLabel.setText(text, juce::dontSendNotification);
+
+    // In builds that count them, hovering over the load shows which regions it's going on
+    if (RegionCostTable::isAvailable())
+        loadLabel.setTooltip(samplerEngine.getRegionCosts().toString(8));
+    loadLabel.setColour(juce::Label::textColourId,
+        peak > 1.0f ? juce::Colour(0xffcc6666) : peak > 0.7f ? juce::Colour(0xffcccc66) : juce::Colour(0xffcccccc));
+}
+
+void MainComponent::saveLoadStatistics()
+{
+    // Taken now, so the file shows the moment the button was pressed
+    auto json = loadMonitor.getSnapshot().toJSON();
+
+    fileChooser = std::make_unique<juce::FileChooser>("Save audio callback load statistics...",
+        juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("callback_load.json"),
+        "*.json");
+
+    auto chooserFlags = juce::FileBrowserComponent::saveMode
+        | juce::FileBrowserComponent::warnAboutOverwriting;
+
+    fileChooser->launchAsync(chooserFlags, [this, json](const juce::FileChooser& fc)
+        {
+            auto file = fc.getResult();
+            if (file == juce::File())
+                return;
+
+            if (file.replaceWithText(json))
+                updateStatusLabel("Saved load statistics to " + file.getFileName());
+            else
+                updateStatusLabel("Couldn't write " + file.getFullPathName());
+        });
+}
+
 void MainComponent::updateStatusLabel(const juce::String& message)
 {
     statusLabel.setText(message, juce::dontSendNotification);
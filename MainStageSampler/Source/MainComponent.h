@@ -3,6 +3,9 @@
 #include <JuceHeader.h>
 #include "SamplerEngine.h"
 #include "ProPianoInterface.h"
+#include "CallbackLoadMonitor.h"
+#include "NoteInput.h"
+#include "SamplerAudioCallback.h"
 
 //==============================================================================
 /*
@@ -12,8 +15,8 @@ class MainComponent : public juce::Component,
     public juce::FileDragAndDropTarget,
     public juce::Button::Listener,
     public juce::KeyListener,
-    public juce::AudioIODeviceCallback,
-    public juce::ComboBox::Listener
+    public juce::ComboBox::Listener,
+    private juce::Timer
 {
 public:
     //==============================================================================
@@ -24,18 +27,6 @@ public:
     void paint(juce::Graphics& g) override;
     void resized() override;
 
-    //==============================================================================
-    // Audio callbacks
-    void audioDeviceIOCallbackWithContext(const float* const* inputChannelData,
-        int numInputChannels,
-        float* const* outputChannelData,
-        int numOutputChannels,
-        int numSamples,
-        const juce::AudioIODeviceCallbackContext& context) override;
-
-    void audioDeviceAboutToStart(juce::AudioIODevice* device) override;
-    void audioDeviceStopped() override;
-
     //==============================================================================
     // File drag and drop
     bool isInterestedInFileDrag(const juce::StringArray& files) override;
@@ -55,7 +46,9 @@ private:
     // Audio components
     juce::AudioDeviceManager audioDeviceManager;
     SamplerEngine samplerEngine;
-    juce::MidiKeyboardState keyboardState;
+    NoteInput noteInput;
+    CallbackLoadMonitor loadMonitor;
+    SamplerAudioCallback audioCallback { samplerEngine, noteInput, loadMonitor };
 
     // UI Components
     std::unique_ptr<ProPianoInterface> pianoInterface;
@@ -67,13 +60,15 @@ private:
     juce::Label statusLabel;
     juce::ComboBox modeComboBox;
     juce::Label modeLabel;
+    juce::Label loadLabel;
+    juce::TextButton loadStatsButton;
+    juce::TooltipWindow tooltipWindow { this };
 
     // File chooser
     std::unique_ptr<juce::FileChooser> fileChooser;
 
     // Current state
     juce::File currentSFZFile;
-    float masterVolume = 0.8f;
 
     //==============================================================================
     void loadSFZFile(const juce::File& file);
@@ -83,6 +78,10 @@ private:
     void updateAudioStatus();
     void switchToPerformanceMode();
     void switchToEngineMode();
+    void saveLoadStatistics();
+
+    /** Refreshes the DSP load readout */
+    void timerCallback() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)
 };
\ No newline at end of file
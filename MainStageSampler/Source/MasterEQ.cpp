@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    MasterEQ.cpp
+    Created: Four band master EQ
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "MasterEQ.h"
+
+namespace
+{
+    struct BandShape
+    {
+        double frequency;
+        double q;
+    };
+
+    // In the order of MasterEQ::Band
+    const BandShape bandShapes[] =
+    {
+        { 120.0, 0.707 },     // low shelf
+        { 1000.0, 0.7 },      // mid peak
+        { 3500.0, 1.2 },      // presence peak
+        { 8000.0, 0.707 }     // high shelf
+    };
+}
+
+//==============================================================================
+MasterEQ::MasterEQ()
+{
+    prepare(sampleRate, 512);
+}
+
+MasterEQ::~MasterEQ()
+{
+}
+
+void MasterEQ::prepare(double newSampleRate, int /*maximumBlockSize*/)
+{
+    sampleRate = newSampleRate;
+
+    // Start at the current settings rather than sweeping to them
+    for (int band = 0; band < numBands; ++band)
+    {
+        appliedGains[band] = bandGains[band];
+        const auto c = makeBand((Band)band, appliedGains[band], sampleRate);
+        const double values[] = { c.b0, c.b1, c.b2, c.a1, c.a2 };
+
+        for (int i = 0; i < 5; ++i)
+            current[band][i] = (float)values[i];
+    }
+
+    active = std::any_of(std::begin(appliedGains), std::end(appliedGains), [](float g) { return g != 0.0f; });
+
+    reset();
+}
+
+void MasterEQ::reset()
+{
+    for (int band = 0; band < numBands; ++band)
+    {
+        state1[band] = Vector::expand(0.0f);
+        state2[band] = Vector::expand(0.0f);
+    }
+}
+
+//==============================================================================
+MasterEQ::Coefficients MasterEQ::makeBand(Band band, float gainDb, double sampleRate)
+{
+    // Robert Bristow-Johnson's cookbook shelves and peaks
+    const auto& shape = bandShapes[band];
+    const auto A = std::pow(10.0, gainDb / 40.0);
+    const auto w0 = juce::MathConstants<double>::twoPi * juce::jmin(shape.frequency, 0.45 * sampleRate) / sampleRate;
+    const auto cosW = std::cos(w0);
+    const auto alpha = std::sin(w0) / (2.0 * shape.q);
+    const auto twoRootAAlpha = 2.0 * std::sqrt(A) * alpha;
+
+    double b0, b1, b2, a0, a1, a2;
+
+    if (band == low)
+    {
+        b0 = A * ((A + 1.0) - (A - 1.0) * cosW + twoRootAAlpha);
+        b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosW);
+        b2 = A * ((A + 1.0) - (A - 1.0) * cosW - twoRootAAlpha);
+        a0 = (A + 1.0) + (A - 1.0) * cosW + twoRootAAlpha;
+        a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosW);
+        a2 = (A + 1.0) + (A - 1.0) * cosW - twoRootAAlpha;
+    }
+    else if (band == high)
+    {
+        b0 = A * ((A + 1.0) + (A - 1.0) * cosW + twoRootAAlpha);
+        b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosW);
+        b2 = A * ((A + 1.0) + (A - 1.0) * cosW - twoRootAAlpha);
+        a0 = (A + 1.0) - (A - 1.0) * cosW + twoRootAAlpha;
+        a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosW);
+        a2 = (A + 1.0) - (A - 1.0) * cosW - twoRootAAlpha;
+    }
+    else
+    {
+        b0 = 1.0 + alpha * A;
+        b1 = -2.0 * cosW;
+        b2 = 1.0 - alpha * A;
+        a0 = 1.0 + alpha / A;
+        a1 = -2.0 * cosW;
+        a2 = 1.0 - alpha / A;
+    }
+
+    return { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+}
+
+double MasterEQ::getMagnitudeForFrequency(const float (&gainsDb)[numBands], double frequency, double sampleRate)
+{
+    const auto w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    const std::complex<double> z1 = std::polar(1.0, -w);
+    const auto z2 = z1 * z1;
+    double magnitude = 1.0;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        const auto c = makeBand((Band)band, gainsDb[band], sampleRate);
+        magnitude *= std::abs((c.b0 + c.b1 * z1 + c.b2 * z2) / (1.0 + c.a1 * z1 + c.a2 * z2));
+    }
+
+    return magnitude;
+}
+
+//==============================================================================
+void MasterEQ::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    float gains[numBands];
+    bool changed = false;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        gains[band] = bandGains[band];
+        changed = changed || gains[band] != appliedGains[band];
+    }
+
+    if ((!changed && !active) || numSamples <= 0)
+        return;
+
+    // Work out where each band has to be by the end of the block, and the step per sample to get there
+    float target[numBands][5];
+    float step[numBands][5] = {};
+
+    if (changed)
+    {
+        for (int band = 0; band < numBands; ++band)
+        {
+            const auto c = makeBand((Band)band, gains[band], sampleRate);
+            const double values[] = { c.b0, c.b1, c.b2, c.a1, c.a2 };
+
+            for (int i = 0; i < 5; ++i)
+            {
+                target[band][i] = (float)values[i];
+                step[band][i] = (target[band][i] - current[band][i]) / (float)numSamples;
+            }
+        }
+    }
+
+    juce::ScopedNoDenormals noDenormals;
+
+    auto* left = buffer.getWritePointer(0, startSample);
+    auto* right = buffer.getNumChannels() > 1 ? buffer.getWritePointer(1, startSample) : nullptr;
+
+    alignas(Vector::SIMDRegisterSize) float frame[Vector::SIMDNumElements] = {};
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        frame[0] = left[i];
+        frame[1] = right != nullptr ? right[i] : 0.0f;
+        auto x = Vector::fromRawArray(frame);
+
+        for (int band = 0; band < numBands; ++band)
+        {
+            auto* c = current[band];
+
+            // Transposed direct form II, which copes well with coefficients on the move
+            const auto y = x * c[0] + state1[band];
+            state1[band] = x * c[1] - y * c[3] + state2[band];
+            state2[band] = x * c[2] - y * c[4];
+            x = y;
+
+            if (changed)
+                for (int k = 0; k < 5; ++k)
+                    c[k] += step[band][k];
+        }
+
+        x.copyToRawArray(frame);
+        left[i] = frame[0];
+
+        if (right != nullptr)
+            right[i] = frame[1];
+    }
+
+    if (changed)
+    {
+        // Land exactly on the target, whatever rounding the steps picked up
+        for (int band = 0; band < numBands; ++band)
+        {
+            std::copy(target[band], target[band] + 5, current[band]);
+            appliedGains[band] = gains[band];
+        }
+
+        active = std::any_of(std::begin(appliedGains), std::end(appliedGains), [](float g) { return g != 0.0f; });
+
+        // Flat and bypassed from here on, so start from silence when it comes back
+        if (!active)
+            reset();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    MasterEQ.h
+    Created: Four band master EQ
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    The master EQ behind the EQ section: a low shelf, a mid peak, a presence peak
+    and a high shelf, run as a cascade of biquads.
+
+    Both channels go through each biquad together in one SIMD register. When a
+    gain changes, the new coefficients are worked out once at the start of the
+    next block and the filters move to them in a straight line across the block,
+    so knob moves don't zip and nothing is recomputed per sample. With every gain
+    at 0 dB the EQ is bypassed.
+*/
+class MasterEQ
+{
+public:
+    //==============================================================================
+    enum Band
+    {
+        low = 0,
+        mid,
+        presence,
+        high,
+        numBands
+    };
+
+    MasterEQ();
+    ~MasterEQ();
+
+    /** Prepares for playback. Call this while the audio callback isn't running. */
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    /** Clears the filters' memory. Call this while the audio callback isn't running. */
+    void reset();
+
+    /** Sets the gain of a band in dB. The next process() moves to it across its block.
+        Call from the audio thread, or while it isn't running.
+    */
+    void setBandGain(Band band, float gainDb) noexcept { bandGains[band] = gainDb; }
+
+    /** Filters the first two channels of the buffer in place. */
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    //==============================================================================
+    /** Returns the gain of the whole cascade at a frequency for the given band gains,
+        as a linear magnitude. Useful for drawing the curve and for checking it.
+    */
+    static double getMagnitudeForFrequency(const float (&gainsDb)[numBands], double frequency, double sampleRate);
+
+private:
+    //==============================================================================
+    using Vector = juce::dsp::SIMDRegister<float>;
+
+    /** Normalised biquad coefficients, b0 b1 b2 a1 a2 */
+    struct Coefficients
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    static Coefficients makeBand(Band band, float gainDb, double sampleRate);
+
+    double sampleRate = 44100.0;
+
+    float bandGains[numBands] = {};
+    float appliedGains[numBands] = {};
+    bool active = false;
+
+    // The coefficients each band is at, then the TDF-II state with L and R in lanes 0 and 1
+    float current[numBands][5] = {};
+    Vector state1[numBands], state2[numBands];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MasterEQ)
+};
\ No newline at end of file
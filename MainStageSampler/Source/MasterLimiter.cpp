@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+    MasterLimiter.cpp
+    Created: Lookahead true-peak limiter for the master bus
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "MasterLimiter.h"
+
+//==============================================================================
+MasterLimiter::MasterLimiter()
+{
+    // Windowed sinc interpolators, each reading the taps either side of the point it estimates
+    for (int phase = 1; phase < oversampling; ++phase)
+    {
+        const auto fraction = (double)phase / (double)oversampling;
+        auto* coefficients = phaseCoefficients[phase - 1];
+        double sum = 0.0;
+
+        for (int k = 0; k < interpolatorTaps; ++k)
+        {
+            // Tap k is k samples behind the newest; the point sits between taps interpolatorDelay and interpolatorDelay - 1
+            const auto t = (double)(interpolatorDelay - k) - fraction;
+            const auto sinc = t == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::pi * t) / (juce::MathConstants<double>::pi * t);
+            const auto window = 0.5 + 0.5 * std::cos(juce::MathConstants<double>::pi * t / (interpolatorDelay + 1));
+
+            coefficients[k] = (float)(sinc * window);
+            sum += sinc * window;
+        }
+
+        // Unity gain at DC
+        for (int k = 0; k < interpolatorTaps; ++k)
+            coefficients[k] = (float)(coefficients[k] / sum);
+    }
+
+    prepare(sampleRate, 512);
+}
+
+MasterLimiter::~MasterLimiter()
+{
+}
+
+void MasterLimiter::prepare(double newSampleRate, int /*maximumBlockSize*/)
+{
+    sampleRate = newSampleRate;
+    lookaheadSamples = juce::jmax(1, juce::roundToInt(lookaheadMs * 0.001 * sampleRate));
+
+    historySize = juce::jmax(lookaheadSamples + interpolatorDelay, interpolatorTaps - 1);
+    const auto channelSize = historySize + chunkSize;
+    stagingBuffer.allocate((size_t)(2 * channelSize), true);
+    staging[0] = stagingBuffer.get();
+    staging[1] = stagingBuffer.get() + channelSize;
+
+    // The window and the average both span the lookahead and the frame being pushed
+    const auto windowLength = juce::nextPowerOfTwo(lookaheadSamples + 1);
+    windowPeaks.allocate((size_t)windowLength, true);
+    windowFrames.allocate((size_t)windowLength, true);
+    windowMask = windowLength - 1;
+
+    averageRing.allocate((size_t)(lookaheadSamples + 1), true);
+
+    reset();
+}
+
+void MasterLimiter::reset()
+{
+    juce::FloatVectorOperations::clear(stagingBuffer.get(), 2 * (historySize + chunkSize));
+
+    windowHead = windowSize = 0;
+    frameCount = 0;
+
+    juce::FloatVectorOperations::fill(averageRing.get(), 1.0f, lookaheadSamples + 1);
+    averagePosition = 0;
+    averageSum = (double)(lookaheadSamples + 1);
+
+    releasedGain = 1.0f;
+    gainReductionDb.store(0.0f);
+}
+
+//==============================================================================
+void MasterLimiter::measurePeaks(int numChannels, int numFrames) noexcept
+{
+    juce::FloatVectorOperations::clear(peaks, numFrames);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        // newest[i - k] is the frame k behind frame i of the chunk
+        const auto* newest = staging[ch] + historySize;
+
+        // The samples themselves, as of the interpolator's delay
+        juce::FloatVectorOperations::abs(interpolated, newest - interpolatorDelay, numFrames);
+        juce::FloatVectorOperations::max(peaks, peaks, interpolated, numFrames);
+
+        // And the points between them
+        for (int phase = 0; phase < oversampling - 1; ++phase)
+        {
+            const auto* coefficients = phaseCoefficients[phase];
+
+            juce::FloatVectorOperations::copyWithMultiply(interpolated, newest, coefficients[0], numFrames);
+
+            for (int k = 1; k < interpolatorTaps; ++k)
+                juce::FloatVectorOperations::addWithMultiply(interpolated, newest - k, coefficients[k], numFrames);
+
+            juce::FloatVectorOperations::abs(interpolated, interpolated, numFrames);
+            juce::FloatVectorOperations::max(peaks, peaks, interpolated, numFrames);
+        }
+    }
+}
+
+float MasterLimiter::pushPeak(float peak) noexcept
+{
+    // Drop peaks that have left the window from the front, and any that the new one hides from the back
+    while (windowSize > 0 && windowFrames[windowHead] <= frameCount - (lookaheadSamples + 1))
+    {
+        windowHead = (windowHead + 1) & windowMask;
+        --windowSize;
+    }
+
+    while (windowSize > 0 && windowPeaks[(windowHead + windowSize - 1) & windowMask] <= peak)
+        --windowSize;
+
+    const auto tail = (windowHead + windowSize) & windowMask;
+    windowPeaks[tail] = peak;
+    windowFrames[tail] = frameCount++;
+    ++windowSize;
+
+    return windowPeaks[windowHead];
+}
+
+void MasterLimiter::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    const int numChannels = juce::jmin(2, buffer.getNumChannels());
+    const auto ceiling = juce::Decibels::decibelsToGain(ceilingDb.load());
+    const auto releaseCoefficient = 1.0f - std::exp(-1.0f / (releaseMs.load() * 0.001f * (float)sampleRate));
+    const auto averageScale = 1.0 / (double)(lookaheadSamples + 1);
+    const auto delay = lookaheadSamples + interpolatorDelay;
+    auto lowestGain = 1.0f;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    for (int done = 0; done < numSamples;)
+    {
+        const int numThisTime = juce::jmin(numSamples - done, chunkSize);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::copy(staging[ch] + historySize, buffer.getReadPointer(ch, startSample + done), numThisTime);
+
+        measurePeaks(numChannels, numThisTime);
+
+        for (int i = 0; i < numThisTime; ++i)
+        {
+            const auto windowPeak = pushPeak(peaks[i]);
+            const auto target = windowPeak > ceiling ? ceiling / windowPeak : 1.0f;
+
+            // Straight down to what's needed, back up at the release rate
+            releasedGain = target < releasedGain ? target : releasedGain + (target - releasedGain) * releaseCoefficient;
+
+            averageSum += (double)releasedGain - (double)averageRing[averagePosition];
+            averageRing[averagePosition] = releasedGain;
+            averagePosition = averagePosition == lookaheadSamples ? 0 : averagePosition + 1;
+
+            gains[i] = (float)(averageSum * averageScale);
+        }
+
+        lowestGain = juce::jmin(lowestGain, juce::FloatVectorOperations::findMinimum(gains, numThisTime));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* output = buffer.getWritePointer(ch, startSample + done);
+            juce::FloatVectorOperations::multiply(output, staging[ch] + historySize - delay, gains, numThisTime);
+
+            // Keep the newest history in front for the next chunk
+            std::memmove(staging[ch], staging[ch] + numThisTime, sizeof(float) * (size_t)historySize);
+        }
+
+        done += numThisTime;
+    }
+
+    // The running sum drifts a little with rounding, so start it afresh each block
+    averageSum = 0.0;
+
+    for (int i = 0; i <= lookaheadSamples; ++i)
+        averageSum += averageRing[i];
+
+    gainReductionDb.store(juce::Decibels::gainToDecibels(lowestGain, -100.0f), std::memory_order_relaxed);
+}
\ No newline at end of file
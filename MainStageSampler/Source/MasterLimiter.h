@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    MasterLimiter.h
+    Created: Lookahead true-peak limiter for the master bus
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Keeps the master bus below a true-peak ceiling, however many voices are
+    summed into it.
+
+    Peaks are measured between samples as well as on them: each chunk is
+    interpolated at four times the sample rate with a polyphase FIR, run as
+    vector operations over the whole chunk. A sliding-window maximum over the
+    lookahead turns those peaks into the gain each sample needs, and averaging
+    that gain over the same window makes it arrive smoothly and in time, so the
+    audio only has to be delayed by the lookahead plus the interpolator's delay.
+    Gain comes back up with a one-pole release.
+
+    The gain reduction is published after every block for meters to read.
+*/
+class MasterLimiter
+{
+public:
+    //==============================================================================
+    MasterLimiter();
+    ~MasterLimiter();
+
+    /** Prepares for playback, picking up the lookahead. Call this while the audio callback isn't running. */
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    /** Clears the lookahead delay and lets go of any gain reduction. Call this while the audio callback isn't running. */
+    void reset();
+
+    /** Sets the lookahead in milliseconds, from 0.1 to 10. Takes effect at the next prepare(). */
+    void setLookahead(double milliseconds) noexcept { lookaheadMs = juce::jlimit(0.1, 10.0, milliseconds); }
+
+    /** Sets the true-peak ceiling in dBTP. Safe to call from any thread. */
+    void setCeiling(float decibels) noexcept { ceilingDb.store(decibels); }
+
+    /** Sets how quickly gain recovers after a peak, in milliseconds. Safe to call from any thread. */
+    void setRelease(float milliseconds) noexcept { releaseMs.store(juce::jmax(1.0f, milliseconds)); }
+
+    /** Limits the first two channels of the buffer in place, delaying them by getLatencySamples(). */
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    //==============================================================================
+    /** Returns how far the output lags the input, in samples. */
+    int getLatencySamples() const noexcept { return lookaheadSamples + interpolatorDelay; }
+
+    /** Returns the most gain reduction applied during the last block, in dB (0 or less). Safe to call from any thread. */
+    float getGainReductionDb() const noexcept { return gainReductionDb.load(std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    static constexpr int chunkSize = 256;
+    static constexpr int oversampling = 4;
+    static constexpr int interpolatorTaps = 12;
+    static constexpr int interpolatorDelay = interpolatorTaps / 2;
+
+    /** Fills peaks with the largest true-peak magnitude of either channel at each frame of the chunk */
+    void measurePeaks(int numChannels, int numFrames) noexcept;
+
+    /** Pushes a peak into the lookahead window and returns the largest peak still in it */
+    float pushPeak(float peak) noexcept;
+
+    double sampleRate = 44100.0;
+    double lookaheadMs = 1.5;
+    int lookaheadSamples = 0;
+
+    // The input of each channel, with the history the interpolator and the delay need in front of it
+    juce::HeapBlock<float> stagingBuffer;
+    float* staging[2] = {};
+    int historySize = 0;
+
+    // Interpolation filters for the points a quarter, half and three quarters of the way between samples
+    float phaseCoefficients[oversampling - 1][interpolatorTaps] = {};
+
+    float peaks[chunkSize] = {};
+    float interpolated[chunkSize] = {};
+    float gains[chunkSize] = {};
+
+    // Sliding-window maximum: a ring of (frame, peak) pairs with falling peaks
+    juce::HeapBlock<float> windowPeaks;
+    juce::HeapBlock<juce::int64> windowFrames;
+    int windowMask = 0, windowHead = 0, windowSize = 0;
+    juce::int64 frameCount = 0;
+
+    // Averaging of the released gain over the lookahead
+    juce::HeapBlock<float> averageRing;
+    int averagePosition = 0;
+    double averageSum = 0.0;
+
+    float releasedGain = 1.0f;
+
+    std::atomic<float> ceilingDb { -1.0f };
+    std::atomic<float> releaseMs { 100.0f };
+    std::atomic<float> gainReductionDb { 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MasterLimiter)
+};
\ No newline at end of file
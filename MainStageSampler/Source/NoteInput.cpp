@@ -0,0 +1,172 @@
+/*
+  ==============================================================================
+
+    NoteInput.cpp
+    Created: Gathers notes from the keyboards and MIDI devices for the audio callback
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "NoteInput.h"
+
+namespace
+{
+    // Set while a MIDI device's message is shown on the keyboard state, so it isn't queued twice
+    thread_local bool showingDeviceMessage = false;
+}
+
+//==============================================================================
+NoteInput::NoteInput()
+{
+    keyboardState.addListener(this);
+}
+
+NoteInput::~NoteInput()
+{
+    keyboardState.removeListener(this);
+}
+
+void NoteInput::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    lastBlockTime = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    keyboardState.reset();
+
+    {
+        const juce::SpinLock::ScopedLockType sl(writeLock);
+        fifo.reset();
+    }
+
+    prepared.store(true);
+}
+
+void NoteInput::reset()
+{
+    prepared.store(false);
+    keyboardState.reset();
+}
+
+//==============================================================================
+int NoteInput::getNoteForComputerKey(int keyCode) noexcept
+{
+    constexpr int baseNote = 60;
+
+    // White keys
+    if (keyCode == 'A') return baseNote;
+    if (keyCode == 'S') return baseNote + 2;
+    if (keyCode == 'D') return baseNote + 4;
+    if (keyCode == 'F') return baseNote + 5;
+    if (keyCode == 'G') return baseNote + 7;
+    if (keyCode == 'H') return baseNote + 9;
+    if (keyCode == 'J') return baseNote + 11;
+    if (keyCode == 'K') return baseNote + 12;
+
+    // Black keys
+    if (keyCode == 'W') return baseNote + 1;
+    if (keyCode == 'E') return baseNote + 3;
+    if (keyCode == 'T') return baseNote + 6;
+    if (keyCode == 'Y') return baseNote + 8;
+    if (keyCode == 'U') return baseNote + 10;
+
+    return -1;
+}
+
+bool NoteInput::computerKeyPressed(int keyCode)
+{
+    const auto midiNote = getNoteForComputerKey(keyCode);
+
+    if (midiNote < 0)
+        return false;
+
+    keyboardState.noteOn(1, midiNote, computerKeyVelocity);
+    return true;
+}
+
+void NoteInput::computerKeysReleased()
+{
+    keyboardState.allNotesOff(1);
+}
+
+//==============================================================================
+void NoteInput::handleIncomingMidiMessage(juce::MidiInput* /*source*/, const juce::MidiMessage& message)
+{
+    // Anything before the device has started has nowhere to go
+    if (!prepared.load())
+        return;
+
+    queueMessage(message, message.getTimeStamp());
+
+    const juce::ScopedValueSetter<bool> showing(showingDeviceMessage, true);
+    keyboardState.processNextMidiEvent(message);
+}
+
+void NoteInput::handleNoteOn(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity)
+{
+    if (!showingDeviceMessage && prepared.load())
+        queueMessage(juce::MidiMessage::noteOn(midiChannel, midiNoteNumber, velocity), -1.0);
+}
+
+void NoteInput::handleNoteOff(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity)
+{
+    if (!showingDeviceMessage && prepared.load())
+        queueMessage(juce::MidiMessage::noteOff(midiChannel, midiNoteNumber, velocity), -1.0);
+}
+
+void NoteInput::queueMessage(const juce::MidiMessage& message, double time)
+{
+    const auto size = message.getRawDataSize();
+
+    if (size > (int)sizeof(QueuedMessage::data))
+        return;
+
+    const juce::SpinLock::ScopedLockType sl(writeLock);
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    // A full queue means the audio callback has stopped taking them
+    if (size1 + size2 == 0)
+        return;
+
+    auto& queued = queue[size1 > 0 ? start1 : start2];
+    std::copy(message.getRawData(), message.getRawData() + size, queued.data);
+    queued.size = size;
+    queued.time = time;
+
+    fifo.finishedWrite(1);
+}
+
+void NoteInput::getNextBlock(juce::MidiBuffer& midi, int numSamples)
+{
+    const auto timeNow = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    const auto blockStart = lastBlockTime;
+    lastBlockTime = timeNow;
+
+    // Device messages keep their spacing, played a block's length after they arrived. If more
+    // than a block's worth of time has passed, they're squeezed in.
+    const auto numSourceSamples = juce::jmax(1, juce::roundToInt((timeNow - blockStart) * sampleRate));
+
+    auto getPosition = [&](double time)
+    {
+        if (time < 0.0)
+            return 0;
+
+        const auto offset = juce::roundToInt((time - blockStart) * sampleRate);
+        const auto position = numSourceSamples > numSamples ? (int)((juce::int64)offset * numSamples / numSourceSamples)
+                                                            : offset + numSamples - numSourceSamples;
+        return juce::jlimit(0, numSamples - 1, position);
+    };
+
+    const auto numReady = fifo.getNumReady();
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+    for (int i = 0; i < size1 + size2; ++i)
+    {
+        const auto& queued = queue[i < size1 ? start1 + i : start2 + i - size1];
+        midi.addEvent(queued.data, queued.size, getPosition(queued.time));
+    }
+
+    fifo.finishedRead(size1 + size2);
+}
\ No newline at end of file
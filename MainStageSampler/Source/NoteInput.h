@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    NoteInput.h
+    Created: Gathers notes from the keyboards and MIDI devices for the audio callback
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Everything that can play a note, turned into MIDI for each audio block.
+
+    The computer keyboard and the on-screen keyboard press keys on a
+    MidiKeyboardState from the message thread. Those presses carry no more than
+    the millisecond they happened in, and each block puts them at its start.
+    MIDI devices deliver timestamped messages on their own thread, which are
+    placed in the block by their timestamps, a block's length after they arrived,
+    and shown on the keyboard state too.
+
+    Both go through one lock-free FIFO, so the audio callback takes them with
+    getNextBlock() without waiting on any other thread. Only messages of up to
+    three bytes are passed on, so SysEx is dropped.
+*/
+class NoteInput : public juce::MidiInputCallback,
+                  private juce::MidiKeyboardState::Listener
+{
+public:
+    //==============================================================================
+    NoteInput();
+    ~NoteInput() override;
+
+    /** Call when the audio device starts, before the first getNextBlock() */
+    void prepare(double sampleRate);
+
+    /** Lets go of every key and forgets anything waiting. Call when the audio device stops. */
+    void reset();
+
+    //==============================================================================
+    /** The keys the on-screen keyboard shows and plays */
+    juce::MidiKeyboardState& getKeyboardState() noexcept { return keyboardState; }
+
+    /** Returns the note a computer key plays, or -1 if it doesn't play one.
+        A to K are the white keys from middle C, and W, E, T, Y and U the black keys.
+    */
+    static int getNoteForComputerKey(int keyCode) noexcept;
+
+    /** Plays the note for a computer key. Returns false if the key doesn't play one. */
+    bool computerKeyPressed(int keyCode);
+
+    /** Called when any computer key goes up, as there's no telling which */
+    void computerKeysReleased();
+
+    /** Velocity of the computer keyboard's notes */
+    static constexpr float computerKeyVelocity = 0.8f;
+
+    //==============================================================================
+    /** Queues a message from a MIDI device. Called on the device's thread. */
+    void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
+
+    /** Fills the buffer with everything played since the last block. Call on the audio thread. */
+    void getNextBlock(juce::MidiBuffer& midi, int numSamples);
+
+private:
+    //==============================================================================
+    struct QueuedMessage
+    {
+        juce::uint8 data[3];
+        int size;
+        double time;    // seconds on the hi-res millisecond counter, or negative for the start of the block
+    };
+
+    void handleNoteOn(juce::MidiKeyboardState* source, int midiChannel, int midiNoteNumber, float velocity) override;
+    void handleNoteOff(juce::MidiKeyboardState* source, int midiChannel, int midiNoteNumber, float velocity) override;
+
+    /** Adds a message to the FIFO. Called from any thread but the audio thread. */
+    void queueMessage(const juce::MidiMessage& message, double time);
+
+    //==============================================================================
+    juce::MidiKeyboardState keyboardState;
+
+    static constexpr int queueSize = 512;
+    QueuedMessage queue[queueSize];
+    juce::AbstractFifo fifo { queueSize };
+    juce::SpinLock writeLock;       // several MIDI devices and the message thread can write at once
+
+    // Set by prepare() before the audio callback starts, then only used on the audio thread
+    double sampleRate = 44100.0;
+    double lastBlockTime = 0.0;
+
+    // Nothing is queued until the device has started
+    std::atomic<bool> prepared { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoteInput)
+};
\ No newline at end of file
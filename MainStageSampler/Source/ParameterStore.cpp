@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    ParameterStore.cpp
+    Created: Lock-free parameters shared by the interface and the engine
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "ParameterStore.h"
+
+namespace
+{
+    // In the order of ParameterStore::ID
+    const ParameterStore::Info parameterInfo[] =
+    {
+        { "Attack",  0.0f,   1.0f,  0.0f, 0.0 },
+        { "Release", 0.0f,   5.0f,  1.0f, 0.0 },
+        { "Tuning",  -50.0f, 50.0f, 0.0f, 0.05 },
+        { "Volume",  0.0f,   1.0f,  0.8f, 0.05 },
+        { "Pan",     -1.0f,  1.0f,  0.0f, 0.05 },
+        { "Close Mic",    0.0f, 1.0f, 0.6f, 0.05 },
+        { "Overhead Mic", 0.0f, 1.0f, 0.5f, 0.05 },
+        { "Room Mic",     0.0f, 1.0f, 0.4f, 0.05 },
+        { "String Resonance", 0.0f, 1.0f, 0.0f, 0.05 },
+        { "Stereo Width",     0.0f, 1.0f, 1.0f, 0.05 },
+        { "Chorus",           0.0f, 1.0f, 0.0f, 0.05 },
+        { "Reverb",           0.0f, 1.0f, 0.0f, 0.05 },
+
+        // The EQ already moves its coefficients across the block a gain changes in
+        { "EQ Low",      -12.0f, 12.0f, 0.0f, 0.0 },
+        { "EQ Mid",      -12.0f, 12.0f, 0.0f, 0.0 },
+        { "EQ Presence", -12.0f, 12.0f, 0.0f, 0.0 },
+        { "EQ High",     -12.0f, 12.0f, 0.0f, 0.0 }
+    };
+
+    static_assert(juce::numElementsInArray(parameterInfo) == ParameterStore::numParameters,
+        "Every parameter needs an entry");
+}
+
+//==============================================================================
+const ParameterStore::Info& ParameterStore::getInfo(ID id) noexcept
+{
+    return parameterInfo[id];
+}
+
+ParameterStore::ParameterStore()
+{
+    for (int i = 0; i < numParameters; ++i)
+        values[i].store(parameterInfo[i].defaultValue);
+
+    prepare(44100.0);
+}
+
+ParameterStore::~ParameterStore()
+{
+}
+
+void ParameterStore::set(ID id, float newValue) noexcept
+{
+    const auto& info = parameterInfo[id];
+    values[id].store(juce::jlimit(info.minimum, info.maximum, newValue), std::memory_order_relaxed);
+}
+
+//==============================================================================
+void ParameterStore::prepare(double sampleRate)
+{
+    for (int i = 0; i < numParameters; ++i)
+    {
+        const auto value = values[i].load(std::memory_order_relaxed);
+
+        smoothed[i].reset(sampleRate, parameterInfo[i].smoothingSeconds);
+        smoothed[i].setCurrentAndTargetValue(value);
+        blockStart[i] = blockEnd[i] = value;
+    }
+
+    // Whatever reads the store should pick up every value on the first block after a prepare
+    refreshAll = true;
+}
+
+void ParameterStore::beginBlock(int numSamples) noexcept
+{
+    for (int i = 0; i < numParameters; ++i)
+    {
+        auto& smoother = smoothed[i];
+        const auto previousEnd = blockEnd[i];
+
+        smoother.setTargetValue(values[i].load(std::memory_order_relaxed));
+
+        if (smoother.isSmoothing())
+        {
+            blockStart[i] = smoother.getCurrentValue();
+            smoother.skip(numSamples);
+        }
+        else
+        {
+            blockStart[i] = smoother.getTargetValue();
+        }
+
+        blockEnd[i] = smoother.getCurrentValue();
+        changed[i] = refreshAll || blockEnd[i] != previousEnd;
+    }
+
+    refreshAll = false;
+}
\ No newline at end of file
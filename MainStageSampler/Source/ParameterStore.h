@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    ParameterStore.h
+    Created: Lock-free parameters shared by the interface and the engine
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    The engine's performance parameters, addressed by integer ID.
+
+    The interface writes a parameter whenever a control moves; each one is a
+    single atomic, so writing never blocks and the newest value always wins. The
+    audio thread reads everything once at the start of each block with
+    beginBlock(), which also moves each parameter along its own smoothing ramp.
+    The engine then works with the values at the start and end of the block, so
+    a gain can be ramped across the block and nothing else touches the atomics.
+*/
+class ParameterStore
+{
+public:
+    //==============================================================================
+    enum ID
+    {
+        attack = 0,     // seconds added to each sound's attack
+        release,        // scale on each sound's release time
+        tuning,         // cents
+        volume,         // linear master gain
+        pan,            // -1 (left) to 1 (right) balance
+        closeMic,       // level of each mic of multi-mic libraries, 0 to 1
+        overheadMic,
+        roomMic,
+        resonance,      // sympathetic string resonance level, 0 to 1
+        width,          // stereo width, 0 (mono) to 1 (as recorded)
+        chorusAmount,   // chorus blend, 0 to 1
+        reverbAmount,   // reverb wet level, 0 to 1
+        eqLow,          // master EQ band gains in dB, in the order of MasterEQ::Band
+        eqMid,
+        eqPresence,
+        eqHigh,
+
+        numParameters
+    };
+
+    struct Info
+    {
+        const char* name;
+        float minimum, maximum, defaultValue;
+        double smoothingSeconds;    // 0 jumps straight to new values
+    };
+
+    /** Returns the range, default and smoothing of a parameter. */
+    static const Info& getInfo(ID id) noexcept;
+
+    ParameterStore();
+    ~ParameterStore();
+
+    //==============================================================================
+    /** Sets a parameter, limited to its range. Safe to call from any thread. */
+    void set(ID id, float newValue) noexcept;
+
+    /** Returns the last value set. Safe to call from any thread. */
+    float get(ID id) const noexcept { return values[id].load(std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** Sets up the smoothing and jumps to the current values. Call this while the audio callback isn't running. */
+    void prepare(double sampleRate);
+
+    /** Reads every parameter and advances its smoothing by one block. Call once
+        at the start of each block on the audio thread.
+    */
+    void beginBlock(int numSamples) noexcept;
+
+    /** Returns a parameter's value at the start of the current block. Audio thread only. */
+    float getBlockStart(ID id) const noexcept { return blockStart[id]; }
+
+    /** Returns a parameter's value at the end of the current block. Audio thread only. */
+    float getBlockEnd(ID id) const noexcept { return blockEnd[id]; }
+
+    /** Returns true if a parameter has moved since the end of the previous block. Audio thread only. */
+    bool hasChanged(ID id) const noexcept { return changed[id]; }
+
+private:
+    //==============================================================================
+    std::atomic<float> values[numParameters];
+
+    // Audio thread only
+    juce::SmoothedValue<float> smoothed[numParameters];
+    float blockStart[numParameters] = {};
+    float blockEnd[numParameters] = {};
+    bool changed[numParameters] = {};
+    bool refreshAll = true;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterStore)
+};
\ No newline at end of file
@@ -36,7 +36,7 @@ ProPianoInterface::ProPianoInterface(SamplerEngine& engine, juce::MidiKeyboardSt
 
     // Setup all control groups
     setupGroupComponent(toneGroup, "TONE");
-    setupSlider(attackSlider, attackLabel, "Attack", 0.0, 1.0, 0.1);
+    setupSlider(attackSlider, attackLabel, "Attack", 0.0, 1.0, 0.0);
     setupSlider(releaseSlider, releaseLabel, "Release", 0.0, 5.0, 1.0);
     setupSlider(velocitySlider, velocityLabel, "Velocity", 0.0, 1.0, 0.7);
     setupSlider(tuningSlider, tuningLabel, "Tuning", -50.0, 50.0, 0.0);
@@ -58,10 +58,15 @@ ProPianoInterface::ProPianoInterface(SamplerEngine& engine, juce::MidiKeyboardSt
     setupSlider(reverbSizeSlider, reverbSizeLabel, "Size", 0.0, 1.0, 0.6);
     setupSlider(chorusAmountSlider, chorusAmountLabel, "Chorus", 0.0, 1.0, 0.0);
 
+    reverbTypeCombo.addSectionHeading("Convolution");
     reverbTypeCombo.addItem("Hall", 1);
     reverbTypeCombo.addItem("Room", 2);
     reverbTypeCombo.addItem("Chamber", 3);
     reverbTypeCombo.addItem("Plate", 4);
+    reverbTypeCombo.addSectionHeading("Algorithmic (light CPU)");
+    reverbTypeCombo.addItem("Hall (FDN)", 5);
+    reverbTypeCombo.addItem("Room (FDN)", 6);
+    reverbTypeCombo.addItem("Plate (FDN)", 7);
     reverbTypeCombo.setSelectedId(1);
     reverbTypeCombo.addListener(this);
     addAndMakeVisible(reverbTypeCombo);
@@ -91,6 +96,23 @@ ProPianoInterface::ProPianoInterface(SamplerEngine& engine, juce::MidiKeyboardSt
     softPedalButton.setClickingTogglesState(true);
     softPedalButton.addListener(this);
     addAndMakeVisible(softPedalButton);
+
+    auto& parameters = samplerEngine.getParameters();
+    parameters.set(ParameterStore::attack, (float)attackSlider.getValue());
+    parameters.set(ParameterStore::release, (float)releaseSlider.getValue());
+    parameters.set(ParameterStore::tuning, (float)tuningSlider.getValue());
+    parameters.set(ParameterStore::volume, (float)volumeSlider.getValue());
+    parameters.set(ParameterStore::pan, (float)panSlider.getValue());
+    parameters.set(ParameterStore::closeMic, (float)closePositionSlider.getValue());
+    parameters.set(ParameterStore::overheadMic, (float)micBlendSlider.getValue());
+    parameters.set(ParameterStore::roomMic, (float)roomPositionSlider.getValue());
+    parameters.set(ParameterStore::resonance, (float)stringResonanceSlider.getValue());
+    parameters.set(ParameterStore::width, (float)stereoWidthSlider.getValue());
+    parameters.set(ParameterStore::chorusAmount, (float)chorusAmountSlider.getValue());
+    parameters.set(ParameterStore::reverbAmount, (float)reverbAmountSlider.getValue());
+
+    updateReverbRoom();
+    updateEQ();
 }
 
 ProPianoInterface::~ProPianoInterface()
@@ -270,18 +292,68 @@ void ProPianoInterface::resized()
 
 void ProPianoInterface::sliderValueChanged(juce::Slider* slider)
 {
+    auto& parameters = samplerEngine.getParameters();
+
     // Handle parameter changes
     if (slider == &volumeSlider)
     {
-        // Update master volume
+        parameters.set(ParameterStore::volume, (float)volumeSlider.getValue());
+    }
+    else if (slider == &panSlider)
+    {
+        parameters.set(ParameterStore::pan, (float)panSlider.getValue());
     }
     else if (slider == &attackSlider)
     {
-        // Update attack time
+        parameters.set(ParameterStore::attack, (float)attackSlider.getValue());
     }
     else if (slider == &releaseSlider)
     {
-        // Update release time
+        parameters.set(ParameterStore::release, (float)releaseSlider.getValue());
+    }
+    else if (slider == &tuningSlider)
+    {
+        parameters.set(ParameterStore::tuning, (float)tuningSlider.getValue());
+    }
+    else if (slider == &stringResonanceSlider)
+    {
+        parameters.set(ParameterStore::resonance, (float)stringResonanceSlider.getValue());
+    }
+    else if (slider == &closePositionSlider)
+    {
+        parameters.set(ParameterStore::closeMic, (float)closePositionSlider.getValue());
+    }
+    else if (slider == &micBlendSlider)
+    {
+        // The overhead pair sits between the close and room mics
+        parameters.set(ParameterStore::overheadMic, (float)micBlendSlider.getValue());
+    }
+    else if (slider == &roomPositionSlider)
+    {
+        parameters.set(ParameterStore::roomMic, (float)roomPositionSlider.getValue());
+    }
+    else if (slider == &stereoWidthSlider)
+    {
+        parameters.set(ParameterStore::width, (float)stereoWidthSlider.getValue());
+    }
+    else if (slider == &chorusAmountSlider)
+    {
+        parameters.set(ParameterStore::chorusAmount, (float)chorusAmountSlider.getValue());
+    }
+    else if (slider == &reverbAmountSlider)
+    {
+        parameters.set(ParameterStore::reverbAmount, (float)reverbAmountSlider.getValue());
+    }
+    else if (slider == &reverbSizeSlider)
+    {
+        // Rebuilding a convolution room is too heavy to do for every step of a drag
+        if (!reverbSizeSlider.isMouseButtonDown() || reverbTypeCombo.getSelectedId() >= 5)
+            updateReverbRoom();
+    }
+    else if (slider == &lowGainSlider || slider == &midGainSlider
+             || slider == &presenceSlider || slider == &highGainSlider)
+    {
+        updateEQ();
     }
     // Add more parameter handling as needed
 }
@@ -306,10 +378,37 @@ void ProPianoInterface::comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged)
     }
     else if (comboBoxThatHasChanged == &reverbTypeCombo)
     {
-        // Change reverb type
+        updateReverbRoom();
     }
 }
 
+void ProPianoInterface::sliderDragEnded(juce::Slider* slider)
+{
+    if (slider == &reverbSizeSlider)
+        updateReverbRoom();
+}
+
+void ProPianoInterface::updateReverbRoom()
+{
+    // Combo IDs 1-4 follow the order of ConvolutionReverb::RoomType, 5-7 that of FDNReverb::RoomType
+    const auto id = reverbTypeCombo.getSelectedId();
+    const auto size = (float)reverbSizeSlider.getValue();
+
+    if (id >= 5)
+        samplerEngine.setAlgorithmicReverbRoom((FDNReverb::RoomType)juce::jlimit(0, 2, id - 5), size);
+    else
+        samplerEngine.setReverbRoom((ConvolutionReverb::RoomType)juce::jlimit(0, 3, id - 1), size);
+}
+
+void ProPianoInterface::updateEQ()
+{
+    auto& parameters = samplerEngine.getParameters();
+    parameters.set(ParameterStore::eqLow, (float)lowGainSlider.getValue());
+    parameters.set(ParameterStore::eqMid, (float)midGainSlider.getValue());
+    parameters.set(ParameterStore::eqPresence, (float)presenceSlider.getValue());
+    parameters.set(ParameterStore::eqHigh, (float)highGainSlider.getValue());
+}
+
 void ProPianoInterface::setCurrentLibrary(const juce::String& libraryName)
 {
     currentLibraryName = libraryName;
@@ -33,6 +33,7 @@ public:
 
     //==============================================================================
     void sliderValueChanged(juce::Slider* slider) override;
+    void sliderDragEnded(juce::Slider* slider) override;
     void buttonClicked(juce::Button* button) override;
     void comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged) override;
 
@@ -126,6 +127,8 @@ private:
     void setupGroupComponent(juce::GroupComponent& group, const juce::String& title);
     void drawProStyleSlider(juce::Graphics& g, juce::Slider& slider);
     void drawSectionBackground(juce::Graphics& g, juce::Rectangle<int> area, const juce::String& title);
+    void updateReverbRoom();
+    void updateEQ();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProPianoInterface)
 };
\ No newline at end of file
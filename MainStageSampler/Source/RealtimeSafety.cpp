@@ -0,0 +1,501 @@
+/*
+  ==============================================================================
+
+    RealtimeSafety.cpp
+    Created: Catches allocations and locks on the audio threads
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "RealtimeSafety.h"
+
+#if SAMPLER_REALTIME_SAFETY_CHECKS
+
+#include <new>
+#include <cstdlib>
+#include <cerrno>
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <execinfo.h>
+ #include <cxxabi.h>
+#endif
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #include <malloc.h>
+
+extern "C"
+{
+    // glibc's own allocator, which the replacements below hand on to
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+}
+#endif
+
+// Kept out of line, so every violation's stack starts with the same two frames: this and the hook
+#if JUCE_MSVC
+ #define SAMPLER_NOINLINE __declspec(noinline)
+#else
+ #define SAMPLER_NOINLINE __attribute__((noinline))
+#endif
+
+namespace
+{
+    //==============================================================================
+    // Plain data only: this is touched from inside malloc, so it mustn't need constructing
+    struct ThreadState
+    {
+        int realtimeDepth;
+        int hookDepth;          // above 0 while recording a violation, so its own allocations pass
+        const void* heldLocks[4];   // taken without waiting by the ScopedTryLocks alive on this thread
+        int numHeldLocks;
+        const char* name;
+    };
+
+    thread_local ThreadState threadState;
+
+    constexpr int maxRecords = 64;
+    constexpr int maxFrames = 32;
+    constexpr int framesToSkip = 2;     // noteViolation and the hook
+
+    // Recorded without allocating, and only turned into strings when asked for
+    struct Record
+    {
+        RealtimeSafety::ViolationType type;
+        const char* thread;
+        size_t bytes;
+        int count;
+        int numFrames;
+        void* frames[maxFrames];
+    };
+
+    Record records[maxRecords];
+    int numRecords = 0;
+    std::atomic<int> numViolations { 0 };
+    std::atomic_flag recordsLock = ATOMIC_FLAG_INIT;    // a spin, so it can't be caught by the hooks
+
+    inline int captureStack(void** frames, int maxToCapture)
+    {
+       #if JUCE_WINDOWS
+        return (int)CaptureStackBackTrace(0, (DWORD)maxToCapture, frames, nullptr);
+       #else
+        return backtrace(frames, maxToCapture);
+       #endif
+    }
+
+    SAMPLER_NOINLINE void noteViolation(RealtimeSafety::ViolationType type, size_t bytes) noexcept
+    {
+        auto& state = threadState;
+
+        if (state.realtimeDepth == 0 || state.hookDepth > 0)
+            return;
+
+        ++state.hookDepth;
+        numViolations.fetch_add(1, std::memory_order_relaxed);
+
+        void* frames[maxFrames];
+        const auto numFrames = captureStack(frames, maxFrames);
+
+        while (recordsLock.test_and_set(std::memory_order_acquire))
+        {
+        }
+
+        // Count repeats of a stack we've already seen against it
+        Record* record = nullptr;
+
+        for (int i = 0; i < numRecords && record == nullptr; ++i)
+        {
+            auto& existing = records[i];
+
+            if (existing.type == type && existing.numFrames == numFrames
+                && std::equal(frames, frames + numFrames, existing.frames))
+                record = &existing;
+        }
+
+        if (record == nullptr && numRecords < maxRecords)
+        {
+            record = &records[numRecords++];
+            record->type = type;
+            record->thread = state.name;
+            record->bytes = 0;
+            record->count = 0;
+            record->numFrames = numFrames;
+            std::copy(frames, frames + numFrames, record->frames);
+        }
+
+        if (record != nullptr)
+        {
+            ++record->count;
+            record->bytes = juce::jmax(record->bytes, bytes);
+        }
+
+        recordsLock.clear(std::memory_order_release);
+        --state.hookDepth;
+    }
+
+    bool isHeldByTryLock(const void* mutex) noexcept
+    {
+        auto& state = threadState;
+        return std::find(state.heldLocks, state.heldLocks + state.numHeldLocks, mutex) != state.heldLocks + state.numHeldLocks;
+    }
+
+    juce::StringArray describeStack(void* const* frames, int numFrames)
+    {
+        juce::StringArray lines;
+
+       #if JUCE_WINDOWS
+        for (int i = framesToSkip; i < numFrames; ++i)
+            lines.add("0x" + juce::String::toHexString((juce::int64)(juce::pointer_sized_int)frames[i]));
+       #else
+        if (auto** symbols = backtrace_symbols(frames, numFrames))
+        {
+            for (int i = framesToSkip; i < numFrames; ++i)
+            {
+                juce::String line(symbols[i]);
+
+                // Demangle the "binary(_ZN...+0x12)" form glibc gives
+                auto mangled = line.fromFirstOccurrenceOf("(", false, false).upToFirstOccurrenceOf("+", false, false);
+                int status = 0;
+
+                if (mangled.isNotEmpty())
+                {
+                    if (auto* demangled = abi::__cxa_demangle(mangled.toRawUTF8(), nullptr, nullptr, &status))
+                    {
+                        line = line.replace(mangled, demangled);
+                        std::free(demangled);
+                    }
+                }
+
+                lines.add(line);
+            }
+
+            std::free(symbols);
+        }
+       #endif
+
+        return lines;
+    }
+
+    // The first stack capture can load the unwinder, which allocates. Get it done at startup.
+    struct StackCaptureWarmUp
+    {
+        StackCaptureWarmUp()
+        {
+            void* frames[4];
+            captureStack(frames, 4);
+        }
+    };
+
+    StackCaptureWarmUp stackCaptureWarmUp;
+
+    // The allocator underneath operator new, bypassing the malloc replacement so nothing is noted twice
+    void* rawAllocate(size_t size) noexcept
+    {
+       #if JUCE_LINUX
+        return __libc_malloc(size == 0 ? 1 : size);
+       #else
+        return std::malloc(size == 0 ? 1 : size);
+       #endif
+    }
+
+   #if ! JUCE_WINDOWS
+    void* rawAllocateAligned(size_t alignment, size_t size) noexcept
+    {
+       #if JUCE_LINUX
+        return __libc_memalign(alignment, size == 0 ? 1 : size);
+       #else
+        void* p = nullptr;
+        return posix_memalign(&p, juce::jmax(sizeof(void*), alignment), size == 0 ? 1 : size) == 0 ? p : nullptr;
+       #endif
+    }
+   #endif
+
+    void rawFree(void* p) noexcept
+    {
+       #if JUCE_LINUX
+        __libc_free(p);
+       #else
+        std::free(p);
+       #endif
+    }
+}
+
+//==============================================================================
+RealtimeSafety::ScopedRealtimeContext::ScopedRealtimeContext(const char* threadName) noexcept
+{
+    auto& state = threadState;
+
+    if (state.realtimeDepth++ == 0)
+        state.name = threadName;
+}
+
+RealtimeSafety::ScopedRealtimeContext::~ScopedRealtimeContext() noexcept
+{
+    --threadState.realtimeDepth;
+}
+
+RealtimeSafety::ScopedTryLock::ScopedTryLock(const juce::CriticalSection& lockToTry) noexcept
+    : lock(lockToTry), locked(lockToTry.tryEnter())
+{
+    auto& state = threadState;
+
+    if (locked && state.numHeldLocks < (int)juce::numElementsInArray(state.heldLocks))
+        state.heldLocks[state.numHeldLocks++] = &lock;
+}
+
+RealtimeSafety::ScopedTryLock::~ScopedTryLock() noexcept
+{
+    if (!locked)
+        return;
+
+    // Scopes end in the reverse order they began, so this one's is the last
+    auto& state = threadState;
+
+    if (state.numHeldLocks > 0 && state.heldLocks[state.numHeldLocks - 1] == &lock)
+        --state.numHeldLocks;
+
+    lock.exit();
+}
+
+//==============================================================================
+int RealtimeSafety::getNumViolations() noexcept
+{
+    return numViolations.load(std::memory_order_relaxed);
+}
+
+juce::Array<RealtimeSafety::Violation> RealtimeSafety::getViolations()
+{
+    // Copied out under the lock, then made readable outside it
+    std::vector<Record> copies;
+
+    while (recordsLock.test_and_set(std::memory_order_acquire))
+    {
+    }
+
+    copies.assign(records, records + numRecords);
+    recordsLock.clear(std::memory_order_release);
+
+    juce::Array<Violation> violations;
+
+    for (auto& record : copies)
+    {
+        Violation violation;
+        violation.type = record.type;
+        violation.thread = record.thread != nullptr ? record.thread : "";
+        violation.bytes = record.bytes;
+        violation.count = record.count;
+        violation.stack = describeStack(record.frames, record.numFrames);
+        violations.add(violation);
+    }
+
+    return violations;
+}
+
+void RealtimeSafety::reset()
+{
+    while (recordsLock.test_and_set(std::memory_order_acquire))
+    {
+    }
+
+    numRecords = 0;
+    numViolations.store(0);
+    recordsLock.clear(std::memory_order_release);
+}
+
+//==============================================================================
+// The replacements. Each notes the call if the thread is real-time, then does what the original would.
+
+namespace
+{
+    forcedinline void* allocate(size_t size)
+    {
+        noteViolation(RealtimeSafety::ViolationType::allocation, size);
+
+        if (auto* p = rawAllocate(size))
+            return p;
+
+        throw std::bad_alloc();
+    }
+
+    forcedinline void* allocateNoThrow(size_t size) noexcept
+    {
+        noteViolation(RealtimeSafety::ViolationType::allocation, size);
+        return rawAllocate(size);
+    }
+
+    forcedinline void deallocate(void* p) noexcept
+    {
+        if (p != nullptr)
+            noteViolation(RealtimeSafety::ViolationType::deallocation, 0);
+
+        rawFree(p);
+    }
+
+   #if ! JUCE_WINDOWS
+    forcedinline void* allocateAligned(size_t size, std::align_val_t alignment)
+    {
+        noteViolation(RealtimeSafety::ViolationType::allocation, size);
+
+        if (auto* p = rawAllocateAligned((size_t)alignment, size))
+            return p;
+
+        throw std::bad_alloc();
+    }
+   #endif
+}
+
+void* operator new(size_t size)                                     { return allocate(size); }
+void* operator new[](size_t size)                                   { return allocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept     { return allocateNoThrow(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept   { return allocateNoThrow(size); }
+
+void operator delete(void* p) noexcept                              { deallocate(p); }
+void operator delete[](void* p) noexcept                            { deallocate(p); }
+void operator delete(void* p, size_t) noexcept                      { deallocate(p); }
+void operator delete[](void* p, size_t) noexcept                    { deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept       { deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept     { deallocate(p); }
+
+#if ! JUCE_WINDOWS
+// Over-aligned types. MSVC's aligned allocations need _aligned_free, so they're left alone there.
+void* operator new(size_t size, std::align_val_t alignment)                   { return allocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment)                 { return allocateAligned(size, alignment); }
+void operator delete(void* p, std::align_val_t) noexcept                      { deallocate(p); }
+void operator delete[](void* p, std::align_val_t) noexcept                    { deallocate(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept              { deallocate(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept            { deallocate(p); }
+#endif
+
+#if JUCE_LINUX
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        noteViolation(RealtimeSafety::ViolationType::allocation, size);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        noteViolation(RealtimeSafety::ViolationType::allocation, count * size);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* p, size_t size)
+    {
+        noteViolation(RealtimeSafety::ViolationType::allocation, size);
+        return __libc_realloc(p, size);
+    }
+
+    void free(void* p)
+    {
+        if (p != nullptr)
+            noteViolation(RealtimeSafety::ViolationType::deallocation, 0);
+
+        __libc_free(p);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        noteViolation(RealtimeSafety::ViolationType::allocation, size);
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        noteViolation(RealtimeSafety::ViolationType::allocation, size);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size)
+    {
+        noteViolation(RealtimeSafety::ViolationType::allocation, size);
+        auto* p = __libc_memalign(alignment, size);
+        if (p == nullptr)
+            return ENOMEM;
+
+        *result = p;
+        return 0;
+    }
+
+    // A juce::CriticalSection is nothing but its mutex here, so the two share an address
+    static_assert(sizeof(juce::CriticalSection) == sizeof(pthread_mutex_t), "CriticalSection should wrap only a pthread mutex");
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        using LockFunction = int (*)(pthread_mutex_t*);
+
+        // Looked up on first use. Not a function-local static, as guarding one can itself take a mutex.
+        static std::atomic<LockFunction> realLock { nullptr };
+        auto lock = realLock.load(std::memory_order_acquire);
+
+        if (lock == nullptr)
+        {
+            lock = (LockFunction)dlsym(RTLD_NEXT, "pthread_mutex_lock");
+            realLock.store(lock, std::memory_order_release);
+        }
+
+        if (!isHeldByTryLock(mutex))
+            noteViolation(RealtimeSafety::ViolationType::lock, 0);
+
+        return lock(mutex);
+    }
+}
+#endif
+
+#else
+
+//==============================================================================
+int RealtimeSafety::getNumViolations() noexcept                      { return 0; }
+juce::Array<RealtimeSafety::Violation> RealtimeSafety::getViolations() { return {}; }
+void RealtimeSafety::reset()                                          {}
+
+#endif
+
+//==============================================================================
+juce::String RealtimeSafety::getTypeName(ViolationType type)
+{
+    if (type == ViolationType::allocation)
+        return "allocation";
+
+    if (type == ViolationType::deallocation)
+        return "deallocation";
+
+    return "lock";
+}
+
+juce::String RealtimeSafety::getReport()
+{
+    if (!isAvailable())
+        return "Real-time safety checks aren't in this build (SAMPLER_REALTIME_SAFETY_CHECKS)\n";
+
+    auto violations = getViolations();
+
+    juce::String text;
+    text << "Real-time safety: " << getNumViolations() << " violations from " << violations.size() << " call sites\n";
+
+    for (auto& violation : violations)
+    {
+        text << "\n" << getTypeName(violation.type) << " on the " << violation.thread << " thread, " << violation.count << " times";
+
+        if (violation.bytes > 0)
+            text << ", up to " << (juce::int64)violation.bytes << " bytes";
+
+        text << "\n";
+
+        for (auto& line : violation.stack)
+            text << "    " << line << "\n";
+    }
+
+    return text;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    RealtimeSafety.h
+    Created: Catches allocations and locks on the audio threads
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Build with this set to 1 to check the audio threads. It replaces the global
+// operator new and delete (and on Linux malloc and pthread_mutex_lock) for the
+// whole program, so it's for debug and test builds only.
+#ifndef SAMPLER_REALTIME_SAFETY_CHECKS
+ #define SAMPLER_REALTIME_SAFETY_CHECKS 0
+#endif
+
+//==============================================================================
+/**
+    Reports anything the audio threads do that can block: allocating or freeing
+    memory, or locking a mutex.
+
+    A thread counts as real-time while a ScopedRealtimeContext is alive on it.
+    Taking a lock again that's already held through a ScopedTryLock is left out.
+    Each violation is recorded with the stack that caused it, once per distinct
+    stack, with a count of how often it happened. Nothing is reported unless
+    the build has SAMPLER_REALTIME_SAFETY_CHECKS set. Without it the scopes
+    compile to nothing.
+
+    What's caught:
+      - operator new and delete, everywhere
+      - malloc, calloc, realloc, free and the aligned variants, on Linux
+      - pthread_mutex_lock, on Linux, which covers juce::CriticalSection and std::mutex
+*/
+class RealtimeSafety
+{
+public:
+    //==============================================================================
+    enum class ViolationType
+    {
+        allocation,
+        deallocation,
+        lock
+    };
+
+    struct Violation
+    {
+        ViolationType type = ViolationType::allocation;
+        juce::String thread;        // the name given to the ScopedRealtimeContext
+        size_t bytes = 0;           // size of the largest allocation from this stack
+        int count = 0;
+        juce::StringArray stack;    // innermost call first
+    };
+
+    //==============================================================================
+    /** Returns true if this build checks the real-time threads */
+    static constexpr bool isAvailable() noexcept { return SAMPLER_REALTIME_SAFETY_CHECKS != 0; }
+
+    /** Returns the number of violations since the last reset(), repeats included */
+    static int getNumViolations() noexcept;
+
+    /** Returns the violations recorded since the last reset(), one per distinct stack */
+    static juce::Array<Violation> getViolations();
+
+    /** Returns the violations as text, for the log or a test's output */
+    static juce::String getReport();
+
+    /** Forgets the violations recorded so far. Don't call it while a real-time thread is running. */
+    static void reset();
+
+    static juce::String getTypeName(ViolationType type);
+
+    //==============================================================================
+    /** Treats the calling thread as real-time for the lifetime of the object. These can nest. */
+    class ScopedRealtimeContext
+    {
+    public:
+       #if SAMPLER_REALTIME_SAFETY_CHECKS
+        explicit ScopedRealtimeContext(const char* threadName) noexcept;
+        ~ScopedRealtimeContext() noexcept;
+       #else
+        explicit ScopedRealtimeContext(const char*) noexcept {}
+       #endif
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeContext)
+    };
+
+    /** Takes a lock only if it's free, for the lifetime of the object. While it's held,
+        taking the same lock again on this thread can't wait, so that isn't reported;
+        if it was busy, whatever takes it next is. Without the checks in the build this
+        does nothing, and the lock is left to be taken as usual.
+    */
+    class ScopedTryLock
+    {
+    public:
+       #if SAMPLER_REALTIME_SAFETY_CHECKS
+        explicit ScopedTryLock(const juce::CriticalSection& lockToTry) noexcept;
+        ~ScopedTryLock() noexcept;
+       #else
+        explicit ScopedTryLock(const juce::CriticalSection&) noexcept {}
+       #endif
+
+    private:
+       #if SAMPLER_REALTIME_SAFETY_CHECKS
+        const juce::CriticalSection& lock;
+        const bool locked;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTryLock)
+    };
+};
\ No newline at end of file
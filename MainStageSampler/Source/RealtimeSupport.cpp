@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+    RealtimeSupport.cpp
+    Created: Keeping the audio path free of page faults and scheduler delays
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "RealtimeSupport.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <sys/mman.h>
+ #include <sys/resource.h>
+ #include <pthread.h>
+ #include <sched.h>
+ #include <unistd.h>
+ #include <cerrno>
+#endif
+
+namespace
+{
+    size_t getPageSize()
+    {
+       #if JUCE_WINDOWS
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return (size_t)info.dwPageSize;
+       #else
+        return (size_t)sysconf(_SC_PAGESIZE);
+       #endif
+    }
+
+    bool lockPages(void* start, size_t numBytes, juce::String& error)
+    {
+       #if JUCE_WINDOWS
+        // VirtualLock is limited by the working set, so grow it to cover the new pages
+        SIZE_T minimumSize = 0, maximumSize = 0;
+        auto process = GetCurrentProcess();
+
+        if (GetProcessWorkingSetSize(process, &minimumSize, &maximumSize))
+            SetProcessWorkingSetSize(process, minimumSize + numBytes, juce::jmax(maximumSize, minimumSize + numBytes));
+
+        if (VirtualLock(start, numBytes))
+            return true;
+
+        error = "VirtualLock failed with error " + juce::String((int)GetLastError());
+        return false;
+       #else
+        if (mlock(start, numBytes) == 0)
+            return true;
+
+        error = juce::String("mlock failed: ") + std::strerror(errno)
+              + (errno == ENOMEM || errno == EPERM ? " (check the memlock limit, ulimit -l)" : "");
+        return false;
+       #endif
+    }
+
+    void unlockPages(void* start, size_t numBytes)
+    {
+       #if JUCE_WINDOWS
+        VirtualUnlock(start, numBytes);
+       #else
+        munlock(start, numBytes);
+       #endif
+    }
+}
+
+//==============================================================================
+juce::String SampleMemoryResidency::Report::toString() const
+{
+    auto megabytes = [](size_t bytes) { return juce::String((double)bytes / (1024.0 * 1024.0), 1) + " MB"; };
+
+    auto text = "Sample memory: " + juce::String(numBuffers) + " buffers, "
+              + megabytes(bytesPrefaulted) + " prefaulted, " + megabytes(bytesLocked) + " locked";
+
+    if (bytesNotLocked > 0)
+        text += ", " + megabytes(bytesNotLocked) + " not locked";
+
+    if (lockError.isNotEmpty())
+        text += " (" + lockError + ")";
+
+    return text + " in " + juce::String(seconds, 2) + "s";
+}
+
+SampleMemoryResidency::SampleMemoryResidency()
+{
+}
+
+SampleMemoryResidency::~SampleMemoryResidency()
+{
+    unlockAll();
+}
+
+SampleMemoryResidency::Report SampleMemoryResidency::makeResident(const juce::Array<SampleSound::Ptr>& sounds,
+    const Options& options, const std::function<void(double)>& progressCallback)
+{
+    Report report;
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+    const auto pageSize = getPageSize();
+
+    for (int i = 0; i < sounds.size(); ++i)
+    {
+        sounds.getReference(i)->visitSampleMemory([&](const void* data, size_t numBytes)
+            {
+                if (data == nullptr || numBytes == 0)
+                    return;
+
+                ++report.numBuffers;
+
+                if (options.prefault)
+                {
+                    // One read per page is enough to bring it in
+                    auto* bytes = static_cast<const volatile char*>(data);
+                    char sum = 0;
+
+                    for (size_t offset = 0; offset < numBytes; offset += pageSize)
+                        sum ^= bytes[offset];
+
+                    sum ^= bytes[numBytes - 1];
+                    juce::ignoreUnused(sum);
+                    report.bytesPrefaulted += numBytes;
+                }
+
+                if (options.lockMemory)
+                {
+                    // Locks work on whole pages
+                    auto first = reinterpret_cast<juce::uint64>(data) & ~(juce::uint64)(pageSize - 1);
+                    auto last = reinterpret_cast<juce::uint64>(data) + numBytes;
+                    auto* start = reinterpret_cast<void*>(first);
+                    auto length = (size_t)(last - first);
+
+                    if (report.numLockFailures > 0 || lockedBytes + length > options.lockLimitBytes)
+                    {
+                        report.bytesNotLocked += numBytes;
+                    }
+                    else if (lockPages(start, length, report.lockError))
+                    {
+                        lockedRanges.push_back({ start, length });
+                        lockedBytes += length;
+                        report.bytesLocked += numBytes;
+                    }
+                    else
+                    {
+                        // The OS limit won't change part way through, so don't keep asking
+                        ++report.numLockFailures;
+                        report.bytesNotLocked += numBytes;
+                    }
+                }
+            });
+
+        if (progressCallback != nullptr)
+            progressCallback((double)(i + 1) / (double)sounds.size());
+    }
+
+    report.seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    return report;
+}
+
+void SampleMemoryResidency::unlockAll()
+{
+    for (auto& range : lockedRanges)
+        unlockPages(range.start, range.numBytes);
+
+    lockedRanges.clear();
+    lockedBytes = 0;
+}
+
+//==============================================================================
+bool RealtimeThread::requestRealtimeScheduling(int priority, juce::String& error)
+{
+    return requestRealtimeScheduling(juce::Thread::getCurrentThreadId(), priority, error);
+}
+
+bool RealtimeThread::requestRealtimeScheduling(juce::Thread::ThreadID thread, int priority, juce::String& error)
+{
+   #if JUCE_LINUX
+    sched_param param {};
+    param.sched_priority = juce::jlimit(sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO), priority);
+
+    // On Linux a JUCE thread ID is the thread's pthread_t
+    auto result = pthread_setschedparam((pthread_t)thread, SCHED_FIFO, &param);
+    if (result == 0)
+        return true;
+
+    error = juce::String("SCHED_FIFO refused: ") + std::strerror(result)
+          + (result == EPERM ? " (check the rtprio limit, ulimit -r)" : "");
+    return false;
+   #else
+    juce::ignoreUnused(thread, priority);
+    error = "Real-time scheduling requests are only supported on Linux";
+    return false;
+   #endif
+}
+
+juce::int64 RealtimeThread::getMajorPageFaults()
+{
+   #if JUCE_LINUX
+    rusage usage {};
+    if (getrusage(RUSAGE_THREAD, &usage) == 0)
+        return (juce::int64)usage.ru_majflt;
+    return -1;
+   #elif JUCE_WINDOWS
+    return -1;
+   #else
+    rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return (juce::int64)usage.ru_majflt;
+    return -1;
+   #endif
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    RealtimeSupport.h
+    Created: Keeping the audio path free of page faults and scheduler delays
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleSound.h"
+
+//==============================================================================
+/**
+    Makes sure the sample data of a loaded instrument is in RAM before the audio
+    thread needs it.
+
+    After a load (or after the OS has paged memory out while the machine sat idle),
+    the first note on a rarely played key would otherwise page-fault inside the
+    audio callback. This touches every page up front and can optionally lock the
+    pages so they can't be paged out again.
+*/
+class SampleMemoryResidency
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        /** Read every page of sample data once after loading */
+        bool prefault = true;
+
+        /** Lock sample data into RAM, up to lockLimitBytes */
+        bool lockMemory = false;
+
+        /** Most sample data to lock. Anything beyond this is only prefaulted. */
+        size_t lockLimitBytes = (size_t)1024 * 1024 * 1024;
+    };
+
+    struct Report
+    {
+        int numBuffers = 0;
+        size_t bytesPrefaulted = 0;
+        size_t bytesLocked = 0;
+        size_t bytesNotLocked = 0;   // over the limit, or refused by the OS
+        int numLockFailures = 0;
+        juce::String lockError;      // the first reason the OS gave for refusing a lock
+        double seconds = 0.0;
+
+        juce::String toString() const;
+    };
+
+    SampleMemoryResidency();
+    ~SampleMemoryResidency();
+
+    /** Prefaults and locks the sample data of the given sounds as the options say.
+        This can take a while for a large instrument, so call it from the loading
+        thread. The progress callback is given values from 0 to 1.
+    */
+    Report makeResident(const juce::Array<SampleSound::Ptr>& sounds, const Options& options,
+        const std::function<void(double progress)>& progressCallback = nullptr);
+
+    /** Unlocks everything locked so far. Call this before the sounds are freed. */
+    void unlockAll();
+
+    /** Returns the number of bytes currently locked. */
+    size_t getLockedBytes() const noexcept { return lockedBytes; }
+
+private:
+    //==============================================================================
+    struct LockedRange
+    {
+        void* start;
+        size_t numBytes;
+    };
+
+    std::vector<LockedRange> lockedRanges;
+    size_t lockedBytes = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleMemoryResidency)
+};
+
+//==============================================================================
+/**
+    Scheduling and fault accounting for the threads that feed the audio device.
+*/
+class RealtimeThread
+{
+public:
+    /** Asks the OS to run the calling thread with real-time (SCHED_FIFO) priority.
+
+        This only does anything on Linux, where the user needs an rtprio limit (for
+        example from the audio group in /etc/security/limits.d). Returns false and
+        fills in the error if the request was refused or isn't supported.
+    */
+    static bool requestRealtimeScheduling(int priority, juce::String& error);
+
+    /** As above, but for another thread, so a thread that mustn't allocate or log can
+        be given its priority by one that can. The ID is what the thread itself got
+        from juce::Thread::getCurrentThreadId(), and the thread must still be running.
+    */
+    static bool requestRealtimeScheduling(juce::Thread::ThreadID thread, int priority, juce::String& error);
+
+    /** Returns the number of major page faults (ones that had to wait for the disk)
+        taken so far by the calling thread, or by the whole process where per-thread
+        figures aren't available. Returns -1 if the platform can't report them.
+    */
+    static juce::int64 getMajorPageFaults();
+};
\ No newline at end of file
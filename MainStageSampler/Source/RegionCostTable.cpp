@@ -0,0 +1,218 @@
+/*
+  ==============================================================================
+
+    RegionCostTable.cpp
+    Created: Charges each voice's render time to the region it's playing
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "RegionCostTable.h"
+
+namespace
+{
+    /** Describes a region by its sample, keys and velocities, which is how it's found in the SFZ */
+    juce::String getRegionLabel(SampleSound& sound)
+    {
+        int lowestNote = -1, highestNote = -1;
+
+        for (int note = 0; note < 128; ++note)
+        {
+            if (sound.appliesToNote(note))
+            {
+                if (lowestNote < 0)
+                    lowestNote = note;
+
+                highestNote = note;
+            }
+        }
+
+        const auto velocities = sound.getVelocityRange();
+
+        return sound.getName() + " keys " + juce::String(lowestNote) + "-" + juce::String(highestNote)
+             + " vel " + juce::String(velocities.getStart()) + "-" + juce::String(velocities.getEnd());
+    }
+}
+
+//==============================================================================
+juce::String RegionCostTable::Snapshot::toString(int maxRegionsShown) const
+{
+    juce::String text;
+
+    if (!isAvailable())
+    {
+        text << "Region costs aren't counted in this build (set SAMPLER_REGION_COST_ATTRIBUTION)" << "\n";
+        return text;
+    }
+
+    text << "Voice render time by region: " << juce::String(totalSeconds * 1000.0, 1) << " ms for "
+         << juce::String(totalVoiceSeconds, 1) << " voice-seconds" << "\n";
+    text << "  " << juce::String("share").paddedLeft(' ', 7) << juce::String("core/voice").paddedLeft(' ', 12)
+         << juce::String("Mcyc/voice-s").paddedLeft(' ', 14) << juce::String("voice-s").paddedLeft(' ', 10) << "  region" << "\n";
+
+    for (int i = 0; i < juce::jmin(maxRegionsShown, regions.size()); ++i)
+    {
+        const auto& cost = regions.getReference(i);
+        const auto share = totalSeconds > 0.0 ? cost.seconds / totalSeconds : 0.0;
+        const auto cyclesPerVoiceSecond = cost.voiceSeconds > 0.0 ? (double)cost.cycles / cost.voiceSeconds : 0.0;
+
+        text << "  " << (juce::String(share * 100.0, 1) + "%").paddedLeft(' ', 7)
+             << (juce::String(cost.getCostPerVoiceSecond() * 100.0, 2) + "%").paddedLeft(' ', 12)
+             << juce::String(cyclesPerVoiceSecond * 1.0e-6, 2).paddedLeft(' ', 14)
+             << juce::String(cost.voiceSeconds, 2).paddedLeft(' ', 10) << "  " << cost.region << "\n";
+    }
+
+    if (regions.size() > maxRegionsShown)
+        text << "  ... and " << regions.size() - maxRegionsShown << " more" << "\n";
+
+    if (numUntrackedRegions > 0)
+        text << "  " << numUntrackedRegions << " regions past the first " << maxRegions << " weren't counted" << "\n";
+
+    return text;
+}
+
+juce::String RegionCostTable::Snapshot::toJSON() const
+{
+    juce::Array<juce::var> regionList;
+
+    for (auto& cost : regions)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("region", cost.region);
+        object->setProperty("cycles", cost.cycles);
+        object->setProperty("voice_samples", cost.voiceSamples);
+        object->setProperty("renders", cost.renders);
+        object->setProperty("seconds", cost.seconds);
+        object->setProperty("voice_seconds", cost.voiceSeconds);
+        object->setProperty("cost_per_voice_second", cost.getCostPerVoiceSecond());
+        regionList.add(juce::var(object));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("available", isAvailable());
+    root->setProperty("cycles_per_second", cyclesPerSecond);
+    root->setProperty("total_seconds", totalSeconds);
+    root->setProperty("total_voice_seconds", totalVoiceSeconds);
+    root->setProperty("untracked_regions", numUntrackedRegions);
+    root->setProperty("regions", regionList);
+
+    return juce::JSON::toString(juce::var(root));
+}
+
+//==============================================================================
+RegionCostTable::RegionCostTable()
+{
+   #if SAMPLER_REGION_COST_ATTRIBUTION
+    slots = std::make_unique<Slot[]>(maxRegions);
+   #endif
+}
+
+RegionCostTable::~RegionCostTable()
+{
+}
+
+void RegionCostTable::assign(const juce::Array<SampleSound::Ptr>& sounds)
+{
+   #if SAMPLER_REGION_COST_ATTRIBUTION
+    // Renders of the old sounds still playing out stop counting from here
+    const auto newGeneration = generation.load() + 1;
+    generation.store(newGeneration);
+    reset();
+
+    juce::StringArray newLabels;
+
+    for (int i = 0; i < sounds.size(); ++i)
+    {
+        auto& sound = *sounds.getUnchecked(i);
+
+        if (i < maxRegions)
+        {
+            newLabels.add(getRegionLabel(sound));
+            sound.setRegionCostKey(((juce::int64)newGeneration << 32) | i);
+        }
+        else
+        {
+            sound.setRegionCostKey(-1);
+        }
+    }
+
+    const juce::ScopedLock sl(labelLock);
+    labels.swapWith(newLabels);
+    numUntrackedRegions = juce::jmax(0, sounds.size() - maxRegions);
+   #else
+    juce::ignoreUnused(sounds);
+   #endif
+}
+
+void RegionCostTable::reset() noexcept
+{
+    if (slots == nullptr)
+        return;
+
+    for (int i = 0; i < maxRegions; ++i)
+    {
+        slots[i].cycles.store(0, std::memory_order_relaxed);
+        slots[i].voiceSamples.store(0, std::memory_order_relaxed);
+        slots[i].renders.store(0, std::memory_order_relaxed);
+    }
+}
+
+RegionCostTable::Snapshot RegionCostTable::getSnapshot(double sampleRate) const
+{
+    Snapshot snapshot;
+
+    if (slots == nullptr || sampleRate <= 0.0)
+        return snapshot;
+
+    snapshot.cyclesPerSecond = getCyclesPerSecond();
+
+    const juce::ScopedLock sl(labelLock);
+    snapshot.numUntrackedRegions = numUntrackedRegions;
+
+    for (int i = 0; i < labels.size(); ++i)
+    {
+        RegionCost cost;
+        cost.renders = slots[i].renders.load(std::memory_order_relaxed);
+
+        if (cost.renders == 0)
+            continue;
+
+        cost.region = labels[i];
+        cost.cycles = slots[i].cycles.load(std::memory_order_relaxed);
+        cost.voiceSamples = slots[i].voiceSamples.load(std::memory_order_relaxed);
+        cost.seconds = (double)cost.cycles / snapshot.cyclesPerSecond;
+        cost.voiceSeconds = (double)cost.voiceSamples / sampleRate;
+
+        snapshot.totalSeconds += cost.seconds;
+        snapshot.totalVoiceSeconds += cost.voiceSeconds;
+        snapshot.regions.add(cost);
+    }
+
+    std::sort(snapshot.regions.begin(), snapshot.regions.end(),
+        [](const RegionCost& a, const RegionCost& b) { return a.cycles > b.cycles; });
+
+    return snapshot;
+}
+
+//==============================================================================
+double RegionCostTable::getCyclesPerSecond()
+{
+   #if SAMPLER_REGION_COST_ATTRIBUTION && JUCE_INTEL
+    // The time stamp counter runs at a fixed rate on anything recent, so timing it once against the clock will do
+    static const double cyclesPerSecond = []
+    {
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        const auto startCycles = readCycleCounter();
+        juce::Thread::sleep(50);
+        const auto cycles = readCycleCounter() - startCycles;
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+        return seconds > 0.0 ? (double)cycles / seconds : 1.0;
+    }();
+
+    return cyclesPerSecond;
+   #else
+    return (double)juce::Time::getHighResolutionTicksPerSecond();
+   #endif
+}
\ No newline at end of file
@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    RegionCostTable.h
+    Created: Charges each voice's render time to the region it's playing
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleSound.h"
+
+// Build with this set to 1 to count what every region costs to play. Without it
+// the table and the timing around each voice compile to nothing.
+#ifndef SAMPLER_REGION_COST_ATTRIBUTION
+ #define SAMPLER_REGION_COST_ATTRIBUTION 0
+#endif
+
+#if SAMPLER_REGION_COST_ATTRIBUTION && JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//==============================================================================
+/**
+    Shows which regions the voices' render time goes on, so a CPU spike can be
+    traced to the samples, layers or articulations that caused it.
+
+    Each region gets a slot when a sample set is loaded. The audio thread reads
+    the CPU's cycle counter around every voice's render and adds the cycles and
+    samples to the slot of the region that voice is playing, with relaxed atomic
+    adds, so any other thread can take a snapshot while it runs.
+
+    Only the first maxRegions regions of a sample set get a slot. Every slot is
+    cleared when a new set is assigned, and renders of sounds from earlier sets
+    are left out.
+*/
+class RegionCostTable
+{
+public:
+    //==============================================================================
+    static constexpr int maxRegions = 4096;
+
+    /** Returns true if this build counts region costs */
+    static constexpr bool isAvailable() noexcept { return SAMPLER_REGION_COST_ATTRIBUTION != 0; }
+
+    /** What one region has cost since the last reset */
+    struct RegionCost
+    {
+        juce::String region;
+        juce::int64 cycles = 0;
+        juce::int64 voiceSamples = 0;    // samples rendered, summed over the voices playing it
+        juce::int64 renders = 0;         // voice render calls
+        double seconds = 0.0;            // render time
+        double voiceSeconds = 0.0;       // audio produced, summed over the voices playing it
+
+        /** Returns the share of one CPU core a voice playing this region takes */
+        double getCostPerVoiceSecond() const noexcept { return voiceSeconds > 0.0 ? seconds / voiceSeconds : 0.0; }
+    };
+
+    /** A copy of the table at one moment */
+    struct Snapshot
+    {
+        juce::Array<RegionCost> regions;    // those that have played, most expensive first
+        double cyclesPerSecond = 0.0;
+        double totalSeconds = 0.0;
+        double totalVoiceSeconds = 0.0;
+        int numUntrackedRegions = 0;        // regions past maxRegions
+
+        /** Returns the most expensive regions as a table, for printing */
+        juce::String toString(int maxRegionsShown = 10) const;
+
+        /** Returns every region that played as JSON, for saving */
+        juce::String toJSON() const;
+    };
+
+    //==============================================================================
+    RegionCostTable();
+    ~RegionCostTable();
+
+    /** Gives each sound its slot and clears the table. Call from the loading thread,
+        before the sounds are added to the synthesiser.
+    */
+    void assign(const juce::Array<SampleSound::Ptr>& sounds);
+
+    /** Zeroes every slot. A render in progress may still land in the fresh totals. */
+    void reset() noexcept;
+
+    /** Takes a copy of the table. Call from any thread but the audio thread. */
+    Snapshot getSnapshot(double sampleRate) const;
+
+    //==============================================================================
+    /** Reads the CPU's time stamp counter, or the high resolution clock where there isn't one */
+    static forcedinline juce::int64 readCycleCounter() noexcept
+    {
+       #if SAMPLER_REGION_COST_ATTRIBUTION && JUCE_INTEL
+        return (juce::int64)__rdtsc();
+       #else
+        return juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    /** Returns how fast readCycleCounter() counts. Measured on the first call, which takes a moment. */
+    static double getCyclesPerSecond();
+
+    //==============================================================================
+    /** Times a voice's render and adds it to the region the voice is playing. Use it on the audio thread. */
+    class ScopedVoiceRender
+    {
+    public:
+       #if SAMPLER_REGION_COST_ATTRIBUTION
+        ScopedVoiceRender(RegionCostTable& tableToUse, juce::int64 regionKey, int numSamplesToRender) noexcept
+            : table(tableToUse), key(regionKey), numSamples(numSamplesToRender), startCycles(readCycleCounter())
+        {
+        }
+
+        ~ScopedVoiceRender() noexcept
+        {
+            table.add(key, readCycleCounter() - startCycles, numSamples);
+        }
+       #else
+        ScopedVoiceRender(RegionCostTable&, juce::int64, int) noexcept {}
+       #endif
+
+    private:
+       #if SAMPLER_REGION_COST_ATTRIBUTION
+        RegionCostTable& table;
+        const juce::int64 key;
+        const int numSamples;
+        const juce::int64 startCycles;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedVoiceRender)
+    };
+
+private:
+    //==============================================================================
+    struct Slot
+    {
+        std::atomic<juce::int64> cycles { 0 };
+        std::atomic<juce::int64> voiceSamples { 0 };
+        std::atomic<juce::int64> renders { 0 };
+    };
+
+    /** Adds one render to the region's slot. Keys from an earlier assign() are ignored. */
+    void add(juce::int64 regionKey, juce::int64 cycles, int numSamples) noexcept
+    {
+        if (regionKey < 0 || (juce::uint32)(regionKey >> 32) != generation.load(std::memory_order_relaxed))
+            return;
+
+        auto& slot = slots[(int)(regionKey & 0xffffffff)];
+        slot.cycles.fetch_add(cycles, std::memory_order_relaxed);
+        slot.voiceSamples.fetch_add(numSamples, std::memory_order_relaxed);
+        slot.renders.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Only allocated in builds that count
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<juce::uint32> generation { 0 };
+
+    // Region names, for the snapshot. Never touched by the audio thread.
+    juce::CriticalSection labelLock;
+    juce::StringArray labels;
+    int numUntrackedRegions = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RegionCostTable)
+};
\ No newline at end of file
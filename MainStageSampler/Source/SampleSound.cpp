@@ -10,6 +10,94 @@
 
 #include "SampleSound.h"
 
+namespace
+{
+    // Windowed-sinc lowpass used when halving the sample rate. The cutoff sits a
+    // little below the new Nyquist so the transition band doesn't fold back.
+    constexpr int decimatorHalfLength = 63;
+
+    const float* getDecimatorCoefficients()
+    {
+        static const auto coefficients = []
+        {
+            std::array<float, 2 * decimatorHalfLength + 1> h {};
+            const double cutoff = 0.225;
+            double sum = 0.0;
+
+            for (int k = -decimatorHalfLength; k <= decimatorHalfLength; ++k)
+            {
+                auto sinc = k == 0 ? 2.0 * cutoff
+                    : std::sin(juce::MathConstants<double>::twoPi * cutoff * k) / (juce::MathConstants<double>::pi * k);
+                auto phase = juce::MathConstants<double>::pi * k / (decimatorHalfLength + 1);
+                auto window = 0.42 + 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+
+                h[(size_t)(k + decimatorHalfLength)] = (float)(sinc * window);
+                sum += sinc * window;
+            }
+
+            for (auto& c : h)
+                c = (float)(c / sum);
+
+            return h;
+        }();
+
+        return coefficients.data();
+    }
+
+    // Inside a loop the sample repeats, so the taps of a frame there wrap round the
+    // loop and the jump back is filtered like any other pair of frames
+    void decimateByTwo(const juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& dest, juce::Range<int> loop)
+    {
+        const auto* h = getDecimatorCoefficients() + decimatorHalfLength;
+        const int inFrames = source.getNumSamples();
+        const int outFrames = (inFrames + 1) / 2;
+
+        dest.setSize(source.getNumChannels(), outFrames);
+
+        for (int ch = 0; ch < source.getNumChannels(); ++ch)
+        {
+            const auto* in = source.getReadPointer(ch);
+            auto* out = dest.getWritePointer(ch);
+
+            for (int n = 0; n < outFrames; ++n)
+            {
+                const int centre = 2 * n;
+                float sum = 0.0f;
+
+                if (loop.contains(centre))
+                {
+                    const int loopLength = loop.getLength();
+
+                    for (int k = -decimatorHalfLength; k <= decimatorHalfLength; ++k)
+                    {
+                        const int offset = (centre + k - loop.getStart()) % loopLength;
+                        sum += h[k] * in[loop.getStart() + (offset < 0 ? offset + loopLength : offset)];
+                    }
+                }
+                else
+                {
+                    const int first = juce::jmax(-decimatorHalfLength, -centre);
+                    const int last = juce::jmin(decimatorHalfLength, inFrames - 1 - centre);
+
+                    for (int k = first; k <= last; ++k)
+                        sum += h[k] * in[centre + k];
+                }
+
+                out[n] = sum;
+            }
+        }
+    }
+
+    // Rounds samples to the nearest value representable at the given integer bit depth
+    void quantiseToBitDepth(float* samples, int numSamples, int bitsPerSample)
+    {
+        const auto fullScale = (float)(1 << (bitsPerSample - 1));
+
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] = (float)juce::jlimit(-fullScale, fullScale - 1.0f, (float)juce::roundToInt(samples[i] * fullScale)) / fullScale;
+    }
+}
+
 SampleSound::SampleSound(const juce::String& soundName,
     juce::AudioBuffer<float>& source,
     const juce::BigInteger& notes,
@@ -19,22 +107,333 @@ SampleSound::SampleSound(const juce::String& soundName,
     double maxSampleLengthSeconds,
     juce::Range<int> velRange)
     : name(soundName),
-    data(std::make_unique<juce::AudioBuffer<float>>()),
-    attackTime(attackTimeSecs),
-    releaseTime(releaseTimeSecs),
     maxSampleLength(maxSampleLengthSeconds),
     midiRootNote(midiNoteForNormalPitch),
     midiNotes(notes),
     velocityRange(velRange)
 {
-    *data = source;
+    auto* original = levels.add(new Level());
+    original->data = source;
+    original->numChannels = source.getNumChannels();
+    original->numFrames = source.getNumSamples();
     length = source.getNumSamples();
+
+    envelope.attack = (float)attackTimeSecs;
+    envelope.release = (float)releaseTimeSecs;
 }
 
 SampleSound::~SampleSound()
 {
 }
 
+bool SampleSound::compressAudioData(int bitsPerSample)
+{
+    auto* original = levels.getUnchecked(0);
+
+    if (original->compressed != nullptr)
+        return true;
+
+    if (original->interleaved != nullptr)
+        return false;
+
+    auto encoded = CompressedSampleData::encode(original->data, bitsPerSample);
+    if (encoded == nullptr)
+        return false;
+
+    original->compressed = std::move(encoded);
+    original->data.setSize(0, 0);
+
+    // The mip levels are filtered so they're no longer exact PCM - round them to
+    // the source bit depth first. That's well below the filter's own error.
+    for (int i = 1; i < levels.size(); ++i)
+    {
+        auto* level = levels.getUnchecked(i);
+
+        if (level->interleaved != nullptr)
+            continue;
+
+        for (int ch = 0; ch < level->numChannels; ++ch)
+            quantiseToBitDepth(level->data.getWritePointer(ch), level->numFrames, bitsPerSample);
+
+        // The guard has to hold what the compressed data will decode to
+        writeLoopGuard(*level, getLevelLoopRange(i));
+
+        level->compressed = CompressedSampleData::encode(level->data, bitsPerSample);
+
+        if (level->compressed != nullptr)
+            level->data.setSize(0, 0);
+    }
+
+    return true;
+}
+
+bool SampleSound::hasCompressedData() const noexcept
+{
+    if (getCompressedData() != nullptr)
+        return true;
+
+    for (auto& stream : micStreams)
+        if (stream != nullptr && stream->hasCompressedData())
+            return true;
+
+    return false;
+}
+
+void SampleSound::interleaveAudioData()
+{
+    for (auto* level : levels)
+    {
+        if (level->numChannels != 2 || level->compressed != nullptr || level->interleaved != nullptr)
+            continue;
+
+        level->interleaved.malloc((size_t)level->numFrames * 2);
+
+        const auto* left = level->data.getReadPointer(0);
+        const auto* right = level->data.getReadPointer(1);
+        auto* dest = level->interleaved.get();
+
+        for (int n = 0; n < level->numFrames; ++n)
+        {
+            dest[2 * n] = left[n];
+            dest[2 * n + 1] = right[n];
+        }
+
+        level->data.setSize(0, 0);
+    }
+}
+
+void SampleSound::setLoop(LoopMode mode, juce::Range<int> loopFrames, int crossfadeFrames, int bitsPerSample)
+{
+    auto* original = levels.getUnchecked(0);
+
+    // The loop is baked into the planar data, so this has to happen first
+    jassert(levels.size() == 1 && original->data.getNumSamples() == length);
+
+    loopMode = mode;
+    loopRange = {};
+
+    if (mode != LoopMode::continuous && mode != LoopMode::sustain)
+        return;
+
+    if (loopFrames.getStart() < 0 || loopFrames.getLength() < 1 || loopFrames.getEnd() > length)
+    {
+        DBG("SampleSound: Ignoring loop outside the sample: " + juce::String(loopFrames.getStart()) + "-" + juce::String(loopFrames.getEnd()));
+        loopMode = LoopMode::none;
+        return;
+    }
+
+    loopRange = loopFrames;
+
+    const int loopStart = loopRange.getStart();
+    const int loopEnd = loopRange.getEnd();
+    int fadeLength = juce::jmin(crossfadeFrames, loopStart, loopRange.getLength());
+
+    // A released sustain loop plays straight on from the loop end, so its frames have to stay as recorded
+    if (mode == LoopMode::sustain && fadeLength > 0)
+    {
+        DBG("SampleSound: Not crossfading the sustain loop of " + name);
+        fadeLength = 0;
+    }
+
+    if (fadeLength > 0)
+    {
+        for (int ch = 0; ch < original->numChannels; ++ch)
+        {
+            auto* samples = original->data.getWritePointer(ch);
+
+            // Equal power, arriving at the frame just before the loop start as the jump happens
+            for (int i = 0; i < fadeLength; ++i)
+            {
+                auto t = (float)(i + 1) / (float)fadeLength * juce::MathConstants<float>::halfPi;
+                auto n = loopEnd - fadeLength + i;
+                samples[n] = samples[n] * std::cos(t) + samples[n - loopRange.getLength()] * std::sin(t);
+            }
+
+            if (bitsPerSample > 0)
+                quantiseToBitDepth(samples + loopEnd - fadeLength, fadeLength, bitsPerSample);
+        }
+    }
+
+    writeLoopGuards();
+}
+
+juce::Range<int> SampleSound::getLevelLoopRange(int level) const noexcept
+{
+    return { loopRange.getStart() >> level, loopRange.getEnd() >> level };
+}
+
+void SampleSound::writeLoopGuards()
+{
+    if (loopRange.isEmpty())
+        return;
+
+    for (int i = 0; i < levels.size(); ++i)
+        writeLoopGuard(*levels.getUnchecked(i), getLevelLoopRange(i));
+}
+
+void SampleSound::writeLoopGuard(Level& level, juce::Range<int> loop)
+{
+    if (loop.isEmpty())
+        return;
+
+    level.loopGuard.setSize(level.data.getNumChannels(), 2);
+
+    for (int ch = 0; ch < level.data.getNumChannels(); ++ch)
+    {
+        level.loopGuard.setSample(ch, 0, level.data.getSample(ch, loop.getEnd() - 1));
+        level.loopGuard.setSample(ch, 1, level.data.getSample(ch, loop.getStart()));
+    }
+}
+
+void SampleSound::buildMipLevels(int numLevels)
+{
+    levels.removeRange(1, levels.size() - 1);
+
+    // Decimation works on the planar data, so this has to happen before compressing or interleaving
+    jassert(levels.getUnchecked(0)->data.getNumSamples() == length);
+
+    // A loop that doesn't land on whole frames of a level would drift or click there
+    if (!loopRange.isEmpty())
+    {
+        while (numLevels > 0 && ((loopRange.getStart() | loopRange.getEnd()) & ((1 << numLevels) - 1)) != 0)
+            --numLevels;
+    }
+
+    for (int i = 0; i < numLevels && levels.getLast()->numFrames > 1; ++i)
+    {
+        auto* previous = levels.getLast();
+        auto* level = levels.add(new Level());
+        decimateByTwo(previous->data, level->data, getLevelLoopRange(i));
+        level->numChannels = level->data.getNumChannels();
+        level->numFrames = level->data.getNumSamples();
+    }
+
+    writeLoopGuards();
+}
+
+int SampleSound::chooseLevel(double pitchRatio) const noexcept
+{
+    int level = 0;
+
+    // Stay on a level until the ratio within it would reach 2, so a voice never
+    // reads more than two source frames per output sample
+    while (level < levels.size() - 1 && pitchRatio >= (double)(2 << level))
+        ++level;
+
+    return level;
+}
+
+const juce::AudioBuffer<float>& SampleSound::getLevelData(int level) const noexcept
+{
+    return levels.getUnchecked(level)->data;
+}
+
+const float* SampleSound::getLevelInterleavedData(int level) const noexcept
+{
+    return levels.getUnchecked(level)->interleaved.get();
+}
+
+const CompressedSampleData* SampleSound::getLevelCompressedData(int level) const noexcept
+{
+    return levels.getUnchecked(level)->compressed.get();
+}
+
+int SampleSound::getLevelNumFrames(int level) const noexcept
+{
+    return levels.getUnchecked(level)->numFrames;
+}
+
+const juce::AudioBuffer<float>& SampleSound::getLevelLoopGuard(int level) const noexcept
+{
+    return levels.getUnchecked(level)->loopGuard;
+}
+
+size_t SampleSound::Level::getMemoryUsageBytes() const noexcept
+{
+    if (compressed != nullptr)
+        return compressed->getCompressedSizeBytes();
+
+    if (interleaved != nullptr)
+        return (size_t)numFrames * 2 * sizeof(float);
+
+    return (size_t)data.getNumChannels() * (size_t)data.getNumSamples() * sizeof(float);
+}
+
+size_t SampleSound::getMemoryUsageBytes() const noexcept
+{
+    size_t bytes = 0;
+
+    for (auto* level : levels)
+        bytes += level->getMemoryUsageBytes();
+
+    for (auto& stream : micStreams)
+        if (stream != nullptr)
+            bytes += stream->getMemoryUsageBytes();
+
+    return bytes;
+}
+
+size_t SampleSound::getUncompressedSizeBytes() const noexcept
+{
+    size_t bytes = 0;
+
+    for (auto* level : levels)
+        bytes += (size_t)level->numChannels * (size_t)level->numFrames * sizeof(float);
+
+    for (auto& stream : micStreams)
+        if (stream != nullptr)
+            bytes += stream->getUncompressedSizeBytes();
+
+    return bytes;
+}
+
+void SampleSound::visitSampleMemory(const std::function<void(const void*, size_t)>& visitor) const
+{
+    for (auto* level : levels)
+    {
+        if (level->compressed != nullptr)
+            level->compressed->visitMemory(visitor);
+        else if (level->interleaved != nullptr)
+            visitor(level->interleaved.get(), (size_t)level->numFrames * 2 * sizeof(float));
+        else
+        {
+            for (int ch = 0; ch < level->data.getNumChannels(); ++ch)
+                visitor(level->data.getReadPointer(ch), (size_t)level->data.getNumSamples() * sizeof(float));
+        }
+    }
+
+    for (auto& stream : micStreams)
+        if (stream != nullptr)
+            stream->visitSampleMemory(visitor);
+}
+
+//==============================================================================
+bool SampleSound::setMicStream(Mic mic, SampleSound* stream)
+{
+    jassert(mic != closeMic && mic < numMics);
+
+    if (stream != nullptr && stream->getNumFrames() != length)
+        return false;
+
+    if (micStreams[mic] != nullptr)
+        --numMicStreams;
+
+    micStreams[mic] = stream;
+
+    if (stream != nullptr)
+        ++numMicStreams;
+
+    return true;
+}
+
+const SampleSound* SampleSound::getMicStream(int mic) const noexcept
+{
+    if (mic == closeMic)
+        return this;
+
+    return juce::isPositiveAndBelow(mic, (int)numMics) ? micStreams[mic].get() : nullptr;
+}
+
 bool SampleSound::appliesToNote(int midiNoteNumber)
 {
     return midiNotes[midiNoteNumber];
@@ -11,6 +11,8 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "CompressedSampleData.h"
+#include "AmpEnvelope.h"
 
 //==============================================================================
 /**
@@ -50,14 +52,177 @@ public:
     /** Returns the name of this sample. */
     const juce::String& getName() const noexcept { return name; }
 
-    /** Returns the audio data. */
-    juce::AudioBuffer<float>* getAudioData() noexcept { return data.get(); }
+    /** Returns the planar audio data. This is empty once the sample has been compressed or interleaved. */
+    juce::AudioBuffer<float>* getAudioData() noexcept { return &levels.getUnchecked(0)->data; }
+
+    /** Returns the compressed audio data, or nullptr if the sample is held as floats. */
+    const CompressedSampleData* getCompressedData() const noexcept { return levels.getUnchecked(0)->compressed.get(); }
+
+    /** Returns true if this sample or any of its mic streams is held compressed. */
+    bool hasCompressedData() const noexcept;
+
+    /** Returns the length of the sample in frames, whichever way it's stored. */
+    int getNumFrames() const noexcept { return length; }
+
+    /** Replaces the float audio data with losslessly compressed blocks.
+
+        @param bitsPerSample  The bit depth of the integer PCM the sample was read from
+        @returns true if the data was compressed, false if it couldn't be stored losslessly
+                 and has been left as it was
+    */
+    bool compressAudioData(int bitsPerSample);
+
+    /** Rearranges the float data of stereo levels into interleaved L/R frames, so a
+        voice reads one memory stream instead of two. Compressed and mono levels are
+        left as they are.
+    */
+    void interleaveAudioData();
+
+    //==============================================================================
+    /** How a voice plays through the sample, following the SFZ loop_mode opcode. */
+    enum class LoopMode
+    {
+        none,        // play once, the note-off starts the release
+        oneShot,     // play to the end whatever the note-off does
+        continuous,  // loop until the voice has finished releasing
+        sustain      // loop until note-off, then play on to the end
+    };
+
+    /** Sets up a loop over the given frames, end exclusive.
+
+        For a continuous loop the last crossfadeFrames before the loop end are blended
+        with the frames before the loop start, so the jump back is seamless without
+        any extra work for the voice. If bitsPerSample is non-zero the blended frames
+        are rounded to that depth so the sample can still be compressed losslessly.
+        A sustain loop isn't crossfaded, as the blend is baked into the sample and
+        would click against the untouched frame after the loop end on release.
+
+        Call this before buildMipLevels(), compressAudioData() or interleaveAudioData().
+    */
+    void setLoop(LoopMode mode, juce::Range<int> loopFrames, int crossfadeFrames, int bitsPerSample);
+
+    /** Returns the loop mode. */
+    LoopMode getLoopMode() const noexcept { return loopMode; }
+
+    /** Returns the looped frames within a level, end exclusive. This is empty if the sample doesn't loop. */
+    juce::Range<int> getLevelLoopRange(int level) const noexcept;
+
+    //==============================================================================
+    /** The response of a voice's filter, following the SFZ fil_type opcode. */
+    enum class FilterType
+    {
+        none,
+        lowpass,
+        highpass,
+        bandpass,
+        notch
+    };
+
+    /** The filter settings of the region this sound came from. */
+    struct FilterSettings
+    {
+        FilterType type = FilterType::none;
+        float cutoff = 20000.0f;     // Hz
+        float resonance = 0.0f;      // dB of peak at the cutoff
+        float velocityTrack = 0.0f;  // cents added to the cutoff at full velocity
+    };
+
+    /** Sets the filter the voices playing this sound should use. */
+    void setFilter(const FilterSettings& newSettings) noexcept { filter = newSettings; }
+
+    /** Returns the filter settings. */
+    const FilterSettings& getFilter() const noexcept { return filter; }
+
+    //==============================================================================
+    /** Sets the amp envelope of the voices playing this sound. This replaces the
+        attack and release times given to the constructor.
+    */
+    void setEnvelope(const AmpEnvelope::Parameters& newEnvelope) noexcept { envelope = newEnvelope; }
+
+    /** Returns the amp envelope. */
+    const AmpEnvelope::Parameters& getEnvelope() const noexcept { return envelope; }
+
+    //==============================================================================
+    /** The microphone positions a multi-mic library can record each region from.
+        The region's sample is the close mic; the others are optional extra streams.
+    */
+    enum Mic
+    {
+        closeMic = 0,
+        overheadMic,
+        roomMic,
+
+        numMics
+    };
+
+    /** Adds another mic's recording of this region. It must be the same length as
+        this sample and set up the same way (loop, levels, storage), so a voice can
+        read every mic at one shared position.
+
+        @returns false, leaving the sound as it was, if the lengths don't match
+    */
+    bool setMicStream(Mic mic, SampleSound* stream);
+
+    /** Returns the sound holding a mic's stream: this one for the close mic, or
+        nullptr if the region has no recording from that mic.
+    */
+    const SampleSound* getMicStream(int mic) const noexcept;
+
+    /** Returns true if the region has more than the close mic. */
+    bool hasMicStreams() const noexcept { return numMicStreams > 0; }
+
+    //==============================================================================
+    /** Builds band-limited copies of the sample, each at half the rate of the one
+        before, so voices transposing up by an octave or more read fewer frames.
+
+        Call this before compressAudioData() so the copies are compressed too. For a
+        looped sample, only levels whose decimation divides the loop points exactly
+        are built, so the loop stays sample accurate on every level, and the filter
+        wraps round the loop so each level's jump back is as smooth as the original's.
+    */
+    void buildMipLevels(int numLevels);
+
+    /** Returns the number of levels, counting the original sample as level 0. */
+    int getNumLevels() const noexcept { return levels.size(); }
+
+    /** Returns the level a voice should read for the given pitch ratio. Level n
+        holds the sample decimated by 2^n, so the ratio within it is pitchRatio / 2^n.
+    */
+    int chooseLevel(double pitchRatio) const noexcept;
+
+    /** Returns the planar float data for a level. This is empty if the level is compressed or interleaved. */
+    const juce::AudioBuffer<float>& getLevelData(int level) const noexcept;
+
+    /** Returns the interleaved L/R frames for a level, or nullptr if it isn't interleaved. */
+    const float* getLevelInterleavedData(int level) const noexcept;
+
+    /** Returns the compressed data for a level, or nullptr if it's held as floats. */
+    const CompressedSampleData* getLevelCompressedData(int level) const noexcept;
+
+    /** Returns the length of a level in frames. */
+    int getLevelNumFrames(int level) const noexcept;
+
+    /** Returns two planar frames for a looped level: the last frame of the loop and
+        the loop start. A voice interpolates across the jump back from these, which
+        leaves the frame after the loop as recorded for a sustain loop's release.
+        This is empty if the sample doesn't loop.
+    */
+    const juce::AudioBuffer<float>& getLevelLoopGuard(int level) const noexcept;
+
+    /** Returns the number of bytes of sample data held in memory, counting every mic. */
+    size_t getMemoryUsageBytes() const noexcept;
+
+    /** Returns the number of bytes the sample data of every mic takes when held as floats. */
+    size_t getUncompressedSizeBytes() const noexcept;
+
+    /** Calls the visitor with each block of memory holding sample data, for every level of every mic. */
+    void visitSampleMemory(const std::function<void(const void* data, size_t numBytes)>& visitor) const;
 
     /** Returns the attack time in seconds. */
-    double getAttackTime() const noexcept { return attackTime; }
+    double getAttackTime() const noexcept { return envelope.attack; }
 
     /** Returns the release time in seconds. */
-    double getReleaseTime() const noexcept { return releaseTime; }
+    double getReleaseTime() const noexcept { return envelope.release; }
 
     /** Returns the MIDI note at which this sample plays at normal pitch. */
     int getRootMidiNote() const noexcept { return midiRootNote; }
@@ -65,6 +230,10 @@ public:
     /** Returns the velocity range for this sample. */
     juce::Range<int> getVelocityRange() const noexcept { return velocityRange; }
 
+    /** Identifies this sound's slot in a RegionCostTable, or -1 if it hasn't got one */
+    juce::int64 getRegionCostKey() const noexcept { return regionCostKey; }
+    void setRegionCostKey(juce::int64 newKey) noexcept { regionCostKey = newKey; }
+
     //==============================================================================
     /** Returns true if this sound should be triggered by the given MIDI note. */
     bool appliesToNote(int midiNoteNumber) override;
@@ -82,12 +251,42 @@ private:
     friend class SampleVoice;
 
     juce::String name;
-    std::unique_ptr<juce::AudioBuffer<float>> data;
-    double attackTime, releaseTime, maxSampleLength;
+
+    // One of these for the original sample and each decimated copy. Exactly one
+    // of the three storage forms holds the audio.
+    struct Level
+    {
+        juce::AudioBuffer<float> data;                      // planar floats
+        juce::HeapBlock<float> interleaved;                 // L0 R0 L1 R1 ...
+        std::unique_ptr<CompressedSampleData> compressed;
+        juce::AudioBuffer<float> loopGuard;                 // the last looped frame, then the loop start
+        int numChannels = 0;
+        int numFrames = 0;
+
+        size_t getMemoryUsageBytes() const noexcept;
+    };
+
+    juce::OwnedArray<Level> levels;
+
+    // The other mics' recordings, indexed by Mic. The close mic's slot stays empty.
+    juce::ReferenceCountedObjectPtr<SampleSound> micStreams[numMics];
+    int numMicStreams = 0;
+
+    /** Copies the frames either side of the jump back into each level's loop guard,
+        so interpolating across it doesn't need the frame after the loop changed. */
+    void writeLoopGuards();
+    void writeLoopGuard(Level& level, juce::Range<int> loop);
+
+    LoopMode loopMode = LoopMode::none;
+    juce::Range<int> loopRange;
+    FilterSettings filter;
+    AmpEnvelope::Parameters envelope;
+    double maxSampleLength;
     int midiRootNote;
     juce::BigInteger midiNotes;
     juce::Range<int> velocityRange;
     int length;
+    juce::int64 regionCostKey = -1;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleSound)
 };
\ No newline at end of file
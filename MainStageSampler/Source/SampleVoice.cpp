@@ -10,13 +10,64 @@
 
 #include "SampleVoice.h"
 
+namespace
+{
+    // Linear interpolation kernels. Each one writes frames until numSamples is
+    // reached or the next read would go past endFrame, and returns the count.
+
+    int interpolatePlanar(const float* inL, const float* inR, juce::Range<int> span,
+        double& position, double ratio, float* destL, float* destR, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i < numSamples; ++i)
+        {
+            auto frame = (int)position;
+            if (frame + 1 >= span.getEnd())
+                break;
+
+            auto alpha = (float)(position - frame);
+            auto invAlpha = 1.0f - alpha;
+            auto pos = frame - span.getStart();
+
+            destL[i] = inL[pos] * invAlpha + inL[pos + 1] * alpha;
+            destR[i] = inR != nullptr ? (inR[pos] * invAlpha + inR[pos + 1] * alpha) : destL[i];
+
+            position += ratio;
+        }
+
+        return i;
+    }
+
+    int interpolateInterleaved(const float* frames, int endFrame,
+        double& position, double ratio, float* destL, float* destR, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i < numSamples; ++i)
+        {
+            auto frame = (int)position;
+            if (frame + 1 >= endFrame)
+                break;
+
+            auto alpha = (float)(position - frame);
+            auto invAlpha = 1.0f - alpha;
+
+            // Both frames sit in four adjacent floats, so this is one read stream per voice
+            const float* pair = frames + 2 * frame;
+
+            destL[i] = pair[0] * invAlpha + pair[2] * alpha;
+            destR[i] = pair[1] * invAlpha + pair[3] * alpha;
+
+            position += ratio;
+        }
+
+        return i;
+    }
+}
+
 SampleVoice::SampleVoice()
 {
-    // Set up default ADSR parameters
-    adsrParams.attack = 0.1f;
-    adsrParams.decay = 1.0f;
-    adsrParams.sustain = 1.0f;
-    adsrParams.release = 0.1f;
 }
 
 SampleVoice::~SampleVoice()
@@ -33,24 +84,66 @@ void SampleVoice::startNote(int midiNoteNumber, float velocity,
 {
     if (auto* sound = dynamic_cast<const SampleSound*> (s))
     {
-        DBG("SampleVoice: Starting note " + juce::String(midiNoteNumber) +
-            " with sound: " + sound->getName());
-
-        pitchRatio = std::pow(2.0, (midiNoteNumber - sound->getRootMidiNote()) / 12.0);
+        notePitchRatio = std::pow(2.0, (midiNoteNumber - sound->getRootMidiNote()) / 12.0);
         sourceSamplePosition = 0.0;
 
+        // Large upward transpositions read from a decimated copy of the sample
+        auto level = sound->chooseLevel(notePitchRatio);
+        notePitchRatio /= (double)(1 << level);
+        pitchRatio = notePitchRatio * std::pow(2.0, playControls.tuningCents / 1200.0);
+
+        auto loop = sound->getLevelLoopRange(level);
+        loopMode = sound->getLoopMode();
+        loopStart = loop.getStart();
+        loopEnd = loop.getEnd();
+        released = false;
+
+        for (int mic = 0; mic < SampleSound::numMics; ++mic)
+        {
+            auto& stream = streams[mic];
+            auto* micSound = sound->getMicStream(mic);
+
+            // A mic stream is built like the close mic, but only read it if that's so
+            if (micSound != nullptr && level < micSound->getNumLevels())
+            {
+                stream.data = &micSound->getLevelData(level);
+                stream.interleaved = micSound->getLevelInterleavedData(level);
+                stream.compressed = micSound->getLevelCompressedData(level);
+                stream.loopGuard = &micSound->getLevelLoopGuard(level);
+                stream.numFrames = micSound->getLevelNumFrames(level);
+            }
+            else
+            {
+                stream.data = nullptr;
+                stream.interleaved = nullptr;
+                stream.compressed = nullptr;
+                stream.loopGuard = nullptr;
+                stream.numFrames = 0;
+            }
+
+            stream.decodeWindow.setSource(stream.compressed, loop.isEmpty() ? -1 : loopStart);
+        }
+
+        multiMic = sound->hasMicStreams();
+
         lgain = velocity;
         rgain = velocity;
 
-        // Update ADSR parameters from the sound
-        adsrParams.attack = (float)sound->getAttackTime();
-        adsrParams.release = (float)sound->getReleaseTime();
-        adsr.setParameters(adsrParams);
+        // fil_veltrack moves the cutoff by up to the given number of cents at full velocity
+        filter = sound->getFilter();
+        noteCutoff = filter.cutoff * std::pow(2.0f, filter.velocityTrack * velocity / 1200.0f);
+        filterRestart = true;
 
-        adsr.setSampleRate(getSampleRate());
-        adsr.noteOn();
+       #if SAMPLER_REGION_COST_ATTRIBUTION
+        regionCostKey = sound->getRegionCostKey();
+       #endif
 
-        DBG("SampleVoice: Note started successfully, pitch ratio: " + juce::String(pitchRatio));
+        // The envelope follows the sound's ampeg_ settings
+        soundEnvelope = sound->getEnvelope();
+        updateEnvelopeTimes();
+
+        envelope.setSampleRate(getSampleRate());
+        envelope.noteOn();
     }
     else
     {
@@ -59,16 +152,65 @@ void SampleVoice::startNote(int midiNoteNumber, float velocity,
     }
 }
 
+void SampleVoice::setPlayControls(const PlayControls& newControls) noexcept
+{
+    playControls = newControls;
+
+    if (isVoiceActive())
+    {
+        pitchRatio = notePitchRatio * std::pow(2.0, playControls.tuningCents / 1200.0);
+        updateEnvelopeTimes();
+    }
+}
+
+float SampleVoice::getMicGain(int mic) const noexcept
+{
+    if (streams[mic].numFrames == 0)
+        return 0.0f;
+
+    // Single-mic sounds ignore the mic levels
+    return multiMic ? playControls.micGains[mic] : 1.0f;
+}
+
+void SampleVoice::allocateDecodeWindow(int mic)
+{
+    if (juce::isPositiveAndBelow(mic, (int)SampleSound::numMics))
+        streams[mic].decodeWindow.allocate();
+}
+
+juce::int64 SampleVoice::getDecodeTicks() const noexcept
+{
+    juce::int64 ticks = 0;
+
+    for (auto& stream : streams)
+        ticks += stream.decodeWindow.getDecodeTicks();
+
+    return ticks;
+}
+
+void SampleVoice::updateEnvelopeTimes() noexcept
+{
+    auto parameters = soundEnvelope;
+    parameters.attack += playControls.extraAttack;
+    parameters.release *= playControls.releaseScale;
+    envelope.setParameters(parameters);
+}
+
 void SampleVoice::stopNote(float /*velocity*/, bool allowTailOff)
 {
     if (allowTailOff)
     {
-        adsr.noteOff();
+        // One-shots play to the end of the sample regardless
+        if (loopMode == SampleSound::LoopMode::oneShot)
+            return;
+
+        released = true;
+        envelope.noteOff();
     }
     else
     {
         clearCurrentNote();
-        adsr.reset();
+        envelope.reset();
     }
 }
 
@@ -84,65 +226,188 @@ void SampleVoice::controllerMoved(int /*controllerNumber*/, int /*newValue*/)
 
 void SampleVoice::renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
 {
-    if (auto* playingSound = static_cast<SampleSound*> (getCurrentlyPlayingSound().get()))
-    {
-        auto& data = *playingSound->getAudioData();
+    float* outL = outputBuffer.getWritePointer(0, startSample);
+    float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer(1, startSample) : nullptr;
 
-        if (data.getNumSamples() == 0)
+    render(outL, outR, 1, numSamples);
+}
+
+void SampleVoice::renderToLane(float* laneL, float* laneR, int stride, int numSamples)
+{
+    render(laneL, laneR, stride, numSamples);
+}
+
+void SampleVoice::render(float* outL, float* outR, int stride, int numSamples)
+{
+    if (getCurrentlyPlayingSound() != nullptr)
+    {
+        if (streams[SampleSound::closeMic].numFrames == 0)
         {
             DBG("SampleVoice: WARNING - Audio data is empty!");
             clearCurrentNote();
             return;
         }
 
-        const float* const inL = data.getReadPointer(0);
-        const float* const inR = data.getNumChannels() > 1 ? data.getReadPointer(1) : nullptr;
-
-        float* outL = outputBuffer.getWritePointer(0, startSample);
-        float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer(1, startSample) : nullptr;
+        // Only the mics that can be heard are read. With all of them muted the close
+        // mic is still read, silently, so the note keeps its place.
+        int micsToRead[SampleSound::numMics];
+        float micGains[SampleSound::numMics];
+        int numMicsToRead = 0;
 
-        while (--numSamples >= 0)
+        for (int mic = 0; mic < SampleSound::numMics; ++mic)
         {
-            auto pos = (int)sourceSamplePosition;
-            auto alpha = (float)(sourceSamplePosition - pos);
-            auto invAlpha = 1.0f - alpha;
+            const auto gain = getMicGain(mic);
 
-            // Bounds checking
-            if (pos >= data.getNumSamples() - 1)
+            if (gain > 0.0f)
             {
-                stopNote(0.0f, false);
-                break;
+                micsToRead[numMicsToRead] = mic;
+                micGains[numMicsToRead++] = gain;
             }
+        }
 
-            // simple linear interpolation..
-            float l = (inL[pos] * invAlpha + inL[pos + 1] * alpha);
-            float r = (inR != nullptr) ? (inR[pos] * invAlpha + inR[pos + 1] * alpha) : l;
+        if (numMicsToRead == 0)
+        {
+            micsToRead[0] = SampleSound::closeMic;
+            micGains[0] = 0.0f;
+            numMicsToRead = 1;
+        }
 
-            auto envelopeValue = adsr.getNextSample();
+        for (int i = 0; i < numMicsToRead; ++i)
+            if (streams[micsToRead[i]].compressed != nullptr)
+                compressedSamplesRendered.fetch_add(numSamples, std::memory_order_relaxed);
 
-            l *= lgain * envelopeValue;
-            r *= rgain * envelopeValue;
+        auto* dryL = scratch.getWritePointer(0);
+        auto* dryR = scratch.getWritePointer(1);
+        auto* micL = scratch.getWritePointer(2);
+        auto* micR = scratch.getWritePointer(3);
+
+        while (numSamples > 0)
+        {
+            const int numThisTime = juce::jmin(numSamples, renderChunkSize);
+            const auto startPosition = sourceSamplePosition;
 
-            if (outR != nullptr)
+            // The first mic is read straight into the mix, the rest are added to it
+            int numRead = readSource(streams[micsToRead[0]], sourceSamplePosition, dryL, dryR, numThisTime);
+
+            if (micGains[0] != 1.0f)
             {
-                *outL++ += l;
-                *outR++ += r;
+                juce::FloatVectorOperations::multiply(dryL, micGains[0], numRead);
+                juce::FloatVectorOperations::multiply(dryR, micGains[0], numRead);
             }
-            else
+
+            for (int i = 1; i < numMicsToRead; ++i)
             {
-                *outL++ += (l + r) * 0.5f;
+                auto position = startPosition;
+                const int numMicRead = readSource(streams[micsToRead[i]], position, micL, micR, numRead);
+
+                juce::FloatVectorOperations::addWithMultiply(dryL, micL, micGains[i], numMicRead);
+                juce::FloatVectorOperations::addWithMultiply(dryR, micR, micGains[i], numMicRead);
             }
 
-            sourceSamplePosition += pitchRatio;
+            envelope.getNextBlock(envelopeGains, numRead);
+            juce::FloatVectorOperations::multiply(dryL, envelopeGains, numRead);
+            juce::FloatVectorOperations::multiply(dryR, envelopeGains, numRead);
 
-            if (sourceSamplePosition >= data.getNumSamples())
+            for (int i = 0; i < numRead; ++i)
+            {
+                auto l = dryL[i] * lgain;
+                auto r = dryR[i] * rgain;
+
+                if (outR != nullptr)
+                {
+                    *outL += l;
+                    *outR += r;
+                    outR += stride;
+                }
+                else
+                {
+                    *outL += (l + r) * 0.5f;
+                }
+
+                outL += stride;
+            }
+
+            // Reached the end of the sample
+            if (numRead < numThisTime)
             {
                 stopNote(0.0f, false);
                 break;
             }
+
+            // Or the end of the envelope, after which there's nothing to hear
+            if (!envelope.isActive())
+                break;
+
+            numSamples -= numThisTime;
         }
 
-        if (!adsr.isActive())
+        if (!envelope.isActive())
             clearCurrentNote();
+
+        // Keep a few blocks decoded ahead of where the next callback starts
+        if (isVoiceActive())
+            for (int i = 0; i < numMicsToRead; ++i)
+                if (streams[micsToRead[i]].compressed != nullptr)
+                    streams[micsToRead[i]].decodeWindow.decodeAhead((int)sourceSamplePosition);
     }
+}
+
+int SampleVoice::readSource(Stream& stream, double& position, float* destL, float* destR, int numSamples) noexcept
+{
+    int numDone = 0;
+
+    const bool looping = loopEnd > loopStart
+        && (loopMode == SampleSound::LoopMode::continuous || (loopMode == SampleSound::LoopMode::sustain && !released));
+
+    // When looping, reading the sample stops at the last looped frame. From there to
+    // the loop start is read from the sound's loop guard, and the position jumps back.
+    const int endFrame = looping ? loopEnd : stream.numFrames;
+
+    while (numDone < numSamples)
+    {
+        if (looping && position >= (double)loopEnd)
+            position = loopStart + std::fmod(position - loopStart, (double)(loopEnd - loopStart));
+
+        const int numLeft = numSamples - numDone;
+        int numRead;
+
+        if (looping && position >= (double)(loopEnd - 1))
+        {
+            jassert(stream.loopGuard != nullptr && stream.loopGuard->getNumSamples() == 2);
+
+            numRead = interpolatePlanar(stream.loopGuard->getReadPointer(0),
+                stream.loopGuard->getNumChannels() > 1 ? stream.loopGuard->getReadPointer(1) : nullptr,
+                { loopEnd - 1, loopEnd + 1 }, position, pitchRatio, destL + numDone, destR + numDone, numLeft);
+        }
+        else if (stream.compressed != nullptr)
+        {
+            // Only the frames in the decode window can be read directly
+            auto firstFrame = (int)position;
+            auto lastFrame = juce::jmin(endFrame - 1, (int)(position + numLeft * pitchRatio) + 1);
+            auto span = stream.decodeWindow.ensureResident(firstFrame, lastFrame);
+
+            numRead = interpolatePlanar(stream.decodeWindow.getReadPointer(0),
+                stream.compressed->getNumChannels() > 1 ? stream.decodeWindow.getReadPointer(1) : nullptr,
+                span.withEnd(juce::jmin(span.getEnd(), endFrame)), position, pitchRatio, destL + numDone, destR + numDone, numLeft);
+        }
+        else if (stream.interleaved != nullptr)
+        {
+            numRead = interpolateInterleaved(stream.interleaved, endFrame,
+                position, pitchRatio, destL + numDone, destR + numDone, numLeft);
+        }
+        else
+        {
+            numRead = interpolatePlanar(stream.data->getReadPointer(0),
+                stream.data->getNumChannels() > 1 ? stream.data->getReadPointer(1) : nullptr,
+                { 0, endFrame }, position, pitchRatio, destL + numDone, destR + numDone, numLeft);
+        }
+
+        // Nothing more is readable, so this is the end of the sample
+        if (numRead == 0 && !(looping && position >= (double)loopEnd))
+            break;
+
+        numDone += numRead;
+    }
+
+    return numDone;
 }
\ No newline at end of file
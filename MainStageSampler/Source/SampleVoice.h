@@ -12,6 +12,7 @@
 
 #include <JuceHeader.h>
 #include "SampleSound.h"
+#include "RegionCostTable.h"
 
 //==============================================================================
 /**
@@ -50,16 +51,132 @@ public:
     /** Renders the next block of audio data. */
     void renderNextBlock(juce::AudioBuffer<float>&, int startSample, int numSamples) override;
 
+    //==============================================================================
+    /** Adjustments from the front panel that apply on top of each sound's own settings */
+    struct PlayControls
+    {
+        float extraAttack = 0.0f;     // seconds added to the sound's attack
+        float releaseScale = 1.0f;    // scale on the sound's release time
+        float tuningCents = 0.0f;
+
+        /** Level of each mic of multi-mic sounds, indexed by SampleSound::Mic. Mics at 0 aren't read at all. */
+        float micGains[SampleSound::numMics] = { 1.0f, 1.0f, 1.0f };
+    };
+
+    /** Applies new play controls, to the note playing now as well as those to come. */
+    void setPlayControls(const PlayControls& newControls) noexcept;
+
+    //==============================================================================
+    /** Renders the voice ahead of its filter into a lane of the synth's VoiceFilterBank.
+        The output is added to the channels, whose frames are stride floats apart.
+    */
+    void renderToLane(float* laneL, float* laneR, int stride, int numSamples);
+
+    /** Returns true if the current note needs the per-voice filter. */
+    bool usesFilter() const noexcept { return filter.type != SampleSound::FilterType::none; }
+
+    /** Returns the filter settings of the current note. */
+    const SampleSound::FilterSettings& getFilterSettings() const noexcept { return filter; }
+
+    /** Returns the current note's cutoff after velocity tracking, in Hz. */
+    float getNoteCutoff() const noexcept { return noteCutoff; }
+
+    /** Returns true once after each new note, when the filter should start from silence. */
+    bool takeFilterRestart() noexcept { return std::exchange(filterRestart, false); }
+
+    //==============================================================================
+    /** Makes room to decode one mic's compressed samples into. Call before any sound
+        with that mic compressed can reach the voice; it allocates, so not from the
+        audio thread.
+    */
+    void allocateDecodeWindow(int mic);
+
+    /** Returns the time this voice has spent decoding compressed samples, in high resolution ticks. */
+    juce::int64 getDecodeTicks() const noexcept;
+
+    /** Returns the number of samples this voice has read from compressed streams, one per mic per output sample. */
+    juce::int64 getCompressedSamplesRendered() const noexcept { return compressedSamplesRendered.load(std::memory_order_relaxed); }
+
+    /** Returns the RegionCostTable key of the sound playing, or -1 in builds that don't count region costs */
+    juce::int64 getRegionCostKey() const noexcept
+    {
+       #if SAMPLER_REGION_COST_ATTRIBUTION
+        return regionCostKey;
+       #else
+        return -1;
+       #endif
+    }
+
     using Ptr = juce::ReferenceCountedObjectPtr<SampleVoice>;
 
 private:
     //==============================================================================
-    double pitchRatio = 0;
-    double sourceSamplePosition = 0;
+    /** One mic's recording of the current note, at the level the note reads from */
+    struct Stream
+    {
+        const juce::AudioBuffer<float>* data = nullptr;
+        const float* interleaved = nullptr;
+        const CompressedSampleData* compressed = nullptr;
+        const juce::AudioBuffer<float>* loopGuard = nullptr;
+        int numFrames = 0;
+
+        // Decoded blocks of the stream when it's held compressed
+        CompressedSampleData::DecodeWindow decodeWindow;
+    };
+
+    /** Interpolates up to numSamples frames of a stream into the scratch channels,
+        starting at position and moving it along, and returns how many were produced.
+        Fewer means the sample ended.
+    */
+    int readSource(Stream& stream, double& position, float* destL, float* destR, int numSamples) noexcept;
+
+    /** Returns the level a mic plays at for the current note, 0 if it isn't read. */
+    float getMicGain(int mic) const noexcept;
+
+    /** Adds the voice to outL/outR, or a mono mix of it to outL if outR is null.
+        Consecutive frames are stride floats apart.
+    */
+    void render(float* outL, float* outR, int stride, int numSamples);
+
+    static constexpr int renderChunkSize = 256;
+
+    /** Sets the envelope from the sound's and the play controls. */
+    void updateEnvelopeTimes() noexcept;
+
+    double pitchRatio = 0;             // source frames per output sample, within the level being read
+    double notePitchRatio = 0;         // the same before the tuning control
+    double sourceSamplePosition = 0;   // in frames of the level being read
+
+    // Every mic of the level this note reads from, see SampleSound::chooseLevel().
+    // They all share sourceSamplePosition.
+    Stream streams[SampleSound::numMics];
+    bool multiMic = false;
+
+    // Loop points within that level, see SampleSound::setLoop()
+    SampleSound::LoopMode loopMode = SampleSound::LoopMode::none;
+    int loopStart = 0, loopEnd = 0;
+    bool released = false;
     float lgain = 0, rgain = 0;
 
-    juce::ADSR adsr;
-    juce::ADSR::Parameters adsrParams;
+    // The filter for the current note, run by the synth's VoiceFilterBank
+    SampleSound::FilterSettings filter;
+    float noteCutoff = 20000.0f;
+    bool filterRestart = false;
+
+   #if SAMPLER_REGION_COST_ATTRIBUTION
+    juce::int64 regionCostKey = -1;
+   #endif
+
+    // The mix of the mics, then the mic being added to it
+    juce::AudioBuffer<float> scratch { 4, renderChunkSize };
+
+    // The sound's own envelope, and the one playing with the play controls applied
+    AmpEnvelope::Parameters soundEnvelope;
+    AmpEnvelope envelope;
+    float envelopeGains[renderChunkSize] = {};
+    PlayControls playControls;
+
+    std::atomic<juce::int64> compressedSamplesRendered { 0 };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleVoice)
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    SamplerAudioCallback.cpp
+    Created: The app's audio device callback, apart from its window
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "SamplerAudioCallback.h"
+#include "RealtimeSafety.h"
+
+//==============================================================================
+SamplerAudioCallback::SamplerAudioCallback(SamplerEngine& engineToPlay, NoteInput& noteInputToUse, CallbackLoadMonitor& loadMonitorToUse)
+    : engine(engineToPlay), noteInput(noteInputToUse), loadMonitor(loadMonitorToUse)
+{
+}
+
+SamplerAudioCallback::~SamplerAudioCallback()
+{
+}
+
+//==============================================================================
+void SamplerAudioCallback::audioDeviceIOCallbackWithContext(const float* const* /*inputChannelData*/,
+    int /*numInputChannels*/,
+    float* const* outputChannelData,
+    int numOutputChannels,
+    int numSamples,
+    const juce::AudioIODeviceCallbackContext& /*context*/)
+{
+    const auto callbackStart = CallbackLoadMonitor::beginCallback();
+    RealtimeSafety::ScopedRealtimeContext realtimeContext("audio");
+
+    // Clear output buffers
+    for (int channel = 0; channel < numOutputChannels; ++channel)
+    {
+        if (outputChannelData[channel] != nullptr)
+            juce::FloatVectorOperations::clear(outputChannelData[channel], numSamples);
+    }
+
+    // Create audio buffer
+    juce::AudioBuffer<float> buffer(outputChannelData, numOutputChannels, numSamples);
+
+    // Reuses the storage reserved when the device started
+    midiBuffer.clear();
+    noteInput.getNextBlock(midiBuffer, numSamples);
+
+    // Process through sampler, which applies the master volume
+    engine.renderNextBlock(buffer, midiBuffer, 0, numSamples);
+
+    loadMonitor.endCallback(callbackStart, numSamples, engine.getNumActiveVoices());
+}
+
+void SamplerAudioCallback::audioDeviceAboutToStart(juce::AudioIODevice* device)
+{
+    auto sampleRate = device->getCurrentSampleRate();
+    auto bufferSize = device->getCurrentBufferSizeSamples();
+
+    // Room for far more events than a block can bring, so the callback never has to grow it
+    midiBuffer.ensureSize(midiBufferBytes);
+
+    engine.prepareToPlay(sampleRate, bufferSize);
+    loadMonitor.prepare(sampleRate);
+    noteInput.prepare(sampleRate);
+
+    if (onDeviceStateChanged != nullptr)
+        onDeviceStateChanged();
+}
+
+void SamplerAudioCallback::audioDeviceStopped()
+{
+    noteInput.reset();
+    engine.releaseResources();
+
+    if (onDeviceStateChanged != nullptr)
+        onDeviceStateChanged();
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    SamplerAudioCallback.h
+    Created: The app's audio device callback, apart from its window
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SamplerEngine.h"
+#include "NoteInput.h"
+#include "CallbackLoadMonitor.h"
+
+//==============================================================================
+/**
+    Plays the engine from an audio device: each callback takes what NoteInput
+    has gathered, renders a block and times it with the load monitor.
+
+    MainComponent hands this to its AudioDeviceManager. Being no part of the
+    window, it can be handed to any other device manager too, so tools can run
+    the app's own callback without a display.
+*/
+class SamplerAudioCallback : public juce::AudioIODeviceCallback
+{
+public:
+    //==============================================================================
+    SamplerAudioCallback(SamplerEngine& engineToPlay, NoteInput& noteInputToUse, CallbackLoadMonitor& loadMonitorToUse);
+    ~SamplerAudioCallback() override;
+
+    /** Called after the device starts or stops, on whichever thread started or stopped it */
+    std::function<void()> onDeviceStateChanged;
+
+    //==============================================================================
+    void audioDeviceIOCallbackWithContext(const float* const* inputChannelData,
+        int numInputChannels,
+        float* const* outputChannelData,
+        int numOutputChannels,
+        int numSamples,
+        const juce::AudioIODeviceCallbackContext& context) override;
+
+    void audioDeviceAboutToStart(juce::AudioIODevice* device) override;
+    void audioDeviceStopped() override;
+
+private:
+    //==============================================================================
+    SamplerEngine& engine;
+    NoteInput& noteInput;
+    CallbackLoadMonitor& loadMonitor;
+
+    static constexpr size_t midiBufferBytes = 16384;
+    juce::MidiBuffer midiBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SamplerAudioCallback)
+};
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "SampleVoice.h"
 #include "SampleSound.h"
 #include "EnhancedSFZLoader.h"
+#include "RealtimeSafety.h"
 
 SamplerEngine::SamplerEngine()
 {
@@ -14,9 +15,30 @@ SamplerEngine::~SamplerEngine()
 {
 }
 
-void SamplerEngine::prepareToPlay(double sampleRate, int /*samplesPerBlock*/)
+void SamplerEngine::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    synth.setCurrentPlaybackSampleRate(sampleRate);
+    parameters.prepare(sampleRate);
+
+    // So the effects start at the stored settings rather than ramping to them
+    applyEffectParameters();
+
+    synth.prepare(sampleRate);
+    stringResonance.prepare(sampleRate, samplesPerBlock);
+    stereoWidth.prepare(sampleRate, samplesPerBlock);
+    chorus.prepare(sampleRate, samplesPerBlock);
+    reverb.prepare(sampleRate, samplesPerBlock);
+    algorithmicReverb.prepare(sampleRate, samplesPerBlock);
+    masterEQ.prepare(sampleRate, samplesPerBlock);
+    limiter.prepare(sampleRate, samplesPerBlock);
+
+    // The device may start a new audio thread, so find out which on its first block
+    audioThreadKnown = false;
+}
+
+void SamplerEngine::releaseResources()
+{
+    const juce::ScopedLock sl(audioThreadLock);
+    audioThreadId.store(nullptr);
 }
 
 void SamplerEngine::renderNextBlock(juce::AudioBuffer<float>& buffer,
@@ -24,79 +46,130 @@ void SamplerEngine::renderNextBlock(juce::AudioBuffer<float>& buffer,
     int startSample,
     int numSamples)
 {
-    // Debug MIDI messages (only when they occur)
-    if (!midiMessages.isEmpty())
+    RealtimeSafety::ScopedRealtimeContext realtimeContext("audio");
+
+    // The scheduling request and any error message are left to updateAudioThreadPriority()
+    if (!audioThreadKnown)
     {
-        DBG("=== MIDI EVENT ===");
-        DBG("Events: " + juce::String(midiMessages.getNumEvents()));
-        DBG("Sounds loaded: " + juce::String(synth.getNumSounds()));
+        audioThreadKnown = true;
+        audioThreadId.store(juce::Thread::getCurrentThreadId());
+        audioThreadChanged.store(true);
+    }
 
-        for (const auto metadata : midiMessages)
-        {
-            auto message = metadata.getMessage();
-            if (message.isNoteOn())
-            {
-                int note = message.getNoteNumber();
-                int velocity = message.getVelocity();
+    parameters.beginBlock(numSamples);
 
-                DBG("Note ON: " + juce::String(note) + " velocity " + juce::String(velocity));
+    if (parameters.hasChanged(ParameterStore::attack) || parameters.hasChanged(ParameterStore::release)
+        || parameters.hasChanged(ParameterStore::tuning) || parameters.hasChanged(ParameterStore::closeMic)
+        || parameters.hasChanged(ParameterStore::overheadMic) || parameters.hasChanged(ParameterStore::roomMic))
+    {
+        SampleVoice::PlayControls controls;
+        controls.extraAttack = parameters.getBlockEnd(ParameterStore::attack);
+        controls.releaseScale = parameters.getBlockEnd(ParameterStore::release);
+        controls.tuningCents = parameters.getBlockEnd(ParameterStore::tuning);
+        controls.micGains[SampleSound::closeMic] = parameters.getBlockEnd(ParameterStore::closeMic);
+        controls.micGains[SampleSound::overheadMic] = parameters.getBlockEnd(ParameterStore::overheadMic);
+        controls.micGains[SampleSound::roomMic] = parameters.getBlockEnd(ParameterStore::roomMic);
+        synth.setPlayControls(controls);
+    }
 
-                // Check which sounds should respond
-                bool foundResponder = false;
-                for (int i = 0; i < synth.getNumSounds(); ++i)
-                {
-                    if (auto* sound = dynamic_cast<SampleSound*>(synth.getSound(i).get()))
-                    {
-                        bool appliesToNote = sound->appliesToNote(note);
-                        bool appliesToVel = sound->appliesToVelocity(velocity);
-
-                        if (appliesToNote && appliesToVel)
-                        {
-                            DBG("  -> Sound " + juce::String(i) + " (" + sound->getName() + ") should respond");
-                            foundResponder = true;
-                        }
-                    }
-                }
+    applyEffectParameters();
 
-                if (!foundResponder)
-                {
-                    DBG("  -> *** NO SOUNDS RESPOND TO THIS NOTE! ***");
-
-                    // Show what notes ARE covered
-                    DBG("  -> Available note ranges:");
-                    for (int i = 0; i < juce::jmin(5, synth.getNumSounds()); ++i)
-                    {
-                        if (auto* sound = dynamic_cast<SampleSound*>(synth.getSound(i).get()))
-                        {
-                            // Find the note range for this sound
-                            int lowestNote = -1, highestNote = -1;
-                            for (int n = 0; n <= 127; ++n)
-                            {
-                                if (sound->appliesToNote(n))
-                                {
-                                    if (lowestNote == -1) lowestNote = n;
-                                    highestNote = n;
-                                }
-                            }
-
-                            if (lowestNote != -1)
-                            {
-                                DBG("    Sound " + juce::String(i) + ": notes " +
-                                    juce::String(lowestNote) + "-" + juce::String(highestNote) +
-                                    " vel " + juce::String(sound->getVelocityRange().getStart()) +
-                                    "-" + juce::String(sound->getVelocityRange().getEnd()));
-                            }
-                        }
-                    }
-                }
-            }
-        }
+    stringResonance.processMidi(midiMessages);
+
+    {
+        // The message thread only holds the synth's lock while it swaps voices or sounds. The synth
+        // takes it again inside, which the checks then only report if it had to wait.
+        RealtimeSafety::ScopedTryLock synthLock(synth.getLock());
+        synth.renderNextBlock(buffer, midiMessages, startSample, numSamples);
     }
 
-    synth.renderNextBlock(buffer, midiMessages, startSample, numSamples);
+    stringResonance.process(buffer, startSample, numSamples);
+    stereoWidth.process(buffer, startSample, numSamples);
+    chorus.process(buffer, startSample, numSamples);
 
-    // Apply master volume
-    buffer.applyGain(0, numSamples, masterVolume);
+    // Only one reverb runs at a time. The convolution one starts clean from the kernel
+    // built by setReverbRoom(), the algorithmic one is cleared when it takes over.
+    if (useAlgorithmicReverb.load())
+    {
+        if (!algorithmicReverbActive)
+            algorithmicReverb.reset();
+
+        algorithmicReverbActive = true;
+        algorithmicReverb.process(buffer, startSample, numSamples);
+    }
+    else
+    {
+        algorithmicReverbActive = false;
+        reverb.process(buffer, startSample, numSamples);
+    }
+
+    masterEQ.process(buffer, startSample, numSamples);
+
+    applyMasterGain(buffer, startSample, numSamples);
+
+    // Last, so nothing after it can push the output over the ceiling
+    limiter.process(buffer, startSample, numSamples);
+}
+
+void SamplerEngine::applyMasterGain(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    // Balance rather than a pan law: the far side is turned down and the near side left alone
+    auto channelGain = [](float volume, float pan, int channel)
+    {
+        return volume * juce::jmin(1.0f, channel == 0 ? 1.0f - pan : 1.0f + pan);
+    };
+
+    const auto startVolume = parameters.getBlockStart(ParameterStore::volume);
+    const auto endVolume = parameters.getBlockEnd(ParameterStore::volume);
+    const auto startPan = parameters.getBlockStart(ParameterStore::pan);
+    const auto endPan = parameters.getBlockEnd(ParameterStore::pan);
+    const bool stereo = buffer.getNumChannels() > 1;
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        // A mono output has nothing to balance
+        const auto startGain = stereo ? channelGain(startVolume, startPan, channel) : startVolume;
+        const auto endGain = stereo ? channelGain(endVolume, endPan, channel) : endVolume;
+
+        if (startGain == endGain)
+            buffer.applyGain(channel, startSample, numSamples, endGain);
+        else
+            buffer.applyGainRamp(channel, startSample, numSamples, startGain, endGain);
+    }
+}
+
+void SamplerEngine::updateAudioThreadPriority()
+{
+    const auto priority = audioThreadPriority.load();
+
+    if (priority <= 0 || !audioThreadChanged.exchange(false))
+        return;
+
+    juce::String error;
+
+    {
+        const juce::ScopedLock sl(audioThreadLock);
+        const auto thread = audioThreadId.load();
+
+        if (thread == nullptr || RealtimeThread::requestRealtimeScheduling(thread, priority, error))
+            return;
+    }
+
+    juce::Logger::writeToLog("Audio thread: " + error);
+}
+
+void SamplerEngine::applyEffectParameters() noexcept
+{
+    stringResonance.setAmount(parameters.getBlockEnd(ParameterStore::resonance));
+    stereoWidth.setWidth(parameters.getBlockEnd(ParameterStore::width));
+    chorus.setAmount(parameters.getBlockEnd(ParameterStore::chorusAmount));
+
+    // Both reverbs follow the level, so switching between them doesn't jump
+    reverb.setWetLevel(parameters.getBlockEnd(ParameterStore::reverbAmount));
+    algorithmicReverb.setWetLevel(parameters.getBlockEnd(ParameterStore::reverbAmount));
+
+    for (int band = 0; band < MasterEQ::numBands; ++band)
+        masterEQ.setBandGain((MasterEQ::Band)band, parameters.getBlockEnd((ParameterStore::ID)(ParameterStore::eqLow + band)));
 }
 
 void SamplerEngine::loadSampleSet(const juce::File& sfzFile)
@@ -104,16 +177,24 @@ void SamplerEngine::loadSampleSet(const juce::File& sfzFile)
     DBG("=== SAMPLER ENGINE LOADING ===");
     DBG("Loading SFZ: " + sfzFile.getFileName());
 
-    // Clear existing sounds
+    // Clear existing sounds, unlocking their memory first as it's about to be freed
+    residency.unlockAll();
     synth.clearSounds();
     DBG("Cleared existing sounds");
 
     // Load the SFZ file with enhanced parser
     EnhancedSFZLoader loader;
+    loader.setLoadOptions(loadOptions);
     auto sounds = loader.loadSFZ(sfzFile);
 
     DBG("Loader returned " + juce::String(sounds.size()) + " sounds");
 
+    // Before the sounds can play, so none of them go uncounted
+    synth.getRegionCosts().assign(sounds);
+
+    // Likewise, so no voice starts a compressed sound with nowhere to decode it
+    allocateDecodeWindows(sounds);
+
     // Add sounds to the synthesiser
     for (auto sound : sounds)
     {
@@ -123,9 +204,150 @@ void SamplerEngine::loadSampleSet(const juce::File& sfzFile)
     DBG("Added sounds to synthesizer");
     debugLoadedSounds();
 
+    // Bring every page in now, rather than on the first note that needs it
+    SampleMemoryResidency::Report report;
+
+    if (residencyOptions.prefault || residencyOptions.lockMemory)
+    {
+        int lastPercent = -1;
+
+        report = residency.makeResident(sounds, residencyOptions, [this, &lastPercent](double progress)
+            {
+                auto percent = 10 * (int)(progress * 10.0);
+                if (percent != lastPercent && onLoadStatus != nullptr)
+                {
+                    lastPercent = percent;
+                    onLoadStatus("Preparing sample memory " + juce::String(percent) + "%");
+                }
+            });
+
+        juce::Logger::writeToLog(report.toString());
+
+        if (report.numLockFailures > 0 && onLoadStatus != nullptr)
+            onLoadStatus("Could not lock all sample memory: " + report.lockError);
+    }
+
+    {
+        const juce::ScopedLock sl(residencyReportLock);
+        residencyReport = report;
+        loadProfile = loader.getLoadProfile();
+    }
+
     juce::Logger::writeToLog("Enhanced SFZ Loader: Loaded " + juce::String(sounds.size()) + " samples from " + sfzFile.getFileName());
 }
 
+SampleMemoryResidency::Report SamplerEngine::getResidencyReport() const
+{
+    const juce::ScopedLock sl(residencyReportLock);
+    return residencyReport;
+}
+
+LoadProfile SamplerEngine::getLoadProfile() const
+{
+    const juce::ScopedLock sl(residencyReportLock);
+    return loadProfile;
+}
+
+SamplerEngine::SampleMemoryStats SamplerEngine::getSampleMemoryStats() const
+{
+    SampleMemoryStats stats;
+
+    for (int i = 0; i < synth.getNumSounds(); ++i)
+    {
+        if (auto* sound = dynamic_cast<SampleSound*>(synth.getSound(i).get()))
+        {
+            stats.storedBytes += sound->getMemoryUsageBytes();
+            stats.uncompressedBytes += sound->getUncompressedSizeBytes();
+        }
+    }
+
+    return stats;
+}
+
+double SamplerEngine::getDecodeCostPerVoice() const
+{
+    juce::int64 decodeTicks = 0, samplesRendered = 0;
+
+    for (int i = 0; i < synth.getNumVoices(); ++i)
+    {
+        if (auto* voice = dynamic_cast<SampleVoice*>(synth.getVoice(i)))
+        {
+            decodeTicks += voice->getDecodeTicks();
+            samplesRendered += voice->getCompressedSamplesRendered();
+        }
+    }
+
+    if (samplesRendered == 0 || synth.getSampleRate() <= 0.0)
+        return 0.0;
+
+    auto decodeSeconds = juce::Time::highResolutionTicksToSeconds(decodeTicks);
+    auto voiceSeconds = (double)samplesRendered / synth.getSampleRate();
+    return decodeSeconds / voiceSeconds;
+}
+
+int SamplerEngine::getNumActiveVoices() const
+{
+    int numActive = 0;
+
+    for (int i = 0; i < synth.getNumVoices(); ++i)
+        if (synth.getVoice(i)->isVoiceActive())
+            ++numActive;
+
+    return numActive;
+}
+
+void SamplerEngine::setNumVoices(int newNumVoices)
+{
+    numVoices = juce::jmax(1, newNumVoices);
+
+    while (synth.getNumVoices() > numVoices)
+        synth.removeVoice(synth.getNumVoices() - 1);
+
+    // New voices get the play controls on the first block after prepareToPlay()
+    while (synth.getNumVoices() < numVoices)
+    {
+        auto* voice = new SampleVoice();
+
+        for (int mic = 0; mic < SampleSound::numMics; ++mic)
+            if (micDecodeWindowsAllocated[mic])
+                voice->allocateDecodeWindow(mic);
+
+        synth.addVoice(voice);
+    }
+
+    synth.updateFilterBank();
+}
+
+void SamplerEngine::allocateDecodeWindows(const juce::Array<SampleSound::Ptr>& sounds)
+{
+    // A window is only made for a mic some sound holds compressed, so a single-mic library
+    // doesn't carry windows for the overhead and room mics. Once made they're kept, as a
+    // voice still sounding from the last library may be decoding into one.
+    for (int mic = 0; mic < SampleSound::numMics; ++mic)
+    {
+        if (micDecodeWindowsAllocated[mic])
+            continue;
+
+        for (auto& sound : sounds)
+        {
+            auto* micSound = sound->getMicStream(mic);
+
+            if (micSound != nullptr && micSound->getCompressedData() != nullptr)
+            {
+                micDecodeWindowsAllocated[mic] = true;
+                break;
+            }
+        }
+
+        if (!micDecodeWindowsAllocated[mic])
+            continue;
+
+        for (int i = 0; i < synth.getNumVoices(); ++i)
+            if (auto* voice = dynamic_cast<SampleVoice*>(synth.getVoice(i)))
+                voice->allocateDecodeWindow(mic);
+    }
+}
+
 void SamplerEngine::debugLoadedSounds()
 {
     DBG("=== SYNTHESIZER SOUNDS DEBUG ===");
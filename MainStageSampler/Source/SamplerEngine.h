@@ -1,6 +1,17 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "EnhancedSFZLoader.h"
+#include "RealtimeSupport.h"
+#include "ConvolutionReverb.h"
+#include "FDNReverb.h"
+#include "SamplerSynthesiser.h"
+#include "SympatheticResonance.h"
+#include "MasterEQ.h"
+#include "StereoChorus.h"
+#include "StereoWidth.h"
+#include "ParameterStore.h"
+#include "MasterLimiter.h"
 
 class SamplerEngine {
 public:
@@ -8,15 +19,155 @@ public:
     ~SamplerEngine();
 
     void prepareToPlay(double sampleRate, int samplesPerBlock);
+
+    /** Call once the audio callback has stopped, so nothing is asked of a thread that may be gone */
+    void releaseResources();
     void renderNextBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&, int startSample, int numSamples);
 
     void loadSampleSet(const juce::File& sfzFile);
 
+    /** Sets how sample data is held in memory by subsequent loads */
+    void setLoadOptions(const EnhancedSFZLoader::LoadOptions& newOptions) { loadOptions = newOptions; }
+
+    /** Sets how sample memory is prefaulted and locked after each load */
+    void setResidencyOptions(const SampleMemoryResidency::Options& newOptions) { residencyOptions = newOptions; }
+
+    /** Returns what the prefault/lock stage did for the last load */
+    SampleMemoryResidency::Report getResidencyReport() const;
+
+    /** Returns where the time and memory of the last load went, phase by phase */
+    LoadProfile getLoadProfile() const;
+
+    /** Sets the SCHED_FIFO priority for the audio thread, which updateAudioThreadPriority()
+        then asks for. 0 leaves the thread alone.
+    */
+    void setAudioThreadRealtimePriority(int priority)
+    {
+        audioThreadPriority.store(priority);
+        audioThreadChanged.store(true);
+
+        // The reverb's tail worker runs just below the audio thread
+        reverb.setWorkerRealtimePriority(juce::jmax(0, priority - 1));
+    }
+
+    /** Asks for the audio thread's priority if the thread or the priority has changed
+        since the last call, and logs a refusal. The audio thread only says which thread
+        it is, so call this regularly from anywhere else, such as a UI timer.
+    */
+    void updateAudioThreadPriority();
+
+    /** Returns the performance parameters, including the effect levels and EQ gains.
+        The interface writes them, the engine reads them once per block.
+    */
+    ParameterStore& getParameters() noexcept { return parameters; }
+
+    /** Switches to the convolution reverb with a generated room. Builds the impulse response on the calling thread. */
+    void setReverbRoom(ConvolutionReverb::RoomType type, float size)
+    {
+        reverb.setRoom(type, size);
+        useAlgorithmicReverb.store(false);
+    }
+
+    /** Switches to the light algorithmic reverb. Cheap enough to call while a control is being dragged. */
+    void setAlgorithmicReverbRoom(FDNReverb::RoomType type, float size)
+    {
+        algorithmicReverb.setRoom(type, size);
+        useAlgorithmicReverb.store(true);
+    }
+
+    /** Sets the master limiter's lookahead in milliseconds. Takes effect at the next prepareToPlay(). */
+    void setLimiterLookahead(double milliseconds) { limiter.setLookahead(milliseconds); }
+
+    /** Set when rendering offline, so the background work is done in line and every render comes out the same */
+    void setNonRealtime(bool isNonRealtime) noexcept { reverb.setNonRealtime(isNonRealtime); }
+
+    /** Returns the number of voices playing. Call from the audio thread, or while it isn't running. */
+    int getNumActiveVoices() const;
+
+    /** Sets how many notes can sound at once. Call while the audio thread isn't running, before prepareToPlay(). */
+    void setNumVoices(int newNumVoices);
+
+    /** Returns how many notes can sound at once */
+    int getNumVoices() const noexcept { return numVoices; }
+
+    /** Returns how many notes have cut off a playing voice for want of a free one since prepareToPlay() */
+    juce::int64 getNumVoicesStolen() const noexcept { return synth.getNumVoicesStolen(); }
+
+    /** Returns how far the engine's output lags its input, in samples */
+    int getLatencySamples() const noexcept { return limiter.getLatencySamples(); }
+
+    /** Returns the master limiter's gain reduction over the last block, in dB (0 or less). Safe to call from any thread. */
+    float getLimiterGainReductionDb() const noexcept { return limiter.getGainReductionDb(); }
+
+    /** Loads a reverb impulse response from an audio file */
+    bool loadReverbImpulse(const juce::File& file) { return reverb.loadImpulseResponse(file); }
+
+    /** Called on the loading thread with progress and problems while a load runs */
+    std::function<void(const juce::String& status)> onLoadStatus;
+
+    struct SampleMemoryStats
+    {
+        size_t storedBytes = 0;       // what the loaded samples occupy in RAM
+        size_t uncompressedBytes = 0; // what they'd occupy as float audio
+    };
+
+    /** Returns the memory used by the currently loaded samples */
+    SampleMemoryStats getSampleMemoryStats() const;
+
+    /** Returns the share of one CPU core spent decoding compressed samples,
+        per voice playing a compressed sample (0.01 = 1% of a core per voice) */
+    double getDecodeCostPerVoice() const;
+
+    /** Returns what voices cost with and without their filter, as a share of one CPU core per voice.
+        Zero unless the build has SAMPLER_VOICE_COST_TIMING set.
+    */
+    SamplerSynthesiser::VoiceCost getVoiceCost() const { return synth.getVoiceCost(); }
+
+    /** Returns what each region has cost to play since the load or the last resetRegionCosts(),
+        most expensive first. Empty unless the build has SAMPLER_REGION_COST_ATTRIBUTION set.
+    */
+    RegionCostTable::Snapshot getRegionCosts() const { return synth.getRegionCosts().getSnapshot(synth.getSampleRate()); }
+
+    /** Starts the region costs again from zero. Safe to call while playing. */
+    void resetRegionCosts() noexcept { synth.getRegionCosts().reset(); }
+
     // Debug method
     void debugLoadedSounds();
 
 private:
-    juce::Synthesiser synth;
+    /** Applies the master volume and pan, ramped across the block */
+    void applyMasterGain(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    /** Passes the effect levels and EQ gains for the end of the block on to the effects */
+    void applyEffectParameters() noexcept;
+
+    /** Gives every voice room to decode the mics the sounds hold compressed, if it hasn't already */
+    void allocateDecodeWindows(const juce::Array<SampleSound::Ptr>& sounds);
+
+    SamplerSynthesiser synth;
     int numVoices = 16;
-    float masterVolume = 0.8f;
+    bool micDecodeWindowsAllocated[SampleSound::numMics] = {};
+    ParameterStore parameters;
+    EnhancedSFZLoader::LoadOptions loadOptions;
+    SympatheticResonance stringResonance;
+    StereoWidth stereoWidth;
+    StereoChorus chorus;
+    ConvolutionReverb reverb;
+    FDNReverb algorithmicReverb;
+    std::atomic<bool> useAlgorithmicReverb { false };
+    bool algorithmicReverbActive = false;
+    MasterEQ masterEQ;
+    MasterLimiter limiter;
+
+    SampleMemoryResidency residency;
+    SampleMemoryResidency::Options residencyOptions;
+    SampleMemoryResidency::Report residencyReport;
+    LoadProfile loadProfile;
+    juce::CriticalSection residencyReportLock;   // also guards loadProfile
+
+    std::atomic<int> audioThreadPriority { 0 };
+    std::atomic<juce::Thread::ThreadID> audioThreadId { nullptr };
+    std::atomic<bool> audioThreadChanged { false };
+    bool audioThreadKnown = false;            // audio thread only
+    juce::CriticalSection audioThreadLock;    // keeps releaseResources() from racing a request
 };
\ No newline at end of file
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    SamplerSynthesiser.cpp
+    Created: Synthesiser that runs the voice filters as one SIMD bank
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "SamplerSynthesiser.h"
+#include "SampleVoice.h"
+
+namespace
+{
+    constexpr int brightnessController = 74;
+    constexpr float brightnessRangeCents = 2400.0f;   // two octaves either way
+}
+
+SamplerSynthesiser::SamplerSynthesiser()
+{
+    // Split the rendering at every MIDI event, so notes start and stop on the sample they were sent for
+    setMinimumRenderingSubdivisionSize(1, false);
+}
+
+SamplerSynthesiser::~SamplerSynthesiser()
+{
+}
+
+void SamplerSynthesiser::prepare(double sampleRate)
+{
+    setCurrentPlaybackSampleRate(sampleRate);
+    filterBank.prepare(sampleRate, voices.size());
+
+    filteredTicks.store(0);
+    filteredVoiceSamples.store(0);
+    unfilteredTicks.store(0);
+    unfilteredVoiceSamples.store(0);
+    voicesStolen.store(0);
+}
+
+void SamplerSynthesiser::updateFilterBank()
+{
+    const juce::ScopedLock sl(lock);
+
+    // Only ever grown, as preparing the bank clears the filters of the voices already playing
+    if (getSampleRate() > 0.0 && filterBank.getNumLanes() < voices.size())
+        filterBank.prepare(getSampleRate(), voices.size());
+}
+
+void SamplerSynthesiser::handleController(int midiChannel, int controllerNumber, int controllerValue)
+{
+    // 64 is the centre, as with the other GM2 sound controllers
+    if (controllerNumber == brightnessController)
+        brightnessCents.store((float)(controllerValue - 64) / 64.0f * brightnessRangeCents);
+
+    juce::Synthesiser::handleController(midiChannel, controllerNumber, controllerValue);
+}
+
+void SamplerSynthesiser::setPlayControls(const SampleVoice::PlayControls& newControls) noexcept
+{
+    for (auto* voice : voices)
+        if (auto* sampleVoice = dynamic_cast<SampleVoice*>(voice))
+            sampleVoice->setPlayControls(newControls);
+}
+
+juce::SynthesiserVoice* SamplerSynthesiser::findVoiceToSteal(juce::SynthesiserSound* soundToPlay, int midiChannel,
+    int midiNoteNumber) const
+{
+    // Only called once every voice is busy, so anything returned is cut off
+    auto* voice = juce::Synthesiser::findVoiceToSteal(soundToPlay, midiChannel, midiNoteNumber);
+
+    if (voice != nullptr)
+        voicesStolen.fetch_add(1, std::memory_order_relaxed);
+
+    return voice;
+}
+
+//==============================================================================
+void SamplerSynthesiser::renderVoices(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+{
+    // Every voice needs a lane, see updateFilterBank()
+    jassert(voices.size() <= filterBank.getNumLanes());
+
+    const auto brightness = std::pow(2.0f, brightnessCents.load() / 1200.0f);
+
+    for (int done = 0; done < numSamples;)
+    {
+        const int numThisTime = juce::jmin(numSamples - done, VoiceFilterBank::chunkSize);
+
+       #if SAMPLER_VOICE_COST_TIMING
+        juce::int64 ticksFiltered = 0, ticksUnfiltered = 0;
+        int numFiltered = 0, numUnfiltered = 0;
+       #endif
+
+        for (int i = 0; i < voices.size(); ++i)
+        {
+            auto* voice = voices.getUnchecked(i);
+
+            if (!voice->isVoiceActive())
+                continue;
+
+           #if SAMPLER_VOICE_COST_TIMING
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+           #endif
+
+            auto* sampleVoice = dynamic_cast<SampleVoice*>(voice);
+
+            // Nothing at all unless the build counts region costs
+            RegionCostTable::ScopedVoiceRender regionCost(regionCosts,
+                sampleVoice != nullptr ? sampleVoice->getRegionCostKey() : -1, numThisTime);
+
+            if (sampleVoice != nullptr && sampleVoice->usesFilter() && i < filterBank.getNumLanes())
+            {
+                const auto& settings = sampleVoice->getFilterSettings();
+                filterBank.setLaneTarget(i, settings.type, sampleVoice->getNoteCutoff() * brightness,
+                    settings.resonance, sampleVoice->takeFilterRestart());
+
+                float* laneL;
+                float* laneR;
+                filterBank.beginLane(i, numThisTime, laneL, laneR);
+                sampleVoice->renderToLane(laneL, laneR, filterBank.getLaneStride(), numThisTime);
+
+               #if SAMPLER_VOICE_COST_TIMING
+                ticksFiltered += juce::Time::getHighResolutionTicks() - startTicks;
+                ++numFiltered;
+               #endif
+            }
+            else
+            {
+                voice->renderNextBlock(outputAudio, startSample + done, numThisTime);
+
+               #if SAMPLER_VOICE_COST_TIMING
+                ticksUnfiltered += juce::Time::getHighResolutionTicks() - startTicks;
+                ++numUnfiltered;
+               #endif
+            }
+        }
+
+       #if SAMPLER_VOICE_COST_TIMING
+        const auto bankTicks = juce::Time::getHighResolutionTicks();
+        filterBank.process(outputAudio, startSample + done, numThisTime);
+        ticksFiltered += juce::Time::getHighResolutionTicks() - bankTicks;
+
+        filteredTicks.fetch_add(ticksFiltered, std::memory_order_relaxed);
+        filteredVoiceSamples.fetch_add((juce::int64)numFiltered * numThisTime, std::memory_order_relaxed);
+        unfilteredTicks.fetch_add(ticksUnfiltered, std::memory_order_relaxed);
+        unfilteredVoiceSamples.fetch_add((juce::int64)numUnfiltered * numThisTime, std::memory_order_relaxed);
+       #else
+        filterBank.process(outputAudio, startSample + done, numThisTime);
+       #endif
+
+        done += numThisTime;
+    }
+}
+
+SamplerSynthesiser::VoiceCost SamplerSynthesiser::getVoiceCost() const
+{
+    VoiceCost cost;
+    const auto sampleRate = getSampleRate();
+
+    if (sampleRate <= 0.0)
+        return cost;
+
+    auto share = [sampleRate](juce::int64 ticks, juce::int64 voiceSamples)
+    {
+        if (voiceSamples == 0)
+            return 0.0;
+
+        return juce::Time::highResolutionTicksToSeconds(ticks) / ((double)voiceSamples / sampleRate);
+    };
+
+    cost.filtered = share(filteredTicks.load(), filteredVoiceSamples.load());
+    cost.unfiltered = share(unfilteredTicks.load(), unfilteredVoiceSamples.load());
+    return cost;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    SamplerSynthesiser.h
+    Created: Synthesiser that runs the voice filters as one SIMD bank
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "VoiceFilterBank.h"
+#include "SampleVoice.h"
+#include "RegionCostTable.h"
+
+// Build with this set to 1 to time voices with and without their filter, for getVoiceCost().
+// Without it nothing is timed or counted as the voices render.
+#ifndef SAMPLER_VOICE_COST_TIMING
+ #define SAMPLER_VOICE_COST_TIMING 0
+#endif
+
+//==============================================================================
+/**
+    A Synthesiser whose voices share a VoiceFilterBank.
+
+    Voices playing a sound without a filter render straight into the output as
+    usual. The others render into their lane of the bank, which then filters them
+    all together. MIDI CC 74 (brightness) shifts every filter's cutoff.
+*/
+class SamplerSynthesiser : public juce::Synthesiser
+{
+public:
+    //==============================================================================
+    SamplerSynthesiser();
+    ~SamplerSynthesiser() override;
+
+    /** Sets the playback rate and makes room for the current voices in the filter bank. */
+    void prepare(double sampleRate);
+
+    /** Makes room in the filter bank for voices added since prepare(). Takes the synth's lock,
+        so it can be called while the audio thread is running, but it allocates.
+    */
+    void updateFilterBank();
+
+    void handleController(int midiChannel, int controllerNumber, int controllerValue) override;
+
+    /** Passes the front panel's play controls to every voice. Call from the audio thread before rendering. */
+    void setPlayControls(const SampleVoice::PlayControls& newControls) noexcept;
+
+    //==============================================================================
+    /** What voices have cost to render, as a share of one CPU core per voice */
+    struct VoiceCost
+    {
+        double filtered = 0.0;     // voices with a filter, including their share of the bank
+        double unfiltered = 0.0;   // voices without one
+    };
+
+    /** Returns true if this build times the voices for getVoiceCost() */
+    static constexpr bool isVoiceCostAvailable() noexcept { return SAMPLER_VOICE_COST_TIMING != 0; }
+
+    /** Returns the average cost of voices with and without a filter since the last prepare().
+        Always zero unless the build has SAMPLER_VOICE_COST_TIMING set.
+    */
+    VoiceCost getVoiceCost() const;
+
+    /** Returns the table that each voice's render time is charged to, by region */
+    RegionCostTable& getRegionCosts() noexcept { return regionCosts; }
+    const RegionCostTable& getRegionCosts() const noexcept { return regionCosts; }
+
+    /** Returns how many notes have had to take a voice that was still playing since the last prepare() */
+    juce::int64 getNumVoicesStolen() const noexcept { return voicesStolen.load(std::memory_order_relaxed); }
+
+protected:
+    void renderVoices(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override;
+    using juce::Synthesiser::renderVoices;
+
+    juce::SynthesiserVoice* findVoiceToSteal(juce::SynthesiserSound* soundToPlay, int midiChannel,
+        int midiNoteNumber) const override;
+
+private:
+    //==============================================================================
+    VoiceFilterBank filterBank;
+    std::atomic<float> brightnessCents { 0.0f };
+
+    std::atomic<juce::int64> filteredTicks { 0 }, filteredVoiceSamples { 0 };
+    std::atomic<juce::int64> unfilteredTicks { 0 }, unfilteredVoiceSamples { 0 };
+
+    // Counted from findVoiceToSteal(), which the base class declares const
+    mutable std::atomic<juce::int64> voicesStolen { 0 };
+
+    RegionCostTable regionCosts;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SamplerSynthesiser)
+};
\ No newline at end of file
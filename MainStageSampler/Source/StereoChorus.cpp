@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    StereoChorus.cpp
+    Created: Master bus chorus
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "StereoChorus.h"
+
+namespace
+{
+    constexpr double lfoRate = 0.6;          // Hz
+    constexpr double centreDelayMs = 12.0;
+    constexpr double delayDepthMs = 4.0;     // either side of the centre
+    constexpr float maxWetMix = 0.5f;        // an even blend of dry and delayed at full amount
+}
+
+//==============================================================================
+StereoChorus::StereoChorus()
+{
+    prepare(sampleRate, 512);
+}
+
+StereoChorus::~StereoChorus()
+{
+}
+
+void StereoChorus::prepare(double newSampleRate, int /*maximumBlockSize*/)
+{
+    sampleRate = newSampleRate;
+
+    centreDelay = (float)(centreDelayMs * 0.001 * sampleRate);
+    delayDepth = (float)(delayDepthMs * 0.001 * sampleRate);
+
+    // Room for the longest delay behind a whole chunk, plus the interpolation tap
+    const auto needed = (int)std::ceil(centreDelay + delayDepth) + chunkSize + 2;
+    const auto length = juce::nextPowerOfTwo(needed);
+
+    delayBuffer.allocate((size_t)(2 * length), true);
+    delayLine[0] = delayBuffer.get();
+    delayLine[1] = delayBuffer.get() + length;
+    delayMask = length - 1;
+
+    const auto angle = juce::MathConstants<double>::twoPi * lfoRate / sampleRate;
+    lfoRotateSin = (float)std::sin(angle);
+    lfoRotateCos = (float)std::cos(angle);
+
+    smoothedAmount.setCurrentAndTargetValue(amount);
+
+    reset();
+}
+
+void StereoChorus::reset()
+{
+    juce::FloatVectorOperations::clear(delayBuffer.get(), 2 * (delayMask + 1));
+    writePosition = 0;
+    lfoSin = 0.0f;
+    lfoCos = 1.0f;
+    bypassed = true;
+}
+
+//==============================================================================
+void StereoChorus::fillModulation(int numFrames) noexcept
+{
+    for (int i = 0; i < numFrames; ++i)
+    {
+        modulation[0][i] = lfoSin;
+        modulation[1][i] = lfoCos;
+
+        const auto s = lfoSin * lfoRotateCos + lfoCos * lfoRotateSin;
+        lfoCos = lfoCos * lfoRotateCos - lfoSin * lfoRotateSin;
+        lfoSin = s;
+    }
+
+    // Pull the phasor back onto the unit circle so rounding can't make it grow or die away
+    const auto scale = 1.0f / std::sqrt(lfoSin * lfoSin + lfoCos * lfoCos);
+    lfoSin *= scale;
+    lfoCos *= scale;
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        juce::FloatVectorOperations::multiply(modulation[ch], delayDepth, numFrames);
+        juce::FloatVectorOperations::add(modulation[ch], centreDelay, numFrames);
+    }
+}
+
+void StereoChorus::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    // The level moves from the last block's setting to this one's across the block
+    smoothedAmount.reset(numSamples);
+    smoothedAmount.setTargetValue(amount);
+
+    if (smoothedAmount.getTargetValue() == 0.0f && !smoothedAmount.isSmoothing())
+    {
+        bypassed = true;
+        return;
+    }
+
+    // Whatever the delay lines held when the chorus was switched off is long out of date
+    if (bypassed)
+    {
+        juce::FloatVectorOperations::clear(delayBuffer.get(), 2 * (delayMask + 1));
+        bypassed = false;
+    }
+
+    juce::ScopedNoDenormals noDenormals;
+
+    const int numChannels = juce::jmin(2, buffer.getNumChannels());
+
+    for (int done = 0; done < numSamples;)
+    {
+        const int numThisTime = juce::jmin(numSamples - done, chunkSize);
+
+        fillModulation(numThisTime);
+
+        for (int i = 0; i < numThisTime; ++i)
+            wetGain[i] = smoothedAmount.getNextValue() * maxWetMix;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* samples = buffer.getWritePointer(ch, startSample + done);
+            auto* line = delayLine[ch];
+
+            for (int i = 0; i < numThisTime; ++i)
+                line[(writePosition + i) & delayMask] = samples[i];
+
+            // The shortest delay is well over a chunk's worth of interpolation away from
+            // the write head, so every read lands on audio that has already been written
+            const auto* delay = modulation[ch];
+
+            for (int i = 0; i < numThisTime; ++i)
+            {
+                const auto readPosition = (float)(writePosition + i) - delay[i];
+                const auto whole = (int)std::floor(readPosition);
+                const auto fraction = readPosition - (float)whole;
+                const auto a = line[whole & delayMask];
+                const auto b = line[(whole + 1) & delayMask];
+
+                wet[i] = a + fraction * (b - a);
+            }
+
+            // samples += (wet - samples) * wetGain
+            juce::FloatVectorOperations::subtract(wet, samples, numThisTime);
+            juce::FloatVectorOperations::multiply(wet, wetGain, numThisTime);
+            juce::FloatVectorOperations::add(samples, wet, numThisTime);
+        }
+
+        writePosition = (writePosition + numThisTime) & delayMask;
+        done += numThisTime;
+    }
+}
\ No newline at end of file
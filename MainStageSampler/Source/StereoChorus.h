@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    StereoChorus.h
+    Created: Master bus chorus
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A stereo chorus for the master bus: each channel is blended with a copy of
+    itself read from a delay line whose length is swept by a slow LFO, with the
+    right channel's LFO a quarter cycle behind the left's.
+
+    Work is done a chunk at a time. The chunk is written into the delay lines
+    first, then the LFO and the wet gain ramp for the whole chunk are filled in,
+    and the reads and the mix run over those arrays. Nothing is allocated once
+    prepared, and with the amount at zero the chorus does nothing at all.
+*/
+class StereoChorus
+{
+public:
+    //==============================================================================
+    StereoChorus();
+    ~StereoChorus();
+
+    /** Prepares for playback. Call this while the audio callback isn't running. */
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    /** Clears the delay lines. Call this while the audio callback isn't running. */
+    void reset();
+
+    /** Sets how much chorus is blended in, from 0 to 1. The next process() ramps to it
+        across its block. Call from the audio thread, or while it isn't running.
+    */
+    void setAmount(float newAmount) noexcept { amount = newAmount; }
+
+    /** Applies the chorus to the first two channels of the buffer in place. */
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    static constexpr int chunkSize = 256;
+
+    /** Fills in the delay, in samples, for each frame of the next chunk on both channels */
+    void fillModulation(int numFrames) noexcept;
+
+    double sampleRate = 44100.0;
+
+    // One delay line per channel, a power of two long so positions wrap with a mask
+    juce::HeapBlock<float> delayBuffer;
+    float* delayLine[2] = {};
+    int delayMask = 0;
+    int writePosition = 0;
+
+    // The LFO is a rotating phasor: its sine drives the left channel and its cosine the right
+    float lfoSin = 0.0f, lfoCos = 1.0f;
+    float lfoRotateSin = 0.0f, lfoRotateCos = 1.0f;
+    float centreDelay = 0.0f, delayDepth = 0.0f;
+
+    float modulation[2][chunkSize] = {};
+    float wet[chunkSize] = {};
+    float wetGain[chunkSize] = {};
+
+    float amount = 0.0f;
+    juce::SmoothedValue<float> smoothedAmount;
+    bool bypassed = true;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StereoChorus)
+};
\ No newline at end of file
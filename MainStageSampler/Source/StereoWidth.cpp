@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    StereoWidth.cpp
+    Created: Mid/side stereo width
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "StereoWidth.h"
+
+//==============================================================================
+StereoWidth::StereoWidth()
+{
+    prepare(44100.0, 512);
+}
+
+StereoWidth::~StereoWidth()
+{
+}
+
+void StereoWidth::prepare(double /*sampleRate*/, int /*maximumBlockSize*/)
+{
+    smoothedWidth.setCurrentAndTargetValue(juce::jlimit(0.0f, 1.0f, width));
+}
+
+void StereoWidth::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    // The width moves from the last block's setting to this one's across the block
+    smoothedWidth.reset(numSamples);
+    smoothedWidth.setTargetValue(juce::jlimit(0.0f, 1.0f, width));
+
+    if (buffer.getNumChannels() < 2 || (smoothedWidth.getTargetValue() == 1.0f && !smoothedWidth.isSmoothing()))
+        return;
+
+    for (int done = 0; done < numSamples;)
+    {
+        const int numThisTime = juce::jmin(numSamples - done, chunkSize);
+        auto* left = buffer.getWritePointer(0, startSample + done);
+        auto* right = buffer.getWritePointer(1, startSample + done);
+
+        for (int i = 0; i < numThisTime; ++i)
+            sideGain[i] = smoothedWidth.getNextValue();
+
+        // mid = (L + R) / 2, side = (L - R) / 2 * width, then L = mid + side, R = mid - side
+        juce::FloatVectorOperations::add(mid, left, right, numThisTime);
+        juce::FloatVectorOperations::multiply(mid, 0.5f, numThisTime);
+        juce::FloatVectorOperations::subtract(side, left, right, numThisTime);
+        juce::FloatVectorOperations::multiply(side, 0.5f, numThisTime);
+        juce::FloatVectorOperations::multiply(side, sideGain, numThisTime);
+
+        juce::FloatVectorOperations::add(left, mid, side, numThisTime);
+        juce::FloatVectorOperations::subtract(right, mid, side, numThisTime);
+
+        done += numThisTime;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    StereoWidth.h
+    Created: Mid/side stereo width
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Narrows the stereo image by scaling the side signal against the mid.
+
+    A width of 1 leaves the recording as it is and costs nothing; 0 folds it to
+    mono. Width changes are ramped a sample at a time into a gain array, and the
+    mid/side matrix runs over whole chunks with vector operations.
+*/
+class StereoWidth
+{
+public:
+    //==============================================================================
+    StereoWidth();
+    ~StereoWidth();
+
+    /** Prepares for playback. Call this while the audio callback isn't running. */
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    /** Sets the width, from 0 (mono) to 1 (as recorded). The next process() ramps to it
+        across its block. Call from the audio thread, or while it isn't running.
+    */
+    void setWidth(float newWidth) noexcept { width = newWidth; }
+
+    /** Applies the width to the first two channels of the buffer in place. */
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    static constexpr int chunkSize = 256;
+
+    float mid[chunkSize] = {};
+    float side[chunkSize] = {};
+    float sideGain[chunkSize] = {};
+
+    float width = 1.0f;
+    juce::SmoothedValue<float> smoothedWidth;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StereoWidth)
+};
\ No newline at end of file
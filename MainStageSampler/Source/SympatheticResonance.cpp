@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    SympatheticResonance.cpp
+    Created: Sympathetic string resonance for the piano
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "SympatheticResonance.h"
+
+namespace
+{
+    constexpr double lowestStringDecay = 10.0;   // T60 of the open A0 string, seconds
+    constexpr double decayHalvingKeys = 30.0;    // strings ring half as long every 30 keys up
+    constexpr double damperDecay = 0.15;         // T60 of a string with its damper down
+    constexpr double attackHoldoff = 0.2;        // time a played string is kept from its own attack, seconds
+    constexpr float outputLevel = 0.5f;
+}
+
+//==============================================================================
+SympatheticResonance::SympatheticResonance()
+{
+    // Bass strings to the left, treble to the right, as the player hears them
+    alignas(Vector::SIMDRegisterSize) float left[numStrings], right[numStrings];
+
+    for (int i = 0; i < numStrings; ++i)
+    {
+        const auto position = 0.25f + 0.5f * (float)i / (float)(numStrings - 1);
+        left[i] = std::cos(position * juce::MathConstants<float>::halfPi);
+        right[i] = std::sin(position * juce::MathConstants<float>::halfPi);
+    }
+
+    for (int v = 0; v < numVectors; ++v)
+    {
+        panLeft[v] = Vector::fromRawArray(left + v * (int)Vector::SIMDNumElements);
+        panRight[v] = Vector::fromRawArray(right + v * (int)Vector::SIMDNumElements);
+    }
+
+    prepare(sampleRate, 512);
+}
+
+SympatheticResonance::~SympatheticResonance()
+{
+}
+
+void SympatheticResonance::prepare(double newSampleRate, int /*maximumBlockSize*/)
+{
+    sampleRate = newSampleRate;
+
+    for (int i = 0; i < numStrings; ++i)
+    {
+        const auto frequency = 440.0 * std::pow(2.0, (lowestNote + i - 69) / 12.0);
+        const auto angle = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const auto openDecay = lowestStringDecay * std::pow(2.0, -i / decayHalvingKeys);
+
+        angleCos[i] = (float)std::cos(angle);
+        angleSin[i] = (float)std::sin(angle);
+
+        // Strings too close to Nyquist stay silent
+        const bool audible = frequency < 0.45 * sampleRate;
+        openRadius[i] = audible ? (float)std::exp(-6.9078 / (openDecay * sampleRate)) : 0.0f;
+        dampedRadius[i] = audible ? (float)std::exp(-6.9078 / (damperDecay * sampleRate)) : 0.0f;
+    }
+
+    holdoffSamples = (int)std::ceil(attackHoldoff * sampleRate);
+
+    smoothedAmount.setCurrentAndTargetValue(amount);
+
+    reset();
+}
+
+void SympatheticResonance::reset()
+{
+    for (int v = 0; v < numVectors; ++v)
+    {
+        stateRe[v] = Vector::expand(0.0f);
+        stateIm[v] = Vector::expand(0.0f);
+    }
+
+    std::fill(std::begin(keyDown), std::end(keyDown), false);
+    std::fill(std::begin(ownNoteHoldoff), std::end(ownNoteHoldoff), 0);
+    sustainDown = false;
+    dampersChanged = true;
+}
+
+//==============================================================================
+void SympatheticResonance::processMidi(const juce::MidiBuffer& midiMessages) noexcept
+{
+    for (const auto metadata : midiMessages)
+    {
+        const auto message = metadata.getMessage();
+
+        if (message.isNoteOn())
+            setKeyDown(message.getNoteNumber(), true);
+        else if (message.isNoteOff())
+            setKeyDown(message.getNoteNumber(), false);
+        else if (message.isSustainPedalOn())
+            setSustainPedalDown(true);
+        else if (message.isSustainPedalOff())
+            setSustainPedalDown(false);
+        else if (message.isAllNotesOff() || message.isAllSoundOff())
+        {
+            std::fill(std::begin(keyDown), std::end(keyDown), false);
+            dampersChanged = true;
+        }
+    }
+}
+
+void SympatheticResonance::setKeyDown(int midiNote, bool isDown) noexcept
+{
+    if (juce::isPositiveAndBelow(midiNote, 128) && keyDown[midiNote] != isDown)
+    {
+        keyDown[midiNote] = isDown;
+        dampersChanged = true;
+
+        // Its own attack mustn't be fed back into it, or the note's fundamental doubles up
+        if (isDown && juce::isPositiveAndBelow(midiNote - lowestNote, numStrings))
+            ownNoteHoldoff[midiNote - lowestNote] = holdoffSamples;
+    }
+}
+
+void SympatheticResonance::setSustainPedalDown(bool isDown) noexcept
+{
+    if (sustainDown != isDown)
+    {
+        sustainDown = isDown;
+        dampersChanged = true;
+    }
+}
+
+void SympatheticResonance::updateDampers() noexcept
+{
+    dampersChanged = false;
+
+    alignas(Vector::SIMDRegisterSize) float cosines[numStrings], sines[numStrings], gains[numStrings];
+
+    for (int i = 0; i < numStrings; ++i)
+    {
+        const bool open = sustainDown || keyDown[lowestNote + i];
+        const auto radius = open ? openRadius[i] : dampedRadius[i];
+
+        // A steady sine at the string's pitch leaves it ringing at the sine's level.
+        // Damped strings get no input and just die away, as do strings just played
+        // until their own note's attack has passed.
+        cosines[i] = radius * angleCos[i];
+        sines[i] = radius * angleSin[i];
+        gains[i] = open && ownNoteHoldoff[i] == 0 ? 2.0f * (1.0f - openRadius[i]) : 0.0f;
+    }
+
+    for (int v = 0; v < numVectors; ++v)
+    {
+        const auto offset = v * (int)Vector::SIMDNumElements;
+        rotateCos[v] = Vector::fromRawArray(cosines + offset);
+        rotateSin[v] = Vector::fromRawArray(sines + offset);
+        inputGain[v] = Vector::fromRawArray(gains + offset);
+    }
+}
+
+void SympatheticResonance::advanceHoldoffs(int numSamples) noexcept
+{
+    for (auto& holdoff : ownNoteHoldoff)
+    {
+        if (holdoff > 0)
+        {
+            holdoff = juce::jmax(0, holdoff - numSamples);
+
+            if (holdoff == 0)
+                dampersChanged = true;
+        }
+    }
+}
+
+void SympatheticResonance::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    if (dampersChanged)
+        updateDampers();
+
+    // Counted whether or not the resonance can be heard, so turning it up doesn't bring back an old attack
+    advanceHoldoffs(numSamples);
+
+    // The level moves from the last block's setting to this one's across the block
+    smoothedAmount.reset(numSamples);
+    smoothedAmount.setTargetValue(amount);
+
+    if (smoothedAmount.getTargetValue() == 0.0f && !smoothedAmount.isSmoothing())
+        return;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    auto* left = buffer.getWritePointer(0, startSample);
+    auto* right = buffer.getNumChannels() > 1 ? buffer.getWritePointer(1, startSample) : nullptr;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto x = right != nullptr ? 0.5f * (left[i] + right[i]) : left[i];
+        auto sumLeft = Vector::expand(0.0f);
+        auto sumRight = Vector::expand(0.0f);
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            const auto re = stateRe[v];
+            const auto im = stateIm[v];
+
+            stateRe[v] = rotateCos[v] * re - rotateSin[v] * im + inputGain[v] * x;
+            stateIm[v] = rotateSin[v] * re + rotateCos[v] * im;
+
+            sumLeft += stateIm[v] * panLeft[v];
+            sumRight += stateIm[v] * panRight[v];
+        }
+
+        const auto gain = smoothedAmount.getNextValue() * outputLevel;
+
+        if (right != nullptr)
+        {
+            left[i] += sumLeft.sum() * gain;
+            right[i] += sumRight.sum() * gain;
+        }
+        else
+        {
+            left[i] += 0.5f * (sumLeft.sum() + sumRight.sum()) * gain;
+        }
+    }
+}
\ No newline at end of file
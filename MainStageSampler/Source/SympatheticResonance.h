@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    SympatheticResonance.h
+    Created: Sympathetic string resonance for the piano
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Models the undamped strings of a piano ringing along with whatever is played.
+
+    There is one resonator per key, tuned to the key's fundamental and excited by
+    the dry mix. A string whose key is held, or every string while the sustain
+    pedal is down, is free to ring for a few seconds; the rest are damped and fed
+    nothing. A string's own note is left out of its input for the first moments
+    after it's played, as the note's sample already has that string ringing. The
+    resonators are complex one-pole filters held in SIMD registers, so the cost is
+    the same whatever the polyphony, and it replaces the resonance samples that
+    would otherwise take up voices.
+
+    Key and pedal state are taken from the MIDI of each block, so the dampers
+    move on block boundaries.
+*/
+class SympatheticResonance
+{
+public:
+    //==============================================================================
+    SympatheticResonance();
+    ~SympatheticResonance();
+
+    /** Prepares for playback. Call this while the audio callback isn't running. */
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    /** Silences every string. Call this while the audio callback isn't running. */
+    void reset();
+
+    /** Sets how loud the resonance is, from 0 to 1. The next process() ramps to it
+        across its block. Call from the audio thread, or while it isn't running.
+    */
+    void setAmount(float newAmount) noexcept { amount = newAmount; }
+
+    //==============================================================================
+    /** Follows the note and sustain pedal messages of the next block. */
+    void processMidi(const juce::MidiBuffer& midiMessages) noexcept;
+
+    /** Lifts or drops the damper of one key. */
+    void setKeyDown(int midiNote, bool isDown) noexcept;
+
+    /** Lifts or drops all of the dampers. */
+    void setSustainPedalDown(bool isDown) noexcept;
+
+    /** Adds the resonance excited by the first two channels of the buffer to them. */
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    using Vector = juce::dsp::SIMDRegister<float>;
+
+    static constexpr int lowestNote = 21;    // A0
+    static constexpr int numStrings = 88;
+    static constexpr int numVectors = numStrings / (int)Vector::SIMDNumElements;
+
+    static_assert(numStrings % (int)Vector::SIMDNumElements == 0, "The strings must fill whole SIMD registers");
+
+    /** Works out each string's decay and input gain from the dampers. */
+    void updateDampers() noexcept;
+
+    /** Counts down the strings whose own notes have just been played. */
+    void advanceHoldoffs(int numSamples) noexcept;
+
+    //==============================================================================
+    double sampleRate = 44100.0;
+
+    bool keyDown[128] = {};
+    bool sustainDown = false;
+    bool dampersChanged = true;
+
+    // Per string: the resonator state, the rotation it applies per sample with its
+    // decay folded in, its input gain and where it sits across the stereo field
+    Vector stateRe[numVectors], stateIm[numVectors];
+    Vector rotateCos[numVectors], rotateSin[numVectors];
+    Vector inputGain[numVectors];
+    Vector panLeft[numVectors], panRight[numVectors];
+
+    // Samples left before a string just played takes input again
+    int ownNoteHoldoff[numStrings] = {};
+    int holdoffSamples = 0;
+
+    float openRadius[numStrings] = {}, dampedRadius[numStrings] = {};
+    float angleCos[numStrings] = {}, angleSin[numStrings] = {};
+
+    float amount = 0.0f;
+    juce::SmoothedValue<float> smoothedAmount;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SympatheticResonance)
+};
\ No newline at end of file
@@ -0,0 +1,229 @@
+/*
+  ==============================================================================
+
+    VoiceFilterBank.cpp
+    Created: Per-voice multimode filters, processed across voices in SIMD lanes
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "VoiceFilterBank.h"
+
+namespace
+{
+    constexpr double cutoffGlideSeconds = 0.02;
+    constexpr float butterworthQ = 0.7071f;   // no resonance gives a Butterworth response
+}
+
+VoiceFilterBank::VoiceFilterBank()
+{
+}
+
+VoiceFilterBank::~VoiceFilterBank()
+{
+}
+
+//==============================================================================
+void VoiceFilterBank::prepare(double newSampleRate, int numVoices)
+{
+    sampleRate = newSampleRate;
+    numGroups = (juce::jmax(1, numVoices) + laneWidth - 1) / laneWidth;
+    numLanes = numGroups * laneWidth;
+
+    // Every block below is a whole number of registers long, so they all stay aligned
+    const int inputSize = chunkSize * numLanes;
+    const int mixSize = chunkSize * laneWidth;
+    storage.calloc((size_t)(2 * inputSize + 2 * mixSize + 11 * numLanes + laneWidth));
+
+    auto* next = Vector::getNextSIMDAlignedPtr(storage.get());
+    auto take = [&next](int size) { auto* block = next; next += size; return block; };
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        input[ch] = take(inputSize);
+        mix[ch] = take(mixSize);
+        state1[ch] = take(numLanes);
+        state2[ch] = take(numLanes);
+    }
+
+    a1 = take(numLanes);
+    a2 = take(numLanes);
+    a3 = take(numLanes);
+    k = take(numLanes);
+    lowGain = take(numLanes);
+    bandGain = take(numLanes);
+    highGain = take(numLanes);
+
+    currentCutoff.calloc((size_t)numLanes);
+    targetCutoff.calloc((size_t)numLanes);
+    resonance.calloc((size_t)numLanes);
+    types.calloc((size_t)numLanes);
+    laneBegun.calloc((size_t)numLanes);
+}
+
+void VoiceFilterBank::setLaneTarget(int lane, SampleSound::FilterType type, float cutoffHz, float resonanceDb, bool restart) noexcept
+{
+    jassert(lane >= 0 && lane < numLanes);
+
+    types[lane] = type;
+    targetCutoff[lane] = juce::jlimit(10.0f, 100000.0f, cutoffHz);
+    resonance[lane] = resonanceDb;
+
+    if (restart)
+    {
+        currentCutoff[lane] = targetCutoff[lane];
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            state1[ch][lane] = 0.0f;
+            state2[ch][lane] = 0.0f;
+        }
+    }
+}
+
+void VoiceFilterBank::beginLane(int lane, int numFrames, float*& left, float*& right) noexcept
+{
+    jassert(lane >= 0 && lane < numLanes && numFrames <= chunkSize);
+
+    laneBegun[lane] = true;
+    left = input[0] + lane;
+    right = input[1] + lane;
+
+    for (int f = 0; f < numFrames; ++f)
+    {
+        left[f * numLanes] = 0.0f;
+        right[f * numLanes] = 0.0f;
+    }
+}
+
+//==============================================================================
+void VoiceFilterBank::updateCoefficients(int numFrames) noexcept
+{
+    const auto glide = (float)(1.0 - std::exp(-numFrames / (cutoffGlideSeconds * sampleRate)));
+    const auto maxCutoff = (float)(0.45 * sampleRate);
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        // Lanes nobody wrote to this time are silenced rather than skipped
+        if (!laneBegun[lane])
+        {
+            lowGain[lane] = bandGain[lane] = highGain[lane] = 0.0f;
+            continue;
+        }
+
+        // Glide in octaves, so sweeps sound even across the range
+        currentCutoff[lane] *= std::pow(targetCutoff[lane] / currentCutoff[lane], glide);
+
+        const auto cutoff = juce::jlimit(10.0f, maxCutoff, currentCutoff[lane]);
+        const auto g = (float)std::tan(juce::MathConstants<double>::pi * cutoff / sampleRate);
+
+        // The resonance is how far the Q is above Butterworth, in dB
+        const auto q = butterworthQ * juce::Decibels::decibelsToGain(juce::jmax(0.0f, resonance[lane]));
+        const auto damping = 1.0f / q;
+
+        a1[lane] = 1.0f / (1.0f + g * (g + damping));
+        a2[lane] = g * a1[lane];
+        a3[lane] = g * a2[lane];
+        k[lane] = damping;
+
+        // Every response is a mix of the three outputs, so lanes of different types share the same maths
+        switch (types[lane])
+        {
+            case SampleSound::FilterType::lowpass:  lowGain[lane] = 1.0f; bandGain[lane] = 0.0f;    highGain[lane] = 0.0f; break;
+            case SampleSound::FilterType::highpass: lowGain[lane] = 0.0f; bandGain[lane] = 0.0f;    highGain[lane] = 1.0f; break;
+            case SampleSound::FilterType::bandpass: lowGain[lane] = 0.0f; bandGain[lane] = damping; highGain[lane] = 0.0f; break;
+            case SampleSound::FilterType::notch:    lowGain[lane] = 1.0f; bandGain[lane] = 0.0f;    highGain[lane] = 1.0f; break;
+            case SampleSound::FilterType::none:
+            default:                                lowGain[lane] = 1.0f; bandGain[lane] = damping; highGain[lane] = 1.0f; break;
+        }
+    }
+}
+
+void VoiceFilterBank::process(juce::AudioBuffer<float>& buffer, int startSample, int numFrames) noexcept
+{
+    jassert(numFrames <= chunkSize);
+
+    bool anyBegun = false;
+    for (int lane = 0; lane < numLanes && !anyBegun; ++lane)
+        anyBegun = laneBegun[lane];
+
+    if (!anyBegun || numFrames <= 0)
+        return;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    updateCoefficients(numFrames);
+
+    for (int ch = 0; ch < 2; ++ch)
+        juce::FloatVectorOperations::clear(mix[ch], numFrames * laneWidth);
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        const int first = group * laneWidth;
+
+        bool groupBegun = false;
+        for (int lane = first; lane < first + laneWidth; ++lane)
+            groupBegun = groupBegun || laneBegun[lane];
+
+        if (!groupBegun)
+            continue;
+
+        const auto vA1 = Vector::fromRawArray(a1 + first);
+        const auto vA2 = Vector::fromRawArray(a2 + first);
+        const auto vA3 = Vector::fromRawArray(a3 + first);
+        const auto vK = Vector::fromRawArray(k + first);
+        const auto vLow = Vector::fromRawArray(lowGain + first);
+        const auto vBand = Vector::fromRawArray(bandGain + first);
+        const auto vHigh = Vector::fromRawArray(highGain + first);
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            auto s1 = Vector::fromRawArray(state1[ch] + first);
+            auto s2 = Vector::fromRawArray(state2[ch] + first);
+            const auto* in = input[ch] + first;
+            auto* out = mix[ch];
+
+            for (int f = 0; f < numFrames; ++f)
+            {
+                const auto x = Vector::fromRawArray(in + f * numLanes);
+
+                // Zavalishin's trapezoidal SVF, in Simper's formulation
+                const auto v3 = x - s2;
+                const auto v1 = vA1 * s1 + vA2 * v3;
+                const auto v2 = s2 + vA2 * s1 + vA3 * v3;
+                s1 = v1 + v1 - s1;
+                s2 = v2 + v2 - s2;
+
+                const auto y = vLow * v2 + vBand * v1 + vHigh * (x - vK * v1 - v2);
+                (Vector::fromRawArray(out + f * laneWidth) + y).copyToRawArray(out + f * laneWidth);
+            }
+
+            s1.copyToRawArray(state1[ch] + first);
+            s2.copyToRawArray(state2[ch] + first);
+        }
+    }
+
+    // One horizontal sum per frame folds all of the groups into the output
+    auto* left = buffer.getWritePointer(0, startSample);
+    auto* right = buffer.getNumChannels() > 1 ? buffer.getWritePointer(1, startSample) : nullptr;
+
+    for (int f = 0; f < numFrames; ++f)
+    {
+        const auto l = Vector::fromRawArray(mix[0] + f * laneWidth).sum();
+        const auto r = Vector::fromRawArray(mix[1] + f * laneWidth).sum();
+
+        if (right != nullptr)
+        {
+            left[f] += l;
+            right[f] += r;
+        }
+        else
+        {
+            left[f] += (l + r) * 0.5f;
+        }
+    }
+
+    for (int lane = 0; lane < numLanes; ++lane)
+        laneBegun[lane] = false;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    VoiceFilterBank.h
+    Created: Per-voice multimode filters, processed across voices in SIMD lanes
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleSound.h"
+
+//==============================================================================
+/**
+    The filters of every voice in the synth, held structure-of-arrays style so
+    that one SIMD register carries the same filter stage of several voices.
+
+    Each voice has a lane. For every chunk, voices that use a filter write their
+    output into their lane of the input buffer, whose frames are laid out as
+    [frame][lane], so the samples of neighbouring voices sit side by side. The
+    bank then runs a TPT state-variable filter down each group of lanes and mixes
+    the result into the output. Coefficients are worked out once per chunk and
+    glide towards their targets, so cutoff changes don't zip.
+*/
+class VoiceFilterBank
+{
+public:
+    //==============================================================================
+    VoiceFilterBank();
+    ~VoiceFilterBank();
+
+    /** Largest number of frames a chunk can hold */
+    static constexpr int chunkSize = 256;
+
+    /** Allocates lanes for the given number of voices. Call this while the audio callback isn't running. */
+    void prepare(double sampleRate, int numVoices);
+
+    //==============================================================================
+    /** Sets what a lane's filter should be doing. When restart is true the filter's
+        memory is cleared and the cutoff jumps straight to the target, as for a new note.
+    */
+    void setLaneTarget(int lane, SampleSound::FilterType type, float cutoffHz, float resonanceDb, bool restart) noexcept;
+
+    /** Clears the first numFrames frames of a lane and returns its two channels,
+        whose samples are getLaneStride() floats apart.
+    */
+    void beginLane(int lane, int numFrames, float*& left, float*& right) noexcept;
+
+    /** Returns the number of lanes, which is at least the number of voices passed to prepare() */
+    int getNumLanes() const noexcept { return numLanes; }
+
+    /** Returns the distance between consecutive frames of a lane */
+    int getLaneStride() const noexcept { return numLanes; }
+
+    /** Filters every lane that was begun since the last call and adds them to the
+        first two channels of the buffer.
+    */
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numFrames) noexcept;
+
+private:
+    //==============================================================================
+    using Vector = juce::dsp::SIMDRegister<float>;
+    static constexpr int laneWidth = (int)Vector::SIMDNumElements;
+
+    /** Moves each lane's cutoff towards its target and recomputes its coefficients */
+    void updateCoefficients(int numFrames) noexcept;
+
+    double sampleRate = 44100.0;
+    int numLanes = 0, numGroups = 0;
+
+    // Aligned storage for the lane buffers, filter state and coefficients
+    juce::HeapBlock<float> storage;
+    float* input[2] = {};
+    float* mix[2] = {};                // the groups summed together, laneWidth floats per frame
+    float* state1[2] = {};
+    float* state2[2] = {};
+    float *a1 = nullptr, *a2 = nullptr, *a3 = nullptr, *k = nullptr;
+    float *lowGain = nullptr, *bandGain = nullptr, *highGain = nullptr;
+
+    // Per lane, scalar
+    juce::HeapBlock<float> currentCutoff, targetCutoff, resonance;
+    juce::HeapBlock<SampleSound::FilterType> types;
+    juce::HeapBlock<bool> laneBegun;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoiceFilterBank)
+};
\ No newline at end of file
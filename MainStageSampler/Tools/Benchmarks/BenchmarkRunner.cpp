@@ -0,0 +1,301 @@
+/*
+  ==============================================================================
+
+    BenchmarkRunner.cpp
+    Created: Times benchmark cases and writes the results as JSON
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "BenchmarkRunner.h"
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    // Bumped whenever the layout of the JSON changes
+    constexpr int formatVersion = 2;
+}
+
+//==============================================================================
+/** Counts the hardware cache misses of the calling thread, in user code only */
+class BenchmarkRunner::CacheMissCounter
+{
+public:
+    CacheMissCounter()
+    {
+       #if JUCE_LINUX
+        perf_event_attr attributes {};
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.size = sizeof(attributes);
+        attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+
+        // Fails in most VMs and containers, and where perf_event_paranoid forbids it
+        fd = (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+       #endif
+    }
+
+    ~CacheMissCounter()
+    {
+       #if JUCE_LINUX
+        if (fd >= 0)
+            close(fd);
+       #endif
+    }
+
+    bool isAvailable() const noexcept { return fd >= 0; }
+
+    void start() noexcept
+    {
+       #if JUCE_LINUX
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+       #endif
+    }
+
+    /** Returns the misses since start(), or -1 if they couldn't be read */
+    juce::int64 stop() noexcept
+    {
+       #if JUCE_LINUX
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        juce::int64 count = 0;
+        if (read(fd, &count, sizeof(count)) == (ssize_t)sizeof(count))
+            return count;
+       #endif
+
+        return -1;
+    }
+
+private:
+    int fd = -1;
+
+    JUCE_DECLARE_NON_COPYABLE(CacheMissCounter)
+};
+
+//==============================================================================
+double BenchmarkRunner::Result::getMedianSeconds() const
+{
+    if (runSeconds.isEmpty())
+        return 0.0;
+
+    auto sorted = runSeconds;
+    sorted.sort();
+
+    const auto middle = sorted.size() / 2;
+    return sorted.size() % 2 != 0 ? sorted[middle] : 0.5 * (sorted[middle - 1] + sorted[middle]);
+}
+
+double BenchmarkRunner::Result::getNanosecondsPerItem() const
+{
+    return itemsPerRun > 0.0 ? getMedianSeconds() * 1.0e9 / itemsPerRun : 0.0;
+}
+
+juce::String BenchmarkRunner::Result::getKey() const
+{
+    auto key = name;
+
+    for (auto& parameter : parameters)
+        key << " " << parameter.name.toString() << "=" << parameter.value.toString();
+
+    return key;
+}
+
+juce::var BenchmarkRunner::Result::toVar() const
+{
+    auto* parameterObject = new juce::DynamicObject();
+
+    for (auto& parameter : parameters)
+        parameterObject->setProperty(parameter.name, parameter.value);
+
+    auto sorted = runSeconds;
+    sorted.sort();
+
+    double total = 0.0;
+    for (auto seconds : sorted)
+        total += seconds;
+
+    auto* object = new juce::DynamicObject();
+    object->setProperty("name", name);
+    object->setProperty("parameters", juce::var(parameterObject));
+    object->setProperty("unit", unit);
+    object->setProperty("items_per_run", itemsPerRun);
+    object->setProperty("runs", sorted.size());
+    object->setProperty("median_seconds", getMedianSeconds());
+    object->setProperty("min_seconds", sorted.isEmpty() ? 0.0 : sorted.getFirst());
+    object->setProperty("max_seconds", sorted.isEmpty() ? 0.0 : sorted.getLast());
+    object->setProperty("mean_seconds", sorted.isEmpty() ? 0.0 : total / sorted.size());
+    object->setProperty("ns_per_item", getNanosecondsPerItem());
+    object->setProperty("items_per_second", getMedianSeconds() > 0.0 ? itemsPerRun / getMedianSeconds() : 0.0);
+
+    if (cacheMissesPerItem >= 0.0)
+        object->setProperty("cache_misses_per_item", cacheMissesPerItem);
+
+    return juce::var(object);
+}
+
+//==============================================================================
+BenchmarkRunner::BenchmarkRunner(const Settings& settingsToUse)
+    : settings(settingsToUse),
+      cacheMisses(std::make_unique<CacheMissCounter>())
+{
+    if (!cacheMisses->isAvailable())
+        std::cerr << "Cache misses aren't counted: hardware perf events aren't available here" << std::endl;
+}
+
+BenchmarkRunner::~BenchmarkRunner()
+{
+}
+
+bool BenchmarkRunner::isCountingCacheMisses() const noexcept
+{
+    return cacheMisses->isAvailable();
+}
+
+bool BenchmarkRunner::isSelected(const juce::String& name) const
+{
+    return settings.filter.isEmpty() || name.contains(settings.filter);
+}
+
+void BenchmarkRunner::run(const juce::String& name, const juce::NamedValueSet& parameters,
+    const juce::String& unit, double itemsPerRun, const std::function<void()>& body)
+{
+    if (!isSelected(name))
+        return;
+
+    Result result;
+    result.name = name;
+    result.parameters = parameters;
+    result.unit = unit;
+    result.itemsPerRun = itemsPerRun;
+
+    // First touches of memory and caches aren't what's being measured
+    body();
+
+    double spent = 0.0;
+
+    if (cacheMisses->isAvailable())
+        cacheMisses->start();
+
+    while (spent < settings.secondsPerCase || result.runSeconds.size() < settings.minRuns)
+    {
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        body();
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+        result.runSeconds.add(seconds);
+        spent += seconds;
+    }
+
+    if (cacheMisses->isAvailable())
+    {
+        const auto misses = cacheMisses->stop();
+
+        if (misses >= 0 && itemsPerRun > 0.0)
+            result.cacheMissesPerItem = (double)misses / (itemsPerRun * result.runSeconds.size());
+    }
+
+    std::cerr << result.getKey() << ": " << juce::String(result.getNanosecondsPerItem(), 2) << " ns per " << unit;
+
+    if (result.cacheMissesPerItem >= 0.0)
+        std::cerr << ", " << juce::String(result.cacheMissesPerItem, 4) << " cache misses";
+
+    std::cerr << std::endl;
+    results.add(result);
+}
+
+void BenchmarkRunner::skip(const juce::String& name, const juce::String& reason)
+{
+    if (!isSelected(name))
+        return;
+
+    std::cerr << name << ": skipped, " << reason << std::endl;
+    skipped.set(name, reason);
+}
+
+//==============================================================================
+juce::String BenchmarkRunner::toJSON() const
+{
+    auto* machine = new juce::DynamicObject();
+    machine->setProperty("cpu", juce::SystemStats::getCpuModel());
+    machine->setProperty("physical_cores", juce::SystemStats::getNumPhysicalCpus());
+    machine->setProperty("logical_cores", juce::SystemStats::getNumCpus());
+    machine->setProperty("cpu_mhz", juce::SystemStats::getCpuSpeedInMegahertz());
+    machine->setProperty("memory_mb", juce::SystemStats::getMemorySizeInMegabytes());
+    machine->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    machine->setProperty("avx2", juce::SystemStats::hasAVX2());
+    machine->setProperty("neon", juce::SystemStats::hasNeon());
+    machine->setProperty("cache_miss_counter", isCountingCacheMisses());
+
+    auto* build = new juce::DynamicObject();
+    build->setProperty("juce", juce::SystemStats::getJUCEVersion());
+   #if JUCE_DEBUG
+    build->setProperty("debug", true);
+   #else
+    build->setProperty("debug", false);
+   #endif
+
+    juce::Array<juce::var> resultList;
+    for (auto& result : results)
+        resultList.add(result.toVar());
+
+    auto* skippedObject = new juce::DynamicObject();
+    for (auto& name : skipped.getAllKeys())
+        skippedObject->setProperty(name, skipped[name]);
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("format_version", formatVersion);
+    root->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("machine", juce::var(machine));
+    root->setProperty("build", juce::var(build));
+    root->setProperty("results", resultList);
+    root->setProperty("skipped", juce::var(skippedObject));
+
+    return juce::JSON::toString(juce::var(root));
+}
+
+juce::StringArray BenchmarkRunner::findRegressions(const juce::var& baseline, double tolerance) const
+{
+    juce::StringArray regressions;
+
+    if (auto* baselineResults = baseline["results"].getArray())
+    {
+        for (auto& result : results)
+        {
+            const auto key = result.getKey();
+
+            for (auto& old : *baselineResults)
+            {
+                // Rebuild the old case's key the same way
+                Result oldResult;
+                oldResult.name = old["name"].toString();
+
+                if (auto* parameterObject = old["parameters"].getDynamicObject())
+                    oldResult.parameters = parameterObject->getProperties();
+
+                if (oldResult.getKey() != key)
+                    continue;
+
+                const auto before = (double)old["ns_per_item"];
+                const auto after = result.getNanosecondsPerItem();
+
+                if (before > 0.0 && after > before * (1.0 + tolerance))
+                    regressions.add(key + ": " + juce::String(before, 2) + " -> " + juce::String(after, 2)
+                        + " ns per " + result.unit + " (+" + juce::String(100.0 * (after / before - 1.0), 1) + "%)");
+
+                break;
+            }
+        }
+    }
+
+    return regressions;
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    BenchmarkRunner.h
+    Created: Times benchmark cases and writes the results as JSON
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Runs each benchmark case until it has been timed for long enough, and keeps
+    the time of every run. Where the OS allows it (Linux perf events), the
+    hardware cache misses of the timed runs are counted too.
+
+    A case is a name plus the parameters it was run with, so the same name can
+    be measured across voice counts, storage formats and so on. Results are
+    written as JSON with a description of the machine, and can be checked
+    against an earlier file to spot regressions.
+*/
+class BenchmarkRunner
+{
+public:
+    //==============================================================================
+    struct Settings
+    {
+        /** Each case is run until this much time has been spent on it */
+        double secondsPerCase = 0.3;
+
+        /** and at least this many times */
+        int minRuns = 5;
+
+        /** Only cases whose name contains this are run. Empty runs them all. */
+        juce::String filter;
+    };
+
+    /** The timings of one case */
+    struct Result
+    {
+        juce::String name;
+        juce::NamedValueSet parameters;
+
+        juce::String unit;          // what one item is, e.g. "voice sample"
+        double itemsPerRun = 0.0;
+        juce::Array<double> runSeconds;
+        double cacheMissesPerItem = -1.0;   // negative where the misses couldn't be counted
+
+        double getMedianSeconds() const;
+        double getNanosecondsPerItem() const;
+
+        /** Returns the name and parameters, which identify the case between files */
+        juce::String getKey() const;
+
+        juce::var toVar() const;
+    };
+
+    //==============================================================================
+    explicit BenchmarkRunner(const Settings& settingsToUse);
+    ~BenchmarkRunner();
+
+    /** Returns true if the cases' cache misses are being counted */
+    bool isCountingCacheMisses() const noexcept;
+
+    /** Returns true if cases with this name should be run. Check this before any expensive setup. */
+    bool isSelected(const juce::String& name) const;
+
+    /** Times a case. body is called once untimed to warm up, then repeatedly until
+        the case has had its time. Each call should process itemsPerRun items.
+    */
+    void run(const juce::String& name, const juce::NamedValueSet& parameters,
+        const juce::String& unit, double itemsPerRun, const std::function<void()>& body);
+
+    /** Records a case that couldn't be run, and why. */
+    void skip(const juce::String& name, const juce::String& reason);
+
+    //==============================================================================
+    /** Returns every result, with details of the machine and build, as JSON. */
+    juce::String toJSON() const;
+
+    /** Compares the results with a file written by toJSON(), and returns a line for
+        every case that has got slower by more than the given fraction.
+    */
+    juce::StringArray findRegressions(const juce::var& baseline, double tolerance) const;
+
+private:
+    //==============================================================================
+    class CacheMissCounter;
+
+    Settings settings;
+    std::unique_ptr<CacheMissCounter> cacheMisses;
+    juce::Array<Result> results;
+    juce::StringPairArray skipped;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BenchmarkRunner)
+};
\ No newline at end of file
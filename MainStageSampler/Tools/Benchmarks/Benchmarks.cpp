@@ -0,0 +1,582 @@
+/*
+  ==============================================================================
+
+    Benchmarks.cpp
+    Created: The benchmark cases for the engine's hot paths
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "SamplerSynthesiser.h"
+#include "SampleVoice.h"
+#include "SampleSound.h"
+#include "EnhancedSFZLoader.h"
+#include "CompressedSampleData.h"
+#include "MasterEQ.h"
+#include "StereoChorus.h"
+#include "StereoWidth.h"
+#include "MasterLimiter.h"
+#include "FDNReverb.h"
+#include "ConvolutionReverb.h"
+#include "SympatheticResonance.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+    constexpr int blocksPerRun = 16;
+
+    // Long enough for a loop over the middle half. Loop points that divide by 16
+    // keep every mip level looped, see SampleSound::buildMipLevels().
+    constexpr int testSoundFrames = 1 << 17;
+    const juce::Range<int> testLoop { 1 << 15, 3 << 15 };
+
+    enum class Storage
+    {
+        planar,
+        interleaved,
+        compressed
+    };
+
+    const char* getStorageName(Storage storage)
+    {
+        return storage == Storage::planar ? "planar" : storage == Storage::interleaved ? "interleaved" : "compressed";
+    }
+
+    /** Stereo audio like a sustained note: a few partials with a little noise, rounded
+        to the given bit depth as a sample file would be. */
+    juce::AudioBuffer<float> makeTestAudio(int numFrames, int seed, int bitsPerSample = 16)
+    {
+        juce::AudioBuffer<float> audio(2, numFrames);
+        juce::Random random(seed);
+
+        const auto frequency = 110.0 * (1.0 + 0.25 * (seed % 8));
+        const auto scale = (double)((1 << (bitsPerSample - 1)) - 1);
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            const auto phase = juce::MathConstants<double>::twoPi * frequency * i / sampleRate;
+            const auto tone = 0.4 * std::sin(phase) + 0.15 * std::sin(2.003 * phase) + 0.05 * std::sin(3.01 * phase);
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                const auto noise = 0.01 * (random.nextDouble() - 0.5);
+                const auto value = (channel == 0 ? tone : 0.9 * tone) + noise;
+                audio.setSample(channel, i, (float)(std::round(value * scale) / scale));
+            }
+        }
+
+        return audio;
+    }
+
+    SampleSound::Ptr makeTestSound(const juce::AudioBuffer<float>& audio, int lowNote, int highNote, int rootNote,
+        juce::Range<int> velocities, Storage storage, bool looped)
+    {
+        juce::BigInteger notes;
+        notes.setRange(lowNote, highNote - lowNote + 1, true);
+
+        auto source = audio;
+        SampleSound::Ptr sound = new SampleSound("test", source, notes, rootNote, 0.0, 0.1, 10.0, velocities);
+
+        if (looped)
+            sound->setLoop(SampleSound::LoopMode::continuous, testLoop, 0, 16);
+
+        sound->buildMipLevels(4);
+
+        if (storage == Storage::compressed)
+            sound->compressAudioData(16);
+        else if (storage == Storage::interleaved)
+            sound->interleaveAudioData();
+
+        return sound;
+    }
+
+    /** Lets the voice benchmarks start any voice on any sound, however many share a note */
+    struct BenchmarkSynthesiser : public SamplerSynthesiser
+    {
+        using juce::Synthesiser::startVoice;
+    };
+
+    /** Starts every voice of the synth on the sound at the given note, each at a different
+        point of the sample so they don't read the same memory in step. */
+    void startAllVoices(BenchmarkSynthesiser& synth, SampleSound* sound, int note)
+    {
+        juce::AudioBuffer<float> scratch(2, blockSize);
+
+        for (int i = 0; i < synth.getNumVoices(); ++i)
+        {
+            auto* voice = synth.getVoice(i);
+            synth.startVoice(voice, sound, 1, note, 0.8f);
+
+            for (int offset = (i * 1031) % testLoop.getStart(); offset > 0; offset -= blockSize)
+                voice->renderNextBlock(scratch, 0, juce::jmin(offset, blockSize));
+        }
+    }
+
+    void addVoices(SamplerSynthesiser& synth, int numVoices)
+    {
+        // Some cases play compressed sounds, so every voice needs room to decode every mic
+        for (int i = 0; i < numVoices; ++i)
+        {
+            auto* voice = new SampleVoice();
+
+            for (int mic = 0; mic < SampleSound::numMics; ++mic)
+                voice->allocateDecodeWindow(mic);
+
+            synth.addVoice(voice);
+        }
+
+        synth.prepare(sampleRate);
+    }
+
+    /** Writes an SFZ of the given number of regions, in groups of 32, either all in
+        the one file or with each group's regions in an included file. */
+    juce::File writeTestSfz(const juce::File& directory, const juce::String& name, int numRegions, bool useIncludes)
+    {
+        juce::String text;
+        text << "// Generated for benchmarking\n"
+             << "#define $RELEASE 0.4\n"
+             << "<control> default_path=samples/\n"
+             << "<global> ampeg_release=$RELEASE\n"
+             << "<master> volume=-2\n";
+
+        for (int first = 0; first < numRegions; first += 32)
+        {
+            const auto layer = (first / 32) % 4;
+            text << "<group> lovel=" << layer * 32 << " hivel=" << layer * 32 + 31 << " ampeg_attack=0.002 fil_type=lpf_2p cutoff=8000\n";
+
+            juce::String regions;
+
+            for (int i = first; i < juce::jmin(numRegions, first + 32); ++i)
+                regions << "<region> sample=note_" << i << ".wav lokey=" << i % 128 << " hikey=" << i % 128
+                        << " pitch_keycenter=" << i % 128 << " tune=" << (i % 7) - 3 << " volume=-3 ampeg_decay=1.5 ampeg_sustain=70\n";
+
+            if (useIncludes)
+            {
+                const auto includeName = name + "_group_" + juce::String(first / 32) + ".sfz";
+                directory.getChildFile(includeName).replaceWithText(regions);
+                text << "#include \"" << includeName << "\"\n";
+            }
+            else
+            {
+                text << regions;
+            }
+        }
+
+        auto file = directory.getChildFile(name + ".sfz");
+        file.replaceWithText(text);
+        return file;
+    }
+
+    bool writeTestWav(const juce::File& file, const juce::AudioBuffer<float>& audio)
+    {
+        file.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream>(file);
+
+        if (!stream->openedOk())
+            return false;
+
+        juce::WavAudioFormat wavFormat;
+        std::unique_ptr<juce::OutputStream> output(std::move(stream));
+        auto writer = wavFormat.createWriterFor(output, juce::AudioFormatWriterOptions()
+            .withSampleRate(sampleRate)
+            .withNumChannels(audio.getNumChannels())
+            .withBitsPerSample(16));
+
+        if (writer == nullptr)
+            return false;
+
+        return writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+    }
+
+    /** Runs one master bus processor over a block of stereo noise at a time */
+    template <typename Processor>
+    void runBusProcessor(BenchmarkRunner& runner, const juce::String& processorName, Processor& processor)
+    {
+        juce::AudioBuffer<float> input(2, blockSize * blocksPerRun), buffer(2, blockSize);
+        juce::Random random(1);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < input.getNumSamples(); ++i)
+                input.setSample(channel, i, 0.5f * (random.nextFloat() - 0.5f));
+
+        runner.run("master_bus", { { "processor", processorName } }, "frame", (double)input.getNumSamples(), [&]
+            {
+                // Each block starts from the input, so boosts can't build up from run to run
+                for (int block = 0; block < blocksPerRun; ++block)
+                {
+                    for (int channel = 0; channel < 2; ++channel)
+                        buffer.copyFrom(channel, 0, input, channel, block * blockSize, blockSize);
+
+                    processor.process(buffer, 0, blockSize);
+                }
+            });
+    }
+
+    /** Runs the convolution reverb at the given block size. Its cost grows with the length
+        of the impulse response, so the time is given per second of audio per second of IR. */
+    void runConvolution(BenchmarkRunner& runner, int convolutionBlockSize)
+    {
+        // In line, so the background partitions are counted too
+        ConvolutionReverb reverb;
+        reverb.setNonRealtime(true);
+        reverb.prepare(sampleRate, convolutionBlockSize);
+        reverb.setRoom(ConvolutionReverb::RoomType::hall, 0.7f);
+        reverb.setWetLevel(0.3f);
+
+        // The same length of audio at every block size, so the background partitions come round as often
+        const auto numBlocks = blockSize * blocksPerRun / convolutionBlockSize;
+        juce::AudioBuffer<float> input(2, convolutionBlockSize * numBlocks), buffer(2, convolutionBlockSize);
+        juce::Random random(1);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < input.getNumSamples(); ++i)
+                input.setSample(channel, i, 0.5f * (random.nextFloat() - 0.5f));
+
+        const auto audioSeconds = input.getNumSamples() / sampleRate;
+
+        runner.run("master_bus", { { "processor", "convolution_reverb" }, { "block_size", convolutionBlockSize } },
+            "audio second per IR second", audioSeconds * reverb.getImpulseLengthSeconds(), [&]
+            {
+                for (int block = 0; block < numBlocks; ++block)
+                {
+                    for (int channel = 0; channel < 2; ++channel)
+                        buffer.copyFrom(channel, 0, input, channel, block * convolutionBlockSize, convolutionBlockSize);
+
+                    reverb.process(buffer, 0, convolutionBlockSize);
+                }
+            });
+    }
+}
+
+//==============================================================================
+void Benchmarks::runVoiceRendering(BenchmarkRunner& runner)
+{
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    const juce::MidiBuffer noMidi;
+
+    if (runner.isSelected("voice_render"))
+    {
+        const auto audio = makeTestAudio(testSoundFrames, 1);
+
+        for (auto storage : { Storage::planar, Storage::interleaved, Storage::compressed })
+        {
+            // Two octaves either way in minor thirds, so every mip level is read at ratios
+            // across its range. The root is set so note 60 plays at the ratio being measured.
+            for (int transpose = -24; transpose <= 24; transpose += 3)
+            {
+                auto sound = makeTestSound(audio, 0, 127, 60 - transpose, { 0, 127 }, storage, true);
+                const auto pitchRatio = std::pow(2.0, transpose / 12.0);
+
+                for (int numVoices : { 1, 16, 64, 256 })
+                {
+                    BenchmarkSynthesiser synth;
+                    addVoices(synth, numVoices);
+                    startAllVoices(synth, sound.get(), 60);
+
+                    runner.run("voice_render",
+                        { { "voices", numVoices }, { "storage", getStorageName(storage) },
+                          { "transpose", transpose }, { "pitch_ratio", pitchRatio },
+                          { "mip_level", sound->chooseLevel(pitchRatio) } },
+                        "voice sample", (double)numVoices * blockSize * blocksPerRun, [&]
+                        {
+                            for (int block = 0; block < blocksPerRun; ++block)
+                            {
+                                buffer.clear();
+
+                                for (int i = 0; i < numVoices; ++i)
+                                    synth.getVoice(i)->renderNextBlock(buffer, 0, blockSize);
+                            }
+                        });
+                }
+            }
+        }
+    }
+
+    if (runner.isSelected("voice_render_mics"))
+    {
+        auto sound = makeTestSound(makeTestAudio(testSoundFrames, 1), 0, 127, 60, { 0, 127 }, Storage::planar, true);
+        auto overhead = makeTestSound(makeTestAudio(testSoundFrames, 2), 0, 127, 60, { 0, 127 }, Storage::planar, true);
+        auto room = makeTestSound(makeTestAudio(testSoundFrames, 3), 0, 127, 60, { 0, 127 }, Storage::planar, true);
+        sound->setMicStream(SampleSound::overheadMic, overhead.get());
+        sound->setMicStream(SampleSound::roomMic, room.get());
+
+        for (int numMics : { 1, 2, 3 })
+        {
+            for (int numVoices : { 16, 64 })
+            {
+                BenchmarkSynthesiser synth;
+                addVoices(synth, numVoices);
+
+                // Mics at 0 aren't read at all
+                SampleVoice::PlayControls controls;
+                for (int mic = 0; mic < SampleSound::numMics; ++mic)
+                    controls.micGains[mic] = mic < numMics ? 1.0f : 0.0f;
+
+                synth.setPlayControls(controls);
+                startAllVoices(synth, sound.get(), 60);
+
+                runner.run("voice_render_mics", { { "voices", numVoices }, { "mics", numMics } },
+                    "voice sample", (double)numVoices * blockSize * blocksPerRun, [&]
+                    {
+                        for (int block = 0; block < blocksPerRun; ++block)
+                        {
+                            buffer.clear();
+
+                            for (int i = 0; i < numVoices; ++i)
+                                synth.getVoice(i)->renderNextBlock(buffer, 0, blockSize);
+                        }
+                    });
+            }
+        }
+    }
+
+    if (runner.isSelected("voice_render_filtered"))
+    {
+        const auto audio = makeTestAudio(testSoundFrames, 1);
+
+        for (bool filtered : { false, true })
+        {
+            auto sound = makeTestSound(audio, 0, 127, 60, { 0, 127 }, Storage::planar, true);
+
+            if (filtered)
+            {
+                SampleSound::FilterSettings filter;
+                filter.type = SampleSound::FilterType::lowpass;
+                filter.cutoff = 2000.0f;
+                filter.resonance = 6.0f;
+                sound->setFilter(filter);
+            }
+
+            for (int numVoices : { 16, 64 })
+            {
+                BenchmarkSynthesiser synth;
+                addVoices(synth, numVoices);
+                startAllVoices(synth, sound.get(), 60);
+
+                // Through the synth, which runs the filters as one bank
+                runner.run("voice_render_filtered", { { "voices", numVoices }, { "filter", filtered ? "lowpass" : "none" } },
+                    "voice sample", (double)numVoices * blockSize * blocksPerRun, [&]
+                    {
+                        for (int block = 0; block < blocksPerRun; ++block)
+                        {
+                            buffer.clear();
+                            synth.renderNextBlock(buffer, noMidi, 0, blockSize);
+                        }
+                    });
+            }
+        }
+    }
+}
+
+void Benchmarks::runNoteOnDispatch(BenchmarkRunner& runner)
+{
+    if (!runner.isSelected("note_on_dispatch"))
+        return;
+
+    constexpr int numVoices = 64;
+    constexpr int notesPerRun = 64;
+    const auto audio = makeTestAudio(1024, 1);
+
+    for (int numRegions : { 16, 128, 1024, 4096 })
+    {
+        SamplerSynthesiser synth;
+        addVoices(synth, numVoices);
+
+        // Keys are shared out first, then velocity layers are added, as a multi-layer library would be.
+        // The synth starts a voice for every region under a note, so layers cost a voice each.
+        const auto keysPerRegion = juce::jmax(1, 128 / numRegions);
+        const auto numLayers = juce::jmax(1, numRegions / 128);
+        const auto layerWidth = 128 / numLayers;
+
+        for (int region = 0; region < numRegions; ++region)
+        {
+            const auto lowKey = (region % (128 / keysPerRegion)) * keysPerRegion;
+            const auto layer = region / (128 / keysPerRegion);
+            synth.addSound(makeTestSound(audio, lowKey, lowKey + keysPerRegion - 1, lowKey, { layer * layerWidth, (layer + 1) * layerWidth },
+                Storage::planar, false));
+        }
+
+        runner.run("note_on_dispatch", { { "regions", numRegions }, { "regions_per_note", numLayers } }, "note-on",
+            (double)notesPerRun, [&]
+            {
+                for (int i = 0; i < notesPerRun; ++i)
+                    synth.noteOn(1, 24 + (i * 37) % 80, 0.8f);
+
+                synth.allNotesOff(0, false);
+            });
+    }
+}
+
+void Benchmarks::runLoading(BenchmarkRunner& runner, const juce::File& salamanderSfz)
+{
+    EnhancedSFZLoader loader;
+
+    if (runner.isSelected("sfz_parse"))
+    {
+        if (salamanderSfz.existsAsFile())
+        {
+            const auto numRegions = loader.parseSFZ(salamanderSfz);
+
+            runner.run("sfz_parse", { { "file", "salamander" }, { "includes", true } }, "region", (double)numRegions, [&]
+                {
+                    loader.parseSFZ(salamanderSfz);
+                });
+        }
+        else
+        {
+            runner.skip("sfz_parse salamander", "can't find " + salamanderSfz.getFullPathName());
+        }
+    }
+
+    if (!runner.isSelected("sfz_parse") && !runner.isSelected("sfz_load"))
+        return;
+
+    auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("MainStageSamplerBenchmarks");
+    directory.deleteRecursively();
+    directory.createDirectory();
+
+    if (runner.isSelected("sfz_parse"))
+    {
+        for (auto [numRegions, useIncludes] : { std::pair<int, bool> { 100, false }, { 1000, false }, { 10000, false }, { 1000, true } })
+        {
+            const auto sfz = writeTestSfz(directory, "parse_" + juce::String(numRegions) + (useIncludes ? "_includes" : ""), numRegions, useIncludes);
+
+            runner.run("sfz_parse", { { "file", "generated" }, { "regions", numRegions }, { "includes", useIncludes } },
+                "region", (double)numRegions, [&]
+                {
+                    loader.parseSFZ(sfz);
+                });
+        }
+    }
+
+    if (runner.isSelected("sfz_load"))
+    {
+        // A small instrument with real files behind it: half a second of audio per region
+        constexpr int numRegions = 64;
+        const auto sfz = writeTestSfz(directory, "load", numRegions, false);
+        const auto samples = directory.getChildFile("samples");
+        samples.createDirectory();
+
+        bool written = true;
+        for (int i = 0; i < numRegions; ++i)
+            written = written && writeTestWav(samples.getChildFile("note_" + juce::String(i) + ".wav"), makeTestAudio(24000, i));
+
+        if (written)
+        {
+            for (bool compressed : { false, true })
+            {
+                EnhancedSFZLoader::LoadOptions options;
+                options.compressSamples = compressed;
+                loader.setLoadOptions(options);
+
+                runner.run("sfz_load", { { "regions", numRegions }, { "compressed", compressed } }, "region", (double)numRegions, [&]
+                    {
+                        loader.loadSFZ(sfz);
+                    });
+            }
+        }
+        else
+        {
+            runner.skip("sfz_load", "couldn't write the test samples to " + samples.getFullPathName());
+        }
+    }
+
+    directory.deleteRecursively();
+}
+
+void Benchmarks::runSampleDecoding(BenchmarkRunner& runner)
+{
+    if (!runner.isSelected("sample_encode") && !runner.isSelected("sample_decode"))
+        return;
+
+    constexpr int numFrames = 10 * (int)sampleRate;
+
+    for (int bitsPerSample : { 16, 24 })
+    {
+        const auto audio = makeTestAudio(numFrames, 1, bitsPerSample);
+        auto compressed = CompressedSampleData::encode(audio, bitsPerSample);
+
+        if (compressed == nullptr)
+        {
+            runner.skip("sample_decode", "the test audio didn't compress at " + juce::String(bitsPerSample) + " bits");
+            continue;
+        }
+
+        const auto ratio = (double)compressed->getUncompressedSizeBytes() / (double)compressed->getCompressedSizeBytes();
+
+        runner.run("sample_encode", { { "bits", bitsPerSample } }, "frame", (double)numFrames, [&]
+            {
+                CompressedSampleData::encode(audio, bitsPerSample);
+            });
+
+        juce::AudioBuffer<float> decoded(2, CompressedSampleData::blockSize);
+
+        runner.run("sample_decode", { { "bits", bitsPerSample }, { "ratio", ratio } }, "frame", (double)numFrames, [&]
+            {
+                for (int block = 0; block < compressed->getNumBlocks(); ++block)
+                    compressed->decodeBlock(block, decoded.getArrayOfWritePointers());
+            });
+    }
+}
+
+void Benchmarks::runMasterBus(BenchmarkRunner& runner)
+{
+    if (!runner.isSelected("master_bus"))
+        return;
+
+    {
+        MasterEQ eq;
+        eq.prepare(sampleRate, blockSize);
+        eq.setBandGain(MasterEQ::low, 3.0f);
+        eq.setBandGain(MasterEQ::mid, -2.0f);
+        eq.setBandGain(MasterEQ::presence, 2.0f);
+        eq.setBandGain(MasterEQ::high, -3.0f);
+        runBusProcessor(runner, "eq", eq);
+    }
+
+    {
+        StereoChorus chorus;
+        chorus.prepare(sampleRate, blockSize);
+        chorus.setAmount(1.0f);
+        runBusProcessor(runner, "chorus", chorus);
+    }
+
+    {
+        StereoWidth width;
+        width.prepare(sampleRate, blockSize);
+        width.setWidth(0.5f);
+        runBusProcessor(runner, "stereo_width", width);
+    }
+
+    {
+        MasterLimiter limiter;
+        limiter.prepare(sampleRate, blockSize);
+        limiter.setCeiling(-12.0f);
+        runBusProcessor(runner, "limiter", limiter);
+    }
+
+    {
+        FDNReverb reverb;
+        reverb.prepare(sampleRate, blockSize);
+        reverb.setRoom(FDNReverb::RoomType::hall, 0.7f);
+        reverb.setWetLevel(0.3f);
+        runBusProcessor(runner, "fdn_reverb", reverb);
+    }
+
+    // At the smallest block the engine is run with as well as the usual one, where the
+    // direct part and the 64-sample partitions are most of the work
+    for (auto convolutionBlockSize : { 64, blockSize })
+        runConvolution(runner, convolutionBlockSize);
+
+    {
+        // With the pedal down every string is free to ring
+        SympatheticResonance resonance;
+        resonance.prepare(sampleRate, blockSize);
+        resonance.setAmount(1.0f);
+        resonance.setSustainPedalDown(true);
+        runBusProcessor(runner, "string_resonance", resonance);
+    }
+}
\ No newline at end of file
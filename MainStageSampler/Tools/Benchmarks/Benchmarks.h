@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+
+    Benchmarks.h
+    Created: The benchmark cases for the engine's hot paths
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BenchmarkRunner.h"
+
+//==============================================================================
+/**
+    Each function runs one group of cases. Test data is generated, apart from
+    the Salamander SFZ, so the numbers don't depend on which libraries are
+    installed.
+*/
+namespace Benchmarks
+{
+    /** SampleVoice::renderNextBlock() across voice counts, storage formats and a sweep of
+        two octaves either way through the mip levels, plus multi-mic voices and voices
+        through the filter bank */
+    void runVoiceRendering(BenchmarkRunner& runner);
+
+    /** Synthesiser note-on dispatch against the number of regions loaded */
+    void runNoteOnDispatch(BenchmarkRunner& runner);
+
+    /** EnhancedSFZLoader parsing of the given SFZ (skipped if it doesn't exist) and of
+        generated ones, and a full load of a generated instrument */
+    void runLoading(BenchmarkRunner& runner, const juce::File& salamanderSfz);
+
+    /** CompressedSampleData encode and decode throughput */
+    void runSampleDecoding(BenchmarkRunner& runner);
+
+    /** The master bus processors, one at a time. The convolution reverb is run at 64 and
+        256 sample blocks, and timed per second of audio per second of impulse response. */
+    void runMasterBus(BenchmarkRunner& runner);
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: Command line front end for the benchmark suite
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "BenchmarkRunner.h"
+#include "Benchmarks.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: Benchmarks [options]" << std::endl
+                  << "  --filter <text>         only run cases whose name contains this" << std::endl
+                  << "  --seconds <seconds>     time spent on each case (default 0.3)" << std::endl
+                  << "  --quick                 a short run, to check the suite works" << std::endl
+                  << "  --output <file>         write the JSON here rather than to stdout" << std::endl
+                  << "  --baseline <file>       compare with an earlier JSON file; exits with 2 on regressions" << std::endl
+                  << "  --tolerance <fraction>  slowdown allowed against the baseline (default 0.1)" << std::endl
+                  << "  --salamander <sfz>      the Salamander SFZ to parse (default: found under Samples/)" << std::endl;
+    }
+
+    /** Looks for the Salamander SFZ in the repository's Samples folder, above the working directory or the executable */
+    juce::File findSalamander()
+    {
+        const juce::String relativePath = "Samples/SalamanderGrandPiano-master/Salamander Grand Piano V3.sfz";
+
+        for (auto start : { juce::File::getCurrentWorkingDirectory(),
+                            juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory() })
+        {
+            for (auto directory = start; directory != directory.getParentDirectory(); directory = directory.getParentDirectory())
+            {
+                for (auto candidate : { directory.getChildFile(relativePath), directory.getChildFile("MainStageSampler").getChildFile(relativePath) })
+                    if (candidate.existsAsFile())
+                        return candidate;
+            }
+        }
+
+        return juce::File::getCurrentWorkingDirectory().getChildFile(relativePath);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    BenchmarkRunner::Settings settings;
+    juce::File outputFile, baselineFile, salamanderSfz;
+    double tolerance = 0.1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+        const auto cwd = juce::File::getCurrentWorkingDirectory();
+
+        if (arg == "--filter" && hasValue)           settings.filter = argv[++i];
+        else if (arg == "--seconds" && hasValue)     settings.secondsPerCase = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--output" && hasValue)      outputFile = cwd.getChildFile(argv[++i]);
+        else if (arg == "--baseline" && hasValue)    baselineFile = cwd.getChildFile(argv[++i]);
+        else if (arg == "--tolerance" && hasValue)   tolerance = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--salamander" && hasValue)  salamanderSfz = cwd.getChildFile(argv[++i]);
+        else if (arg == "--quick")
+        {
+            settings.secondsPerCase = 0.02;
+            settings.minRuns = 2;
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (salamanderSfz == juce::File())
+        salamanderSfz = findSalamander();
+
+    BenchmarkRunner runner(settings);
+
+    Benchmarks::runVoiceRendering(runner);
+    Benchmarks::runNoteOnDispatch(runner);
+    Benchmarks::runLoading(runner, salamanderSfz);
+    Benchmarks::runSampleDecoding(runner);
+    Benchmarks::runMasterBus(runner);
+
+    const auto json = runner.toJSON();
+
+    if (outputFile == juce::File())
+        std::cout << json << std::endl;
+    else if (!outputFile.replaceWithText(json))
+    {
+        std::cerr << "Can't write " << outputFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    if (baselineFile != juce::File())
+    {
+        const auto baseline = juce::JSON::parse(baselineFile);
+
+        if (baseline.isVoid())
+        {
+            std::cerr << "Can't read " << baselineFile.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        const auto regressions = runner.findRegressions(baseline, tolerance);
+
+        for (auto& line : regressions)
+            std::cerr << "REGRESSION " << line << std::endl;
+
+        if (!regressions.isEmpty())
+            return 2;
+    }
+
+    return 0;
+}
\ No newline at end of file
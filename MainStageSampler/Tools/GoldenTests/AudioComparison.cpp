@@ -0,0 +1,203 @@
+/*
+  ==============================================================================
+
+    AudioComparison.cpp
+    Created: Tolerance and spectral checks between two renders
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "AudioComparison.h"
+
+namespace
+{
+    constexpr int fftOrder = 12;
+    constexpr int fftSize = 1 << fftOrder;
+
+    double toDecibels(double power)
+    {
+        return 10.0 * std::log10(juce::jmax(power, 1.0e-30));
+    }
+}
+
+//==============================================================================
+AudioComparison::Tolerance AudioComparison::getExactTolerance()
+{
+    Tolerance tolerance;
+    tolerance.maxSampleError = 1.0e-6f;
+    tolerance.maxResidualDb = -120.0;
+    tolerance.maxBandDifferenceDb = 0.01;
+    return tolerance;
+}
+
+juce::String AudioComparison::Result::toString() const
+{
+    juce::String text;
+    text << "max error " << juce::String(juce::Decibels::gainToDecibels(maxSampleError, -200.0f), 1) << " dBFS"
+         << " (channel " << worstChannel << ", sample " << worstSample << "), residual "
+         << juce::String(residualDb, 1) << " dB, worst band " << juce::String(worstBandDifferenceDb, 2)
+         << " dB at " << juce::String(worstBandFrequency, 0) << " Hz";
+
+    if (failure.isNotEmpty())
+        text << " - " << failure;
+
+    return text;
+}
+
+AudioComparison::Result AudioComparison::compare(const juce::AudioBuffer<float>& reference, const juce::AudioBuffer<float>& test,
+    double sampleRate, const Tolerance& tolerance)
+{
+    Result result;
+
+    if (reference.getNumChannels() != test.getNumChannels() || reference.getNumSamples() != test.getNumSamples())
+    {
+        result.failure = "shape differs: " + juce::String(test.getNumChannels()) + " x " + juce::String(test.getNumSamples())
+                       + " against " + juce::String(reference.getNumChannels()) + " x " + juce::String(reference.getNumSamples());
+        return result;
+    }
+
+    // Sample by sample, and the residual it leaves
+    double referencePower = 0.0, residualPower = 0.0;
+
+    for (int channel = 0; channel < reference.getNumChannels(); ++channel)
+    {
+        const auto* expected = reference.getReadPointer(channel);
+        const auto* actual = test.getReadPointer(channel);
+
+        for (int i = 0; i < reference.getNumSamples(); ++i)
+        {
+            const auto error = std::abs(actual[i] - expected[i]);
+
+            if (error > result.maxSampleError)
+            {
+                result.maxSampleError = error;
+                result.worstSample = i;
+                result.worstChannel = channel;
+            }
+
+            referencePower += (double)expected[i] * expected[i];
+            residualPower += (double)error * error;
+        }
+    }
+
+    result.residualDb = residualPower > 0.0 ? toDecibels(residualPower) - toDecibels(referencePower) : -200.0;
+
+    // Band by band
+    juce::Array<double> centres;
+    const auto expectedBands = getBandLevels(reference, sampleRate, centres);
+    const auto actualBands = getBandLevels(test, sampleRate, centres);
+
+    double loudest = -300.0;
+    for (auto level : expectedBands)
+        loudest = juce::jmax(loudest, level);
+
+    for (int band = 0; band < expectedBands.size(); ++band)
+    {
+        if (expectedBands[band] < loudest + tolerance.bandFloorDb && actualBands[band] < loudest + tolerance.bandFloorDb)
+            continue;
+
+        const auto difference = actualBands[band] - expectedBands[band];
+
+        if (std::abs(difference) > std::abs(result.worstBandDifferenceDb))
+        {
+            result.worstBandDifferenceDb = difference;
+            result.worstBandFrequency = centres[band];
+        }
+    }
+
+    if (result.maxSampleError > tolerance.maxSampleError)
+        result.failure = "sample error over " + juce::String(juce::Decibels::gainToDecibels(tolerance.maxSampleError), 1) + " dBFS";
+    else if (result.residualDb > tolerance.maxResidualDb)
+        result.failure = "residual over " + juce::String(tolerance.maxResidualDb, 1) + " dB";
+    else if (std::abs(result.worstBandDifferenceDb) > tolerance.maxBandDifferenceDb)
+        result.failure = "spectrum off by more than " + juce::String(tolerance.maxBandDifferenceDb, 2) + " dB";
+    else
+        result.passed = true;
+
+    return result;
+}
+
+//==============================================================================
+juce::Array<double> AudioComparison::getBandLevels(const juce::AudioBuffer<float>& audio, double sampleRate, juce::Array<double>& centres)
+{
+    // Hann windowed frames overlapping by half, power averaged over the whole render
+    juce::dsp::FFT fft(fftOrder);
+    juce::dsp::WindowingFunction<float> window((size_t)fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+    std::vector<float> frame((size_t)fftSize * 2);
+    std::vector<double> power((size_t)fftSize / 2 + 1, 0.0);
+    int numFrames = 0;
+
+    for (int start = 0; start + fftSize <= juce::jmax(fftSize, audio.getNumSamples()); start += fftSize / 2)
+    {
+        for (int channel = 0; channel < juce::jmin(2, audio.getNumChannels()); ++channel)
+        {
+            std::fill(frame.begin(), frame.end(), 0.0f);
+            const auto numToCopy = juce::jmin(fftSize, audio.getNumSamples() - start);
+
+            if (numToCopy > 0)
+                std::copy(audio.getReadPointer(channel, start), audio.getReadPointer(channel, start) + numToCopy, frame.begin());
+
+            window.multiplyWithWindowingTable(frame.data(), (size_t)fftSize);
+            fft.performFrequencyOnlyForwardTransform(frame.data(), true);
+
+            for (size_t bin = 0; bin < power.size(); ++bin)
+                power[bin] += (double)frame[bin] * frame[bin];
+        }
+
+        ++numFrames;
+    }
+
+    // Third octaves from 25 Hz, summing the bins whose centres fall in each
+    juce::Array<double> levels;
+    centres.clearQuick();
+
+    const auto binWidth = sampleRate / fftSize;
+    const auto top = juce::jmin(20000.0, sampleRate * 0.45);
+
+    for (double centre = 25.0; centre <= top; centre *= std::pow(2.0, 1.0 / 3.0))
+    {
+        const auto lowEdge = centre * std::pow(2.0, -1.0 / 6.0), highEdge = centre * std::pow(2.0, 1.0 / 6.0);
+        double bandPower = 0.0;
+
+        for (auto bin = (size_t)std::ceil(lowEdge / binWidth); bin < power.size() && bin * binWidth < highEdge; ++bin)
+            bandPower += power[bin];
+
+        centres.add(centre);
+        levels.add(toDecibels(bandPower / juce::jmax(1, numFrames)));
+    }
+
+    return levels;
+}
+
+float AudioComparison::getTruePeak(const juce::AudioBuffer<float>& audio, int startSample)
+{
+    const auto numSamples = audio.getNumSamples() - startSample;
+    if (numSamples <= 0)
+        return 0.0f;
+
+    const auto numChannels = juce::jmin(2, audio.getNumChannels());
+
+    // Two 2x stages of linear phase filtering, as a meter following BS.1770 would
+    juce::dsp::Oversampling<float> oversampling((size_t)numChannels, 2,
+        juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple, true, true);
+    oversampling.initProcessing((size_t)numSamples);
+
+    juce::AudioBuffer<float> input(numChannels, numSamples);
+    for (int channel = 0; channel < numChannels; ++channel)
+        input.copyFrom(channel, 0, audio, channel, startSample, numSamples);
+
+    juce::dsp::AudioBlock<float> block(input);
+    auto upsampled = oversampling.processSamplesUp(block);
+
+    float peak = 0.0f;
+    for (size_t channel = 0; channel < upsampled.getNumChannels(); ++channel)
+    {
+        const auto* samples = upsampled.getChannelPointer(channel);
+
+        for (size_t i = 0; i < upsampled.getNumSamples(); ++i)
+            peak = juce::jmax(peak, std::abs(samples[i]));
+    }
+
+    return peak;
+}
\ No newline at end of file
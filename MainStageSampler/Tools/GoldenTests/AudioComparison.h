@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    AudioComparison.h
+    Created: Tolerance and spectral checks between two renders
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Checks that a render matches a reference closely enough to sound the same.
+
+    Three checks, from strictest to most forgiving:
+      - no sample may differ by more than maxSampleError
+      - the difference signal must sit maxResidualDb below the reference
+      - the average spectrum, in third-octave bands, must match within maxBandDifferenceDb
+
+    The first catches clicks and misplaced events, the second small errors spread over
+    the whole render, and the third changes in tone that a tighter check would flag as
+    a failure anyway but gives no clue about.
+*/
+namespace AudioComparison
+{
+    struct Tolerance
+    {
+        float maxSampleError = 1.0e-4f;         // about -80 dBFS
+        double maxResidualDb = -80.0;           // difference against the reference, RMS
+        double maxBandDifferenceDb = 0.1;
+        double bandFloorDb = -90.0;             // bands this far below the loudest aren't compared
+    };
+
+    /** Tolerance for renders that should be identical but for float rounding */
+    Tolerance getExactTolerance();
+
+    struct Result
+    {
+        bool passed = false;
+        juce::String failure;               // why it didn't, if it didn't
+
+        float maxSampleError = 0.0f;
+        int worstSample = 0;
+        int worstChannel = 0;
+        double residualDb = -200.0;
+        double worstBandDifferenceDb = 0.0;
+        double worstBandFrequency = 0.0;
+
+        juce::String toString() const;
+    };
+
+    /** Compares a render against a reference of the same length and channel count */
+    Result compare(const juce::AudioBuffer<float>& reference, const juce::AudioBuffer<float>& test,
+        double sampleRate, const Tolerance& tolerance);
+
+    /** Returns the average power in third-octave bands from 25 Hz up to 20 kHz (or Nyquist),
+        in dB, both channels together. The bands' centre frequencies go in centres.
+    */
+    juce::Array<double> getBandLevels(const juce::AudioBuffer<float>& audio, double sampleRate, juce::Array<double>& centres);
+
+    /** Returns the highest true peak of the first two channels, measured at four times the
+        sample rate, as a linear level.
+    */
+    float getTruePeak(const juce::AudioBuffer<float>& audio, int startSample = 0);
+}
\ No newline at end of file
@@ -0,0 +1,549 @@
+/*
+  ==============================================================================
+
+    GoldenTests.cpp
+    Created: Renders fixed MIDI through the engine and checks it still sounds the same
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "GoldenTests.h"
+#include "OfflineRenderer.h"
+#include "MasterEQ.h"
+#include "MasterLimiter.h"
+#include "RealtimeSupport.h"
+
+namespace
+{
+    constexpr double sampleFileRate = 44100.0;   // not the render rate, so every voice resamples
+    constexpr int sampleFileFrames = 66150;      // 1.5 seconds
+    constexpr double tailSeconds = 2.0;
+
+    //==============================================================================
+    /** A decaying harmonic tone, brighter as brightness goes from 0 to 1, rounded to 24 bits */
+    juce::AudioBuffer<float> makeTone(double frequency, double brightness, int seed, int delayFrames = 0, float level = 1.0f)
+    {
+        juce::AudioBuffer<float> audio(2, sampleFileFrames);
+        audio.clear();
+        juce::Random random(seed);
+
+        constexpr double scale = (double)((1 << 23) - 1);
+
+        for (int i = delayFrames; i < sampleFileFrames; ++i)
+        {
+            const auto t = (i - delayFrames) / sampleFileRate;
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                double value = 0.0;
+
+                for (int partial = 1; partial <= 8; ++partial)
+                {
+                    const auto amplitude = std::pow(0.3 + 0.6 * brightness, partial - 1) / partial;
+                    const auto decay = std::exp(-t * (0.4 + 0.3 * partial));
+                    const auto phase = juce::MathConstants<double>::twoPi * frequency * partial * t + channel * 0.3 * partial;
+                    value += amplitude * decay * std::sin(phase);
+                }
+
+                value = level * (0.35 * value + 0.002 * (random.nextDouble() - 0.5));
+                audio.setSample(channel, i, (float)(std::round(value * scale) / scale));
+            }
+        }
+
+        return audio;
+    }
+
+    /** A short burst of filtered noise, for a one-shot region */
+    juce::AudioBuffer<float> makeClick(int seed)
+    {
+        juce::AudioBuffer<float> audio(2, 4410);
+        juce::Random random(seed);
+        float state = 0.0f;
+
+        for (int i = 0; i < audio.getNumSamples(); ++i)
+        {
+            state += 0.3f * ((random.nextFloat() - 0.5f) - state);
+            const auto value = state * std::exp(-(float)i / 600.0f);
+            audio.setSample(0, i, value);
+            audio.setSample(1, i, -value);
+        }
+
+        return audio;
+    }
+
+    void writeSample(const juce::File& directory, const juce::String& name, const juce::AudioBuffer<float>& audio)
+    {
+        juce::String error;
+        if (!OfflineRenderer::writeWavFile(directory.getChildFile(name), audio, sampleFileRate, 24, error))
+            std::cerr << error << std::endl;
+    }
+
+    /** Writes the test library: three keyzones of two velocity layers, a one-shot, and
+        a multi-mic keyzone in two SFZ files, one with its other mics and one without.
+    */
+    void writeTestLibrary(const juce::File& directory)
+    {
+        auto samples = directory.getChildFile("samples");
+        samples.createDirectory();
+
+        const struct { const char* name; int root; } zones[] = { { "c3", 48 }, { "c4", 60 }, { "c5", 72 } };
+        int seed = 1;
+
+        for (auto& zone : zones)
+        {
+            const auto frequency = juce::MidiMessage::getMidiNoteInHertz(zone.root);
+            writeSample(samples, juce::String("soft_") + zone.name + ".wav", makeTone(frequency, 0.2, seed++));
+            writeSample(samples, juce::String("loud_") + zone.name + ".wav", makeTone(frequency, 0.9, seed++));
+        }
+
+        writeSample(samples, "click.wav", makeClick(seed++));
+
+        // The other mics hear the same tone later and quieter
+        const auto c4 = juce::MidiMessage::getMidiNoteInHertz(60);
+        writeSample(samples, "close_c4.wav", makeTone(c4, 0.5, seed));
+        writeSample(samples, "overhead_c4.wav", makeTone(c4, 0.4, seed, 40, 0.6f));
+        writeSample(samples, "room_c4.wav", makeTone(c4, 0.3, seed, 200, 0.4f));
+
+        juce::String text;
+        text << "// Generated by GoldenTests - changing this changes every golden render\n"
+             << "<control> default_path=samples/\n"
+             << "<global> ampeg_release=0.3\n"
+             << "<group> lovel=0 hivel=79 ampeg_attack=0.002 ampeg_decay=1.0 ampeg_sustain=50\n"
+             << "<region> sample=soft_c3.wav lokey=36 hikey=53 pitch_keycenter=48 loop_mode=loop_continuous loop_start=22050 loop_end=66149 loop_crossfade=0.05\n"
+             << "<region> sample=soft_c4.wav lokey=54 hikey=65 pitch_keycenter=60\n"
+             << "<region> sample=soft_c5.wav lokey=66 hikey=84 pitch_keycenter=72 tune=-7\n"
+             << "<group> lovel=80 hivel=127 ampeg_hold=0.05 fil_type=lpf_2p cutoff=5000 resonance=3 fil_veltrack=1200\n"
+             << "<region> sample=loud_c3.wav lokey=36 hikey=53 pitch_keycenter=48 loop_mode=loop_sustain loop_start=22050 loop_end=66149\n"
+             << "<region> sample=loud_c4.wav lokey=54 hikey=65 pitch_keycenter=60 volume=-3 pan=-30\n"
+             << "<region> sample=loud_c5.wav lokey=66 hikey=84 pitch_keycenter=72\n"
+             << "<group>\n"
+             << "<region> sample=click.wav key=90 loop_mode=one_shot\n";
+
+        directory.getChildFile("golden.sfz").replaceWithText(text);
+
+        const juce::String multiMicRegion = "<region> sample=close_c4.wav lokey=54 hikey=65 pitch_keycenter=60 ampeg_release=0.5";
+        directory.getChildFile("multimic.sfz").replaceWithText("<control> default_path=samples/\n" + multiMicRegion
+            + " sample_overhead=overhead_c4.wav sample_room=room_c4.wav\n");
+        directory.getChildFile("closeonly.sfz").replaceWithText("<control> default_path=samples/\n" + multiMicRegion + "\n");
+    }
+
+    //==============================================================================
+    void addNote(juce::MidiMessageSequence& sequence, int note, int velocity, double start, double length)
+    {
+        sequence.addEvent(juce::MidiMessage::noteOn(1, note, (juce::uint8)velocity), start);
+        sequence.addEvent(juce::MidiMessage::noteOff(1, note), start + length);
+    }
+
+    /** Every keyzone and layer, one note at a time, ending on the one-shot */
+    juce::MidiMessageSequence makeScale()
+    {
+        juce::MidiMessageSequence sequence;
+
+        for (int i = 0; i < 13; ++i)
+            addNote(sequence, 36 + 4 * i, i % 2 == 0 ? 50 : 110, 0.3 * i, 0.25);
+
+        addNote(sequence, 90, 100, 4.0, 0.05);
+        sequence.updateMatchedPairs();
+        return sequence;
+    }
+
+    /** Chords held by the sustain pedal, then one after it's lifted */
+    juce::MidiMessageSequence makePedalChords()
+    {
+        juce::MidiMessageSequence sequence;
+        sequence.addEvent(juce::MidiMessage::controllerEvent(1, 64, 127), 0.0);
+
+        for (auto note : { 48, 55, 60, 64 })
+            addNote(sequence, note, 70, 0.0, 0.4);
+
+        for (auto note : { 50, 57, 62, 65 })
+            addNote(sequence, note, 100, 0.6, 0.4);
+
+        sequence.addEvent(juce::MidiMessage::controllerEvent(1, 64, 0), 1.8);
+
+        for (auto note : { 60, 64, 67, 72 })
+            addNote(sequence, note, 120, 2.0, 0.5);
+
+        sequence.updateMatchedPairs();
+        return sequence;
+    }
+
+    /** Fast repeats of one key, rising in velocity, so voices are stolen and layers change */
+    juce::MidiMessageSequence makeRepeatedNotes()
+    {
+        juce::MidiMessageSequence sequence;
+
+        for (int i = 0; i < 24; ++i)
+            addNote(sequence, 60, 20 + i * 107 / 23, 0.04 * i, 0.03);
+
+        sequence.updateMatchedPairs();
+        return sequence;
+    }
+
+    struct Sequence
+    {
+        const char* name;
+        juce::MidiMessageSequence (*make)();
+    };
+
+    const Sequence sequences[] =
+    {
+        { "scale", makeScale },
+        { "pedal_chords", makePedalChords },
+        { "repeated_notes", makeRepeatedNotes }
+    };
+
+    /** The master bus effects that are off by default, turned on for the chords so they're covered too */
+    void useEffects(SamplerEngine& engine)
+    {
+        auto& parameters = engine.getParameters();
+        parameters.set(ParameterStore::chorusAmount, 0.3f);
+        parameters.set(ParameterStore::width, 0.7f);
+        parameters.set(ParameterStore::eqPresence, 3.0f);
+        engine.setReverbRoom(ConvolutionReverb::RoomType::chamber, 0.5f);
+        parameters.set(ParameterStore::reverbAmount, 0.25f);
+    }
+
+    bool readWavFile(const juce::File& file, juce::AudioBuffer<float>& audio)
+    {
+        if (!file.existsAsFile())
+            return false;
+
+        juce::WavAudioFormat wavFormat;
+        std::unique_ptr<juce::AudioFormatReader> reader(wavFormat.createReaderFor(file.createInputStream().release(), true));
+
+        if (reader == nullptr)
+            return false;
+
+        audio.setSize((int)reader->numChannels, (int)reader->lengthInSamples);
+        return reader->read(&audio, 0, audio.getNumSamples(), 0, true, true);
+    }
+}
+
+//==============================================================================
+GoldenTests::GoldenTests(const Settings& settingsToUse)
+    : settings(settingsToUse)
+{
+    libraryDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+        .getChildFile("GoldenTests_" + juce::String::toHexString(juce::Random::getSystemRandom().nextInt()));
+    libraryDirectory.createDirectory();
+    writeTestLibrary(libraryDirectory);
+}
+
+GoldenTests::~GoldenTests()
+{
+    libraryDirectory.deleteRecursively();
+}
+
+int GoldenTests::runAll()
+{
+    numFailed = 0;
+    numSkipped = 0;
+
+    runGoldenRenders();
+    runPathEquivalence();
+    runMultiMicEquivalence();
+    runEQResponse();
+    runLimiterTruePeak();
+    runPageFaults();
+
+    return numFailed;
+}
+
+//==============================================================================
+juce::AudioBuffer<float> GoldenTests::render(const RenderSetup& setup, const juce::MidiMessageSequence& sequence)
+{
+    SamplerEngine engine;
+    engine.setLoadOptions(setup.loadOptions);
+    engine.setResidencyOptions({ false, false });
+    engine.loadSampleSet(libraryDirectory.getChildFile(setup.sfzName + ".sfz"));
+
+    if (setup.configure != nullptr)
+        setup.configure(engine);
+
+    OfflineRenderer::Settings renderSettings;
+    renderSettings.sampleRate = sampleRate;
+    renderSettings.blockSize = setup.blockSize;
+    renderSettings.tailSeconds = tailSeconds;
+
+    juce::AudioBuffer<float> output;
+    OfflineRenderer(engine).render(sequence, renderSettings, output);
+    return output;
+}
+
+bool GoldenTests::isSelected(const juce::String& name) const
+{
+    return settings.filter.isEmpty() || name.contains(settings.filter);
+}
+
+void GoldenTests::report(const juce::String& name, bool passed, const juce::String& detail)
+{
+    if (!passed)
+        ++numFailed;
+
+    std::cout << (passed ? "PASS  " : "FAIL  ") << name.paddedRight(' ', 36) << detail << std::endl;
+}
+
+void GoldenTests::skip(const juce::String& name, const juce::String& reason)
+{
+    ++numSkipped;
+    std::cout << "SKIP  " << name.paddedRight(' ', 36) << reason << std::endl;
+}
+
+void GoldenTests::compareRenders(const juce::String& name, const juce::AudioBuffer<float>& reference,
+    const juce::AudioBuffer<float>& test, const AudioComparison::Tolerance& tolerance)
+{
+    const auto result = AudioComparison::compare(reference, test, sampleRate, tolerance);
+    report(name, result.passed, result.toString());
+
+    if (!result.passed)
+        saveFailure(name, test);
+}
+
+void GoldenTests::saveFailure(const juce::String& name, const juce::AudioBuffer<float>& audio)
+{
+    if (settings.failureDirectory == juce::File())
+        return;
+
+    settings.failureDirectory.createDirectory();
+
+    juce::String error;
+    OfflineRenderer::writeWavFile(settings.failureDirectory.getChildFile(name.replaceCharacter('/', '_') + ".wav"),
+        audio, sampleRate, 32, error);
+}
+
+//==============================================================================
+void GoldenTests::runGoldenRenders()
+{
+    for (auto& sequence : sequences)
+    {
+        const auto name = juce::String("golden/") + sequence.name;
+        if (!isSelected(name))
+            continue;
+
+        RenderSetup setup;
+        if (juce::String(sequence.name) == "pedal_chords")
+            setup.configure = useEffects;
+
+        const auto audio = render(setup, sequence.make());
+        const auto goldenFile = settings.goldenDirectory.getChildFile(juce::String(sequence.name) + ".wav");
+
+        if (settings.recordGoldens)
+        {
+            juce::String error;
+            settings.goldenDirectory.createDirectory();
+            const auto written = OfflineRenderer::writeWavFile(goldenFile, audio, sampleRate, 32, error);
+            report(name, written, written ? "recorded " + goldenFile.getFileName() : error);
+            continue;
+        }
+
+        juce::AudioBuffer<float> golden;
+        if (!readWavFile(goldenFile, golden))
+        {
+            report(name, false, "no golden render at " + goldenFile.getFullPathName() + " - record one with --record");
+            continue;
+        }
+
+        // Other compilers and CPUs round differently, so a little slack over the exact tolerance
+        compareRenders(name, golden, audio, {});
+    }
+}
+
+void GoldenTests::runPathEquivalence()
+{
+    struct Variant
+    {
+        const char* name;
+        std::function<void(RenderSetup&)> apply;
+        bool exact;
+    };
+
+    // Each is the reference path but for one thing, which must not change the sound
+    const Variant variants[] =
+    {
+        { "interleaved", [](RenderSetup& s) { s.loadOptions.interleaveSamples = true; }, true },
+        { "compressed", [](RenderSetup& s) { s.loadOptions.compressSamples = true; }, true },
+        { "block_64", [](RenderSetup& s) { s.blockSize = 64; }, false },
+        { "block_997", [](RenderSetup& s) { s.blockSize = 997; }, false }
+    };
+
+    for (auto& sequence : sequences)
+    {
+        juce::AudioBuffer<float> reference;
+
+        for (auto& variant : variants)
+        {
+            const auto name = juce::String("equivalence/") + sequence.name + "/" + variant.name;
+            if (!isSelected(name))
+                continue;
+
+            RenderSetup setup;
+            if (juce::String(sequence.name) == "pedal_chords")
+                setup.configure = useEffects;
+
+            if (reference.getNumSamples() == 0)
+                reference = render(setup, sequence.make());
+
+            variant.apply(setup);
+            compareRenders(name, reference, render(setup, sequence.make()),
+                variant.exact ? AudioComparison::getExactTolerance() : AudioComparison::Tolerance());
+        }
+    }
+}
+
+void GoldenTests::runMultiMicEquivalence()
+{
+    const juce::String name = "equivalence/multi_mic_close_only";
+    if (!isSelected(name))
+        return;
+
+    // With the other mics at zero, a multi-mic region must play exactly as its close mic alone
+    RenderSetup closeOnly;
+    closeOnly.sfzName = "closeonly";
+
+    RenderSetup multiMic;
+    multiMic.sfzName = "multimic";
+    multiMic.configure = [](SamplerEngine& engine)
+        {
+            engine.getParameters().set(ParameterStore::overheadMic, 0.0f);
+            engine.getParameters().set(ParameterStore::roomMic, 0.0f);
+        };
+
+    juce::MidiMessageSequence sequence;
+    for (int i = 0; i < 6; ++i)
+        addNote(sequence, 55 + 2 * i, 40 + 15 * i, 0.2 * i, 0.5);
+    sequence.updateMatchedPairs();
+
+    compareRenders(name, render(closeOnly, sequence), render(multiMic, sequence), AudioComparison::getExactTolerance());
+}
+
+//==============================================================================
+void GoldenTests::runEQResponse()
+{
+    const juce::String name = "processor/master_eq_response";
+    if (!isSelected(name))
+        return;
+
+    const float gains[MasterEQ::numBands] = { 6.0f, -4.0f, 3.0f, -6.0f };
+    constexpr int order = 14, size = 1 << order;
+
+    MasterEQ eq;
+    for (int band = 0; band < MasterEQ::numBands; ++band)
+        eq.setBandGain((MasterEQ::Band)band, gains[band]);
+
+    eq.prepare(sampleRate, 256);
+
+    // Impulse response, a block at a time as the engine would run it
+    juce::AudioBuffer<float> impulse(2, size);
+    impulse.clear();
+    impulse.setSample(0, 0, 1.0f);
+    impulse.setSample(1, 0, 1.0f);
+
+    for (int start = 0; start < size; start += 256)
+    {
+        juce::AudioBuffer<float> block(impulse.getArrayOfWritePointers(), 2, start, 256);
+        eq.process(block, 0, 256);
+    }
+
+    std::vector<float> spectrum((size_t)size * 2, 0.0f);
+    std::copy(impulse.getReadPointer(0), impulse.getReadPointer(0) + size, spectrum.begin());
+    juce::dsp::FFT(order).performFrequencyOnlyForwardTransform(spectrum.data(), true);
+
+    // Compare at bins spread evenly in log frequency, against the design curve
+    double worstDb = 0.0, worstFrequency = 0.0;
+
+    for (double frequency = 30.0; frequency < 18000.0; frequency *= 1.1)
+    {
+        const auto bin = juce::roundToInt(frequency * size / sampleRate);
+        const auto binFrequency = bin * sampleRate / size;
+
+        const auto measuredDb = juce::Decibels::gainToDecibels((double)spectrum[(size_t)bin], -200.0);
+        const auto expectedDb = juce::Decibels::gainToDecibels(MasterEQ::getMagnitudeForFrequency(gains, binFrequency, sampleRate), -200.0);
+
+        if (std::abs(measuredDb - expectedDb) > std::abs(worstDb))
+        {
+            worstDb = measuredDb - expectedDb;
+            worstFrequency = binFrequency;
+        }
+    }
+
+    report(name, std::abs(worstDb) <= 0.1,
+        "worst " + juce::String(worstDb, 3) + " dB from the design curve at " + juce::String(worstFrequency, 0) + " Hz");
+}
+
+void GoldenTests::runLimiterTruePeak()
+{
+    const juce::String name = "processor/limiter_true_peak";
+    if (!isSelected(name))
+        return;
+
+    constexpr float ceilingDb = -1.0f;
+    constexpr int blockSize = 256, numSamples = 2 * (int)sampleRate;
+
+    // A tone at a quarter of the sample rate, phased so every sample misses the peak by 3 dB,
+    // pushed 6 dB over full scale with drum-like bursts on top
+    juce::AudioBuffer<float> audio(2, numSamples);
+    juce::Random random(7);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto tone = 2.0 * std::sin(juce::MathConstants<double>::halfPi * i + juce::MathConstants<double>::pi / 4.0);
+        const auto burst = (i % 12000) < 600 ? 3.0 * (random.nextDouble() - 0.5) * std::exp(-(i % 12000) / 150.0) : 0.0;
+
+        audio.setSample(0, i, (float)(tone + burst));
+        audio.setSample(1, i, (float)(0.7 * tone - burst));
+    }
+
+    MasterLimiter limiter;
+    limiter.setCeiling(ceilingDb);
+    limiter.prepare(sampleRate, blockSize);
+
+    for (int start = 0; start < numSamples; start += blockSize)
+        limiter.process(audio, start, juce::jmin(blockSize, numSamples - start));
+
+    // Some slack for the meter's own filters
+    const auto peakDb = juce::Decibels::gainToDecibels(AudioComparison::getTruePeak(audio, limiter.getLatencySamples()));
+    report(name, peakDb <= ceilingDb + 0.2f,
+        "true peak " + juce::String(peakDb, 2) + " dBTP against a ceiling of " + juce::String(ceilingDb, 1) + " dBTP");
+}
+
+//==============================================================================
+void GoldenTests::runPageFaults()
+{
+    const juce::String name = "residency/no_major_faults_after_warm_up";
+    if (!isSelected(name))
+        return;
+
+    SamplerEngine engine;
+    engine.setResidencyOptions({ true, false });
+    engine.loadSampleSet(libraryDirectory.getChildFile("golden.sfz"));
+
+    OfflineRenderer::Settings renderSettings;
+    renderSettings.sampleRate = sampleRate;
+    renderSettings.tailSeconds = tailSeconds;
+
+    // One note pages in the render code, so whatever faults after that is sample memory
+    // the prefault stage missed - every keyzone and layer is played once it's done
+    juce::MidiMessageSequence warmUp;
+    addNote(warmUp, 60, 100, 0.0, 0.1);
+    warmUp.updateMatchedPairs();
+
+    juce::AudioBuffer<float> output;
+    OfflineRenderer renderer(engine);
+    renderer.render(warmUp, renderSettings, output);
+
+    const auto faultsBefore = RealtimeThread::getMajorPageFaults();
+
+    if (faultsBefore < 0)
+    {
+        skip(name, "major page faults aren't reported on this platform");
+        return;
+    }
+
+    renderer.render(makeScale(), renderSettings, output);
+    renderer.render(makePedalChords(), renderSettings, output);
+
+    const auto newFaults = RealtimeThread::getMajorPageFaults() - faultsBefore;
+    report(name, newFaults == 0, juce::String(newFaults) + " major page faults while rendering");
+}
\ No newline at end of file
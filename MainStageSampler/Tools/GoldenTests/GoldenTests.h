@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    GoldenTests.h
+    Created: Renders fixed MIDI through the engine and checks it still sounds the same
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SamplerEngine.h"
+#include "AudioComparison.h"
+
+//==============================================================================
+/**
+    Regression tests for the sound of the engine.
+
+    A small SFZ of generated samples is written to a temporary folder, then fixed
+    MIDI sequences are rendered through it with OfflineRenderer. There are three
+    kinds of test:
+
+      - golden renders, compared against WAV files recorded from a known good build
+        and kept in Tools/GoldenTests/Golden. A missing one is a failure.
+      - equivalence tests, where each alternative path through the engine (sample
+        storage, block size, multi-mic) is compared against the reference path
+      - checks of single processors against what they're meant to do
+      - a check that, once warmed up, rendering takes no major page faults
+
+    Everything is generated from fixed seeds and rendered in non-real-time mode,
+    so a render only changes when the code does.
+*/
+class GoldenTests
+{
+public:
+    //==============================================================================
+    struct Settings
+    {
+        /** Where the golden renders are kept */
+        juce::File goldenDirectory;
+
+        /** Record new golden renders rather than checking against them */
+        bool recordGoldens = false;
+
+        /** Only run tests whose name contains this */
+        juce::String filter;
+
+        /** Where renders that fail are written for listening to. Nothing is written if this isn't set. */
+        juce::File failureDirectory;
+    };
+
+    explicit GoldenTests(const Settings& settingsToUse);
+    ~GoldenTests();
+
+    /** Runs the selected tests, printing a line for each. Returns the number that failed. */
+    int runAll();
+
+    /** Returns the number of tests the last runAll() couldn't run on this platform */
+    int getNumSkipped() const noexcept { return numSkipped; }
+
+    static constexpr double sampleRate = 48000.0;
+
+private:
+    //==============================================================================
+    /** How one render is set up. The defaults are the reference path. */
+    struct RenderSetup
+    {
+        juce::String sfzName = "golden";
+        EnhancedSFZLoader::LoadOptions loadOptions;
+        int blockSize = 256;
+        std::function<void(SamplerEngine&)> configure;
+    };
+
+    juce::AudioBuffer<float> render(const RenderSetup& setup, const juce::MidiMessageSequence& sequence);
+
+    bool isSelected(const juce::String& name) const;
+    void report(const juce::String& name, bool passed, const juce::String& detail);
+    void skip(const juce::String& name, const juce::String& reason);
+    void compareRenders(const juce::String& name, const juce::AudioBuffer<float>& reference,
+        const juce::AudioBuffer<float>& test, const AudioComparison::Tolerance& tolerance);
+    void saveFailure(const juce::String& name, const juce::AudioBuffer<float>& audio);
+
+    void runGoldenRenders();
+    void runPathEquivalence();
+    void runMultiMicEquivalence();
+    void runEQResponse();
+    void runLimiterTruePeak();
+    void runPageFaults();
+
+    Settings settings;
+    juce::File libraryDirectory;
+    int numFailed = 0;
+    int numSkipped = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GoldenTests)
+};
\ No newline at end of file
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: Command line front end for the golden render tests
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "GoldenTests.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: GoldenTests [options]" << std::endl
+                  << "  --golden <dir>      where the golden renders are kept (default: Tools/GoldenTests/Golden)" << std::endl
+                  << "  --record            record new golden renders instead of checking against them" << std::endl
+                  << "  --filter <text>     only run tests whose name contains this" << std::endl
+                  << "  --failures <dir>    write renders that fail here, to listen to" << std::endl;
+    }
+
+    /** Looks for the golden renders beside this tool's source, above the working directory or the executable */
+    juce::File findGoldenDirectory()
+    {
+        const juce::String relativePath = "Tools/GoldenTests/Golden";
+
+        for (auto start : { juce::File::getCurrentWorkingDirectory(),
+                            juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory() })
+        {
+            for (auto directory = start; directory != directory.getParentDirectory(); directory = directory.getParentDirectory())
+            {
+                for (auto candidate : { directory.getChildFile(relativePath), directory.getChildFile("MainStageSampler").getChildFile(relativePath) })
+                    if (candidate.isDirectory())
+                        return candidate;
+            }
+        }
+
+        return juce::File::getCurrentWorkingDirectory().getChildFile(relativePath);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    GoldenTests::Settings settings;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--golden" && hasValue)          settings.goldenDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else if (arg == "--record")                 settings.recordGoldens = true;
+        else if (arg == "--filter" && hasValue)     settings.filter = argv[++i];
+        else if (arg == "--failures" && hasValue)   settings.failureDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (settings.goldenDirectory == juce::File())
+        settings.goldenDirectory = findGoldenDirectory();
+
+    GoldenTests tests(settings);
+    const auto numFailed = tests.runAll();
+    const auto numSkipped = tests.getNumSkipped();
+
+    const auto skipped = numSkipped > 0 ? " (" + juce::String(numSkipped) + " skipped)" : juce::String();
+
+    std::cout << (numFailed == 0 ? juce::String("All tests passed") : juce::String(numFailed) + " failed") << skipped << std::endl;
+    return numFailed == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,436 @@
+/*
+  ==============================================================================
+
+    LatencyHarness.cpp
+    Created: Measures the time from a key going down to the first sample of its note
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "LatencyHarness.h"
+#include "OfflineRenderer.h"
+
+namespace
+{
+    constexpr double noteLengthMs = 30.0;
+    constexpr double noteSpacingMs = 120.0;    // room for the release to die away before the next note
+    constexpr double warmupMs = 200.0;
+
+    double nowMs()
+    {
+        return juce::Time::getMillisecondCounterHiRes();
+    }
+
+    /** Sleeps most of the way, then spins, so the wake-up is well inside a millisecond */
+    void waitUntil(double targetMs)
+    {
+        for (;;)
+        {
+            const auto remaining = targetMs - nowMs();
+
+            if (remaining <= 0.0)
+                return;
+
+            if (remaining > 2.0)
+                juce::Thread::sleep(1);
+            else
+                juce::Thread::yield();
+        }
+    }
+
+    //==============================================================================
+    /** Calls back at the block rate on the wall clock, as an audio device does, and records what comes out */
+    class DeviceThread : public juce::Thread
+    {
+    public:
+        DeviceThread(SamplerEngine& engineToUse, NoteInput& noteInputToUse, juce::AudioBuffer<float>& recordingToFill,
+            double firstCallbackMs, double blockPeriodMs, int samplesPerBlock)
+            : juce::Thread("Latency harness device"),
+              engine(engineToUse), noteInput(noteInputToUse), recording(recordingToFill),
+              startMs(firstCallbackMs), periodMs(blockPeriodMs), blockSize(samplesPerBlock),
+              numBlocks(recordingToFill.getNumSamples() / samplesPerBlock)
+        {
+            callbackTimes.ensureStorageAllocated(numBlocks);
+            noteOnPositions.ensureStorageAllocated(numBlocks);
+        }
+
+        ~DeviceThread() override
+        {
+            stopThread(1000);
+        }
+
+        void run() override
+        {
+            juce::AudioBuffer<float> block(2, blockSize);
+            juce::MidiBuffer midi;
+            midi.ensureSize(2048);
+
+            for (int index = 0; index < numBlocks && !threadShouldExit(); ++index)
+            {
+                waitUntil(startMs + index * periodMs);
+                callbackTimes.add(nowMs());
+
+                // As MainComponent's callback does it
+                block.clear();
+                midi.clear();
+                noteInput.getNextBlock(midi, blockSize);
+
+                for (const auto metadata : midi)
+                    if (metadata.getMessage().isNoteOn())
+                        noteOnPositions.add(index * blockSize + metadata.samplePosition);
+
+                engine.renderNextBlock(block, midi, 0, blockSize);
+
+                for (int channel = 0; channel < 2; ++channel)
+                    recording.copyFrom(channel, index * blockSize, block, channel, 0, blockSize);
+            }
+        }
+
+        juce::Array<double> callbackTimes;    // when each callback began, in ms
+        juce::Array<int> noteOnPositions;     // where each note-on reached the engine, in samples of the recording
+
+    private:
+        SamplerEngine& engine;
+        NoteInput& noteInput;
+        juce::AudioBuffer<float>& recording;
+        const double startMs, periodMs;
+        const int blockSize, numBlocks;
+    };
+
+    //==============================================================================
+    /** Returns the first sample at or after start and before end where either channel is over the threshold, or -1 */
+    int findOnset(const juce::AudioBuffer<float>& audio, int start, int end, float threshold)
+    {
+        for (int i = juce::jmax(0, start); i < juce::jmin(end, audio.getNumSamples()); ++i)
+            for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+                if (std::abs(audio.getSample(channel, i)) > threshold)
+                    return i;
+
+        return -1;
+    }
+}
+
+//==============================================================================
+const char* LatencyHarness::getPathName(Path path)
+{
+    if (path == Path::computerKeyboard)  return "computer-keyboard";
+    if (path == Path::onScreenKeyboard)  return "on-screen-keyboard";
+    return "midi-input";
+}
+
+double LatencyHarness::PathResult::getPercentile(const juce::Array<double>& values, double fraction)
+{
+    if (values.isEmpty())
+        return 0.0;
+
+    auto sorted = values;
+    sorted.sort();
+
+    const auto index = juce::jlimit(0, sorted.size() - 1, (int)std::ceil(fraction * sorted.size()) - 1);
+    return sorted[index];
+}
+
+double LatencyHarness::PathResult::getSampleAccurateShare() const
+{
+    if (sampleErrors.isEmpty())
+        return 0.0;
+
+    int numAccurate = 0;
+    for (auto error : sampleErrors)
+        if (std::abs(error) <= 1)
+            ++numAccurate;
+
+    return (double)numAccurate / sampleErrors.size();
+}
+
+juce::String LatencyHarness::PathResult::toString() const
+{
+    auto describe = [](const juce::Array<double>& values)
+    {
+        return "p50 " + juce::String(getPercentile(values, 0.5), 2) + " ms   p95 " + juce::String(getPercentile(values, 0.95), 2)
+             + " ms   max " + juce::String(getPercentile(values, 1.0), 2) + " ms";
+    };
+
+    double meanError = 0.0;
+    int minError = 0, maxError = 0;
+
+    for (int i = 0; i < sampleErrors.size(); ++i)
+    {
+        meanError += sampleErrors[i];
+        minError = i == 0 ? sampleErrors[i] : juce::jmin(minError, sampleErrors[i]);
+        maxError = i == 0 ? sampleErrors[i] : juce::jmax(maxError, sampleErrors[i]);
+    }
+
+    if (!sampleErrors.isEmpty())
+        meanError /= sampleErrors.size();
+
+    juce::String text;
+    text << getPathName(path) << ": " << numNotes << " notes, " << numMissed << " missed";
+
+    if (lateCallbacks > 0)
+        text << ", " << lateCallbacks << " late callbacks";
+
+    text << "\n"
+         << "  key to sound    " << describe(latencyMs) << "\n"
+         << "  key to engine   " << describe(schedulingMs) << "\n"
+         << "  sample error    mean " << juce::String(meanError, 1) << "   min " << minError << "   max " << maxError
+         << " samples, " << juce::String(getSampleAccurateShare() * 100.0, 0) << "% within a sample" << "\n";
+
+    return text;
+}
+
+juce::var LatencyHarness::PathResult::toVar() const
+{
+    auto toList = [](const auto& values)
+    {
+        juce::Array<juce::var> list;
+        for (auto value : values)
+            list.add(value);
+        return list;
+    };
+
+    auto* object = new juce::DynamicObject();
+    object->setProperty("path", getPathName(path));
+    object->setProperty("notes", numNotes);
+    object->setProperty("missed", numMissed);
+    object->setProperty("late_callbacks", lateCallbacks);
+    object->setProperty("latency_ms_p50", getPercentile(latencyMs, 0.5));
+    object->setProperty("latency_ms_p95", getPercentile(latencyMs, 0.95));
+    object->setProperty("latency_ms_max", getPercentile(latencyMs, 1.0));
+    object->setProperty("sample_accurate_share", getSampleAccurateShare());
+    object->setProperty("latency_ms", toList(latencyMs));
+    object->setProperty("scheduling_ms", toList(schedulingMs));
+    object->setProperty("sample_errors", toList(sampleErrors));
+    return juce::var(object);
+}
+
+//==============================================================================
+LatencyHarness::LatencyHarness(const Settings& settingsToUse)
+    : settings(settingsToUse)
+{
+    if (settings.paths.isEmpty())
+        for (int i = 0; i < numPaths; ++i)
+            settings.paths.add((Path)i);
+
+    libraryDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+        .getChildFile("LatencyHarness_" + juce::String::toHexString(juce::Random::getSystemRandom().nextInt()));
+}
+
+LatencyHarness::~LatencyHarness()
+{
+    libraryDirectory.deleteRecursively();
+}
+
+bool LatencyHarness::run(juce::String& error)
+{
+    results.clear();
+
+    // A tone at full level from its first sample, with no attack, so the onset is the note's start
+    juce::AudioBuffer<float> tone(2, (int)(0.3 * settings.sampleRate));
+    for (int i = 0; i < tone.getNumSamples(); ++i)
+    {
+        const auto value = 0.5f * (float)std::cos(juce::MathConstants<double>::twoPi * 1000.0 * i / settings.sampleRate);
+        tone.setSample(0, i, value);
+        tone.setSample(1, i, value);
+    }
+
+    if (!libraryDirectory.createDirectory()
+        || !OfflineRenderer::writeWavFile(libraryDirectory.getChildFile("tone.wav"), tone, settings.sampleRate, 32, error))
+    {
+        if (error.isEmpty())
+            error = "Can't create " + libraryDirectory.getFullPathName();
+
+        return false;
+    }
+
+    auto sfz = libraryDirectory.getChildFile("latency.sfz");
+    sfz.replaceWithText("<region> sample=tone.wav key=" + juce::String(testNote) + " pitch_keycenter=" + juce::String(testNote)
+        + " ampeg_attack=0 ampeg_release=0.005 loop_mode=no_loop\n");
+
+    engine.loadSampleSet(sfz);
+
+    if (engine.getSampleMemoryStats().storedBytes == 0)
+    {
+        error = "The test sound didn't load";
+        return false;
+    }
+
+    for (auto path : settings.paths)
+    {
+        std::cout << "Playing " << settings.notesPerPath << " notes by " << getPathName(path) << std::endl;
+        results.add(runPath(path));
+    }
+
+    return true;
+}
+
+//==============================================================================
+void LatencyHarness::pressKey(Path path)
+{
+    if (path == Path::computerKeyboard)
+    {
+        // What MainComponent::keyPressed() does with the A key
+        noteInput.computerKeyPressed('A');
+    }
+    else if (path == Path::onScreenKeyboard)
+    {
+        // What a MidiKeyboardComponent on the keyboard state does on a mouse press
+        noteInput.getKeyboardState().noteOn(1, testNote, NoteInput::computerKeyVelocity);
+    }
+    else
+    {
+        // Timestamped as juce::MidiInput does
+        auto message = juce::MidiMessage::noteOn(1, testNote, NoteInput::computerKeyVelocity);
+        message.setTimeStamp(nowMs() * 0.001);
+        noteInput.handleIncomingMidiMessage(nullptr, message);
+    }
+}
+
+void LatencyHarness::releaseKey(Path path)
+{
+    if (path == Path::computerKeyboard)
+    {
+        noteInput.computerKeysReleased();
+    }
+    else if (path == Path::onScreenKeyboard)
+    {
+        noteInput.getKeyboardState().noteOff(1, testNote, 0.0f);
+    }
+    else
+    {
+        auto message = juce::MidiMessage::noteOff(1, testNote);
+        message.setTimeStamp(nowMs() * 0.001);
+        noteInput.handleIncomingMidiMessage(nullptr, message);
+    }
+}
+
+LatencyHarness::PathResult LatencyHarness::runPath(Path path)
+{
+    const auto blockSize = settings.blockSize;
+    const auto periodMs = 1000.0 * blockSize / settings.sampleRate;
+    const auto blocksPerNote = (int)std::ceil(noteSpacingMs / periodMs);
+    const auto warmupBlocks = (int)std::ceil(warmupMs / periodMs);
+    const auto numBlocks = warmupBlocks + (settings.notesPerPath + 1) * blocksPerNote;
+
+    engine.prepareToPlay(settings.sampleRate, blockSize);
+    engineLatency = engine.getLatencySamples();
+    noteInput.prepare(settings.sampleRate);
+
+    juce::AudioBuffer<float> recording(2, numBlocks * blockSize);
+    recording.clear();
+
+    const auto startMs = nowMs() + 50.0;
+    DeviceThread device(engine, noteInput, recording, startMs, periodMs, blockSize);
+    device.startThread(juce::Thread::Priority::highest);
+
+    // Each key goes down at a random point in its block
+    juce::Random random(settings.seed + (int)path);
+    juce::Array<double> keyDownTimes;
+
+    for (int note = 0; note < settings.notesPerPath; ++note)
+    {
+        const auto keyDown = startMs + (warmupBlocks + note * blocksPerNote + random.nextDouble()) * periodMs;
+
+        waitUntil(keyDown);
+        keyDownTimes.add(nowMs());
+        pressKey(path);
+
+        waitUntil(keyDown + noteLengthMs);
+        releaseKey(path);
+    }
+
+    device.waitForThreadToExit(juce::roundToInt((numBlocks + warmupBlocks) * periodMs) + 1000);
+    device.stopThread(1000);
+
+    //==============================================================================
+    PathResult result;
+    result.path = path;
+    result.numNotes = keyDownTimes.size();
+
+    const auto& callbackTimes = device.callbackTimes;
+
+    for (int index = 0; index < callbackTimes.size(); ++index)
+        if (callbackTimes[index] - (startMs + index * periodMs) >= periodMs)
+            ++result.lateCallbacks;
+
+    int callback = 0;
+
+    for (int note = 0; note < keyDownTimes.size(); ++note)
+    {
+        const auto keyDown = keyDownTimes[note];
+
+        // Where the key went down in the output, between the callbacks either side of it
+        while (callback + 2 < callbackTimes.size() && callbackTimes[callback + 1] <= keyDown)
+            ++callback;
+
+        if (callback + 1 >= callbackTimes.size())
+        {
+            ++result.numMissed;
+            continue;
+        }
+
+        const auto span = juce::jmax(1.0e-6, callbackTimes[callback + 1] - callbackTimes[callback]);
+        const auto keyDownPosition = (callback + (keyDown - callbackTimes[callback]) / span) * blockSize;
+
+        // A late callback can take a key pressed just before it into the same block, so look a block back too
+        const auto windowStart = (int)keyDownPosition - blockSize;
+        const auto windowEnd = (warmupBlocks + (note + 1) * blocksPerNote - 1) * blockSize;
+
+        const auto onset = findOnset(recording, windowStart, windowEnd, settings.onsetThreshold);
+
+        if (onset < 0)
+        {
+            ++result.numMissed;
+            continue;
+        }
+
+        const auto toMs = [this](double samples) { return 1000.0 * samples / settings.sampleRate; };
+        result.latencyMs.add(toMs(onset - keyDownPosition));
+
+        for (auto position : device.noteOnPositions)
+        {
+            if (position >= windowStart && position < windowEnd)
+            {
+                result.schedulingMs.add(toMs(position - keyDownPosition));
+                break;
+            }
+        }
+
+        const auto accurateOnset = juce::roundToInt(keyDownPosition) + blockSize + engineLatency;
+        result.sampleErrors.add(onset - accurateOnset);
+    }
+
+    return result;
+}
+
+//==============================================================================
+juce::String LatencyHarness::toString() const
+{
+    juce::String text;
+    text << "Blocks of " << settings.blockSize << " at " << juce::String(settings.sampleRate, 0) << " Hz ("
+         << juce::String(1000.0 * settings.blockSize / settings.sampleRate, 2) << " ms); engine latency "
+         << engineLatency << " samples (" << juce::String(1000.0 * engineLatency / settings.sampleRate, 2) << " ms)" << "\n"
+         << "Sample error is the onset against one block after the key plus the engine latency; negative is early" << "\n";
+
+    for (auto& result : results)
+        text << result.toString();
+
+    return text;
+}
+
+juce::String LatencyHarness::toJSON() const
+{
+    juce::Array<juce::var> pathList;
+    for (auto& result : results)
+        pathList.add(result.toVar());
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("sample_rate", settings.sampleRate);
+    root->setProperty("block_size", settings.blockSize);
+    root->setProperty("engine_latency_samples", engineLatency);
+    root->setProperty("onset_threshold", settings.onsetThreshold);
+    root->setProperty("paths", pathList);
+
+    return juce::JSON::toString(juce::var(root));
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    LatencyHarness.h
+    Created: Measures the time from a key going down to the first sample of its note
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SamplerEngine.h"
+#include "NoteInput.h"
+
+//==============================================================================
+/**
+    Plays notes into the app's NoteInput by each way it can be reached, at random
+    moments within the audio blocks, and finds where each note starts in what
+    the engine renders.
+
+    A thread stands in for the audio device, calling back at the block rate on
+    the wall clock the way the app's callback is called, so the keyboards' and
+    MIDI's own timestamps behave as they would live. Each note's key-down time
+    is placed in the output stream by the callback times either side of it.
+
+    For every note there are three positions: the key going down, the MIDI
+    event reaching the engine, and the first output sample over the threshold.
+    The difference of the last two is the engine's own latency (the limiter's
+    lookahead). The sample-accuracy error is how far the note started from
+    where a sample-accurate schedule would put it: one block after the key
+    went down, plus the engine latency.
+
+    The times are within the audio stream, so the device's own output latency
+    comes on top of them.
+*/
+class LatencyHarness
+{
+public:
+    //==============================================================================
+    enum class Path
+    {
+        computerKeyboard,
+        onScreenKeyboard,
+        midiInput
+    };
+
+    static constexpr int numPaths = 3;
+
+    /** Returns the name used on the command line and in reports */
+    static const char* getPathName(Path path);
+
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        int notesPerPath = 100;
+        juce::Array<Path> paths;           // every path if empty
+        int seed = 1;
+        float onsetThreshold = 0.01f;      // -40 dBFS, against a test tone at -6
+    };
+
+    /** What one path's notes took */
+    struct PathResult
+    {
+        Path path = Path::computerKeyboard;
+        int numNotes = 0;
+        int numMissed = 0;                  // no onset found before the next note
+
+        juce::Array<double> latencyMs;      // key down to the first sample of the note
+        juce::Array<double> schedulingMs;   // key down to the MIDI event reaching the engine
+        juce::Array<int> sampleErrors;      // onset against the sample-accurate schedule, in samples
+        int lateCallbacks = 0;              // device callbacks that started a block or more late
+
+        /** Returns the value that the given fraction (0 to 1) of the notes came in under */
+        static double getPercentile(const juce::Array<double>& values, double fraction);
+
+        /** Returns the share of notes that started within a sample of the sample-accurate schedule */
+        double getSampleAccurateShare() const;
+
+        juce::String toString() const;
+        juce::var toVar() const;
+    };
+
+    //==============================================================================
+    explicit LatencyHarness(const Settings& settingsToUse);
+    ~LatencyHarness();
+
+    /** Writes and loads the test sound, then plays every path in real time. Takes a few seconds per path. */
+    bool run(juce::String& error);
+
+    const juce::Array<PathResult>& getResults() const noexcept { return results; }
+
+    /** Returns the results as a report, for printing */
+    juce::String toString() const;
+
+    /** Returns the settings and results as JSON */
+    juce::String toJSON() const;
+
+private:
+    //==============================================================================
+    PathResult runPath(Path path);
+    void pressKey(Path path);
+    void releaseKey(Path path);
+
+    Settings settings;
+    SamplerEngine engine;
+    NoteInput noteInput;
+    juce::File libraryDirectory;
+    juce::Array<PathResult> results;
+    int engineLatency = 0;
+
+    static constexpr int testNote = 60;    // the note the computer keyboard's A plays
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyHarness)
+};
\ No newline at end of file
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: Command line front end for the key-to-sound latency harness
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "LatencyHarness.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: LatencyHarness [options]" << std::endl
+                  << "  --paths <names>       comma separated: computer-keyboard, on-screen-keyboard, midi-input (default all)" << std::endl
+                  << "  --notes <n>           notes played by each path (default 100)" << std::endl
+                  << "  --rate <hz>           sample rate (default 48000)" << std::endl
+                  << "  --block <samples>     block size (default 256)" << std::endl
+                  << "  --seed <n>            where in their blocks the keys go down (default 1)" << std::endl
+                  << "  --output <file>       also write the results, note by note, as JSON" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    LatencyHarness::Settings settings;
+    juce::File outputFile;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--paths" && hasValue)
+        {
+            for (auto& name : juce::StringArray::fromTokens(argv[++i], ",", ""))
+            {
+                bool found = false;
+
+                for (int path = 0; path < LatencyHarness::numPaths; ++path)
+                {
+                    if (name.trim() == LatencyHarness::getPathName((LatencyHarness::Path)path))
+                    {
+                        settings.paths.addIfNotAlreadyThere((LatencyHarness::Path)path);
+                        found = true;
+                    }
+                }
+
+                if (!found)
+                {
+                    std::cerr << "Unknown path: " << name << std::endl;
+                    return 1;
+                }
+            }
+        }
+        else if (arg == "--notes" && hasValue)   settings.notesPerPath = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--rate" && hasValue)    settings.sampleRate = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--block" && hasValue)   settings.blockSize = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--seed" && hasValue)    settings.seed = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--output" && hasValue)  outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (settings.notesPerPath <= 0 || settings.sampleRate <= 0.0 || settings.blockSize <= 0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    LatencyHarness harness(settings);
+    juce::String error;
+
+    if (!harness.run(error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    std::cout << harness.toString();
+
+    if (outputFile != juce::File() && !outputFile.replaceWithText(harness.toJSON()))
+    {
+        std::cerr << "Can't write " << outputFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
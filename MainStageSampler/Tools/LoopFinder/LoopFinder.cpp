@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    LoopFinder.cpp
+    Created: Offline loop point search for sustaining samples
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "LoopFinder.h"
+
+namespace
+{
+    int alignUp(int value, int alignment)   { return ((value + alignment - 1) / alignment) * alignment; }
+    int alignDown(int value, int alignment) { return (value / alignment) * alignment; }
+}
+
+LoopFinder::Result LoopFinder::findLoop(const juce::AudioBuffer<float>& audio, double sampleRate, const Settings& settings)
+{
+    Result best;
+
+    const int numFrames = audio.getNumSamples();
+    const int window = juce::jmax(16, settings.matchWindow);
+    const int half = window / 2;
+    const int alignment = juce::jmax(1, settings.alignment);
+
+    if (audio.getNumChannels() == 0 || numFrames < 2 * window)
+        return best;
+
+    const int minLength = juce::jmax(alignment, alignUp((int)(settings.minLoopSeconds * sampleRate), alignment));
+    const int maxLength = juce::jmax(minLength, alignDown((int)(settings.maxLoopSeconds * sampleRate), alignment));
+
+    // Loop starts need a full window before them, loop ends a full window after
+    auto searchStart = settings.searchStartSeconds >= 0.0 ? (int)(settings.searchStartSeconds * sampleRate) : numFrames / 4;
+    const int firstStart = alignUp(juce::jmax(half, searchStart), alignment);
+    const int lastEnd = alignDown(numFrames - half, alignment);
+    const int lastStart = lastEnd - minLength;
+
+    if (lastStart < firstStart)
+        return best;
+
+    //==============================================================================
+    // Mono mix, plus running energy so each window's energy is a subtraction
+    std::vector<float> mono((size_t)numFrames, 0.0f);
+    for (int ch = 0; ch < audio.getNumChannels(); ++ch)
+    {
+        const auto* samples = audio.getReadPointer(ch);
+        for (int i = 0; i < numFrames; ++i)
+            mono[(size_t)i] += samples[i] / (float)audio.getNumChannels();
+    }
+
+    std::vector<double> energy((size_t)numFrames + 1, 0.0);
+    for (int i = 0; i < numFrames; ++i)
+        energy[(size_t)i + 1] = energy[(size_t)i] + (double)mono[(size_t)i] * mono[(size_t)i];
+
+    auto windowEnergy = [&](int centre)
+    {
+        return energy[(size_t)(centre + half)] - energy[(size_t)(centre - half)];
+    };
+
+    //==============================================================================
+    // Transform every frame that could sit in a loop start window once. Correlating
+    // an end template against it gives the match at every start in one go.
+    const int segmentStart = firstStart - half;
+    const int segmentLength = lastStart + half - segmentStart;
+    const int fftOrder = juce::jmax(1, juce::findHighestSetBit((juce::uint32)(segmentLength + window - 1)) + 1);
+    const int fftSize = 1 << fftOrder;
+
+    juce::dsp::FFT fft(fftOrder);
+
+    std::vector<float> segmentSpectrum((size_t)fftSize * 2, 0.0f);
+    std::copy(mono.begin() + segmentStart, mono.begin() + segmentStart + segmentLength, segmentSpectrum.begin());
+    fft.performRealOnlyForwardTransform(segmentSpectrum.data());
+
+    std::vector<float> work((size_t)fftSize * 2);
+
+    const int numEnds = (lastEnd - (firstStart + minLength)) / alignment + 1;
+    const int endStep = juce::jmax(1, numEnds / juce::jmax(1, settings.maxEndCandidates));
+    float bestScore = -2.0f;
+
+    for (int endIndex = 0; endIndex < numEnds; endIndex += endStep)
+    {
+        const int loopEnd = lastEnd - endIndex * alignment;
+        const double endEnergy = windowEnergy(loopEnd);
+
+        if (endEnergy <= 0.0)
+            continue;
+
+        std::fill(work.begin(), work.end(), 0.0f);
+        std::copy(mono.begin() + loopEnd - half, mono.begin() + loopEnd + half, work.begin());
+        fft.performRealOnlyForwardTransform(work.data());
+
+        // segment x conj(template), giving the correlation at each offset into the segment
+        for (int bin = 0; bin < fftSize; ++bin)
+        {
+            const auto sr = segmentSpectrum[(size_t)(2 * bin)], si = segmentSpectrum[(size_t)(2 * bin + 1)];
+            const auto tr = work[(size_t)(2 * bin)], ti = work[(size_t)(2 * bin + 1)];
+            work[(size_t)(2 * bin)] = sr * tr + si * ti;
+            work[(size_t)(2 * bin + 1)] = si * tr - sr * ti;
+        }
+
+        fft.performRealOnlyInverseTransform(work.data());
+
+        const int earliest = juce::jmax(firstStart, loopEnd - maxLength);
+        const int latest = loopEnd - minLength;
+
+        for (int loopStart = alignUp(earliest, alignment); loopStart <= latest; loopStart += alignment)
+        {
+            const double startEnergy = windowEnergy(loopStart);
+            if (startEnergy <= 0.0)
+                continue;
+
+            const auto correlation = (float)(work[(size_t)(loopStart - firstStart)] / std::sqrt(startEnergy * endEnergy));
+            const auto levelMatch = (float)std::sqrt(juce::jmin(startEnergy, endEnergy) / juce::jmax(startEnergy, endEnergy));
+
+            // A level step pumps audibly even when the waveforms line up
+            const auto score = correlation - (1.0f - levelMatch);
+
+            if (score > bestScore)
+            {
+                bestScore = score;
+                best.found = true;
+                best.loop = { loopStart, loopEnd };
+                best.correlation = correlation;
+                best.levelMatch = levelMatch;
+            }
+        }
+    }
+
+    return best;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    LoopFinder.h
+    Created: Offline loop point search for sustaining samples
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Searches a sample for a pair of loop points where the audio either side of
+    the jump back matches as closely as possible.
+
+    For every candidate loop end, the frames around it are cross-correlated (by
+    FFT) against every possible loop start, and the start with the highest
+    normalised correlation and the closest level wins.
+*/
+class LoopFinder
+{
+public:
+    //==============================================================================
+    struct Settings
+    {
+        /** Shortest and longest loops to consider */
+        double minLoopSeconds = 0.5;
+        double maxLoopSeconds = 4.0;
+
+        /** Where the loop may start, or negative to skip the first quarter of the sample (the attack) */
+        double searchStartSeconds = -1.0;
+
+        /** Loop points are kept to multiples of this. 16 keeps four octave-down mip levels loopable. */
+        int alignment = 16;
+
+        /** Number of frames compared around each splice */
+        int matchWindow = 1024;
+
+        /** Number of loop ends tried, spread evenly across the allowed range */
+        int maxEndCandidates = 32;
+    };
+
+    struct Result
+    {
+        bool found = false;
+        juce::Range<int> loop;      // end exclusive
+        float correlation = 0.0f;   // 1 is a perfect match
+        float levelMatch = 0.0f;    // quieter / louder RMS of the two sides of the splice
+    };
+
+    /** Finds the best loop in the given audio. The channels are mixed down for the search. */
+    static Result findLoop(const juce::AudioBuffer<float>& audio, double sampleRate, const Settings& settings);
+};
\ No newline at end of file
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: Command line front end for LoopFinder
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "LoopFinder.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: LoopFinder [options] <audio file>..." << std::endl
+                  << "  --min <seconds>        shortest loop (default 0.5)" << std::endl
+                  << "  --max <seconds>        longest loop (default 4)" << std::endl
+                  << "  --from <seconds>       earliest loop start (default: a quarter of the way in)" << std::endl
+                  << "  --align <frames>       keep loop points to multiples of this (default 16)" << std::endl
+                  << "  --crossfade <seconds>  loop_crossfade to suggest (default 0.05)" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    LoopFinder::Settings settings;
+    double crossfadeSeconds = 0.05;
+    juce::Array<juce::File> files;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--min" && hasValue)            settings.minLoopSeconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--max" && hasValue)       settings.maxLoopSeconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--from" && hasValue)      settings.searchStartSeconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--align" && hasValue)     settings.alignment = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--crossfade" && hasValue) crossfadeSeconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg.startsWith("--"))
+        {
+            printUsage();
+            return 1;
+        }
+        else
+        {
+            files.add(juce::File::getCurrentWorkingDirectory().getChildFile(arg));
+        }
+    }
+
+    if (files.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    int numFailed = 0;
+
+    for (auto& file : files)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+
+        if (reader == nullptr)
+        {
+            std::cerr << file.getFileName() << ": can't read this file" << std::endl;
+            ++numFailed;
+            continue;
+        }
+
+        juce::AudioBuffer<float> audio((int)reader->numChannels, (int)reader->lengthInSamples);
+        reader->read(&audio, 0, audio.getNumSamples(), 0, true, true);
+
+        auto result = LoopFinder::findLoop(audio, reader->sampleRate, settings);
+
+        if (!result.found)
+        {
+            std::cerr << file.getFileName() << ": no loop found (sample too short for these settings?)" << std::endl;
+            ++numFailed;
+            continue;
+        }
+
+        // SFZ loop_end is the last frame played
+        std::cout << file.getFileName() << ": loop_mode=loop_continuous"
+                  << " loop_start=" << result.loop.getStart()
+                  << " loop_end=" << result.loop.getEnd() - 1
+                  << " loop_crossfade=" << juce::String(crossfadeSeconds, 3)
+                  << "  // correlation " << juce::String(result.correlation, 4)
+                  << ", level match " << juce::String(result.levelMatch, 3) << std::endl;
+    }
+
+    return numFailed == 0 ? 0 : 1;
+}
\ No newline at end of file
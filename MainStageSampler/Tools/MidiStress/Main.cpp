@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: Command line front end for the MIDI stress test
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "StressTest.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: MidiStress [options]" << std::endl
+                  << "  --workloads <names>      comma separated: glissando, chords, controllers, combined (default all)" << std::endl
+                  << "  --voices <counts>        polyphonies to try (default 16,32,64,128)" << std::endl
+                  << "  --zones <counts>         sizes of generated library, in keyzones (default 8,30,88)" << std::endl
+                  << "  --sample-seconds <s>     length of each generated sample (default 3)" << std::endl
+                  << "  --sfz <file>             play this library rather than generated ones" << std::endl
+                  << "  --compress               hold samples compressed, as the app's load option" << std::endl
+                  << "  --seconds <s>            length of each workload (default 6)" << std::endl
+                  << "  --notes-per-second <n>   glissando speed (default 30)" << std::endl
+                  << "  --chord-size <n>         notes in each repeated chord (default 10)" << std::endl
+                  << "  --chords-per-second <n>  chord repetition rate (default 6)" << std::endl
+                  << "  --cc-rate <n>            events per second from each controller (default 1000)" << std::endl
+                  << "  --rate <hz>              sample rate (default 48000)" << std::endl
+                  << "  --block <samples>        block size (default 128)" << std::endl
+                  << "  --output <file>          also write the results as JSON" << std::endl;
+    }
+
+    juce::Array<int> parseCounts(const juce::String& text)
+    {
+        juce::Array<int> counts;
+
+        for (auto& token : juce::StringArray::fromTokens(text, ",", ""))
+            if (token.getIntValue() > 0)
+                counts.add(token.getIntValue());
+
+        return counts;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    StressTest::Settings settings;
+    juce::File outputFile;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+        const auto cwd = juce::File::getCurrentWorkingDirectory();
+
+        if (arg == "--workloads" && hasValue)
+        {
+            for (auto& name : juce::StringArray::fromTokens(argv[++i], ",", ""))
+            {
+                StressWorkloads::Workload workload;
+
+                if (!StressWorkloads::findWorkload(name, workload))
+                {
+                    std::cerr << "Unknown workload: " << name << std::endl;
+                    return 1;
+                }
+
+                settings.workloads.addIfNotAlreadyThere(workload);
+            }
+        }
+        else if (arg == "--voices" && hasValue)              settings.polyphonies = parseCounts(argv[++i]);
+        else if (arg == "--zones" && hasValue)               settings.librarySizes = parseCounts(argv[++i]);
+        else if (arg == "--sample-seconds" && hasValue)      settings.sampleSeconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--sfz" && hasValue)                 settings.sfzFile = cwd.getChildFile(argv[++i]);
+        else if (arg == "--compress")                        settings.loadOptions.compressSamples = true;
+        else if (arg == "--seconds" && hasValue)             settings.workload.seconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--notes-per-second" && hasValue)    settings.workload.glissandoNotesPerSecond = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--chord-size" && hasValue)          settings.workload.chordSize = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--chords-per-second" && hasValue)   settings.workload.chordsPerSecond = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--cc-rate" && hasValue)             settings.workload.controllerEventsPerSecond = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--rate" && hasValue)                settings.sampleRate = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--block" && hasValue)               settings.blockSize = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--output" && hasValue)              outputFile = cwd.getChildFile(argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (settings.polyphonies.isEmpty() || settings.librarySizes.isEmpty() || settings.sampleRate <= 0.0
+        || settings.blockSize <= 0 || settings.workload.seconds <= 0.0 || settings.sampleSeconds <= 0.0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    StressTest test(settings);
+    juce::String error;
+
+    if (!test.run(error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    if (outputFile != juce::File() && !outputFile.replaceWithText(test.toJSON()))
+    {
+        std::cerr << "Can't write " << outputFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
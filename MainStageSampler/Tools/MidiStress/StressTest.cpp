@@ -0,0 +1,233 @@
+/*
+  ==============================================================================
+
+    StressTest.cpp
+    Created: Plays the stress workloads through the engine at each polyphony and library size
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "StressTest.h"
+#include "OfflineRenderer.h"
+
+//==============================================================================
+StressTest::StressTest(const Settings& settingsToUse)
+    : settings(settingsToUse)
+{
+    if (settings.workloads.isEmpty())
+        for (int i = 0; i < StressWorkloads::numWorkloads; ++i)
+            settings.workloads.add((StressWorkloads::Workload)i);
+}
+
+StressTest::~StressTest()
+{
+}
+
+bool StressTest::run(juce::String& error)
+{
+    cases.clear();
+    std::cout << getTableHeader() << std::endl;
+
+    if (settings.sfzFile != juce::File())
+        return runLibrary(settings.sfzFile, settings.sfzFile.getFileNameWithoutExtension(), error);
+
+    auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+        .getChildFile("MidiStress_" + juce::String::toHexString(juce::Random::getSystemRandom().nextInt()));
+    bool ok = true;
+
+    for (auto numZones : settings.librarySizes)
+    {
+        StressWorkloads::LibrarySpec spec;
+        spec.numZones = numZones;
+        spec.sampleSeconds = settings.sampleSeconds;
+
+        auto libraryDirectory = directory.getChildFile("zones_" + juce::String(numZones));
+        const auto sfz = StressWorkloads::writeLibrary(libraryDirectory, spec, error);
+
+        ok = sfz != juce::File() && runLibrary(sfz, juce::String(numZones) + " zones", error);
+
+        // Only one library's samples on disk at a time
+        libraryDirectory.deleteRecursively();
+
+        if (!ok)
+            break;
+    }
+
+    directory.deleteRecursively();
+    return ok;
+}
+
+bool StressTest::runLibrary(const juce::File& sfzFile, const juce::String& libraryName, juce::String& error)
+{
+    SamplerEngine engine;
+    engine.setLoadOptions(settings.loadOptions);
+    engine.loadSampleSet(sfzFile);
+
+    const auto memory = engine.getSampleMemoryStats();
+
+    if (memory.storedBytes == 0)
+    {
+        error = sfzFile.getFileName() + ": no samples loaded";
+        return false;
+    }
+
+    OfflineRenderer renderer(engine);
+    OfflineRenderer::Settings renderSettings;
+    renderSettings.sampleRate = settings.sampleRate;
+    renderSettings.blockSize = settings.blockSize;
+
+    // Long enough for the last releases to finish, so no case starts with the previous one's voices
+    renderSettings.tailSeconds = juce::jmax(1.0, settings.tailSeconds);
+
+    juce::AudioBuffer<float> audio;
+
+    for (auto polyphony : settings.polyphonies)
+    {
+        engine.setNumVoices(polyphony);
+
+        for (auto workload : settings.workloads)
+        {
+            const auto sequence = StressWorkloads::generate(workload, settings.workload);
+            const auto report = renderer.render(sequence, renderSettings, audio);
+            const auto period = report.getBlockPeriod();
+
+            Case result;
+            result.workload = StressWorkloads::getName(workload);
+            result.library = libraryName;
+            result.polyphony = engine.getNumVoices();
+            result.libraryBytes = (juce::int64)memory.storedBytes;
+            result.numBlocks = report.blockSeconds.size();
+
+            double totalSeconds = 0.0;
+            for (auto seconds : report.blockSeconds)
+            {
+                totalSeconds += seconds;
+                result.worstBlockSeconds = juce::jmax(result.worstBlockSeconds, seconds);
+
+                if (seconds > period)
+                    ++result.overruns;
+            }
+
+            juce::int64 totalVoices = 0;
+            for (auto voices : report.blockVoices)
+                totalVoices += voices;
+
+            if (result.numBlocks > 0 && period > 0.0)
+            {
+                result.meanLoad = totalSeconds / result.numBlocks / period;
+                result.p99Load = report.getBlockPercentile(0.99) / period;
+                result.worstLoad = result.worstBlockSeconds / period;
+                result.meanVoices = (double)totalVoices / result.numBlocks;
+            }
+
+            result.peakVoices = report.peakVoices;
+            result.voicesStolen = report.voicesStolen;
+            result.realtimeFactor = report.getRealtimeFactor();
+
+            // Counted from the render's prepareToPlay(), so this case's alone
+            const auto voiceCost = engine.getVoiceCost();
+            result.filteredVoiceCost = voiceCost.filtered;
+            result.unfilteredVoiceCost = voiceCost.unfiltered;
+
+            cases.add(result);
+            std::cout << toTableRow(result) << std::endl;
+        }
+    }
+
+    // Summed over every case with this library
+    if (settings.loadOptions.compressSamples)
+        std::cout << libraryName << ": decoding took " << juce::String(engine.getDecodeCostPerVoice() * 100.0, 3)
+                  << "% of a core per compressed voice" << std::endl;
+
+    if (RegionCostTable::isAvailable())
+        std::cout << engine.getRegionCosts().toString(5);
+
+    return true;
+}
+
+//==============================================================================
+juce::String StressTest::getTableHeader()
+{
+    auto header = juce::String("library").paddedRight(' ', 14) + juce::String("voices").paddedLeft(' ', 7)
+         + "  " + juce::String("workload").paddedRight(' ', 12)
+         + juce::String("mean").paddedLeft(' ', 8) + juce::String("p99").paddedLeft(' ', 8)
+         + juce::String("worst").paddedLeft(' ', 8) + juce::String("worst us").paddedLeft(' ', 10)
+         + juce::String("over").paddedLeft(' ', 6) + juce::String("avg vc").paddedLeft(' ', 8)
+         + juce::String("peak vc").paddedLeft(' ', 9) + juce::String("stolen").paddedLeft(' ', 8)
+         + juce::String("speed").paddedLeft(' ', 8);
+
+    if (SamplerSynthesiser::isVoiceCostAvailable())
+        header << juce::String("filt/vc").paddedLeft(' ', 9) << juce::String("dry/vc").paddedLeft(' ', 9);
+
+    return header;
+}
+
+juce::String StressTest::toTableRow(const Case& result)
+{
+    auto toPercent = [](double load) { return juce::String(load * 100.0, 1) + "%"; };
+
+    auto row = result.library.paddedRight(' ', 14) + juce::String(result.polyphony).paddedLeft(' ', 7)
+         + "  " + result.workload.paddedRight(' ', 12)
+         + toPercent(result.meanLoad).paddedLeft(' ', 8) + toPercent(result.p99Load).paddedLeft(' ', 8)
+         + toPercent(result.worstLoad).paddedLeft(' ', 8)
+         + juce::String(result.worstBlockSeconds * 1.0e6, 0).paddedLeft(' ', 10)
+         + juce::String(result.overruns).paddedLeft(' ', 6) + juce::String(result.meanVoices, 1).paddedLeft(' ', 8)
+         + juce::String(result.peakVoices).paddedLeft(' ', 9) + juce::String(result.voicesStolen).paddedLeft(' ', 8)
+         + (juce::String(result.realtimeFactor, 1) + "x").paddedLeft(' ', 8);
+
+    // Per voice, so a hundredth of a percent is worth showing
+    if (SamplerSynthesiser::isVoiceCostAvailable())
+        row << (juce::String(result.filteredVoiceCost * 100.0, 3) + "%").paddedLeft(' ', 9)
+            << (juce::String(result.unfilteredVoiceCost * 100.0, 3) + "%").paddedLeft(' ', 9);
+
+    return row;
+}
+
+juce::String StressTest::toJSON() const
+{
+    juce::Array<juce::var> caseList;
+
+    for (auto& result : cases)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("workload", result.workload);
+        object->setProperty("library", result.library);
+        object->setProperty("polyphony", result.polyphony);
+        object->setProperty("library_bytes", result.libraryBytes);
+        object->setProperty("blocks", result.numBlocks);
+        object->setProperty("mean_load", result.meanLoad);
+        object->setProperty("p99_load", result.p99Load);
+        object->setProperty("worst_load", result.worstLoad);
+        object->setProperty("worst_block_seconds", result.worstBlockSeconds);
+        object->setProperty("overruns", result.overruns);
+        object->setProperty("mean_voices", result.meanVoices);
+        object->setProperty("peak_voices", result.peakVoices);
+        object->setProperty("voices_stolen", result.voicesStolen);
+        object->setProperty("realtime_factor", result.realtimeFactor);
+
+        if (SamplerSynthesiser::isVoiceCostAvailable())
+        {
+            object->setProperty("filtered_voice_cost", result.filteredVoiceCost);
+            object->setProperty("unfiltered_voice_cost", result.unfilteredVoiceCost);
+        }
+
+        caseList.add(juce::var(object));
+    }
+
+    auto* workload = new juce::DynamicObject();
+    workload->setProperty("seconds", settings.workload.seconds);
+    workload->setProperty("glissando_notes_per_second", settings.workload.glissandoNotesPerSecond);
+    workload->setProperty("chord_size", settings.workload.chordSize);
+    workload->setProperty("chords_per_second", settings.workload.chordsPerSecond);
+    workload->setProperty("controller_events_per_second", settings.workload.controllerEventsPerSecond);
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("sample_rate", settings.sampleRate);
+    root->setProperty("block_size", settings.blockSize);
+    root->setProperty("compressed_samples", settings.loadOptions.compressSamples);
+    root->setProperty("workload_settings", juce::var(workload));
+    root->setProperty("cases", caseList);
+
+    return juce::JSON::toString(juce::var(root));
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    StressTest.h
+    Created: Plays the stress workloads through the engine at each polyphony and library size
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SamplerEngine.h"
+#include "StressWorkloads.h"
+
+//==============================================================================
+/**
+    Runs every combination of workload, polyphony and library through a headless
+    SamplerEngine with OfflineRenderer, and reports what each cost: the render
+    time of every block against its deadline, how many voices were playing and
+    how many notes had to steal one. Builds that time the voices also show what a
+    voice cost with its filter and without.
+
+    Libraries are generated into a temporary folder unless a real SFZ is given,
+    and each is loaded once for all the cases that use it.
+*/
+class StressTest
+{
+public:
+    //==============================================================================
+    struct Settings
+    {
+        juce::Array<StressWorkloads::Workload> workloads;   // every workload if empty
+        juce::Array<int> polyphonies { 16, 32, 64, 128 };
+        juce::Array<int> librarySizes { 8, 30, 88 };         // zones in each generated library
+
+        /** A library to play instead of the generated ones */
+        juce::File sfzFile;
+
+        StressWorkloads::Settings workload;
+        double sampleSeconds = 3.0;   // length of the generated samples
+        EnhancedSFZLoader::LoadOptions loadOptions;
+
+        double sampleRate = 48000.0;
+        int blockSize = 128;
+        double tailSeconds = 1.0;
+    };
+
+    /** What one combination cost. Loads are fractions of the block period. */
+    struct Case
+    {
+        juce::String workload;
+        juce::String library;
+        int polyphony = 0;
+        juce::int64 libraryBytes = 0;
+
+        int numBlocks = 0;
+        double meanLoad = 0.0;
+        double p99Load = 0.0;
+        double worstLoad = 0.0;
+        double worstBlockSeconds = 0.0;
+        int overruns = 0;              // blocks that took longer than their period
+
+        double meanVoices = 0.0;
+        int peakVoices = 0;
+        int voicesStolen = 0;
+        double realtimeFactor = 0.0;
+
+        // Share of a core per voice with and without a filter, where the build times them
+        // (see SamplerSynthesiser::isVoiceCostAvailable())
+        double filteredVoiceCost = 0.0;
+        double unfilteredVoiceCost = 0.0;
+    };
+
+    explicit StressTest(const Settings& settingsToUse);
+    ~StressTest();
+
+    /** Runs every combination, printing a row of the table as each finishes.
+        Returns false if a library couldn't be written or loaded.
+    */
+    bool run(juce::String& error);
+
+    /** Returns the cases run so far */
+    const juce::Array<Case>& getCases() const noexcept { return cases; }
+
+    /** Returns the column headings and a row for one case, for printing */
+    static juce::String getTableHeader();
+    static juce::String toTableRow(const Case& result);
+
+    /** Returns the settings and every case as JSON */
+    juce::String toJSON() const;
+
+private:
+    //==============================================================================
+    bool runLibrary(const juce::File& sfzFile, const juce::String& libraryName, juce::String& error);
+
+    Settings settings;
+    juce::Array<Case> cases;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StressTest)
+};
\ No newline at end of file
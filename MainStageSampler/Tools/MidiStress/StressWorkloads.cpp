@@ -0,0 +1,264 @@
+/*
+  ==============================================================================
+
+    StressWorkloads.cpp
+    Created: Generates the MIDI and sample libraries that MidiStress plays
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "StressWorkloads.h"
+#include "OfflineRenderer.h"
+
+namespace
+{
+    constexpr int sustainController = 64;
+    constexpr int expressionController = 11;
+    constexpr int modWheelController = 1;
+    constexpr int brightnessController = 74;
+
+    void addEvent(juce::MidiMessageSequence& sequence, juce::MidiMessage message, double time)
+    {
+        message.setTimeStamp(time);
+        sequence.addEvent(message);
+    }
+
+    void addNote(juce::MidiMessageSequence& sequence, int note, int velocity, double start, double length)
+    {
+        addEvent(sequence, juce::MidiMessage::noteOn(1, note, (juce::uint8)juce::jlimit(1, 127, velocity)), start);
+        addEvent(sequence, juce::MidiMessage::noteOff(1, note), start + length);
+    }
+
+    bool isBlackKey(int note)
+    {
+        const auto pitchClass = note % 12;
+        return pitchClass == 1 || pitchClass == 3 || pitchClass == 6 || pitchClass == 8 || pitchClass == 10;
+    }
+
+    //==============================================================================
+    juce::MidiMessageSequence makeGlissando(const StressWorkloads::Settings& settings)
+    {
+        juce::MidiMessageSequence sequence;
+        juce::Random random(settings.seed);
+
+        const auto step = 1.0 / juce::jmax(1.0, settings.glissandoNotesPerSecond);
+        auto note = settings.lowestNote;
+        auto direction = 1;
+
+        addEvent(sequence, juce::MidiMessage::controllerEvent(1, sustainController, 127), 0.0);
+
+        for (auto time = 0.01; time < settings.seconds; time += step)
+        {
+            addNote(sequence, note, 70 + random.nextInt(40), time, step * 0.9);
+
+            // Next white key, turning round at the ends with a quick change of pedal
+            do
+            {
+                note += direction;
+
+                if (note > settings.highestNote || note < settings.lowestNote)
+                {
+                    direction = -direction;
+                    note += 2 * direction;
+
+                    addEvent(sequence, juce::MidiMessage::controllerEvent(1, sustainController, 0), time + step * 0.5);
+                    addEvent(sequence, juce::MidiMessage::controllerEvent(1, sustainController, 127), time + step * 0.9);
+                }
+            }
+            while (isBlackKey(note) && note > settings.lowestNote && note < settings.highestNote);
+        }
+
+        addEvent(sequence, juce::MidiMessage::controllerEvent(1, sustainController, 0), settings.seconds);
+        return sequence;
+    }
+
+    juce::MidiMessageSequence makeChords(const StressWorkloads::Settings& settings)
+    {
+        juce::MidiMessageSequence sequence;
+        juce::Random random(settings.seed + 1);
+
+        // Open voicings of A and D, spread upwards from the bass in fifths and thirds
+        const int intervals[] = { 0, 7, 12, 16, 19, 24 };
+        const int roots[] = { 33, 38 };
+        const auto period = 1.0 / juce::jmax(0.1, settings.chordsPerSecond);
+        int strike = 0;
+
+        for (auto time = 0.01; time < settings.seconds; time += period, ++strike)
+        {
+            const auto root = roots[strike % 2];
+
+            for (int i = 0; i < settings.chordSize; ++i)
+            {
+                const auto note = root + intervals[i % 6] + 24 * (i / 6);
+
+                if (note < settings.lowestNote || note > settings.highestNote)
+                    continue;
+
+                // Two hands never land quite together
+                const auto spread = random.nextDouble() * 0.005;
+                addNote(sequence, note, 118 + random.nextInt(10), time + spread, period * 0.85);
+            }
+        }
+
+        return sequence;
+    }
+
+    juce::MidiMessageSequence makeControllers(const StressWorkloads::Settings& settings)
+    {
+        juce::MidiMessageSequence sequence;
+        juce::Random random(settings.seed + 2);
+
+        // A chord restruck every two seconds, for the controllers to act on
+        const int chord[] = { 45, 52, 57, 61, 64, 69 };
+
+        for (auto time = 0.01; time < settings.seconds; time += 2.0)
+            for (auto note : chord)
+                addNote(sequence, note, 60 + random.nextInt(40), time, 1.9);
+
+        // Every value is sent, moved or not, as some pedals do
+        const auto step = 1.0 / juce::jmax(1.0, settings.controllerEventsPerSecond);
+        const auto twoPi = juce::MathConstants<double>::twoPi;
+
+        for (auto time = 0.0; time < settings.seconds; time += step)
+        {
+            const auto expression = 83.5 + 43.5 * std::sin(twoPi * 0.5 * time);
+            const auto modWheel = 127.0 * std::abs(std::fmod(time * 0.4, 2.0) - 1.0);
+            const auto brightness = 64.0 + 44.0 * std::sin(twoPi * 0.3 * time);
+            const auto halfPedal = 70.0 + 20.0 * std::sin(twoPi * 1.0 * time);
+
+            addEvent(sequence, juce::MidiMessage::controllerEvent(1, expressionController, juce::roundToInt(expression)), time);
+            addEvent(sequence, juce::MidiMessage::controllerEvent(1, modWheelController, juce::roundToInt(modWheel)), time);
+            addEvent(sequence, juce::MidiMessage::controllerEvent(1, brightnessController, juce::roundToInt(brightness)), time);
+            addEvent(sequence, juce::MidiMessage::controllerEvent(1, sustainController, juce::roundToInt(halfPedal)), time);
+        }
+
+        addEvent(sequence, juce::MidiMessage::controllerEvent(1, sustainController, 0), settings.seconds);
+        return sequence;
+    }
+
+    //==============================================================================
+    /** A decaying tone with falling upper partials, a little different in each channel */
+    juce::AudioBuffer<float> makeTone(double frequency, double sampleRate, double seconds)
+    {
+        juce::AudioBuffer<float> audio(2, (int)(seconds * sampleRate));
+        audio.clear();
+
+        constexpr int numPartials = 8;
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto* data = audio.getWritePointer(channel);
+            const auto detune = channel == 0 ? 1.0 : 1.0007;
+
+            for (int partial = 1; partial <= numPartials; ++partial)
+            {
+                const auto partialFrequency = frequency * partial * detune * std::sqrt(1.0 + 0.0004 * partial * partial);
+
+                if (partialFrequency >= sampleRate * 0.45)
+                    break;
+
+                const auto delta = juce::MathConstants<double>::twoPi * partialFrequency / sampleRate;
+                const auto decayPerSample = std::exp(-(1.0 + partial) / sampleRate);
+                auto level = 0.3 / partial;
+
+                for (int i = 0; i < audio.getNumSamples(); ++i)
+                {
+                    data[i] += (float)(level * std::sin(delta * i));
+                    level *= decayPerSample;
+                }
+            }
+        }
+
+        return audio;
+    }
+}
+
+//==============================================================================
+const char* StressWorkloads::getName(Workload workload)
+{
+    if (workload == Workload::glissando)    return "glissando";
+    if (workload == Workload::chords)       return "chords";
+    if (workload == Workload::controllers)  return "controllers";
+    return "combined";
+}
+
+bool StressWorkloads::findWorkload(const juce::String& name, Workload& workload)
+{
+    for (int i = 0; i < numWorkloads; ++i)
+    {
+        if (name.trim().equalsIgnoreCase(getName((Workload)i)))
+        {
+            workload = (Workload)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+juce::MidiMessageSequence StressWorkloads::generate(Workload workload, const Settings& settings)
+{
+    juce::MidiMessageSequence sequence;
+
+    if (workload == Workload::glissando || workload == Workload::combined)
+        sequence.addSequence(makeGlissando(settings), 0.0);
+
+    if (workload == Workload::chords || workload == Workload::combined)
+        sequence.addSequence(makeChords(settings), 0.0);
+
+    if (workload == Workload::controllers || workload == Workload::combined)
+        sequence.addSequence(makeControllers(settings), 0.0);
+
+    sequence.sort();
+    sequence.updateMatchedPairs();
+    return sequence;
+}
+
+//==============================================================================
+juce::File StressWorkloads::writeLibrary(const juce::File& directory, const LibrarySpec& spec, juce::String& error)
+{
+    constexpr double sampleFileRate = 44100.0;
+
+    auto samples = directory.getChildFile("samples");
+
+    if (!samples.createDirectory())
+    {
+        error = "Can't create " + samples.getFullPathName();
+        return {};
+    }
+
+    const auto numKeys = spec.highestNote - spec.lowestNote + 1;
+    const auto numZones = juce::jlimit(1, numKeys, spec.numZones);
+
+    juce::String text;
+    text << "// Generated by MidiStress: " << numZones << " zones of " << juce::String(spec.sampleSeconds, 1) << " s\n"
+         << "<control> default_path=samples/\n"
+         << "<global> ampeg_attack=0.001 ampeg_decay=" << juce::String(spec.sampleSeconds, 1)
+         << " ampeg_sustain=30 ampeg_release=0.4 fil_type=lpf_2p cutoff=6000 fil_veltrack=2400\n";
+
+    for (int zone = 0; zone < numZones; ++zone)
+    {
+        const auto lokey = spec.lowestNote + zone * numKeys / numZones;
+        const auto hikey = spec.lowestNote + (zone + 1) * numKeys / numZones - 1;
+        const auto root = (lokey + hikey) / 2;
+        const auto name = "zone_" + juce::String(zone) + ".wav";
+
+        const auto audio = makeTone(juce::MidiMessage::getMidiNoteInHertz(root), sampleFileRate, spec.sampleSeconds);
+
+        if (!OfflineRenderer::writeWavFile(samples.getChildFile(name), audio, sampleFileRate, 24, error))
+            return {};
+
+        text << "<region> sample=" << name << " lokey=" << lokey << " hikey=" << hikey << " pitch_keycenter=" << root << "\n";
+    }
+
+    auto sfz = directory.getChildFile("stress_" + juce::String(numZones) + ".sfz");
+
+    if (!sfz.replaceWithText(text))
+    {
+        error = "Can't write " + sfz.getFullPathName();
+        return {};
+    }
+
+    return sfz;
+}
\ No newline at end of file
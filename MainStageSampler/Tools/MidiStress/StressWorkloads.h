@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    StressWorkloads.h
+    Created: Generates the MIDI and sample libraries that MidiStress plays
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    The playing that costs the engine most, generated rather than recorded so
+    it can be made as dense as needed:
+
+      - glissando:   full-keyboard white-key sweeps with the sustain pedal down,
+                     re-pedalled at each turn, so voices pile up and then all release
+      - chords:      repeated fortissimo chords across the keyboard, each strike
+                     starting a new voice on top of the last one's release
+      - controllers: held notes under dense streams of expression (CC 11), mod
+                     wheel (CC 1), brightness (CC 74) and half-pedal (CC 64) values
+      - combined:    all three at once
+
+    Sequences are timed in seconds, as OfflineRenderer expects, and come out the
+    same for the same settings.
+*/
+namespace StressWorkloads
+{
+    enum class Workload
+    {
+        glissando,
+        chords,
+        controllers,
+        combined
+    };
+
+    constexpr int numWorkloads = 4;
+
+    /** Returns the name used on the command line and in reports */
+    const char* getName(Workload workload);
+
+    /** Finds the workload with the given name. Returns false if there isn't one. */
+    bool findWorkload(const juce::String& name, Workload& workload);
+
+    //==============================================================================
+    /** How dense the generated playing is */
+    struct Settings
+    {
+        double seconds = 6.0;                   // length of each workload, before the tail
+        int lowestNote = 21;                    // A0
+        int highestNote = 108;                  // C8
+        double glissandoNotesPerSecond = 30.0;
+        int chordSize = 10;
+        double chordsPerSecond = 6.0;
+        double controllerEventsPerSecond = 1000.0;   // for each of the four controllers
+        int seed = 1;
+    };
+
+    /** Generates one workload */
+    juce::MidiMessageSequence generate(Workload workload, const Settings& settings);
+
+    //==============================================================================
+    /** The shape of a generated library */
+    struct LibrarySpec
+    {
+        int numZones = 88;            // keyzones spread evenly over the keyboard, one sample each
+        double sampleSeconds = 3.0;   // length of each decaying sample
+        int lowestNote = 21;
+        int highestNote = 108;
+    };
+
+    /** Writes an SFZ and its samples into the directory, and returns the SFZ file.
+        The regions have a low-pass filter, so brightness changes reach every voice.
+    */
+    juce::File writeLibrary(const juce::File& directory, const LibrarySpec& spec, juce::String& error);
+}
\ No newline at end of file
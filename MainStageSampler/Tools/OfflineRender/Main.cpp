@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: Command line front end for OfflineRenderer
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+#include "RealtimeSafety.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: OfflineRender [options] <sfz file> <midi file> <output wav>" << std::endl
+                  << "  --rate <hz>          sample rate (default 48000)" << std::endl
+                  << "  --block <samples>    block size (default 256)" << std::endl
+                  << "  --tail <seconds>     rendered after the last MIDI event (default 3)" << std::endl
+                  << "  --bits <16|24|32>    WAV sample size (default 24)" << std::endl
+                  << "  --compress           hold samples compressed, as the app's load option" << std::endl
+                  << "  --interleave         hold stereo samples interleaved" << std::endl
+                  << "  --load-report <file> write where the load's time and memory went as JSON" << std::endl
+                  << "  --region-costs <file> write what each region cost to play as JSON" << std::endl
+                  << "                       (needs SAMPLER_REGION_COST_ATTRIBUTION)" << std::endl
+                  << "  --check-realtime     report allocations and locks on the audio threads, and exit" << std::endl
+                  << "                       with 3 if there were any (needs SAMPLER_REALTIME_SAFETY_CHECKS)" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    OfflineRenderer::Settings settings;
+    EnhancedSFZLoader::LoadOptions loadOptions;
+    int bitsPerSample = 24;
+    juce::StringArray paths;
+    juce::String loadReportPath, regionCostsPath;
+    bool checkRealtime = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--rate" && hasValue)         settings.sampleRate = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--block" && hasValue)   settings.blockSize = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--tail" && hasValue)    settings.tailSeconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--bits" && hasValue)    bitsPerSample = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--compress")            loadOptions.compressSamples = true;
+        else if (arg == "--interleave")          loadOptions.interleaveSamples = true;
+        else if (arg == "--load-report" && hasValue) loadReportPath = argv[++i];
+        else if (arg == "--region-costs" && hasValue) regionCostsPath = argv[++i];
+        else if (arg == "--check-realtime")      checkRealtime = true;
+        else if (arg.startsWith("--"))
+        {
+            printUsage();
+            return 1;
+        }
+        else
+        {
+            paths.add(arg);
+        }
+    }
+
+    if (paths.size() != 3 || settings.sampleRate <= 0.0 || settings.blockSize <= 0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (checkRealtime && !RealtimeSafety::isAvailable())
+    {
+        std::cerr << RealtimeSafety::getReport();
+        return 1;
+    }
+
+    const auto sfzFile = juce::File::getCurrentWorkingDirectory().getChildFile(paths[0]);
+    const auto midiFile = juce::File::getCurrentWorkingDirectory().getChildFile(paths[1]);
+    const auto outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(paths[2]);
+
+    juce::String error;
+    juce::MidiMessageSequence sequence;
+
+    if (!OfflineRenderer::readMidiFile(midiFile, sequence, error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    SamplerEngine engine;
+    engine.setLoadOptions(loadOptions);
+
+    engine.loadSampleSet(sfzFile);
+
+    const auto memory = engine.getSampleMemoryStats();
+    const auto profile = engine.getLoadProfile();
+
+    if (loadReportPath.isNotEmpty())
+    {
+        const auto reportFile = juce::File::getCurrentWorkingDirectory().getChildFile(loadReportPath);
+
+        if (!reportFile.replaceWithText(profile.toJSON()))
+            std::cerr << "Couldn't write " << reportFile.getFullPathName() << std::endl;
+    }
+
+    if (memory.storedBytes == 0)
+    {
+        std::cerr << sfzFile.getFileName() << ": no samples loaded" << std::endl;
+        return 1;
+    }
+
+    std::cout << profile.toString()
+              << "Holding " << juce::String((double)memory.storedBytes / (1024.0 * 1024.0), 1) << " MB of samples" << std::endl;
+
+    OfflineRenderer renderer(engine);
+    juce::AudioBuffer<float> audio;
+
+    // Only what the render itself does counts, not the load
+    RealtimeSafety::reset();
+    const auto report = renderer.render(sequence, settings, audio);
+
+    std::cout << report.toString();
+
+    if (loadOptions.compressSamples)
+        std::cout << "Decoding: " << juce::String(engine.getDecodeCostPerVoice() * 100.0, 3)
+                  << "% of a core per compressed voice" << std::endl;
+
+    const auto regionCosts = engine.getRegionCosts();
+
+    if (RegionCostTable::isAvailable())
+        std::cout << regionCosts.toString();
+
+    if (regionCostsPath.isNotEmpty())
+    {
+        const auto costsFile = juce::File::getCurrentWorkingDirectory().getChildFile(regionCostsPath);
+
+        if (!costsFile.replaceWithText(regionCosts.toJSON()))
+            std::cerr << "Couldn't write " << costsFile.getFullPathName() << std::endl;
+    }
+
+    if (!OfflineRenderer::writeWavFile(outputFile, audio, settings.sampleRate, bitsPerSample, error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << outputFile.getFullPathName() << std::endl;
+
+    if (checkRealtime)
+    {
+        std::cout << RealtimeSafety::getReport();
+
+        if (RealtimeSafety::getNumViolations() > 0)
+            return 3;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,229 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+    Created: Plays MIDI through the engine without an audio device
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+
+//==============================================================================
+double OfflineRenderer::Report::getRealtimeFactor() const noexcept
+{
+    return wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0;
+}
+
+double OfflineRenderer::Report::getBlockPercentile(double fraction) const
+{
+    if (blockSeconds.isEmpty())
+        return 0.0;
+
+    auto sorted = blockSeconds;
+    sorted.sort();
+
+    const auto index = juce::jlimit(0, sorted.size() - 1, (int)std::ceil(fraction * sorted.size()) - 1);
+    return sorted[index];
+}
+
+juce::String OfflineRenderer::Report::toString() const
+{
+    const auto period = getBlockPeriod();
+    auto toMicroseconds = [](double seconds) { return juce::String(seconds * 1.0e6, 1) + " us"; };
+    auto toLoad = [period](double seconds) { return juce::String(period > 0.0 ? 100.0 * seconds / period : 0.0, 1) + "%"; };
+
+    juce::String text;
+    text << "Rendered " << juce::String(audioSeconds, 2) << " s at " << juce::String(sampleRate, 0) << " Hz in "
+         << blockSeconds.size() << " blocks of " << blockSize << " (" << toMicroseconds(period) << " each)" << "\n";
+    text << "Real-time factor: " << juce::String(getRealtimeFactor(), 1) << "x (" << juce::String(wallSeconds, 2) << " s)" << "\n";
+    text << "Peak voices: " << peakVoices << " (" << voicesStolen << " stolen)" << "\n";
+    text << "Block render time:" << "\n";
+
+    for (auto fraction : { 0.5, 0.9, 0.99, 0.999, 1.0 })
+    {
+        const auto seconds = getBlockPercentile(fraction);
+        const auto label = fraction < 1.0 ? "  p" + juce::String(fraction * 100.0, fraction < 0.99 ? 0 : 1) : juce::String("  max");
+
+        text << label.paddedRight(' ', 8) << toMicroseconds(seconds).paddedLeft(' ', 12)
+             << toLoad(seconds).paddedLeft(' ', 10) << " of the period" << "\n";
+    }
+
+    // Where the blocks fell relative to their deadline
+    const double edges[] = { 0.1, 0.25, 0.5, 0.75, 1.0 };
+    int counts[juce::numElementsInArray(edges) + 1] = {};
+
+    for (auto seconds : blockSeconds)
+    {
+        int bin = 0;
+
+        while (bin < juce::numElementsInArray(edges) && seconds > edges[bin] * period)
+            ++bin;
+
+        ++counts[bin];
+    }
+
+    text << "Blocks by share of the period:" << "\n";
+
+    for (int bin = 0; bin <= juce::numElementsInArray(edges); ++bin)
+    {
+        const auto label = bin == juce::numElementsInArray(edges)
+            ? juce::String("over 100%")
+            : juce::String(bin == 0 ? 0.0 : edges[bin - 1] * 100.0, 0) + "-" + juce::String(edges[bin] * 100.0, 0) + "%";
+
+        text << "  " << label.paddedRight(' ', 10) << juce::String(counts[bin]).paddedLeft(' ', 8) << "\n";
+    }
+
+    return text;
+}
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer(SamplerEngine& engineToUse)
+    : engine(engineToUse)
+{
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+}
+
+OfflineRenderer::Report OfflineRenderer::render(const juce::MidiMessageSequence& sequence, const Settings& settings,
+    juce::AudioBuffer<float>& output)
+{
+    Report report;
+    report.sampleRate = settings.sampleRate;
+    report.blockSize = juce::jmax(1, settings.blockSize);
+
+    engine.setNonRealtime(true);
+    engine.prepareToPlay(report.sampleRate, report.blockSize);
+
+    const auto latency = engine.getLatencySamples();
+    const auto endTime = sequence.getNumEvents() > 0 ? sequence.getEndTime() : 0.0;
+    const auto numOutputSamples = (int)std::ceil((endTime + juce::jmax(0.0, settings.tailSeconds)) * report.sampleRate);
+    const auto numBlocks = (numOutputSamples + latency + report.blockSize - 1) / report.blockSize;
+
+    output.setSize(2, numOutputSamples);
+    output.clear();
+
+    report.audioSeconds = numOutputSamples / report.sampleRate;
+    report.blockSeconds.ensureStorageAllocated(numBlocks);
+    report.blockVoices.ensureStorageAllocated(numBlocks);
+
+    // The buffer a device would hand over, reused for every block
+    juce::AudioBuffer<float> block(2, report.blockSize);
+    juce::MidiBuffer midi;
+    int nextEvent = 0;
+
+    const auto renderStart = juce::Time::getHighResolutionTicks();
+
+    for (int blockIndex = 0; blockIndex < numBlocks; ++blockIndex)
+    {
+        const auto blockStart = (juce::int64)blockIndex * report.blockSize;
+
+        block.clear();
+        midi.clear();
+
+        // Events land on the sample they're timed for
+        while (nextEvent < sequence.getNumEvents())
+        {
+            const auto& message = sequence.getEventPointer(nextEvent)->message;
+            const auto position = (juce::int64)std::llround(message.getTimeStamp() * report.sampleRate);
+
+            if (position >= blockStart + report.blockSize)
+                break;
+
+            if (!message.isMetaEvent())
+                midi.addEvent(message, (int)juce::jmax((juce::int64)0, position - blockStart));
+
+            ++nextEvent;
+        }
+
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        engine.renderNextBlock(block, midi, 0, report.blockSize);
+        const auto endTicks = juce::Time::getHighResolutionTicks();
+
+        report.blockSeconds.add(juce::Time::highResolutionTicksToSeconds(endTicks - startTicks));
+        const auto activeVoices = engine.getNumActiveVoices();
+        report.blockVoices.add(activeVoices);
+        report.peakVoices = juce::jmax(report.peakVoices, activeVoices);
+
+        // Leave off the first latency samples, so output sample 0 is MIDI time 0
+        const auto firstOutput = blockStart - latency;
+        const auto skip = (int)juce::jmax((juce::int64)0, -firstOutput);
+        const auto numToCopy = (int)juce::jmin((juce::int64)report.blockSize - skip, (juce::int64)numOutputSamples - (firstOutput + skip));
+
+        if (numToCopy > 0)
+            for (int channel = 0; channel < 2; ++channel)
+                output.copyFrom(channel, (int)(firstOutput + skip), block, channel, skip, numToCopy);
+    }
+
+    report.wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - renderStart);
+    report.voicesStolen = (int)engine.getNumVoicesStolen();
+    return report;
+}
+
+//==============================================================================
+bool OfflineRenderer::readMidiFile(const juce::File& file, juce::MidiMessageSequence& sequence, juce::String& error)
+{
+    juce::FileInputStream stream(file);
+
+    if (!stream.openedOk())
+    {
+        error = "Can't open " + file.getFullPathName();
+        return false;
+    }
+
+    juce::MidiFile midiFile;
+
+    if (!midiFile.readFrom(stream))
+    {
+        error = file.getFileName() + " isn't a Standard MIDI File";
+        return false;
+    }
+
+    midiFile.convertTimestampTicksToSeconds();
+
+    sequence.clear();
+
+    for (int track = 0; track < midiFile.getNumTracks(); ++track)
+        sequence.addSequence(*midiFile.getTrack(track), 0.0);
+
+    sequence.sort();
+    return true;
+}
+
+bool OfflineRenderer::writeWavFile(const juce::File& file, const juce::AudioBuffer<float>& audio,
+    double sampleRate, int bitsPerSample, juce::String& error)
+{
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+
+    if (!stream->openedOk())
+    {
+        error = "Can't write " + file.getFullPathName();
+        return false;
+    }
+
+    // The writer takes the stream if it's made, and leaves it here if not
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::OutputStream> output(std::move(stream));
+    auto writer = wavFormat.createWriterFor(output, juce::AudioFormatWriterOptions()
+        .withSampleRate(sampleRate)
+        .withNumChannels(audio.getNumChannels())
+        .withBitsPerSample(bitsPerSample));
+
+    if (writer == nullptr)
+    {
+        error = "WAV doesn't support " + juce::String(bitsPerSample) + " bit samples";
+        return false;
+    }
+
+    if (!writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples()))
+    {
+        error = "Couldn't write all of " + file.getFullPathName();
+        return false;
+    }
+
+    return true;
+}
\ No newline at end of file
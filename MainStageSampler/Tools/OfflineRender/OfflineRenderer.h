@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+    Created: Plays MIDI through the engine without an audio device
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SamplerEngine.h"
+
+//==============================================================================
+/**
+    Drives a SamplerEngine the way an audio device would, block by block, but
+    as fast as it can go and from a MIDI sequence rather than live input.
+
+    Every block is timed around SamplerEngine::renderNextBlock(), so the report
+    shows how close each one came to its deadline as well as the overall speed.
+    The engine is put in non-real-time mode, so renders of the same input come
+    out the same.
+*/
+class OfflineRenderer
+{
+public:
+    //==============================================================================
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+
+        /** Rendered after the last MIDI event, for releases and the reverb tail */
+        double tailSeconds = 3.0;
+    };
+
+    /** What a render cost */
+    struct Report
+    {
+        double sampleRate = 0.0;
+        int blockSize = 0;
+
+        double audioSeconds = 0.0;     // length of the render
+        double wallSeconds = 0.0;      // time taken, including feeding the engine its MIDI
+        int peakVoices = 0;            // most voices playing at the end of any block
+        int voicesStolen = 0;          // notes that cut off a playing voice for want of a free one
+
+        /** Time spent in SamplerEngine::renderNextBlock() for each block, in seconds */
+        juce::Array<double> blockSeconds;
+
+        /** Voices playing at the end of each block */
+        juce::Array<int> blockVoices;
+
+        /** Returns how many times faster than real time the render ran */
+        double getRealtimeFactor() const noexcept;
+
+        /** Returns the time of one block of audio, in seconds */
+        double getBlockPeriod() const noexcept { return sampleRate > 0.0 ? blockSize / sampleRate : 0.0; }
+
+        /** Returns the block render time that the given fraction (0 to 1) of blocks came in under */
+        double getBlockPercentile(double fraction) const;
+
+        /** Returns a summary for printing */
+        juce::String toString() const;
+    };
+
+    //==============================================================================
+    explicit OfflineRenderer(SamplerEngine& engineToUse);
+    ~OfflineRenderer();
+
+    /** Prepares the engine, plays the sequence through it and fills output with the result.
+        Event timestamps are in seconds. The output is lined up with the MIDI: the engine's
+        latency is rendered past the end and left off the start.
+    */
+    Report render(const juce::MidiMessageSequence& sequence, const Settings& settings, juce::AudioBuffer<float>& output);
+
+    //==============================================================================
+    /** Reads every track of a Standard MIDI File into one sequence timed in seconds. */
+    static bool readMidiFile(const juce::File& file, juce::MidiMessageSequence& sequence, juce::String& error);
+
+    /** Writes audio to a WAV file, replacing anything already there. */
+    static bool writeWavFile(const juce::File& file, const juce::AudioBuffer<float>& audio,
+        double sampleRate, int bitsPerSample, juce::String& error);
+
+private:
+    //==============================================================================
+    SamplerEngine& engine;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OfflineRenderer)
+};
\ No newline at end of file
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: Command line front end for the soak test
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SoakTest.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: SoakTest [options]" << std::endl
+                  << "  --hours <h>                how long to play (default 1)" << std::endl
+                  << "  --report-seconds <s>       time between lines of statistics (default 60)" << std::endl
+                  << "  --sfz <file>               a library to swap between; give it more than once (default two generated)" << std::endl
+                  << "  --swap-seconds <s>         time between library swaps, 0 for none (default 60)" << std::endl
+                  << "  --compress                 hold samples compressed, as the app's load option" << std::endl
+                  << "  --rate <hz>                sample rate the device opens at (default 48000)" << std::endl
+                  << "  --block <samples>          block size (default 256)" << std::endl
+                  << "  --jitter-ms <ms>           most each callback starts late by (default 0)" << std::endl
+                  << "  --rate-change-seconds <s>  audio between device sample rate changes, 0 for none (default 0)" << std::endl
+                  << "  --rates <hz>               comma separated rates to change between (default 44100,48000,96000)" << std::endl
+                  << "  --restart-seconds <s>      audio between device stops and restarts, 0 for none (default 0)" << std::endl
+                  << "  --restart-gap-ms <ms>      how long each restart leaves the device stopped (default 100)" << std::endl
+                  << "  --seed <n>                 seed for the jitter and the playing (default 1)" << std::endl
+                  << "  --allow-misses <n>         missed deadlines that still pass (default 0)" << std::endl
+                  << "  --output <file>            also write the reports as JSON" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    SoakTest::Settings settings;
+    juce::File outputFile;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+        const auto cwd = juce::File::getCurrentWorkingDirectory();
+
+        if (arg == "--rates" && hasValue)
+        {
+            settings.faults.sampleRates.clear();
+
+            for (auto& token : juce::StringArray::fromTokens(argv[++i], ",", ""))
+                if (token.getDoubleValue() > 0.0)
+                    settings.faults.sampleRates.add(token.getDoubleValue());
+        }
+        else if (arg == "--hours" && hasValue)                  settings.durationSeconds = juce::String(argv[++i]).getDoubleValue() * 3600.0;
+        else if (arg == "--report-seconds" && hasValue)         settings.reportSeconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--sfz" && hasValue)                    settings.libraries.add(cwd.getChildFile(argv[++i]));
+        else if (arg == "--swap-seconds" && hasValue)           settings.swapSeconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--compress")                           settings.loadOptions.compressSamples = true;
+        else if (arg == "--rate" && hasValue)                   settings.sampleRate = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--block" && hasValue)                  settings.blockSize = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--jitter-ms" && hasValue)              settings.faults.jitterMs = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--rate-change-seconds" && hasValue)    settings.faults.sampleRateChangeSeconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--restart-seconds" && hasValue)        settings.faults.restartSeconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--restart-gap-ms" && hasValue)         settings.faults.restartGapMs = juce::String(argv[++i]).getDoubleValue();
+        else if (arg == "--allow-misses" && hasValue)           settings.maxMissedDeadlines = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--output" && hasValue)                 outputFile = cwd.getChildFile(argv[++i]);
+        else if (arg == "--seed" && hasValue)
+        {
+            settings.faults.seed = juce::String(argv[++i]).getIntValue();
+            settings.playing.seed = settings.faults.seed;
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (settings.durationSeconds <= 0.0 || settings.reportSeconds <= 0.0 || settings.sampleRate <= 0.0
+        || settings.blockSize <= 0 || settings.faults.jitterMs < 0.0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    SoakTest test(settings);
+    juce::String error;
+
+    if (!test.run(error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    if (outputFile != juce::File() && !outputFile.replaceWithText(test.toJSON()))
+    {
+        std::cerr << "Can't write " << outputFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    if (!test.hasPassed())
+    {
+        std::cerr << "Failed: " << test.getFailureReason() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Passed" << std::endl;
+    return 0;
+}
\ No newline at end of file
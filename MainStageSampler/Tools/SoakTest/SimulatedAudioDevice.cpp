@@ -0,0 +1,436 @@
+/*
+  ==============================================================================
+
+    SimulatedAudioDevice.cpp
+    Created: An audio device with no hardware, for running the app's callback headless
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "SimulatedAudioDevice.h"
+
+namespace
+{
+    double nowMs()
+    {
+        return juce::Time::getMillisecondCounterHiRes();
+    }
+
+    bool hasNonFiniteSamples(const juce::AudioBuffer<float>& buffer, int numSamples)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            const auto* data = buffer.getReadPointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+                if (!std::isfinite(data[i]))
+                    return true;
+        }
+
+        return false;
+    }
+
+    /** Raises the value to the candidate if it's higher. Only the device thread writes these. */
+    void storeMax(std::atomic<double>& value, double candidate)
+    {
+        if (candidate > value.load(std::memory_order_relaxed))
+            value.store(candidate, std::memory_order_relaxed);
+    }
+}
+
+//==============================================================================
+juce::String SimulatedAudioDevice::Stats::toString() const
+{
+    const auto totalSeconds = juce::roundToInt(secondsPlayed);
+
+    return juce::String(totalSeconds / 3600) + ":" + juce::String((totalSeconds / 60) % 60).paddedLeft('0', 2)
+         + ":" + juce::String(totalSeconds % 60).paddedLeft('0', 2) + " played, "
+         + juce::String(numCallbacks) + " callbacks, "
+         + juce::String(numMissedDeadlines) + " missed deadlines (worst by " + juce::String(worstOverrunMs, 2) + " ms), "
+         + "worst callback " + juce::String(worstCallbackMs, 2) + " ms, "
+         + juce::String(numSampleRateChanges) + " rate changes, "
+         + juce::String(numRestarts) + " restarts, "
+         + juce::String(numNonFiniteBlocks) + " blocks with NaN or infinite samples";
+}
+
+//==============================================================================
+SimulatedAudioDevice::SimulatedAudioDevice(const Faults& faultsToInject)
+    : juce::AudioIODevice(deviceName, typeName),
+      juce::Thread("Simulated audio device"),
+      faults(faultsToInject)
+{
+}
+
+SimulatedAudioDevice::~SimulatedAudioDevice()
+{
+    close();
+}
+
+SimulatedAudioDevice::Stats SimulatedAudioDevice::getStats() const
+{
+    Stats stats;
+    stats.numCallbacks = numCallbacks.load();
+    stats.numMissedDeadlines = numMissedDeadlines.load();
+    stats.numNonFiniteBlocks = numNonFiniteBlocks.load();
+    stats.worstCallbackMs = worstCallbackMs.load();
+    stats.worstOverrunMs = worstOverrunMs.load();
+    stats.numSampleRateChanges = numSampleRateChanges.load();
+    stats.numRestarts = numRestarts.load();
+    stats.secondsPlayed = secondsPlayed.load();
+    return stats;
+}
+
+//==============================================================================
+juce::StringArray SimulatedAudioDevice::getOutputChannelNames()
+{
+    return { "Left", "Right" };
+}
+
+juce::StringArray SimulatedAudioDevice::getInputChannelNames()
+{
+    return {};
+}
+
+juce::Array<double> SimulatedAudioDevice::getAvailableSampleRates()
+{
+    juce::Array<double> rates { 44100.0, 48000.0, 88200.0, 96000.0 };
+
+    for (auto rate : faults.sampleRates)
+        rates.addIfNotAlreadyThere(rate);
+
+    rates.sort();
+    return rates;
+}
+
+juce::Array<int> SimulatedAudioDevice::getAvailableBufferSizes()
+{
+    return { 32, 64, 128, 256, 512, 1024, 2048 };
+}
+
+int SimulatedAudioDevice::getDefaultBufferSize()
+{
+    return 256;
+}
+
+//==============================================================================
+juce::String SimulatedAudioDevice::open(const juce::BigInteger& /*inputChannels*/, const juce::BigInteger& outputChannels,
+    double sampleRate, int bufferSizeSamples)
+{
+    close();
+
+    if (sampleRate <= 0.0 || bufferSizeSamples <= 0)
+        return "The simulated device needs a sample rate and buffer size";
+
+    // Two outputs at most, and no inputs
+    activeOutputs.clear();
+    activeOutputs.setBit(0, outputChannels[0]);
+    activeOutputs.setBit(1, outputChannels[1]);
+
+    currentSampleRate.store(sampleRate);
+    currentBufferSize.store(bufferSizeSamples);
+    outputBuffer.setSize(activeOutputs.countNumberOfSetBits(), bufferSizeSamples);
+    nextSampleRateIndex = 0;
+
+    numCallbacks.store(0);
+    numMissedDeadlines.store(0);
+    numNonFiniteBlocks.store(0);
+    worstCallbackMs.store(0.0);
+    worstOverrunMs.store(0.0);
+    secondsPlayed.store(0.0);
+    numSampleRateChanges.store(0);
+    numRestarts.store(0);
+
+    opened = true;
+    startThread(juce::Thread::Priority::highest);
+    return {};
+}
+
+void SimulatedAudioDevice::close()
+{
+    stop();
+    stopThread(2000);
+    opened = false;
+}
+
+bool SimulatedAudioDevice::isOpen()
+{
+    return opened;
+}
+
+//==============================================================================
+void SimulatedAudioDevice::start(juce::AudioIODeviceCallback* callbackToUse)
+{
+    if (!opened || callbackToUse == nullptr)
+        return;
+
+    stop();
+    callbackToUse->audioDeviceAboutToStart(this);
+
+    const juce::ScopedLock sl(callbackLock);
+    callback = callbackToUse;
+}
+
+void SimulatedAudioDevice::stop()
+{
+    juce::AudioIODeviceCallback* lastCallback = nullptr;
+
+    {
+        const juce::ScopedLock sl(callbackLock);
+
+        // One stopped for a restart has already been told
+        lastCallback = callback;
+        callback = nullptr;
+        pausedCallback = nullptr;
+    }
+
+    if (lastCallback != nullptr)
+        lastCallback->audioDeviceStopped();
+}
+
+bool SimulatedAudioDevice::isPlaying()
+{
+    const juce::ScopedLock sl(callbackLock);
+    return callback != nullptr || pausedCallback != nullptr;
+}
+
+juce::String SimulatedAudioDevice::getLastError()
+{
+    return {};
+}
+
+//==============================================================================
+int SimulatedAudioDevice::getCurrentBufferSizeSamples()
+{
+    return currentBufferSize.load();
+}
+
+double SimulatedAudioDevice::getCurrentSampleRate()
+{
+    return currentSampleRate.load();
+}
+
+int SimulatedAudioDevice::getCurrentBitDepth()
+{
+    return 32;
+}
+
+juce::BigInteger SimulatedAudioDevice::getActiveOutputChannels() const
+{
+    return activeOutputs;
+}
+
+juce::BigInteger SimulatedAudioDevice::getActiveInputChannels() const
+{
+    return {};
+}
+
+int SimulatedAudioDevice::getOutputLatencyInSamples()
+{
+    // The block handed back plays while the next is rendered
+    return currentBufferSize.load();
+}
+
+int SimulatedAudioDevice::getInputLatencyInSamples()
+{
+    return 0;
+}
+
+int SimulatedAudioDevice::getXRunCount() const noexcept
+{
+    return (int)numMissedDeadlines.load();
+}
+
+//==============================================================================
+void SimulatedAudioDevice::run()
+{
+    juce::Random random(faults.seed);
+    auto nextStartMs = nowMs();
+    auto secondsToRateChange = faults.sampleRateChangeSeconds;
+    auto secondsToRestart = faults.restartSeconds;
+
+    while (!threadShouldExit())
+    {
+        const auto bufferSize = currentBufferSize.load();
+        const auto blockSeconds = bufferSize / currentSampleRate.load();
+        const auto deadlineMs = nextStartMs + blockSeconds * 1000.0;
+
+        // Drawn whether or not there's a callback, so the jitter doesn't depend on when one was added
+        const auto jitterMs = faults.jitterMs * random.nextDouble();
+
+        if (!waitUntil(nextStartMs + jitterMs))
+            break;
+
+        const auto startMs = nowMs();
+        bool called = false;
+
+        {
+            const juce::ScopedLock sl(callbackLock);
+
+            if (callback != nullptr)
+            {
+                callback->audioDeviceIOCallbackWithContext(nullptr, 0, outputBuffer.getArrayOfWritePointers(),
+                    outputBuffer.getNumChannels(), bufferSize, {});
+                called = true;
+            }
+        }
+
+        const auto endMs = nowMs();
+        nextStartMs = deadlineMs;
+
+        if (called)
+        {
+            numCallbacks.fetch_add(1, std::memory_order_relaxed);
+            storeMax(worstCallbackMs, endMs - startMs);
+
+            if (endMs > deadlineMs)
+            {
+                numMissedDeadlines.fetch_add(1, std::memory_order_relaxed);
+                storeMax(worstOverrunMs, endMs - deadlineMs);
+            }
+
+            if (hasNonFiniteSamples(outputBuffer, bufferSize))
+                numNonFiniteBlocks.fetch_add(1, std::memory_order_relaxed);
+
+            secondsPlayed.store(secondsPlayed.load(std::memory_order_relaxed) + blockSeconds, std::memory_order_relaxed);
+
+            if (faults.sampleRateChangeSeconds > 0.0 && (secondsToRateChange -= blockSeconds) <= 0.0)
+            {
+                changeSampleRate();
+                secondsToRateChange += faults.sampleRateChangeSeconds;
+                nextStartMs = nowMs();
+            }
+
+            if (faults.restartSeconds > 0.0 && (secondsToRestart -= blockSeconds) <= 0.0)
+            {
+                restart();
+                secondsToRestart += faults.restartSeconds;
+                nextStartMs = nowMs();
+            }
+        }
+
+        // A whole block behind: a real device would have dropped out and carried on from now
+        if (endMs > nextStartMs + blockSeconds * 1000.0)
+            nextStartMs = endMs;
+    }
+}
+
+bool SimulatedAudioDevice::waitUntil(double targetMs)
+{
+    // Sleeps most of the way, then spins, so the wake-up is well inside a millisecond
+    for (;;)
+    {
+        if (threadShouldExit())
+            return false;
+
+        const auto remaining = targetMs - nowMs();
+
+        if (remaining <= 0.0)
+            return true;
+
+        if (remaining > 2.0)
+            juce::Thread::sleep(1);
+        else
+            juce::Thread::yield();
+    }
+}
+
+void SimulatedAudioDevice::changeSampleRate()
+{
+    const auto currentRate = currentSampleRate.load();
+    auto newRate = currentRate;
+
+    for (int i = 0; i < faults.sampleRates.size() && newRate == currentRate; ++i)
+        newRate = faults.sampleRates[nextSampleRateIndex++ % faults.sampleRates.size()];
+
+    if (newRate == currentRate)
+        return;
+
+    // As a device whose rate is changed under it does: stop, change, start again
+    const juce::ScopedLock sl(callbackLock);
+
+    if (callback != nullptr)
+        callback->audioDeviceStopped();
+
+    currentSampleRate.store(newRate);
+    numSampleRateChanges.fetch_add(1);
+
+    if (callback != nullptr)
+        callback->audioDeviceAboutToStart(this);
+}
+
+void SimulatedAudioDevice::restart()
+{
+    juce::AudioIODeviceCallback* stoppedCallback = nullptr;
+
+    {
+        const juce::ScopedLock sl(callbackLock);
+        stoppedCallback = callback;
+        pausedCallback = callback;
+        callback = nullptr;
+    }
+
+    if (stoppedCallback == nullptr)
+        return;
+
+    stoppedCallback->audioDeviceStopped();
+    numRestarts.fetch_add(1);
+
+    wait(faults.restartGapMs);
+
+    const juce::ScopedLock sl(callbackLock);
+
+    // Unless stop() was called while it was down
+    if (pausedCallback != nullptr)
+    {
+        pausedCallback->audioDeviceAboutToStart(this);
+        callback = pausedCallback;
+        pausedCallback = nullptr;
+    }
+}
+
+//==============================================================================
+SimulatedAudioDeviceType::SimulatedAudioDeviceType(const SimulatedAudioDevice::Faults& faultsToInject)
+    : juce::AudioIODeviceType(SimulatedAudioDevice::typeName),
+      faults(faultsToInject)
+{
+}
+
+SimulatedAudioDeviceType::~SimulatedAudioDeviceType()
+{
+}
+
+void SimulatedAudioDeviceType::scanForDevices()
+{
+}
+
+juce::StringArray SimulatedAudioDeviceType::getDeviceNames(bool wantInputNames) const
+{
+    if (wantInputNames)
+        return {};
+
+    return { SimulatedAudioDevice::deviceName };
+}
+
+int SimulatedAudioDeviceType::getDefaultDeviceIndex(bool forInput) const
+{
+    return forInput ? -1 : 0;
+}
+
+int SimulatedAudioDeviceType::getIndexOfDevice(juce::AudioIODevice* device, bool asInput) const
+{
+    return (!asInput && dynamic_cast<SimulatedAudioDevice*>(device) != nullptr) ? 0 : -1;
+}
+
+bool SimulatedAudioDeviceType::hasSeparateInputsAndOutputs() const
+{
+    return false;
+}
+
+juce::AudioIODevice* SimulatedAudioDeviceType::createDevice(const juce::String& outputDeviceName, const juce::String& /*inputDeviceName*/)
+{
+    if (outputDeviceName.isNotEmpty() && outputDeviceName != SimulatedAudioDevice::deviceName)
+        return nullptr;
+
+    return new SimulatedAudioDevice(faults);
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+    SimulatedAudioDevice.h
+    Created: An audio device with no hardware, for running the app's callback headless
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A stereo output device that calls its callback from its own thread at the
+    block rate on the wall clock, as a sound card's driver would, and throws
+    away what comes back.
+
+    Each callback has until the next is due to return. One that returns later
+    has missed its deadline, which on a real device is a dropout; those count
+    as xruns. A device that falls a whole block behind starts its clock again
+    from there rather than racing to catch up.
+
+    It can also misbehave the way real devices do:
+
+      - jitter:    each callback starts up to a given time late, leaving the
+                   callback less of its period
+      - rates:     the device stops, changes sample rate and starts again, as
+                   when another application changes a shared device's rate
+      - restarts:  the device stops for a moment and starts again, as after a
+                   driver reset or a USB interface dropping out
+
+    Changes and restarts fall at set intervals of audio played, and the jitter
+    comes from a seeded generator, so the same settings give the same run.
+*/
+class SimulatedAudioDevice : public juce::AudioIODevice,
+    private juce::Thread
+{
+public:
+    //==============================================================================
+    static constexpr const char* typeName = "Simulated";
+    static constexpr const char* deviceName = "Simulated Output";
+
+    /** What goes wrong, and how often */
+    struct Faults
+    {
+        double jitterMs = 0.0;                  // most a callback starts late by
+        double sampleRateChangeSeconds = 0.0;   // audio played between rate changes, 0 for none
+        juce::Array<double> sampleRates { 44100.0, 48000.0, 96000.0 };   // taken in turn after the opened rate
+        double restartSeconds = 0.0;            // audio played between restarts, 0 for none
+        double restartGapMs = 100.0;            // how long the device is stopped for
+        int seed = 1;
+    };
+
+    /** What the device has seen since it was opened */
+    struct Stats
+    {
+        juce::int64 numCallbacks = 0;
+        juce::int64 numMissedDeadlines = 0;
+        juce::int64 numNonFiniteBlocks = 0;     // callbacks that returned NaN or infinite samples
+        double worstCallbackMs = 0.0;
+        double worstOverrunMs = 0.0;            // furthest past its deadline a callback returned
+        int numSampleRateChanges = 0;
+        int numRestarts = 0;
+        double secondsPlayed = 0.0;
+
+        /** Returns a one-line summary, for printing */
+        juce::String toString() const;
+    };
+
+    //==============================================================================
+    explicit SimulatedAudioDevice(const Faults& faultsToInject);
+    ~SimulatedAudioDevice() override;
+
+    /** Returns the statistics so far. Safe to call from any thread. */
+    Stats getStats() const;
+
+    //==============================================================================
+    juce::StringArray getOutputChannelNames() override;
+    juce::StringArray getInputChannelNames() override;
+    juce::Array<double> getAvailableSampleRates() override;
+    juce::Array<int> getAvailableBufferSizes() override;
+    int getDefaultBufferSize() override;
+
+    juce::String open(const juce::BigInteger& inputChannels, const juce::BigInteger& outputChannels,
+        double sampleRate, int bufferSizeSamples) override;
+    void close() override;
+    bool isOpen() override;
+
+    void start(juce::AudioIODeviceCallback* callbackToUse) override;
+    void stop() override;
+    bool isPlaying() override;
+    juce::String getLastError() override;
+
+    int getCurrentBufferSizeSamples() override;
+    double getCurrentSampleRate() override;
+    int getCurrentBitDepth() override;
+    juce::BigInteger getActiveOutputChannels() const override;
+    juce::BigInteger getActiveInputChannels() const override;
+    int getOutputLatencyInSamples() override;
+    int getInputLatencyInSamples() override;
+    int getXRunCount() const noexcept override;
+
+private:
+    //==============================================================================
+    void run() override;
+    bool waitUntil(double targetMs);
+    void changeSampleRate();
+    void restart();
+
+    const Faults faults;
+
+    juce::AudioBuffer<float> outputBuffer;
+    juce::BigInteger activeOutputs;
+    std::atomic<double> currentSampleRate { 48000.0 };
+    std::atomic<int> currentBufferSize { 256 };
+    int nextSampleRateIndex = 0;
+    bool opened = false;
+
+    // Held by the device thread around each callback, so start() and stop() wait for one in progress
+    juce::CriticalSection callbackLock;
+    juce::AudioIODeviceCallback* callback = nullptr;
+    juce::AudioIODeviceCallback* pausedCallback = nullptr;    // stopped for a restart, and started again after it
+
+    std::atomic<juce::int64> numCallbacks { 0 }, numMissedDeadlines { 0 }, numNonFiniteBlocks { 0 };
+    std::atomic<double> worstCallbackMs { 0.0 }, worstOverrunMs { 0.0 }, secondsPlayed { 0.0 };
+    std::atomic<int> numSampleRateChanges { 0 }, numRestarts { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SimulatedAudioDevice)
+};
+
+//==============================================================================
+/**
+    Offers the simulated device to an AudioDeviceManager. Add it with
+    addAudioDeviceType() and select it with setCurrentAudioDeviceType().
+*/
+class SimulatedAudioDeviceType : public juce::AudioIODeviceType
+{
+public:
+    //==============================================================================
+    explicit SimulatedAudioDeviceType(const SimulatedAudioDevice::Faults& faultsToInject);
+    ~SimulatedAudioDeviceType() override;
+
+    void scanForDevices() override;
+    juce::StringArray getDeviceNames(bool wantInputNames = false) const override;
+    int getDefaultDeviceIndex(bool forInput) const override;
+    int getIndexOfDevice(juce::AudioIODevice* device, bool asInput) const override;
+    bool hasSeparateInputsAndOutputs() const override;
+    juce::AudioIODevice* createDevice(const juce::String& outputDeviceName, const juce::String& inputDeviceName) override;
+
+private:
+    //==============================================================================
+    const SimulatedAudioDevice::Faults faults;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SimulatedAudioDeviceType)
+};
\ No newline at end of file
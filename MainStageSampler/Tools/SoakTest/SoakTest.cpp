@@ -0,0 +1,313 @@
+/*
+  ==============================================================================
+
+    SoakTest.cpp
+    Created: Hours of heavy playing and instrument swaps through the app's audio callback
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#include "SoakTest.h"
+#include "RealtimeSafety.h"
+
+namespace
+{
+    double nowSeconds()
+    {
+        return juce::Time::getMillisecondCounterHiRes() * 0.001;
+    }
+}
+
+//==============================================================================
+SoakTest::SoakTest(const Settings& settingsToUse)
+    : settings(settingsToUse)
+{
+}
+
+SoakTest::~SoakTest()
+{
+    deviceManager.removeAudioCallback(&audioCallback);
+    deviceManager.closeAudioDevice();
+
+    // A swap still loading needs the engine
+    while (loading.load())
+        juce::Thread::sleep(10);
+
+    if (generatedDirectory != juce::File())
+        generatedDirectory.deleteRecursively();
+}
+
+//==============================================================================
+bool SoakTest::run(juce::String& error)
+{
+    reports.clear();
+
+    if (!prepareLibraries(error))
+        return false;
+
+    engine.setLoadOptions(settings.loadOptions);
+    engine.loadSampleSet(settings.libraries.getFirst());
+    nextLibrary = 1;
+
+    if (engine.getSampleMemoryStats().storedBytes == 0)
+    {
+        error = settings.libraries.getFirst().getFileName() + ": no samples loaded";
+        return false;
+    }
+
+    deviceManager.addAudioDeviceType(std::make_unique<SimulatedAudioDeviceType>(settings.faults));
+    deviceManager.setCurrentAudioDeviceType(SimulatedAudioDevice::typeName, true);
+
+    auto setup = deviceManager.getAudioDeviceSetup();
+    setup.outputDeviceName = SimulatedAudioDevice::deviceName;
+    setup.sampleRate = settings.sampleRate;
+    setup.bufferSize = settings.blockSize;
+
+    error = deviceManager.setAudioDeviceSetup(setup, true);
+
+    if (error.isNotEmpty())
+        return false;
+
+    if (dynamic_cast<SimulatedAudioDevice*>(deviceManager.getCurrentAudioDevice()) == nullptr)
+    {
+        error = "The simulated device didn't open";
+        return false;
+    }
+
+    deviceManager.addAudioCallback(&audioCallback);
+    std::cout << getTableHeader() << std::endl;
+
+    const auto sequence = StressWorkloads::generate(StressWorkloads::Workload::combined, settings.playing);
+    const auto loopSeconds = settings.playing.seconds + 1.0;    // the last releases die away before it comes round again
+
+    const auto startSeconds = nowSeconds();
+    auto loopStart = startSeconds;
+    auto nextReport = startSeconds + settings.reportSeconds;
+    auto nextSwap = startSeconds + settings.swapSeconds;
+    int nextEvent = 0;
+
+    for (auto now = startSeconds; now - startSeconds < settings.durationSeconds; now = nowSeconds())
+    {
+        // Whatever has come due, stamped with when it arrived as a MIDI device's messages are
+        while (nextEvent < sequence.getNumEvents() && loopStart + sequence.getEventTime(nextEvent) <= now)
+        {
+            auto message = sequence.getEventPointer(nextEvent++)->message;
+            message.setTimeStamp(now);
+            noteInput.handleIncomingMidiMessage(nullptr, message);
+        }
+
+        if (nextEvent >= sequence.getNumEvents() && now >= loopStart + loopSeconds)
+        {
+            loopStart += loopSeconds;
+            nextEvent = 0;
+        }
+
+        if (settings.swapSeconds > 0.0 && now >= nextSwap)
+        {
+            swapLibrary();
+            nextSwap += settings.swapSeconds;
+        }
+
+        if (now >= nextReport)
+        {
+            reports.add(makeReport(now - startSeconds));
+            std::cout << toTableRow(reports.getLast()) << std::endl;
+            nextReport += settings.reportSeconds;
+        }
+
+        juce::Thread::sleep(1);
+    }
+
+    reports.add(makeReport(nowSeconds() - startSeconds));
+    std::cout << toTableRow(reports.getLast()) << std::endl;
+
+    deviceManager.removeAudioCallback(&audioCallback);
+    deviceManager.closeAudioDevice();
+    return true;
+}
+
+bool SoakTest::prepareLibraries(juce::String& error)
+{
+    if (!settings.libraries.isEmpty())
+    {
+        for (auto& file : settings.libraries)
+        {
+            if (!file.existsAsFile())
+            {
+                error = "Can't find " + file.getFullPathName();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // A full keyboard and a sparse one, so each swap changes what's loaded
+    generatedDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+        .getChildFile("SoakTest_" + juce::String::toHexString(juce::Random::getSystemRandom().nextInt()));
+
+    for (auto numZones : { 88, 30 })
+    {
+        StressWorkloads::LibrarySpec spec;
+        spec.numZones = numZones;
+
+        const auto sfz = StressWorkloads::writeLibrary(generatedDirectory.getChildFile("zones_" + juce::String(numZones)), spec, error);
+
+        if (sfz == juce::File())
+            return false;
+
+        settings.libraries.add(sfz);
+    }
+
+    return true;
+}
+
+void SoakTest::swapLibrary()
+{
+    // Still loading the last one; a player wouldn't drop another file on it either
+    if (loading.exchange(true))
+        return;
+
+    const auto file = settings.libraries[nextLibrary++ % settings.libraries.size()];
+
+    // As MainComponent loads a dropped file
+    juce::Thread::launch([this, file]()
+        {
+            engine.loadSampleSet(file);
+
+            const auto seconds = engine.getLoadProfile().total.wallSeconds;
+
+            if (seconds > worstSwapSeconds.load())
+                worstSwapSeconds.store(seconds);
+
+            ++numSwaps;
+            loading.store(false);
+        });
+}
+
+SoakTest::Report SoakTest::makeReport(double elapsedSeconds)
+{
+    Report report;
+    report.elapsedSeconds = elapsedSeconds;
+
+    if (auto* device = dynamic_cast<SimulatedAudioDevice*>(deviceManager.getCurrentAudioDevice()))
+    {
+        report.device = device->getStats();
+        report.sampleRate = device->getCurrentSampleRate();
+    }
+
+    report.peakLoad = loadMonitor.getAndResetPeakLoad();
+    report.activeVoices = engine.getNumActiveVoices();
+    report.numSwaps = numSwaps.load();
+    report.worstSwapSeconds = worstSwapSeconds.load();
+    report.realtimeViolations = RealtimeSafety::getNumViolations();
+    return report;
+}
+
+//==============================================================================
+bool SoakTest::hasPassed() const
+{
+    return getFailureReason().isEmpty();
+}
+
+juce::String SoakTest::getFailureReason() const
+{
+    if (reports.isEmpty())
+        return "The soak didn't run";
+
+    const auto& last = reports.getLast();
+    juce::StringArray reasons;
+
+    if (last.device.numNonFiniteBlocks > 0)
+        reasons.add(juce::String(last.device.numNonFiniteBlocks) + " blocks had NaN or infinite samples");
+
+    if (last.device.numMissedDeadlines > settings.maxMissedDeadlines)
+        reasons.add(juce::String(last.device.numMissedDeadlines) + " callbacks missed their deadline ("
+            + juce::String(settings.maxMissedDeadlines) + " allowed)");
+
+    if (last.realtimeViolations > 0)
+        reasons.add(juce::String(last.realtimeViolations) + " allocations or locks on the audio thread");
+
+    return reasons.joinIntoString("; ");
+}
+
+//==============================================================================
+juce::String SoakTest::getTableHeader()
+{
+    return juce::String("minutes").paddedLeft(' ', 8) + juce::String("rate").paddedLeft(' ', 8)
+         + juce::String("callbacks").paddedLeft(' ', 11) + juce::String("missed").paddedLeft(' ', 8)
+         + juce::String("worst ms").paddedLeft(' ', 10) + juce::String("peak").paddedLeft(' ', 8)
+         + juce::String("voices").paddedLeft(' ', 8) + juce::String("swaps").paddedLeft(' ', 7)
+         + juce::String("load s").paddedLeft(' ', 8) + juce::String("rate chg").paddedLeft(' ', 10)
+         + juce::String("restarts").paddedLeft(' ', 10) + juce::String("non-finite").paddedLeft(' ', 12)
+         + juce::String("rt faults").paddedLeft(' ', 11);
+}
+
+juce::String SoakTest::toTableRow(const Report& report)
+{
+    return juce::String(report.elapsedSeconds / 60.0, 1).paddedLeft(' ', 8)
+         + juce::String(juce::roundToInt(report.sampleRate)).paddedLeft(' ', 8)
+         + juce::String(report.device.numCallbacks).paddedLeft(' ', 11)
+         + juce::String(report.device.numMissedDeadlines).paddedLeft(' ', 8)
+         + juce::String(report.device.worstCallbackMs, 2).paddedLeft(' ', 10)
+         + (juce::String(report.peakLoad * 100.0f, 1) + "%").paddedLeft(' ', 8)
+         + juce::String(report.activeVoices).paddedLeft(' ', 8)
+         + juce::String(report.numSwaps).paddedLeft(' ', 7)
+         + juce::String(report.worstSwapSeconds, 2).paddedLeft(' ', 8)
+         + juce::String(report.device.numSampleRateChanges).paddedLeft(' ', 10)
+         + juce::String(report.device.numRestarts).paddedLeft(' ', 10)
+         + juce::String(report.device.numNonFiniteBlocks).paddedLeft(' ', 12)
+         + juce::String(report.realtimeViolations).paddedLeft(' ', 11);
+}
+
+juce::String SoakTest::toJSON() const
+{
+    juce::Array<juce::var> reportList;
+
+    for (auto& report : reports)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("elapsed_seconds", report.elapsedSeconds);
+        object->setProperty("sample_rate", report.sampleRate);
+        object->setProperty("callbacks", report.device.numCallbacks);
+        object->setProperty("missed_deadlines", report.device.numMissedDeadlines);
+        object->setProperty("worst_callback_ms", report.device.worstCallbackMs);
+        object->setProperty("worst_overrun_ms", report.device.worstOverrunMs);
+        object->setProperty("non_finite_blocks", report.device.numNonFiniteBlocks);
+        object->setProperty("sample_rate_changes", report.device.numSampleRateChanges);
+        object->setProperty("restarts", report.device.numRestarts);
+        object->setProperty("seconds_played", report.device.secondsPlayed);
+        object->setProperty("peak_load", report.peakLoad);
+        object->setProperty("active_voices", report.activeVoices);
+        object->setProperty("swaps", report.numSwaps);
+        object->setProperty("worst_swap_seconds", report.worstSwapSeconds);
+        object->setProperty("realtime_violations", report.realtimeViolations);
+        reportList.add(juce::var(object));
+    }
+
+    juce::Array<juce::var> libraryList;
+
+    for (auto& file : settings.libraries)
+        libraryList.add(file.getFullPathName());
+
+    auto* faults = new juce::DynamicObject();
+    faults->setProperty("jitter_ms", settings.faults.jitterMs);
+    faults->setProperty("sample_rate_change_seconds", settings.faults.sampleRateChangeSeconds);
+    faults->setProperty("restart_seconds", settings.faults.restartSeconds);
+    faults->setProperty("restart_gap_ms", settings.faults.restartGapMs);
+    faults->setProperty("seed", settings.faults.seed);
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("duration_seconds", settings.durationSeconds);
+    root->setProperty("sample_rate", settings.sampleRate);
+    root->setProperty("block_size", settings.blockSize);
+    root->setProperty("swap_seconds", settings.swapSeconds);
+    root->setProperty("libraries", libraryList);
+    root->setProperty("faults", juce::var(faults));
+    root->setProperty("passed", hasPassed());
+    root->setProperty("failure", getFailureReason());
+    root->setProperty("reports", reportList);
+
+    return juce::JSON::toString(juce::var(root));
+}
\ No newline at end of file
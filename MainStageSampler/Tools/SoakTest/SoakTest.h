@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    SoakTest.h
+    Created: Hours of heavy playing and instrument swaps through the app's audio callback
+    Author:  Joel.Cox
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SamplerEngine.h"
+#include "NoteInput.h"
+#include "CallbackLoadMonitor.h"
+#include "SamplerAudioCallback.h"
+#include "SimulatedAudioDevice.h"
+#include "StressWorkloads.h"
+
+//==============================================================================
+/**
+    Runs the app's audio callback on a SimulatedAudioDevice through an
+    AudioDeviceManager, as the app does on a real one, for as long as asked.
+
+    The whole time, the stress workloads' combined playing loops into NoteInput
+    as MIDI from a device would arrive, and every so often the next library is
+    loaded on a background thread the way the app loads a dropped SFZ, so the
+    swap happens under the playing. The device adds whatever jitter, rate
+    changes and restarts it's given.
+
+    A line of statistics is printed at each report interval. The run passes if
+    no block had NaN or infinite samples, no more deadlines were missed than
+    allowed, and, in builds with the checks, the audio thread never allocated
+    or locked.
+*/
+class SoakTest
+{
+public:
+    //==============================================================================
+    struct Settings
+    {
+        double durationSeconds = 3600.0;
+        double reportSeconds = 60.0;
+
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        SimulatedAudioDevice::Faults faults;
+
+        /** Libraries swapped between in turn. Two are generated if there are none. */
+        juce::Array<juce::File> libraries;
+        double swapSeconds = 60.0;               // between swaps, 0 for none
+        EnhancedSFZLoader::LoadOptions loadOptions;
+
+        StressWorkloads::Settings playing;        // the combined workload, looped
+        int maxMissedDeadlines = 0;
+    };
+
+    /** The state of things at one report */
+    struct Report
+    {
+        double elapsedSeconds = 0.0;
+        SimulatedAudioDevice::Stats device;
+        double sampleRate = 0.0;
+        float peakLoad = 0.0f;                    // since the last report, as a fraction of the block period
+        int activeVoices = 0;
+        int numSwaps = 0;
+        double worstSwapSeconds = 0.0;
+        int realtimeViolations = 0;
+    };
+
+    //==============================================================================
+    explicit SoakTest(const Settings& settingsToUse);
+    ~SoakTest();
+
+    /** Plays for the whole duration, printing a report at each interval.
+        Returns false if it couldn't start: a library that wouldn't write or load, or no device.
+    */
+    bool run(juce::String& error);
+
+    /** Returns true if the run finished without a fault it counts as failing */
+    bool hasPassed() const;
+
+    /** Returns why the run failed, or an empty string if it passed */
+    juce::String getFailureReason() const;
+
+    const juce::Array<Report>& getReports() const noexcept { return reports; }
+
+    /** Returns the settings and every report as JSON */
+    juce::String toJSON() const;
+
+    static juce::String getTableHeader();
+    static juce::String toTableRow(const Report& report);
+
+private:
+    //==============================================================================
+    bool prepareLibraries(juce::String& error);
+    void swapLibrary();
+    Report makeReport(double elapsedSeconds);
+
+    Settings settings;
+    juce::File generatedDirectory;
+
+    SamplerEngine engine;
+    NoteInput noteInput;
+    CallbackLoadMonitor loadMonitor;
+    SamplerAudioCallback audioCallback { engine, noteInput, loadMonitor };
+    juce::AudioDeviceManager deviceManager;
+
+    int nextLibrary = 0;
+    std::atomic<bool> loading { false };
+    std::atomic<int> numSwaps { 0 };
+    std::atomic<double> worstSwapSeconds { 0.0 };
+
+    juce::Array<Report> reports;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SoakTest)
+};
\ No newline at end of file